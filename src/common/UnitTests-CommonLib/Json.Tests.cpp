@@ -0,0 +1,101 @@
+#include "pch.h"
+#include <common/utils/json.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsCommonLib
+{
+    TEST_CLASS (NativeJsonUnitTests)
+    {
+    private:
+        const std::string m_json = R"({"name":"Module Name","properties":{"bool_toggle_true":{"value":true},"int_spinner":{"value":10},"string_text":{"value":"a quick fox"},"list":[1,2.5,null]},"version":"1.0"})";
+
+    public:
+        TEST_METHOD (ParseValues)
+        {
+            const auto document = json::native::Document::Parse(m_json);
+            Assert::IsTrue(document.has_value());
+
+            const auto& root = document->Root();
+            Assert::AreEqual(std::wstring(L"Module Name"), root.GetNamedString(L"name"));
+
+            const auto& properties = root.GetNamedObject(L"properties");
+            Assert::IsTrue(properties.GetNamedObject(L"bool_toggle_true").GetNamedBoolean(L"value"));
+            Assert::AreEqual(10.0, properties.GetNamedObject(L"int_spinner").GetNamedNumber(L"value"));
+            Assert::AreEqual(std::string("a quick fox"), std::string(properties.GetNamedObject("string_text").GetNamedStringView("value")));
+
+            const auto& list = properties.GetNamedArray(L"list");
+            Assert::AreEqual(static_cast<size_t>(3), list.Size());
+            Assert::AreEqual(2.5, list.GetAt(1).GetNumber());
+            Assert::IsTrue(list.GetAt(2).IsNull());
+        }
+
+        TEST_METHOD (MissingMembers)
+        {
+            const auto document = json::native::Document::Parse(m_json);
+            const auto& root = document->Root();
+
+            Assert::IsFalse(root.HasKey(L"missing"));
+            Assert::AreEqual(5.0, root.GetNamedNumber(L"missing", 5.0));
+            Assert::AreEqual(std::wstring(L"default"), root.GetNamedString(L"version-missing", L"default"));
+            Assert::ExpectException<json::native::error>([&] { root.GetNamedString(L"missing"); });
+            Assert::ExpectException<json::native::error>([&] { root.GetNamedNumber(L"name"); });
+        }
+
+        TEST_METHOD (InvalidJson)
+        {
+            for (const char* text : { "", "{", "{\"a\":}", "[1,]", "{\"a\":1,}", "01", "\"unterminated", "[1] 2", "{'a':1}" })
+            {
+                json::native::ParseError error;
+                Assert::IsFalse(json::native::Document::Parse(text, &error).has_value());
+                Assert::AreNotEqual(std::string(""), std::string(error.message));
+            }
+        }
+
+        TEST_METHOD (Unicode)
+        {
+            const auto document = json::native::Document::Parse("{\"path\":\"C:\\\\Program Files\\\\\\u00e9\\ud83d\\ude00.exe\"}");
+            Assert::IsTrue(document.has_value());
+            Assert::AreEqual(std::wstring(L"C:\\Program Files\\\u00e9\U0001F600.exe"), document->Root().GetNamedString(L"path"));
+        }
+
+        TEST_METHOD (WriteRoundTrip)
+        {
+            const auto document = json::native::Document::Parse(m_json);
+
+            json::native::Writer writer;
+            writer.Write(document->Root());
+            Assert::AreEqual(m_json, writer.GetString());
+        }
+
+        TEST_METHOD (WriteEscapedStrings)
+        {
+            json::native::Writer writer;
+            writer.StartObject();
+            writer.Key(L"path");
+            writer.String(L"C:\\a \"b\"\n\u00e9");
+            writer.Key("numbers");
+            writer.StartArray();
+            writer.Number(int64_t{ -1 });
+            writer.Number(0.5);
+            writer.EndArray();
+            writer.EndObject();
+
+            Assert::AreEqual(std::string("{\"path\":\"C:\\\\a \\\"b\\\"\\n\xC3\xA9\",\"numbers\":[-1,0.5]}"), writer.GetString());
+        }
+
+        TEST_METHOD (SameAsWindowsDataJson)
+        {
+            const auto document = json::native::Document::Parse(m_json);
+            const auto expected = json::JsonValue::Parse(winrt::to_hstring(m_json));
+
+            Assert::AreEqual(expected.Stringify().c_str(), json::to_winrt(document->Root()).Stringify().c_str());
+
+            json::native::Writer writer;
+            json::write(writer, expected);
+            const auto reparsed = json::native::Document::Parse(writer.GetString());
+            Assert::IsTrue(reparsed.has_value());
+            Assert::AreEqual(expected.Stringify().c_str(), json::to_winrt(reparsed->Root()).Stringify().c_str());
+        }
+    };
+}
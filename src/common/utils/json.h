@@ -4,6 +4,8 @@
 #include <winrt/Windows.Foundation.Collections.h>
 #include <winrt/Windows.Data.Json.h>
 
+#include "json_native.h"
+
 #include <optional>
 #include <fstream>
 
@@ -70,4 +72,75 @@ namespace json
     {
         return value; // identity function overload for convenience
     }
+
+    // Bridges between json::native and Windows.Data.Json, for callers migrating one file at a time
+
+    inline JsonValue to_winrt(const native::Value& value)
+    {
+        switch (value.Type())
+        {
+        case native::ValueType::Boolean:
+            return JsonValue::CreateBooleanValue(value.GetBoolean());
+        case native::ValueType::Number:
+            return JsonValue::CreateNumberValue(value.GetNumber());
+        case native::ValueType::String:
+            return JsonValue::CreateStringValue(value.GetString());
+        case native::ValueType::Array:
+        {
+            JsonArray array;
+            for (const auto& element : value)
+            {
+                array.Append(to_winrt(element));
+            }
+            return array.as<JsonValue>();
+        }
+        case native::ValueType::Object:
+        {
+            JsonObject object;
+            for (auto member = value.MembersBegin(); member != value.MembersEnd(); ++member)
+            {
+                object.SetNamedValue(native::to_wide(member->name), to_winrt(member->value));
+            }
+            return object.as<JsonValue>();
+        }
+        default:
+            return JsonValue::CreateNullValue();
+        }
+    }
+
+    inline void write(native::Writer& writer, const IJsonValue& value)
+    {
+        switch (value.ValueType())
+        {
+        case JsonValueType::Boolean:
+            writer.Boolean(value.GetBoolean());
+            break;
+        case JsonValueType::Number:
+            writer.Number(value.GetNumber());
+            break;
+        case JsonValueType::String:
+            writer.String(std::wstring_view{ value.GetString() });
+            break;
+        case JsonValueType::Array:
+            writer.StartArray();
+            for (const auto& element : value.GetArray())
+            {
+                write(writer, element);
+            }
+            writer.EndArray();
+            break;
+        case JsonValueType::Object:
+            writer.StartObject();
+            for (const auto& member : value.GetObjectW())
+            {
+                writer.Key(std::wstring_view{ member.Key() });
+                write(writer, member.Value());
+            }
+            writer.EndObject();
+            break;
+        default:
+            writer.Null();
+            break;
+        }
+    }
 }
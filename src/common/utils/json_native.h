@@ -0,0 +1,1473 @@
+#pragma once
+
+// Native JSON reader and writer over UTF-8, without Windows.Data.Json.
+//
+// Reader is a SAX parser calling a handler for each token, Document builds an immutable DOM on top of it,
+// with every node and string in one arena. Writer appends compact JSON to a string.
+// Only the standard library is used, so it builds on any platform with a C++20 compiler.
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json::native
+{
+    // Thrown when a value is read as the wrong type, or a member is missing
+    class error : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    namespace details
+    {
+        inline void append_utf8(std::string& out, uint32_t codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                out.push_back(static_cast<char>(codePoint));
+            }
+            else if (codePoint < 0x800)
+            {
+                out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+                out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else if (codePoint < 0x10000)
+            {
+                out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else
+            {
+                out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+        }
+
+        // Next code point of a wide string, UTF-16 where wchar_t has 16 bits and UTF-32 elsewhere
+        inline uint32_t next_code_point(std::wstring_view str, size_t& i)
+        {
+            uint32_t codePoint = static_cast<uint32_t>(str[i++]);
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && i < str.size())
+                {
+                    const uint32_t low = static_cast<uint32_t>(str[i]);
+                    if (low >= 0xDC00 && low < 0xE000)
+                    {
+                        ++i;
+                        return 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                }
+            }
+
+            if ((codePoint >= 0xD800 && codePoint < 0xE000) || codePoint > 0x10FFFF)
+            {
+                return 0xFFFD;
+            }
+            return codePoint;
+        }
+
+        // Next code point of a UTF-8 string, invalid sequences are decoded as U+FFFD
+        inline uint32_t next_code_point(std::string_view str, size_t& i)
+        {
+            const auto lead = static_cast<unsigned char>(str[i++]);
+            if (lead < 0x80)
+            {
+                return lead;
+            }
+
+            size_t length;
+            uint32_t codePoint;
+            uint32_t minimum;
+            if ((lead & 0xE0) == 0xC0)
+            {
+                length = 1;
+                codePoint = lead & 0x1F;
+                minimum = 0x80;
+            }
+            else if ((lead & 0xF0) == 0xE0)
+            {
+                length = 2;
+                codePoint = lead & 0x0F;
+                minimum = 0x800;
+            }
+            else if ((lead & 0xF8) == 0xF0)
+            {
+                length = 3;
+                codePoint = lead & 0x07;
+                minimum = 0x10000;
+            }
+            else
+            {
+                return 0xFFFD;
+            }
+
+            for (size_t k = 0; k < length; ++k)
+            {
+                if (i >= str.size() || (static_cast<unsigned char>(str[i]) & 0xC0) != 0x80)
+                {
+                    return 0xFFFD;
+                }
+                codePoint = (codePoint << 6) | (static_cast<unsigned char>(str[i++]) & 0x3F);
+            }
+
+            if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint < 0xE000))
+            {
+                return 0xFFFD;
+            }
+            return codePoint;
+        }
+
+        inline void append_wide(std::wstring& out, uint32_t codePoint)
+        {
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                if (codePoint >= 0x10000)
+                {
+                    codePoint -= 0x10000;
+                    out.push_back(static_cast<wchar_t>(0xD800 + (codePoint >> 10)));
+                    out.push_back(static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF)));
+                    return;
+                }
+            }
+            out.push_back(static_cast<wchar_t>(codePoint));
+        }
+    }
+
+    inline void append_utf8(std::string& out, std::wstring_view str)
+    {
+        for (size_t i = 0; i < str.size();)
+        {
+            const wchar_t c = str[i];
+            if (static_cast<uint32_t>(c) < 0x80)
+            {
+                out.push_back(static_cast<char>(c));
+                ++i;
+            }
+            else
+            {
+                details::append_utf8(out, details::next_code_point(str, i));
+            }
+        }
+    }
+
+    inline std::string to_utf8(std::wstring_view str)
+    {
+        std::string result;
+        result.reserve(str.size());
+        append_utf8(result, str);
+        return result;
+    }
+
+    inline std::wstring to_wide(std::string_view str)
+    {
+        std::wstring result;
+        result.reserve(str.size());
+        for (size_t i = 0; i < str.size();)
+        {
+            const char c = str[i];
+            if (static_cast<unsigned char>(c) < 0x80)
+            {
+                result.push_back(static_cast<wchar_t>(c));
+                ++i;
+            }
+            else
+            {
+                details::append_wide(result, details::next_code_point(str, i));
+            }
+        }
+        return result;
+    }
+
+    // Compares a UTF-8 string with a wide string without converting either
+    inline bool equals(std::string_view utf8, std::wstring_view wide)
+    {
+        size_t i = 0;
+        size_t j = 0;
+        while (i < utf8.size() && j < wide.size())
+        {
+            if (static_cast<unsigned char>(utf8[i]) < 0x80 && static_cast<uint32_t>(wide[j]) < 0x80)
+            {
+                if (utf8[i++] != static_cast<char>(wide[j++]))
+                {
+                    return false;
+                }
+            }
+            else if (details::next_code_point(utf8, i) != details::next_code_point(wide, j))
+            {
+                return false;
+            }
+        }
+        return i == utf8.size() && j == wide.size();
+    }
+
+    /**
+     * Bump allocator for the nodes and strings of a document, freed all at once.
+     * Blocks never move, so the pointers stay valid when the arena itself is moved.
+     */
+    class Arena
+    {
+    public:
+        static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+        explicit Arena(size_t blockSize = DefaultBlockSize) :
+            m_blockSize(blockSize)
+        {
+        }
+
+        Arena(Arena&&) noexcept = default;
+        Arena& operator=(Arena&&) noexcept = default;
+
+        void* Allocate(size_t size, size_t alignment)
+        {
+            // Large allocations get a block of their own, the current block keeps its free space
+            if (size > m_blockSize / 4)
+            {
+                return Align(NewBlock(size + alignment), alignment);
+            }
+
+            std::byte* result = Align(m_current, alignment);
+            if (m_current == nullptr || static_cast<size_t>(result - m_current) + size > m_available)
+            {
+                m_current = NewBlock(m_blockSize);
+                m_available = m_blockSize;
+                result = Align(m_current, alignment);
+            }
+
+            m_available -= static_cast<size_t>(result - m_current) + size;
+            m_current = result + size;
+            return result;
+        }
+
+        template<typename T>
+        T* AllocateArray(size_t count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>);
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        std::string_view CopyString(std::string_view str)
+        {
+            if (str.empty())
+            {
+                return {};
+            }
+            char* copy = AllocateArray<char>(str.size());
+            std::memcpy(copy, str.data(), str.size());
+            return { copy, str.size() };
+        }
+
+        // Memory taken from the system
+        size_t BytesReserved() const noexcept
+        {
+            return m_reserved;
+        }
+
+    private:
+        std::byte* NewBlock(size_t size)
+        {
+            m_blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+            m_reserved += size;
+            return m_blocks.back().get();
+        }
+
+        static std::byte* Align(std::byte* pointer, size_t alignment) noexcept
+        {
+            const auto address = reinterpret_cast<uintptr_t>(pointer);
+            return pointer + (alignment - address % alignment) % alignment;
+        }
+
+        size_t m_blockSize;
+        std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+        std::byte* m_current = nullptr;
+        size_t m_available = 0;
+        size_t m_reserved = 0;
+    };
+
+    enum class ValueType : uint8_t
+    {
+        Null,
+        Boolean,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    struct Member;
+
+    /**
+     * Node of a Document. The accessors follow the names of Windows.Data.Json, so that callers
+     * migrate by changing types, but strings are UTF-8 and the errors are json::native::error.
+     */
+    class Value
+    {
+    public:
+        Value() noexcept :
+            m_number(0)
+        {
+        }
+
+        ValueType Type() const noexcept { return m_type; }
+        bool IsNull() const noexcept { return m_type == ValueType::Null; }
+        bool IsBoolean() const noexcept { return m_type == ValueType::Boolean; }
+        bool IsNumber() const noexcept { return m_type == ValueType::Number; }
+        bool IsString() const noexcept { return m_type == ValueType::String; }
+        bool IsArray() const noexcept { return m_type == ValueType::Array; }
+        bool IsObject() const noexcept { return m_type == ValueType::Object; }
+
+        bool GetBoolean() const
+        {
+            Expect(ValueType::Boolean);
+            return m_boolean;
+        }
+
+        double GetNumber() const
+        {
+            Expect(ValueType::Number);
+            return m_number;
+        }
+
+        std::string_view GetStringView() const
+        {
+            Expect(ValueType::String);
+            return { m_string, m_size };
+        }
+
+        std::wstring GetString() const
+        {
+            return to_wide(GetStringView());
+        }
+
+        // Number of elements of an array, or members of an object
+        size_t Size() const noexcept
+        {
+            return (m_type == ValueType::Array || m_type == ValueType::Object) ? m_size : 0;
+        }
+
+        const Value& GetAt(size_t index) const
+        {
+            Expect(ValueType::Array);
+            if (index >= m_size)
+            {
+                throw error("json: index out of range");
+            }
+            return m_elements[index];
+        }
+
+        // Elements of an array, empty for other values
+        const Value* begin() const noexcept { return m_type == ValueType::Array ? m_elements : nullptr; }
+        const Value* end() const noexcept { return m_type == ValueType::Array ? m_elements + m_size : nullptr; }
+
+        // Members of an object in document order, empty for other values
+        inline const Member* MembersBegin() const noexcept;
+        inline const Member* MembersEnd() const noexcept;
+
+        // Members are searched linearly, as settings objects are small
+        inline const Value* Find(std::string_view name) const noexcept;
+        inline const Value* Find(std::wstring_view name) const noexcept;
+
+        template<typename Name>
+        bool HasKey(const Name& name) const noexcept
+        {
+            return Find(name) != nullptr;
+        }
+
+        template<typename Name>
+        const Value& GetNamedValue(const Name& name) const
+        {
+            Expect(ValueType::Object);
+            if (const Value* value = Find(name))
+            {
+                return *value;
+            }
+            throw error("json: missing member");
+        }
+
+        template<typename Name>
+        bool GetNamedBoolean(const Name& name) const { return GetNamedValue(name).GetBoolean(); }
+        template<typename Name>
+        double GetNamedNumber(const Name& name) const { return GetNamedValue(name).GetNumber(); }
+        template<typename Name>
+        std::wstring GetNamedString(const Name& name) const { return GetNamedValue(name).GetString(); }
+        template<typename Name>
+        std::string_view GetNamedStringView(const Name& name) const { return GetNamedValue(name).GetStringView(); }
+
+        template<typename Name>
+        const Value& GetNamedArray(const Name& name) const
+        {
+            const Value& value = GetNamedValue(name);
+            value.Expect(ValueType::Array);
+            return value;
+        }
+
+        template<typename Name>
+        const Value& GetNamedObject(const Name& name) const
+        {
+            const Value& value = GetNamedValue(name);
+            value.Expect(ValueType::Object);
+            return value;
+        }
+
+        // Value of an optional member, or the default when it is missing or of another type
+        template<typename Name>
+        bool GetNamedBoolean(const Name& name, bool defaultValue) const
+        {
+            const Value* value = Find(name);
+            return value && value->IsBoolean() ? value->m_boolean : defaultValue;
+        }
+
+        template<typename Name>
+        double GetNamedNumber(const Name& name, double defaultValue) const
+        {
+            const Value* value = Find(name);
+            return value && value->IsNumber() ? value->m_number : defaultValue;
+        }
+
+        template<typename Name>
+        std::wstring GetNamedString(const Name& name, std::wstring_view defaultValue) const
+        {
+            const Value* value = Find(name);
+            return value && value->IsString() ? value->GetString() : std::wstring{ defaultValue };
+        }
+
+        static Value MakeNull() noexcept { return Value{}; }
+
+        static Value MakeBoolean(bool boolean) noexcept
+        {
+            Value value;
+            value.m_type = ValueType::Boolean;
+            value.m_boolean = boolean;
+            return value;
+        }
+
+        static Value MakeNumber(double number) noexcept
+        {
+            Value value;
+            value.m_type = ValueType::Number;
+            value.m_number = number;
+            return value;
+        }
+
+        // The string must outlive the value, in a document it is in the arena
+        static Value MakeString(std::string_view str) noexcept
+        {
+            Value value;
+            value.m_type = ValueType::String;
+            value.m_string = str.data();
+            value.m_size = static_cast<uint32_t>(str.size());
+            return value;
+        }
+
+        static Value MakeArray(const Value* elements, size_t size) noexcept
+        {
+            Value value;
+            value.m_type = ValueType::Array;
+            value.m_elements = elements;
+            value.m_size = static_cast<uint32_t>(size);
+            return value;
+        }
+
+        static Value MakeObject(const Member* members, size_t size) noexcept
+        {
+            Value value;
+            value.m_type = ValueType::Object;
+            value.m_members = members;
+            value.m_size = static_cast<uint32_t>(size);
+            return value;
+        }
+
+    private:
+        void Expect(ValueType type) const
+        {
+            if (m_type != type)
+            {
+                throw error("json: unexpected value type");
+            }
+        }
+
+        ValueType m_type = ValueType::Null;
+        uint32_t m_size = 0;
+        union
+        {
+            bool m_boolean;
+            double m_number;
+            const char* m_string;
+            const Value* m_elements;
+            const Member* m_members;
+        };
+    };
+
+    struct Member
+    {
+        std::string_view name;
+        Value value;
+    };
+
+    inline const Member* Value::MembersBegin() const noexcept
+    {
+        return m_type == ValueType::Object ? m_members : nullptr;
+    }
+
+    inline const Member* Value::MembersEnd() const noexcept
+    {
+        return m_type == ValueType::Object ? m_members + m_size : nullptr;
+    }
+
+    inline const Value* Value::Find(std::string_view name) const noexcept
+    {
+        for (auto member = MembersBegin(); member != MembersEnd(); ++member)
+        {
+            if (member->name == name)
+            {
+                return &member->value;
+            }
+        }
+        return nullptr;
+    }
+
+    inline const Value* Value::Find(std::wstring_view name) const noexcept
+    {
+        for (auto member = MembersBegin(); member != MembersEnd(); ++member)
+        {
+            if (equals(member->name, name))
+            {
+                return &member->value;
+            }
+        }
+        return nullptr;
+    }
+
+    struct ParseError
+    {
+        size_t offset = 0;
+        const char* message = "";
+    };
+
+    /**
+     * SAX parser. The handler gets Null(), Boolean(bool), Number(double), String(std::string_view),
+     * StartObject(), Key(std::string_view), EndObject(size_t members), StartArray() and EndArray(size_t elements),
+     * each returning false to stop the parse. Strings are only valid during the call, as the escaped
+     * ones are decoded into a buffer reused by the reader.
+     */
+    class Reader
+    {
+    public:
+        static constexpr size_t MaxDepth = 512;
+
+        template<typename Handler>
+        bool Parse(std::string_view text, Handler& handler)
+        {
+            m_text = text;
+            m_position = 0;
+            m_error = {};
+
+            // A UTF-8 byte order mark is skipped, as files written by some editors start with it
+            if (m_text.starts_with("\xEF\xBB\xBF"))
+            {
+                m_position = 3;
+            }
+
+            SkipWhitespace();
+            if (!ParseValue(handler, 0))
+            {
+                return false;
+            }
+
+            SkipWhitespace();
+            if (m_position != m_text.size())
+            {
+                return Fail("unexpected data after the root value");
+            }
+            return true;
+        }
+
+        const ParseError& Error() const noexcept
+        {
+            return m_error;
+        }
+
+    private:
+        bool Fail(const char* message)
+        {
+            // Keep the first error, a handler stopping the parse reports no error of its own
+            if (*m_error.message == '\0')
+            {
+                m_error = ParseError{ m_position, message };
+            }
+            return false;
+        }
+
+        bool Abort()
+        {
+            return Fail("parse stopped by the handler");
+        }
+
+        void SkipWhitespace() noexcept
+        {
+            while (m_position < m_text.size())
+            {
+                const char c = m_text[m_position];
+                if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+                {
+                    break;
+                }
+                ++m_position;
+            }
+        }
+
+        bool Consume(std::string_view literal) noexcept
+        {
+            if (m_text.substr(m_position, literal.size()) == literal)
+            {
+                m_position += literal.size();
+                return true;
+            }
+            return false;
+        }
+
+        template<typename Handler>
+        bool ParseValue(Handler& handler, size_t depth)
+        {
+            if (m_position >= m_text.size())
+            {
+                return Fail("unexpected end of data");
+            }
+
+            switch (m_text[m_position])
+            {
+            case '{':
+                return ParseObject(handler, depth);
+            case '[':
+                return ParseArray(handler, depth);
+            case '"':
+            {
+                std::string_view str;
+                return ParseString(str) && (handler.String(str) || Abort());
+            }
+            case 't':
+                return Consume("true") ? (handler.Boolean(true) || Abort()) : Fail("invalid literal");
+            case 'f':
+                return Consume("false") ? (handler.Boolean(false) || Abort()) : Fail("invalid literal");
+            case 'n':
+                return Consume("null") ? (handler.Null() || Abort()) : Fail("invalid literal");
+            default:
+                return ParseNumber(handler);
+            }
+        }
+
+        template<typename Handler>
+        bool ParseObject(Handler& handler, size_t depth)
+        {
+            if (depth >= MaxDepth)
+            {
+                return Fail("nesting too deep");
+            }
+
+            ++m_position;
+            if (!handler.StartObject())
+            {
+                return Abort();
+            }
+
+            size_t members = 0;
+            SkipWhitespace();
+            if (m_position < m_text.size() && m_text[m_position] == '}')
+            {
+                ++m_position;
+                return handler.EndObject(members) || Abort();
+            }
+
+            while (true)
+            {
+                if (m_position >= m_text.size() || m_text[m_position] != '"')
+                {
+                    return Fail("expected a member name");
+                }
+
+                std::string_view name;
+                if (!ParseString(name))
+                {
+                    return false;
+                }
+                if (!handler.Key(name))
+                {
+                    return Abort();
+                }
+
+                SkipWhitespace();
+                if (m_position >= m_text.size() || m_text[m_position] != ':')
+                {
+                    return Fail("expected ':'");
+                }
+                ++m_position;
+                SkipWhitespace();
+
+                if (!ParseValue(handler, depth + 1))
+                {
+                    return false;
+                }
+                ++members;
+
+                SkipWhitespace();
+                if (m_position >= m_text.size())
+                {
+                    return Fail("unexpected end of data");
+                }
+                if (m_text[m_position] == ',')
+                {
+                    ++m_position;
+                    SkipWhitespace();
+                }
+                else if (m_text[m_position] == '}')
+                {
+                    ++m_position;
+                    return handler.EndObject(members) || Abort();
+                }
+                else
+                {
+                    return Fail("expected ',' or '}'");
+                }
+            }
+        }
+
+        template<typename Handler>
+        bool ParseArray(Handler& handler, size_t depth)
+        {
+            if (depth >= MaxDepth)
+            {
+                return Fail("nesting too deep");
+            }
+
+            ++m_position;
+            if (!handler.StartArray())
+            {
+                return Abort();
+            }
+
+            size_t elements = 0;
+            SkipWhitespace();
+            if (m_position < m_text.size() && m_text[m_position] == ']')
+            {
+                ++m_position;
+                return handler.EndArray(elements) || Abort();
+            }
+
+            while (true)
+            {
+                if (!ParseValue(handler, depth + 1))
+                {
+                    return false;
+                }
+                ++elements;
+
+                SkipWhitespace();
+                if (m_position >= m_text.size())
+                {
+                    return Fail("unexpected end of data");
+                }
+                if (m_text[m_position] == ',')
+                {
+                    ++m_position;
+                    SkipWhitespace();
+                }
+                else if (m_text[m_position] == ']')
+                {
+                    ++m_position;
+                    return handler.EndArray(elements) || Abort();
+                }
+                else
+                {
+                    return Fail("expected ',' or ']'");
+                }
+            }
+        }
+
+        bool ParseHex4(uint32_t& value)
+        {
+            if (m_position + 4 > m_text.size())
+            {
+                return Fail("invalid escape sequence");
+            }
+
+            value = 0;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                const char c = m_text[m_position++];
+                value <<= 4;
+                if (c >= '0' && c <= '9')
+                {
+                    value |= static_cast<uint32_t>(c - '0');
+                }
+                else if (c >= 'a' && c <= 'f')
+                {
+                    value |= static_cast<uint32_t>(c - 'a' + 10);
+                }
+                else if (c >= 'A' && c <= 'F')
+                {
+                    value |= static_cast<uint32_t>(c - 'A' + 10);
+                }
+                else
+                {
+                    return Fail("invalid escape sequence");
+                }
+            }
+            return true;
+        }
+
+        // Strings without escapes are returned as a view of the text, the others are decoded into m_buffer
+        bool ParseString(std::string_view& result)
+        {
+            const size_t start = ++m_position;
+            while (m_position < m_text.size())
+            {
+                const char c = m_text[m_position];
+                if (c == '"')
+                {
+                    result = m_text.substr(start, m_position - start);
+                    ++m_position;
+                    return true;
+                }
+                if (c == '\\')
+                {
+                    break;
+                }
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    return Fail("control character in string");
+                }
+                ++m_position;
+            }
+
+            m_buffer.assign(m_text.substr(start, m_position - start));
+            while (m_position < m_text.size())
+            {
+                const char c = m_text[m_position++];
+                if (c == '"')
+                {
+                    result = m_buffer;
+                    return true;
+                }
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    --m_position;
+                    return Fail("control character in string");
+                }
+                if (c != '\\')
+                {
+                    m_buffer.push_back(c);
+                    continue;
+                }
+
+                if (m_position >= m_text.size())
+                {
+                    break;
+                }
+
+                switch (m_text[m_position++])
+                {
+                case '"':
+                    m_buffer.push_back('"');
+                    break;
+                case '\\':
+                    m_buffer.push_back('\\');
+                    break;
+                case '/':
+                    m_buffer.push_back('/');
+                    break;
+                case 'b':
+                    m_buffer.push_back('\b');
+                    break;
+                case 'f':
+                    m_buffer.push_back('\f');
+                    break;
+                case 'n':
+                    m_buffer.push_back('\n');
+                    break;
+                case 'r':
+                    m_buffer.push_back('\r');
+                    break;
+                case 't':
+                    m_buffer.push_back('\t');
+                    break;
+                case 'u':
+                {
+                    uint32_t codePoint;
+                    if (!ParseHex4(codePoint))
+                    {
+                        return false;
+                    }
+
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00 && Consume("\\u"))
+                    {
+                        uint32_t low;
+                        if (!ParseHex4(low))
+                        {
+                            return false;
+                        }
+
+                        if (low >= 0xDC00 && low < 0xE000)
+                        {
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        else
+                        {
+                            // Unpaired high surrogate, the next escape is decoded on its own
+                            details::append_utf8(m_buffer, 0xFFFD);
+                            codePoint = (low >= 0xD800 && low < 0xE000) ? 0xFFFD : low;
+                        }
+                    }
+                    else if (codePoint >= 0xD800 && codePoint < 0xE000)
+                    {
+                        codePoint = 0xFFFD;
+                    }
+
+                    details::append_utf8(m_buffer, codePoint);
+                    break;
+                }
+                default:
+                    --m_position;
+                    return Fail("invalid escape sequence");
+                }
+            }
+
+            return Fail("unterminated string");
+        }
+
+        template<typename Handler>
+        bool ParseNumber(Handler& handler)
+        {
+            const size_t start = m_position;
+            bool negative = false;
+            if (m_text[m_position] == '-')
+            {
+                negative = true;
+                ++m_position;
+            }
+
+            // Integers of up to 15 digits are exact in a double, and skip from_chars
+            uint64_t integer = 0;
+            const size_t integerStart = m_position;
+            if (m_position < m_text.size() && m_text[m_position] == '0')
+            {
+                ++m_position;
+            }
+            else
+            {
+                while (m_position < m_text.size() && m_text[m_position] >= '0' && m_text[m_position] <= '9')
+                {
+                    integer = integer * 10 + static_cast<uint64_t>(m_text[m_position] - '0');
+                    ++m_position;
+                }
+            }
+
+            const size_t integerDigits = m_position - integerStart;
+            if (integerDigits == 0)
+            {
+                m_position = start;
+                return Fail("invalid value");
+            }
+
+            bool simple = integerDigits <= 15;
+            if (m_position < m_text.size() && m_text[m_position] == '.')
+            {
+                simple = false;
+                ++m_position;
+                const size_t fractionStart = m_position;
+                while (m_position < m_text.size() && m_text[m_position] >= '0' && m_text[m_position] <= '9')
+                {
+                    ++m_position;
+                }
+                if (m_position == fractionStart)
+                {
+                    return Fail("invalid number");
+                }
+            }
+
+            if (m_position < m_text.size() && (m_text[m_position] == 'e' || m_text[m_position] == 'E'))
+            {
+                simple = false;
+                ++m_position;
+                if (m_position < m_text.size() && (m_text[m_position] == '+' || m_text[m_position] == '-'))
+                {
+                    ++m_position;
+                }
+                const size_t exponentStart = m_position;
+                while (m_position < m_text.size() && m_text[m_position] >= '0' && m_text[m_position] <= '9')
+                {
+                    ++m_position;
+                }
+                if (m_position == exponentStart)
+                {
+                    return Fail("invalid number");
+                }
+            }
+
+            double number = 0;
+            if (simple)
+            {
+                number = static_cast<double>(integer);
+                if (negative)
+                {
+                    number = -number;
+                }
+            }
+            else
+            {
+                // from_chars does not take the leading '+' JSON forbids, the grammar was checked above
+                const char* first = m_text.data() + start;
+                const char* last = m_text.data() + m_position;
+                const auto [end, ec] = std::from_chars(first, last, number);
+                if (ec == std::errc::result_out_of_range)
+                {
+                    // The number is left unchanged, only a negative exponent makes it too small
+                    const auto exponent = std::string_view(first, static_cast<size_t>(last - first)).find_first_of("eE");
+                    const bool tiny = exponent != std::string_view::npos && first[exponent + 1] == '-';
+                    number = tiny ? 0.0 : HUGE_VAL;
+                    if (negative)
+                    {
+                        number = -number;
+                    }
+                }
+                else if (ec != std::errc{} || end != last)
+                {
+                    return Fail("invalid number");
+                }
+            }
+
+            return handler.Number(number) || Abort();
+        }
+
+        std::string_view m_text;
+        size_t m_position = 0;
+        std::string m_buffer;
+        ParseError m_error;
+    };
+
+    /**
+     * Immutable DOM, with all of its nodes and strings in one arena.
+     */
+    class Document
+    {
+    public:
+        Document() = default;
+        Document(Document&&) noexcept = default;
+        Document& operator=(Document&&) noexcept = default;
+
+        static std::optional<Document> Parse(std::string_view text, ParseError* error = nullptr)
+        {
+            Document document;
+            Builder builder{ document.m_arena };
+            Reader reader;
+            if (!reader.Parse(text, builder))
+            {
+                if (error)
+                {
+                    *error = reader.Error();
+                }
+                return std::nullopt;
+            }
+
+            document.m_root = builder.Root();
+            return document;
+        }
+
+        const Value& Root() const noexcept
+        {
+            return m_root;
+        }
+
+        const Arena& GetArena() const noexcept
+        {
+            return m_arena;
+        }
+
+    private:
+        // Keeps the values of the open arrays and objects on a stack, and moves them to the arena once closed
+        class Builder
+        {
+        public:
+            explicit Builder(Arena& arena) :
+                m_arena(arena)
+            {
+            }
+
+            bool Null()
+            {
+                m_values.push_back(Value::MakeNull());
+                return true;
+            }
+
+            bool Boolean(bool boolean)
+            {
+                m_values.push_back(Value::MakeBoolean(boolean));
+                return true;
+            }
+
+            bool Number(double number)
+            {
+                m_values.push_back(Value::MakeNumber(number));
+                return true;
+            }
+
+            bool String(std::string_view str)
+            {
+                m_values.push_back(Value::MakeString(m_arena.CopyString(str)));
+                return true;
+            }
+
+            bool Key(std::string_view name)
+            {
+                m_names.push_back(m_arena.CopyString(name));
+                return true;
+            }
+
+            bool StartObject() { return true; }
+            bool StartArray() { return true; }
+
+            bool EndObject(size_t size)
+            {
+                Member* members = m_arena.AllocateArray<Member>(size);
+                const size_t valuesStart = m_values.size() - size;
+                const size_t namesStart = m_names.size() - size;
+                for (size_t i = 0; i < size; ++i)
+                {
+                    new (members + i) Member{ m_names[namesStart + i], m_values[valuesStart + i] };
+                }
+
+                m_values.resize(valuesStart);
+                m_names.resize(namesStart);
+                m_values.push_back(Value::MakeObject(members, size));
+                return true;
+            }
+
+            bool EndArray(size_t size)
+            {
+                Value* elements = m_arena.AllocateArray<Value>(size);
+                const size_t valuesStart = m_values.size() - size;
+                std::uninitialized_copy(m_values.begin() + valuesStart, m_values.end(), elements);
+
+                m_values.resize(valuesStart);
+                m_values.push_back(Value::MakeArray(elements, size));
+                return true;
+            }
+
+            Value Root() const
+            {
+                return m_values.back();
+            }
+
+        private:
+            Arena& m_arena;
+            std::vector<Value> m_values;
+            std::vector<std::string_view> m_names;
+        };
+
+        Arena m_arena;
+        Value m_root;
+    };
+
+    /**
+     * Appends compact JSON to a string. Wide strings are converted to UTF-8 as they are written.
+     */
+    class Writer
+    {
+    public:
+        void StartObject()
+        {
+            BeforeValue();
+            m_output.push_back('{');
+            m_first.push_back(true);
+        }
+
+        void EndObject()
+        {
+            m_output.push_back('}');
+            m_first.pop_back();
+        }
+
+        void StartArray()
+        {
+            BeforeValue();
+            m_output.push_back('[');
+            m_first.push_back(true);
+        }
+
+        void EndArray()
+        {
+            m_output.push_back(']');
+            m_first.pop_back();
+        }
+
+        void Key(std::string_view name)
+        {
+            BeforeValue();
+            AppendString(name);
+            m_output.push_back(':');
+            m_afterKey = true;
+        }
+
+        void Key(std::wstring_view name)
+        {
+            BeforeValue();
+            AppendString(name);
+            m_output.push_back(':');
+            m_afterKey = true;
+        }
+
+        void String(std::string_view str)
+        {
+            BeforeValue();
+            AppendString(str);
+        }
+
+        void String(std::wstring_view str)
+        {
+            BeforeValue();
+            AppendString(str);
+        }
+
+        // JSON has no representation of infinities and NaN, they are written as null
+        void Number(double number)
+        {
+            BeforeValue();
+            if (!std::isfinite(number))
+            {
+                m_output.append("null");
+                return;
+            }
+
+            char buffer[32];
+            const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), number);
+            m_output.append(buffer, ec == std::errc{} ? end : buffer);
+        }
+
+        void Number(int64_t number)
+        {
+            BeforeValue();
+            char buffer[24];
+            const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), number);
+            m_output.append(buffer, ec == std::errc{} ? end : buffer);
+        }
+
+        void Boolean(bool boolean)
+        {
+            BeforeValue();
+            m_output.append(boolean ? "true" : "false");
+        }
+
+        void Null()
+        {
+            BeforeValue();
+            m_output.append("null");
+        }
+
+        void Write(const Value& value)
+        {
+            switch (value.Type())
+            {
+            case ValueType::Null:
+                Null();
+                break;
+            case ValueType::Boolean:
+                Boolean(value.GetBoolean());
+                break;
+            case ValueType::Number:
+                Number(value.GetNumber());
+                break;
+            case ValueType::String:
+                String(value.GetStringView());
+                break;
+            case ValueType::Array:
+                StartArray();
+                for (const auto& element : value)
+                {
+                    Write(element);
+                }
+                EndArray();
+                break;
+            case ValueType::Object:
+                StartObject();
+                for (auto member = value.MembersBegin(); member != value.MembersEnd(); ++member)
+                {
+                    Key(member->name);
+                    Write(member->value);
+                }
+                EndObject();
+                break;
+            }
+        }
+
+        void Reserve(size_t size)
+        {
+            m_output.reserve(size);
+        }
+
+        const std::string& GetString() const noexcept
+        {
+            return m_output;
+        }
+
+        std::string Release() noexcept
+        {
+            m_first.clear();
+            m_afterKey = false;
+            return std::move(m_output);
+        }
+
+    private:
+        void BeforeValue()
+        {
+            if (m_afterKey)
+            {
+                m_afterKey = false;
+                return;
+            }
+
+            if (!m_first.empty())
+            {
+                if (!m_first.back())
+                {
+                    m_output.push_back(',');
+                }
+                m_first.back() = false;
+            }
+        }
+
+        void AppendEscaped(char c)
+        {
+            static constexpr char hex[] = "0123456789abcdef";
+            switch (c)
+            {
+            case '"':
+                m_output.append("\\\"");
+                break;
+            case '\\':
+                m_output.append("\\\\");
+                break;
+            case '\b':
+                m_output.append("\\b");
+                break;
+            case '\f':
+                m_output.append("\\f");
+                break;
+            case '\n':
+                m_output.append("\\n");
+                break;
+            case '\r':
+                m_output.append("\\r");
+                break;
+            case '\t':
+                m_output.append("\\t");
+                break;
+            default:
+                m_output.append("\\u00");
+                m_output.push_back(hex[(c >> 4) & 0xF]);
+                m_output.push_back(hex[c & 0xF]);
+                break;
+            }
+        }
+
+        static bool NeedsEscape(char c) noexcept
+        {
+            return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+        }
+
+        void AppendString(std::string_view str)
+        {
+            m_output.push_back('"');
+            size_t runStart = 0;
+            for (size_t i = 0; i < str.size(); ++i)
+            {
+                if (NeedsEscape(str[i]))
+                {
+                    m_output.append(str.substr(runStart, i - runStart));
+                    AppendEscaped(str[i]);
+                    runStart = i + 1;
+                }
+            }
+            m_output.append(str.substr(runStart));
+            m_output.push_back('"');
+        }
+
+        void AppendString(std::wstring_view str)
+        {
+            m_output.push_back('"');
+            for (size_t i = 0; i < str.size();)
+            {
+                const wchar_t c = str[i];
+                if (static_cast<uint32_t>(c) < 0x80)
+                {
+                    if (NeedsEscape(static_cast<char>(c)))
+                    {
+                        AppendEscaped(static_cast<char>(c));
+                    }
+                    else
+                    {
+                        m_output.push_back(static_cast<char>(c));
+                    }
+                    ++i;
+                }
+                else
+                {
+                    details::append_utf8(m_output, details::next_code_point(str, i));
+                }
+            }
+            m_output.push_back('"');
+        }
+
+        std::string m_output;
+        // Whether each open array or object has no element yet
+        std::vector<bool> m_first;
+        bool m_afterKey = false;
+    };
+
+    inline std::optional<std::string> read_file(std::wstring_view file_name)
+    {
+        std::ifstream file{ std::filesystem::path{ file_name }, std::ios::binary | std::ios::ate };
+        if (!file.is_open())
+        {
+            return std::nullopt;
+        }
+
+        std::string contents;
+        contents.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+        if (!file)
+        {
+            return std::nullopt;
+        }
+        return contents;
+    }
+
+    inline std::optional<Document> from_file(std::wstring_view file_name)
+    {
+        if (auto contents = read_file(file_name))
+        {
+            return Document::Parse(*contents);
+        }
+        return std::nullopt;
+    }
+
+    inline bool to_file(std::wstring_view file_name, std::string_view contents)
+    {
+        std::ofstream file{ std::filesystem::path{ file_name }, std::ios::binary | std::ios::trunc };
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        return file.good();
+    }
+}
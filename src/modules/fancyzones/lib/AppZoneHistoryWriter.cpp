@@ -0,0 +1,184 @@
+#include "pch.h"
+
+#include "AppZoneHistoryWriter.h"
+#include "CallTracer.h"
+
+#include <common/logger/logger.h>
+
+#include <fstream>
+
+namespace
+{
+    // Replace the file with the new contents, leaving the old file in place if anything fails
+    bool WriteFileAtomically(const std::wstring& fileName, const std::string& contents)
+    {
+        const std::wstring tempFileName = fileName + L".tmp";
+        {
+            std::ofstream file{ tempFileName, std::ios::binary | std::ios::trunc };
+            file << contents;
+            if (!file.good())
+            {
+                return false;
+            }
+        }
+
+        return MoveFileExW(tempFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+    }
+}
+
+AppZoneHistoryWriter::AppZoneHistoryWriter(std::recursive_mutex& dataLock, SnapshotCallback snapshot, std::chrono::milliseconds interval) :
+    m_dataLock(dataLock),
+    m_snapshot(std::move(snapshot)),
+    m_interval(interval)
+{
+}
+
+AppZoneHistoryWriter::~AppZoneHistoryWriter()
+{
+    Stop();
+}
+
+void AppZoneHistoryWriter::SetFileName(const std::wstring& fileName)
+{
+    std::scoped_lock lock{ m_writeMutex };
+    m_fileName = fileName;
+    m_lastContents.clear();
+}
+
+void AppZoneHistoryWriter::Schedule()
+{
+    {
+        std::scoped_lock lock{ m_mutex };
+        if (!m_stopped)
+        {
+            if (m_dirty)
+            {
+                ++m_writesAvoided;
+            }
+
+            m_dirty = true;
+
+            // The thread is only started by the first change
+            if (!m_thread.joinable())
+            {
+                m_thread = std::thread{ [this] { WorkerThread(); } };
+            }
+
+            m_cv.notify_one();
+            return;
+        }
+
+        // The thread is being stopped
+        m_dirty = true;
+    }
+
+    Write();
+}
+
+void AppZoneHistoryWriter::Flush()
+{
+    {
+        std::scoped_lock lock{ m_mutex };
+        m_dirty = true;
+    }
+
+    Write();
+}
+
+void AppZoneHistoryWriter::Stop()
+{
+    std::thread thread;
+    {
+        std::scoped_lock lock{ m_mutex };
+        m_stopped = true;
+        thread = std::move(m_thread);
+        m_cv.notify_one();
+    }
+
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+
+    // Changes made while the thread was stopping are in this write, the next ones start it again
+    {
+        std::scoped_lock lock{ m_mutex };
+        m_stopped = false;
+    }
+
+    Write();
+}
+
+AppZoneHistoryWriter::Statistics AppZoneHistoryWriter::GetStatistics() const noexcept
+{
+    return Statistics{
+        .writes = m_writes,
+        .writesAvoided = m_writesAvoided,
+        .maxSnapshotTime = std::chrono::microseconds{ m_maxSnapshotMicroseconds }
+    };
+}
+
+void AppZoneHistoryWriter::WorkerThread()
+{
+    std::unique_lock lock{ m_mutex };
+    while (true)
+    {
+        m_cv.wait(lock, [this] { return m_dirty || m_stopped; });
+
+        // Let the changes of the next interval pile up, Stop() writes them if it comes first
+        if (m_cv.wait_for(lock, m_interval, [this] { return m_stopped; }))
+        {
+            break;
+        }
+
+        lock.unlock();
+        Write();
+        lock.lock();
+    }
+}
+
+void AppZoneHistoryWriter::Write()
+{
+    _TRACER_;
+    {
+        std::scoped_lock lock{ m_mutex };
+        if (!m_dirty)
+        {
+            return;
+        }
+        m_dirty = false;
+    }
+
+    // The snapshots are numbered under the data lock, so that a write never replaces a newer one
+    JSONHelpers::TAppZoneHistoryMap appZoneHistoryMap;
+    uint64_t generation;
+    {
+        std::scoped_lock lock{ m_dataLock };
+        const auto snapshotStart = std::chrono::steady_clock::now();
+        generation = ++m_generation;
+        appZoneHistoryMap = m_snapshot();
+
+        const auto snapshotTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - snapshotStart).count();
+        m_maxSnapshotMicroseconds = (std::max)(m_maxSnapshotMicroseconds.load(), static_cast<long long>(snapshotTime));
+    }
+
+    std::string contents = JSONHelpers::SerializeAppZoneHistoryFile(appZoneHistoryMap);
+
+    std::scoped_lock lock{ m_writeMutex };
+    if (generation < m_writtenGeneration || contents == m_lastContents)
+    {
+        ++m_writesAvoided;
+        return;
+    }
+
+    if (WriteFileAtomically(m_fileName, contents))
+    {
+        m_lastContents = std::move(contents);
+        m_writtenGeneration = generation;
+        ++m_writes;
+    }
+    else
+    {
+        Logger::error(L"Failed to write {}, error {}", m_fileName, GetLastError());
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "JsonHelpers.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Writes the app zone history file on a background thread.
+ *
+ * Changes only mark the history as dirty. At most once per interval, the thread copies the history
+ * under the data lock, serializes the copy once the lock is released, and replaces the file through
+ * a temporary file so that it is never left half written.
+ */
+class AppZoneHistoryWriter
+{
+public:
+    using SnapshotCallback = std::function<JSONHelpers::TAppZoneHistoryMap()>;
+
+    struct Statistics
+    {
+        // Files written
+        size_t writes = 0;
+        // Changes written along with a later one, and snapshots identical to the file
+        size_t writesAvoided = 0;
+        // Longest time the data lock was held for a snapshot
+        std::chrono::microseconds maxSnapshotTime{};
+    };
+
+    static constexpr std::chrono::milliseconds DefaultInterval{ 1000 };
+
+    /**
+     * @param   dataLock Lock of the history, held during the snapshot only.
+     * @param   snapshot Returns a copy of the history.
+     */
+    AppZoneHistoryWriter(std::recursive_mutex& dataLock, SnapshotCallback snapshot, std::chrono::milliseconds interval = DefaultInterval);
+    ~AppZoneHistoryWriter();
+
+    AppZoneHistoryWriter(const AppZoneHistoryWriter&) = delete;
+    AppZoneHistoryWriter& operator=(const AppZoneHistoryWriter&) = delete;
+
+    void SetFileName(const std::wstring& fileName);
+
+    /**
+     * Mark the history as changed, to be written by the background thread.
+     */
+    void Schedule();
+
+    /**
+     * Write the history now, on the calling thread.
+     */
+    void Flush();
+
+    /**
+     * Stop the background thread and write the pending changes. The next change starts the thread again.
+     * Must be called before the module is unloaded, the thread cannot be joined from DllMain.
+     */
+    void Stop();
+
+    Statistics GetStatistics() const noexcept;
+
+private:
+    void WorkerThread();
+    void Write();
+
+    std::recursive_mutex& m_dataLock;
+    SnapshotCallback m_snapshot;
+    // Number of the last snapshot, guarded by the data lock
+    uint64_t m_generation = 0;
+    const std::chrono::milliseconds m_interval;
+
+    // Guards the state below, never held while the data lock is taken
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+    bool m_dirty = false;
+    bool m_stopped = false;
+
+    // Serializes writes, guards the file name and what was last written
+    std::mutex m_writeMutex;
+    std::wstring m_fileName;
+    std::string m_lastContents;
+    uint64_t m_writtenGeneration = 0;
+
+    std::atomic<size_t> m_writes = 0;
+    std::atomic<size_t> m_writesAvoided = 0;
+    std::atomic<long long> m_maxSnapshotMicroseconds = 0;
+};
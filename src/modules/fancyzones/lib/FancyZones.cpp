@@ -83,6 +83,11 @@ public:
     {
         m_settings->SetCallback(this);
 
+        // The settings written by FancyZones are not reloaded
+        FancyZonesDataInstance().SetZoneSettingsSavedCallback([this](std::string_view contents) {
+            m_fileWatcher.SetKnownContents(FancyZonesDataInstance().GetZonesSettingsFileName(), contents);
+        });
+
         this->disableModuleCallback = std::move(disableModuleCallback);
     }
 
@@ -140,14 +145,26 @@ public:
             PostMessageW(m_window, WM_PRIV_NAMECHANGE, wparam, lparam);
             break;
 
+        case EVENT_OBJECT_CREATE:
+            if (data->idObject == OBJID_WINDOW)
+            {
+                // The handle may have belonged to a window of another process
+                FancyZonesDataInstance().InvalidateProcessPath(data->hwnd);
+            }
+            [[fallthrough]];
         case EVENT_OBJECT_UNCLOAKED:
         case EVENT_OBJECT_SHOW:
-        case EVENT_OBJECT_CREATE:
             if (data->idObject == OBJID_WINDOW)
             {
                 PostMessageW(m_window, WM_PRIV_WINDOWCREATED, wparam, lparam);
             }
             break;
+        case EVENT_OBJECT_DESTROY:
+            if (data->idObject == OBJID_WINDOW)
+            {
+                FancyZonesDataInstance().InvalidateProcessPath(data->hwnd);
+            }
+            break;
         }
     }
 
@@ -340,6 +357,9 @@ FancyZones::Destroy() noexcept
     {
         SetEvent(m_terminateVirtualDesktopTrackerEvent.get());
     }
+
+    FancyZonesDataInstance().SetZoneSettingsSavedCallback(nullptr);
+    FancyZonesDataInstance().StopAppZoneHistoryWriter();
 }
 
 // IFancyZonesCallback
@@ -16,7 +16,6 @@
 #include <regex>
 #include <sstream>
 #include <unordered_set>
-#include <common/utils/process_path.h>
 #include <common/logger/logger.h>
 
 // Non-localizable strings
@@ -145,13 +144,15 @@ FancyZonesData& FancyZonesDataInstance()
     return instance;
 }
 
-FancyZonesData::FancyZonesData()
+FancyZonesData::FancyZonesData() :
+    appZoneHistoryWriter(dataLock, [this] { return appZoneHistoryMap; })
 {
     std::wstring saveFolderPath = PTSettingsHelper::get_module_save_folder_location(NonLocalizable::FancyZonesStr);
 
     zonesSettingsFileName = saveFolderPath + L"\\" + std::wstring(NonLocalizable::FancyZonesDataFile);
     appZoneHistoryFileName = saveFolderPath + L"\\" + std::wstring(NonLocalizable::FancyZonesAppZoneHistoryFile);
     editorParametersFileName = saveFolderPath + L"\\" + std::wstring(NonLocalizable::FancyZonesEditorParametersFile);
+    appZoneHistoryWriter.SetFileName(appZoneHistoryFileName);
 }
 
 const JSONHelpers::TDeviceInfoMap& FancyZonesData::GetDeviceInfoMap() const
@@ -317,30 +318,24 @@ void FancyZonesData::RemoveDeletedDesktops(const std::vector<std::wstring>& acti
 bool FancyZonesData::IsAnotherWindowOfApplicationInstanceZoned(HWND window, const std::wstring_view& deviceId) const
 {
     std::scoped_lock lock{ dataLock };
-    auto processPath = get_process_path(window);
-    if (!processPath.empty())
+    if (const auto perDesktopData = FindAppZoneHistory(window))
     {
-        auto history = appZoneHistoryMap.find(processPath);
-        if (history != std::end(appZoneHistoryMap))
+        for (auto& data : *perDesktopData)
         {
-            auto& perDesktopData = history->second;
-            for (auto& data : perDesktopData)
+            if (data.deviceId == deviceId)
             {
-                if (data.deviceId == deviceId)
-                {
-                    DWORD processId = 0;
-                    GetWindowThreadProcessId(window, &processId);
+                DWORD processId = 0;
+                GetWindowThreadProcessId(window, &processId);
 
-                    auto processIdIt = data.processIdToHandleMap.find(processId);
+                auto processIdIt = data.processIdToHandleMap.find(processId);
 
-                    if (processIdIt == std::end(data.processIdToHandleMap))
-                    {
-                        return false;
-                    }
-                    else if (processIdIt->second != window && IsWindow(processIdIt->second))
-                    {
-                        return true;
-                    }
+                if (processIdIt == std::end(data.processIdToHandleMap))
+                {
+                    return false;
+                }
+                else if (processIdIt->second != window && IsWindow(processIdIt->second))
+                {
+                    return true;
                 }
             }
         }
@@ -352,22 +347,16 @@ bool FancyZonesData::IsAnotherWindowOfApplicationInstanceZoned(HWND window, cons
 void FancyZonesData::UpdateProcessIdToHandleMap(HWND window, const std::wstring_view& deviceId)
 {
     std::scoped_lock lock{ dataLock };
-    auto processPath = get_process_path(window);
-    if (!processPath.empty())
+    if (const auto perDesktopData = FindAppZoneHistory(window))
     {
-        auto history = appZoneHistoryMap.find(processPath);
-        if (history != std::end(appZoneHistoryMap))
+        for (auto& data : *perDesktopData)
         {
-            auto& perDesktopData = history->second;
-            for (auto& data : perDesktopData)
+            if (data.deviceId == deviceId)
             {
-                if (data.deviceId == deviceId)
-                {
-                    DWORD processId = 0;
-                    GetWindowThreadProcessId(window, &processId);
-                    data.processIdToHandleMap[processId] = window;
-                    break;
-                }
+                DWORD processId = 0;
+                GetWindowThreadProcessId(window, &processId);
+                data.processIdToHandleMap[processId] = window;
+                break;
             }
         }
     }
@@ -376,19 +365,13 @@ void FancyZonesData::UpdateProcessIdToHandleMap(HWND window, const std::wstring_
 std::vector<size_t> FancyZonesData::GetAppLastZoneIndexSet(HWND window, const std::wstring_view& deviceId, const std::wstring_view& zoneSetId) const
 {
     std::scoped_lock lock{ dataLock };
-    auto processPath = get_process_path(window);
-    if (!processPath.empty())
+    if (const auto perDesktopData = FindAppZoneHistory(window))
     {
-        auto history = appZoneHistoryMap.find(processPath);
-        if (history != std::end(appZoneHistoryMap))
+        for (const auto& data : *perDesktopData)
         {
-            const auto& perDesktopData = history->second;
-            for (const auto& data : perDesktopData)
+            if (data.zoneSetUuid == zoneSetId && data.deviceId == deviceId)
             {
-                if (data.zoneSetUuid == zoneSetId && data.deviceId == deviceId)
-                {
-                    return data.zoneIndexSet;
-                }
+                return data.zoneIndexSet;
             }
         }
     }
@@ -400,48 +383,45 @@ bool FancyZonesData::RemoveAppLastZone(HWND window, const std::wstring_view& dev
 {
     _TRACER_;
     std::scoped_lock lock{ dataLock };
-    auto processPath = get_process_path(window);
-    if (!processPath.empty())
+    const auto pathId = processPathCache.GetPathId(window);
+    if (const auto history = FindAppZoneHistory(pathId))
     {
-        auto history = appZoneHistoryMap.find(processPath);
-        if (history != std::end(appZoneHistoryMap))
+        auto& perDesktopData = *history;
+        for (auto data = std::begin(perDesktopData); data != std::end(perDesktopData);)
         {
-            auto& perDesktopData = history->second;
-            for (auto data = std::begin(perDesktopData); data != std::end(perDesktopData);)
+            if (data->deviceId == deviceId && data->zoneSetUuid == zoneSetId)
             {
-                if (data->deviceId == deviceId && data->zoneSetUuid == zoneSetId)
+                if (!IsAnotherWindowOfApplicationInstanceZoned(window, deviceId))
                 {
-                    if (!IsAnotherWindowOfApplicationInstanceZoned(window, deviceId))
-                    {
-                        DWORD processId = 0;
-                        GetWindowThreadProcessId(window, &processId);
-
-                        data->processIdToHandleMap.erase(processId);
-                    }
+                    DWORD processId = 0;
+                    GetWindowThreadProcessId(window, &processId);
 
-                    // if there is another instance of same application placed in the same zone don't erase history
-                    size_t windowZoneStamp = reinterpret_cast<size_t>(::GetProp(window, ZonedWindowProperties::PropertyMultipleZoneID));
-                    for (auto placedWindow : data->processIdToHandleMap)
-                    {
-                        size_t placedWindowZoneStamp = reinterpret_cast<size_t>(::GetProp(placedWindow.second, ZonedWindowProperties::PropertyMultipleZoneID));
-                        if (IsWindow(placedWindow.second) && (windowZoneStamp == placedWindowZoneStamp))
-                        {
-                            return false;
-                        }
-                    }
+                    data->processIdToHandleMap.erase(processId);
+                }
 
-                    data = perDesktopData.erase(data);
-                    if (perDesktopData.empty())
+                // if there is another instance of same application placed in the same zone don't erase history
+                size_t windowZoneStamp = reinterpret_cast<size_t>(::GetProp(window, ZonedWindowProperties::PropertyMultipleZoneID));
+                for (auto placedWindow : data->processIdToHandleMap)
+                {
+                    size_t placedWindowZoneStamp = reinterpret_cast<size_t>(::GetProp(placedWindow.second, ZonedWindowProperties::PropertyMultipleZoneID));
+                    if (IsWindow(placedWindow.second) && (windowZoneStamp == placedWindowZoneStamp))
                     {
-                        appZoneHistoryMap.erase(processPath);
+                        return false;
                     }
-                    SaveAppZoneHistory();
-                    return true;
                 }
-                else
+
+                data = perDesktopData.erase(data);
+                if (perDesktopData.empty())
                 {
-                    ++data;
+                    appZoneHistoryMap.erase(processPathCache.GetPath(pathId));
+                    appZoneHistoryIndex.erase(pathId);
                 }
+                appZoneHistoryWriter.Schedule();
+                return true;
+            }
+            else
+            {
+                ++data;
             }
         }
     }
@@ -459,8 +439,9 @@ bool FancyZonesData::SetAppLastZones(HWND window, const std::wstring& deviceId,
         return false;
     }
 
-    auto processPath = get_process_path(window);
-    if (processPath.empty())
+    // Already resolved by IsAnotherWindowOfApplicationInstanceZoned, so usually a cache hit
+    const auto pathId = processPathCache.GetPathId(window);
+    if (pathId == ProcessPathCache::EmptyPathId)
     {
         return false;
     }
@@ -468,11 +449,10 @@ bool FancyZonesData::SetAppLastZones(HWND window, const std::wstring& deviceId,
     DWORD processId = 0;
     GetWindowThreadProcessId(window, &processId);
 
-    auto history = appZoneHistoryMap.find(processPath);
-    if (history != std::end(appZoneHistoryMap))
+    const auto history = FindAppZoneHistory(pathId);
+    if (history)
     {
-        auto& perDesktopData = history->second;
-        for (auto& data : perDesktopData)
+        for (auto& data : *history)
         {
             if (data.deviceId == deviceId)
             {
@@ -480,7 +460,7 @@ bool FancyZonesData::SetAppLastZones(HWND window, const std::wstring& deviceId,
                 data.processIdToHandleMap[processId] = window;
                 data.zoneSetUuid = zoneSetId;
                 data.zoneIndexSet = zoneIndexSet;
-                SaveAppZoneHistory();
+                appZoneHistoryWriter.Schedule();
                 return true;
             }
         }
@@ -493,18 +473,20 @@ bool FancyZonesData::SetAppLastZones(HWND window, const std::wstring& deviceId,
                                                   .deviceId = deviceId,
                                                   .zoneIndexSet = zoneIndexSet };
 
-    if (appZoneHistoryMap.contains(processPath))
+    if (history)
     {
         // application already has history but on other desktop, add with new desktop info
-        appZoneHistoryMap[processPath].push_back(data);
+        history->push_back(data);
     }
     else
     {
         // new application, create entry in app zone history map
-        appZoneHistoryMap[processPath] = std::vector<FancyZonesDataTypes::AppZoneHistoryData>{ data };
+        auto& perDesktopData = appZoneHistoryMap[processPathCache.GetPath(pathId)];
+        perDesktopData = std::vector<FancyZonesDataTypes::AppZoneHistoryData>{ data };
+        appZoneHistoryIndex[pathId] = &perDesktopData;
     }
 
-    SaveAppZoneHistory();
+    appZoneHistoryWriter.Schedule();
     return true;
 }
 
@@ -541,6 +523,24 @@ void FancyZonesData::SetActiveZoneSet(const std::wstring& deviceId, const FancyZ
     }
 }
 
+void FancyZonesData::InvalidateCustomLayouts(const JSONHelpers::TCustomZoneSetsMap& customZoneSets)
+{
+    // The editor saves every custom layout when one of them changes, those are recalculated on their next use
+    auto& layoutCache = FancyZonesLayout::LayoutCacheInstance();
+    for (const auto& [uuid, data] : customZoneSetsMap)
+    {
+        layoutCache.Invalidate(uuid);
+    }
+    for (const auto& [uuid, data] : customZoneSets)
+    {
+        // Layouts not found before were cached as failed calculations
+        if (!customZoneSetsMap.contains(uuid))
+        {
+            layoutCache.Invalidate(uuid);
+        }
+    }
+}
+
 json::JsonObject FancyZonesData::GetPersistFancyZonesJSON()
 {
     return JSONHelpers::GetPersistFancyZonesJSON(zonesSettingsFileName, appZoneHistoryFileName);
@@ -557,8 +557,11 @@ void FancyZonesData::LoadFancyZonesData()
         json::JsonObject fancyZonesDataJSON = GetPersistFancyZonesJSON();
 
         appZoneHistoryMap = JSONHelpers::ParseAppZoneHistory(fancyZonesDataJSON);
+        UpdateAppZoneHistoryIndex();
         deviceInfoMap = JSONHelpers::ParseDeviceInfos(fancyZonesDataJSON);
-        customZoneSetsMap = JSONHelpers::ParseCustomZoneSets(fancyZonesDataJSON);
+        auto customZoneSets = JSONHelpers::ParseCustomZoneSets(fancyZonesDataJSON);
+        InvalidateCustomLayouts(customZoneSets);
+        customZoneSetsMap = std::move(customZoneSets);
         quickKeysMap = JSONHelpers::ParseQuickKeys(fancyZonesDataJSON);
     }
 }
@@ -573,14 +576,43 @@ void FancyZonesData::SaveZoneSettings() const
 {
     _TRACER_;
     std::scoped_lock lock{ dataLock };
-    JSONHelpers::SaveZoneSettings(zonesSettingsFileName, deviceInfoMap, customZoneSetsMap, quickKeysMap);
+    const auto contents = JSONHelpers::SaveZoneSettings(zonesSettingsFileName, deviceInfoMap, customZoneSetsMap, quickKeysMap);
+    if (contents && zoneSettingsSavedCallback)
+    {
+        zoneSettingsSavedCallback(*contents);
+    }
+}
+
+void FancyZonesData::SetZoneSettingsSavedCallback(std::function<void(std::string_view)> callback)
+{
+    std::scoped_lock lock{ dataLock };
+    zoneSettingsSavedCallback = std::move(callback);
 }
 
 void FancyZonesData::SaveAppZoneHistory() const
 {
     _TRACER_;
-    std::scoped_lock lock{ dataLock };
-    JSONHelpers::SaveAppZoneHistory(appZoneHistoryFileName, appZoneHistoryMap);
+    appZoneHistoryWriter.Flush();
+}
+
+void FancyZonesData::StopAppZoneHistoryWriter()
+{
+    appZoneHistoryWriter.Stop();
+}
+
+AppZoneHistoryWriter::Statistics FancyZonesData::GetAppZoneHistoryWriterStatistics() const
+{
+    return appZoneHistoryWriter.GetStatistics();
+}
+
+void FancyZonesData::InvalidateProcessPath(HWND window)
+{
+    processPathCache.InvalidateWindow(window);
+}
+
+ProcessPathCache::Statistics FancyZonesData::GetProcessPathCacheStatistics() const
+{
+    return processPathCache.GetStatistics();
 }
 
 void FancyZonesData::SaveFancyZonesEditorParameters(bool spanZonesAcrossMonitors, const std::wstring& virtualDesktopId, const HMONITOR& targetMonitor) const
@@ -672,4 +704,26 @@ void FancyZonesData::RemoveDesktopAppZoneHistory(const std::wstring& desktopId)
             ++it;
         }
     }
+
+    UpdateAppZoneHistoryIndex();
+}
+
+void FancyZonesData::UpdateAppZoneHistoryIndex()
+{
+    appZoneHistoryIndex.clear();
+    for (auto& [path, perDesktopData] : appZoneHistoryMap)
+    {
+        appZoneHistoryIndex[processPathCache.InternPath(path)] = &perDesktopData;
+    }
+}
+
+FancyZonesData::TAppZoneHistory* FancyZonesData::FindAppZoneHistory(ProcessPathCache::PathId pathId) const
+{
+    auto it = appZoneHistoryIndex.find(pathId);
+    return it != appZoneHistoryIndex.end() ? it->second : nullptr;
+}
+
+FancyZonesData::TAppZoneHistory* FancyZonesData::FindAppZoneHistory(HWND window) const
+{
+    return FindAppZoneHistory(processPathCache.GetPathId(window));
 }
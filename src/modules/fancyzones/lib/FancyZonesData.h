@@ -1,6 +1,9 @@
 #pragma once
 
+#include "AppZoneHistoryWriter.h"
 #include "JsonHelpers.h"
+#include "LayoutCache.h"
+#include "ProcessPathCache.h"
 
 #include <common/SettingsAPI/settings_helpers.h>
 #include <common/utils/json.h>
@@ -79,6 +82,17 @@ public:
     void SaveZoneSettings() const;
     void SaveAppZoneHistory() const;
 
+    // Called with the contents of the zones settings file each time FancyZones writes it
+    void SetZoneSettingsSavedCallback(std::function<void(std::string_view)> callback);
+
+    // Writes the pending app zone history changes and stops the background writer, on shutdown
+    void StopAppZoneHistoryWriter();
+    AppZoneHistoryWriter::Statistics GetAppZoneHistoryWriterStatistics() const;
+
+    // Called when a window is created or destroyed, as its handle may be reused by another process
+    void InvalidateProcessPath(HWND window);
+    ProcessPathCache::Statistics GetProcessPathCacheStatistics() const;
+
     void SaveFancyZonesEditorParameters(bool spanZonesAcrossMonitors, const std::wstring& virtualDesktopId, const HMONITOR& targetMonitor) const;
 
 private:
@@ -97,6 +111,7 @@ private:
     inline void SetCustomZonesets(const std::wstring& uuid, FancyZonesDataTypes::CustomZoneSetData data)
     {
         customZoneSetsMap[uuid] = data;
+        FancyZonesLayout::LayoutCacheInstance().Invalidate(uuid);
     }
 
     inline bool ParseDeviceInfos(const json::JsonObject& fancyZonesDataJSON)
@@ -108,8 +123,10 @@ private:
     inline void clear_data()
     {
         appZoneHistoryMap.clear();
+        appZoneHistoryIndex.clear();
         deviceInfoMap.clear();
         customZoneSetsMap.clear();
+        FancyZonesLayout::LayoutCacheInstance().Clear();
     }
 
     inline void SetSettingsModulePath(std::wstring_view moduleName)
@@ -117,12 +134,22 @@ private:
         std::wstring result = PTSettingsHelper::get_module_save_folder_location(moduleName);
         zonesSettingsFileName = result + L"\\" + std::wstring(L"zones-settings.json");
         appZoneHistoryFileName = result + L"\\" + std::wstring(L"app-zone-history.json");
+        appZoneHistoryWriter.SetFileName(appZoneHistoryFileName);
     }
 #endif
+    using TAppZoneHistory = std::vector<FancyZonesDataTypes::AppZoneHistoryData>;
+
     void RemoveDesktopAppZoneHistory(const std::wstring& desktopId);
+    void UpdateAppZoneHistoryIndex();
+    void InvalidateCustomLayouts(const JSONHelpers::TCustomZoneSetsMap& customZoneSets);
+    TAppZoneHistory* FindAppZoneHistory(ProcessPathCache::PathId pathId) const;
+    TAppZoneHistory* FindAppZoneHistory(HWND window) const;
 
     // Maps app path to app's zone history data
-    std::unordered_map<std::wstring, std::vector<FancyZonesDataTypes::AppZoneHistoryData>> appZoneHistoryMap{};
+    std::unordered_map<std::wstring, TAppZoneHistory> appZoneHistoryMap{};
+    // Maps the interned app path to the app's entry in appZoneHistoryMap
+    std::unordered_map<ProcessPathCache::PathId, TAppZoneHistory*> appZoneHistoryIndex{};
+    mutable ProcessPathCache processPathCache;
     // Maps device unique ID to device data
     JSONHelpers::TDeviceInfoMap deviceInfoMap{};
     // Maps custom zoneset UUID to it's data
@@ -134,7 +161,12 @@ private:
     std::wstring appZoneHistoryFileName;
     std::wstring editorParametersFileName;
 
+    std::function<void(std::string_view)> zoneSettingsSavedCallback;
+
     mutable std::recursive_mutex dataLock;
+
+    // Declared last, so that it is stopped while the data is still there
+    mutable AppZoneHistoryWriter appZoneHistoryWriter;
 };
 
 FancyZonesData& FancyZonesDataInstance();
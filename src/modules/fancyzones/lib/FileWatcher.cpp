@@ -1,68 +1,406 @@
-#include "pch.h"
+// Built without the precompiled header, see FileWatcher.h
 #include "FileWatcher.h"
 
-std::optional<FILETIME> FileWatcher::MyFileTime()
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <atomic>
+#include <unordered_map>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Blocks until a watched directory changes. Directories are identified by the order they were added in.
+class DirectoryChangeNotifier
+{
+public:
+    DirectoryChangeNotifier();
+    ~DirectoryChangeNotifier();
+
+    bool Valid() const noexcept;
+    bool AddDirectory(const std::filesystem::path& directory);
+
+    // Waits for changes until the timeout, returns false once stopped
+    bool Wait(std::optional<std::chrono::milliseconds> timeout, std::vector<size_t>& changed);
+    void Stop();
+
+private:
+    std::mutex m_mutex;
+#ifdef _WIN32
+    HANDLE m_stopEvent;
+    // Signaled when a directory is added, so that the waiting thread waits on it as well
+    HANDLE m_wakeEvent;
+    std::vector<HANDLE> m_directories;
+#else
+    int m_inotify;
+    int m_wakeEvent;
+    std::atomic<bool> m_stopped = false;
+    std::unordered_map<int, size_t> m_directories;
+    size_t m_directoryCount = 0;
+#endif
+};
+
+#ifdef _WIN32
+DirectoryChangeNotifier::DirectoryChangeNotifier() :
+    m_stopEvent(CreateEventW(nullptr, TRUE, FALSE, nullptr)),
+    m_wakeEvent(CreateEventW(nullptr, FALSE, FALSE, nullptr))
+{
+}
+
+DirectoryChangeNotifier::~DirectoryChangeNotifier()
+{
+    for (HANDLE directory : m_directories)
+    {
+        FindCloseChangeNotification(directory);
+    }
+
+    if (m_wakeEvent)
+    {
+        CloseHandle(m_wakeEvent);
+    }
+
+    if (m_stopEvent)
+    {
+        CloseHandle(m_stopEvent);
+    }
+}
+
+bool DirectoryChangeNotifier::Valid() const noexcept
+{
+    return m_stopEvent != nullptr && m_wakeEvent != nullptr;
+}
+
+bool DirectoryChangeNotifier::AddDirectory(const std::filesystem::path& directory)
+{
+    std::scoped_lock lock{ m_mutex };
+
+    // The stop and wake events take two of the wait slots
+    if (m_directories.size() + 2 >= MAXIMUM_WAIT_OBJECTS)
+    {
+        return false;
+    }
+
+    HANDLE handle = FindFirstChangeNotificationW(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    m_directories.push_back(handle);
+    SetEvent(m_wakeEvent);
+    return true;
+}
+
+bool DirectoryChangeNotifier::Wait(std::optional<std::chrono::milliseconds> timeout, std::vector<size_t>& changed)
+{
+    std::vector<HANDLE> handles{ m_stopEvent, m_wakeEvent };
+    {
+        std::scoped_lock lock{ m_mutex };
+        handles.insert(handles.end(), m_directories.begin(), m_directories.end());
+    }
+
+    const DWORD milliseconds = timeout ? static_cast<DWORD>(timeout->count()) : INFINITE;
+    const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, milliseconds);
+    if (result == WAIT_OBJECT_0 || result == WAIT_FAILED)
+    {
+        return false;
+    }
+
+    if (result >= WAIT_OBJECT_0 + 2 && result < WAIT_OBJECT_0 + handles.size())
+    {
+        const size_t index = result - WAIT_OBJECT_0;
+        changed.push_back(index - 2);
+        FindNextChangeNotification(handles[index]);
+    }
+
+    return true;
+}
+
+void DirectoryChangeNotifier::Stop()
+{
+    SetEvent(m_stopEvent);
+}
+#else
+DirectoryChangeNotifier::DirectoryChangeNotifier() :
+    m_inotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+    m_wakeEvent(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+}
+
+DirectoryChangeNotifier::~DirectoryChangeNotifier()
+{
+    if (m_wakeEvent >= 0)
+    {
+        close(m_wakeEvent);
+    }
+
+    if (m_inotify >= 0)
+    {
+        close(m_inotify);
+    }
+}
+
+bool DirectoryChangeNotifier::Valid() const noexcept
 {
-    HANDLE hFile = CreateFileW(m_path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
-    std::optional<FILETIME> result;
-    if (hFile != INVALID_HANDLE_VALUE)
+    return m_inotify >= 0 && m_wakeEvent >= 0;
+}
+
+bool DirectoryChangeNotifier::AddDirectory(const std::filesystem::path& directory)
+{
+    std::scoped_lock lock{ m_mutex };
+    const int watch = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM);
+    if (watch < 0)
+    {
+        return false;
+    }
+
+    m_directories[watch] = m_directoryCount++;
+    return true;
+}
+
+bool DirectoryChangeNotifier::Wait(std::optional<std::chrono::milliseconds> timeout, std::vector<size_t>& changed)
+{
+    pollfd descriptors[] = { { m_wakeEvent, POLLIN, 0 }, { m_inotify, POLLIN, 0 } };
+    if (poll(descriptors, 2, timeout ? static_cast<int>(timeout->count()) : -1) < 0)
+    {
+        return !m_stopped;
+    }
+
+    if (descriptors[0].revents & POLLIN)
+    {
+        uint64_t count;
+        [[maybe_unused]] const auto bytes = read(m_wakeEvent, &count, sizeof(count));
+    }
+
+    if (m_stopped)
     {
-        FILETIME lastWrite;
-        if (GetFileTime(hFile, nullptr, nullptr, &lastWrite))
+        return false;
+    }
+
+    if (descriptors[1].revents & POLLIN)
+    {
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
         {
-            result = lastWrite;
+            std::scoped_lock lock{ m_mutex };
+            for (char* event = buffer; event < buffer + length;)
+            {
+                const auto* notification = reinterpret_cast<const inotify_event*>(event);
+                if (auto it = m_directories.find(notification->wd); it != m_directories.end())
+                {
+                    changed.push_back(it->second);
+                }
+                event += sizeof(inotify_event) + notification->len;
+            }
         }
+    }
+
+    return true;
+}
+
+void DirectoryChangeNotifier::Stop()
+{
+    m_stopped = true;
+    const uint64_t count = 1;
+    [[maybe_unused]] const auto bytes = write(m_wakeEvent, &count, sizeof(count));
+}
+#endif
 
-        CloseHandle(hFile);
+FileWatcher::FileWatcher(std::chrono::milliseconds debounce) :
+    m_debounce(debounce),
+    m_notifier(std::make_unique<DirectoryChangeNotifier>())
+{
+    if (m_notifier->Valid())
+    {
+        m_thread = std::thread([this]() { Run(); });
     }
+}
 
-    return result;
+FileWatcher::FileWatcher(const std::wstring& path, Callback callback, std::chrono::milliseconds debounce) :
+    FileWatcher(debounce)
+{
+    Watch(path, std::move(callback));
 }
 
-void FileWatcher::Run()
+FileWatcher::~FileWatcher()
+{
+    if (m_thread.joinable())
+    {
+        m_notifier->Stop();
+        m_thread.join();
+    }
+}
+
+bool FileWatcher::Watch(const std::wstring& path, Callback callback)
 {
-    while (1)
+    if (!m_thread.joinable())
+    {
+        return false;
+    }
+
+    const std::filesystem::path filePath = std::filesystem::absolute(std::filesystem::path{ path });
+    Hash hash = ReadHash(filePath);
+
+    std::scoped_lock lock{ m_mutex };
+    const auto directory = std::find(m_directories.begin(), m_directories.end(), filePath.parent_path());
+    const size_t directoryIndex = static_cast<size_t>(std::distance(m_directories.begin(), directory));
+    if (directory == m_directories.end())
     {
-        auto lastWrite = MyFileTime();
-        if (!m_lastWrite.has_value())
+        if (!m_notifier->AddDirectory(filePath.parent_path()))
         {
-            m_lastWrite = lastWrite;
+            return false;
         }
-        else if (lastWrite.has_value())
+        m_directories.push_back(filePath.parent_path());
+    }
+
+    m_files.push_back(File{ .path = filePath, .directory = directoryIndex, .callback = std::move(callback), .hash = hash, .deadline = std::nullopt });
+    return true;
+}
+
+void FileWatcher::SetKnownContents(const std::wstring& path, std::string_view contents)
+{
+    const std::filesystem::path filePath = std::filesystem::absolute(std::filesystem::path{ path });
+    const uint64_t hash = HashContents(contents);
+
+    std::scoped_lock lock{ m_mutex };
+    for (auto& file : m_files)
+    {
+        if (file.path == filePath)
         {
-            if (m_lastWrite->dwHighDateTime != lastWrite->dwHighDateTime ||
-                m_lastWrite->dwLowDateTime != lastWrite->dwLowDateTime)
-            {
-                m_lastWrite = lastWrite;
-                m_callback();
-            }
+            file.hash = hash;
         }
+    }
+}
+
+FileWatcher::Statistics FileWatcher::GetStatistics() const
+{
+    std::scoped_lock lock{ m_mutex };
+    return m_statistics;
+}
 
-        if (WaitForSingleObject(m_abortEvent, m_refreshPeriod) == WAIT_OBJECT_0)
+FileWatcher::Hash FileWatcher::ReadHash(const std::filesystem::path& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    std::string contents{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+    return HashContents(contents);
+}
+
+uint64_t FileWatcher::HashContents(std::string_view contents) noexcept
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : contents)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void FileWatcher::Run()
+{
+    std::vector<size_t> changedDirectories;
+    while (m_notifier->Wait(NextTimeout(), changedDirectories))
+    {
+        if (!changedDirectories.empty())
         {
-            return;
+            // The check waits for the changes to settle, an editor saving a file makes several
+            const auto deadline = std::chrono::steady_clock::now() + m_debounce;
+
+            std::scoped_lock lock{ m_mutex };
+            m_statistics.notifications += changedDirectories.size();
+            for (auto& file : m_files)
+            {
+                if (std::find(changedDirectories.begin(), changedDirectories.end(), file.directory) != changedDirectories.end())
+                {
+                    file.deadline = deadline;
+                }
+            }
+            changedDirectories.clear();
         }
+
+        CheckFiles();
     }
 }
 
-FileWatcher::FileWatcher(const std::wstring& path, std::function<void()> callback, DWORD refreshPeriod) :
-    m_refreshPeriod(refreshPeriod),
-    m_path(path),
-    m_callback(callback)
+std::optional<std::chrono::milliseconds> FileWatcher::NextTimeout()
 {
-    m_abortEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
-    if (m_abortEvent)
+    std::scoped_lock lock{ m_mutex };
+    std::optional<std::chrono::steady_clock::time_point> next;
+    for (const auto& file : m_files)
     {
-        m_thread = std::thread([this]() { Run(); });
+        if (file.deadline && (!next || *file.deadline < *next))
+        {
+            next = file.deadline;
+        }
     }
+
+    if (!next)
+    {
+        return std::nullopt;
+    }
+
+    // Rounded up, so that the files are due when the wait ends
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*next - std::chrono::steady_clock::now());
+    return (std::max)(remaining, std::chrono::milliseconds{ 0 });
 }
 
-FileWatcher::~FileWatcher()
+void FileWatcher::CheckFiles()
 {
-    if (m_abortEvent)
+    const auto now = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<size_t, std::filesystem::path>> dueFiles;
     {
-        SetEvent(m_abortEvent);
-        m_thread.join();
-        CloseHandle(m_abortEvent);
+        std::scoped_lock lock{ m_mutex };
+        for (size_t i = 0; i < m_files.size(); ++i)
+        {
+            if (m_files[i].deadline && *m_files[i].deadline <= now)
+            {
+                m_files[i].deadline.reset();
+                dueFiles.emplace_back(i, m_files[i].path);
+            }
+        }
+    }
+
+    // The files are read without the lock, SetKnownContents may be called while a file is written
+    std::vector<Callback> callbacks;
+    for (const auto& [index, path] : dueFiles)
+    {
+        const Hash hash = ReadHash(path);
+
+        std::scoped_lock lock{ m_mutex };
+        ++m_statistics.checks;
+        if (hash == m_files[index].hash)
+        {
+            ++m_statistics.unchanged;
+            continue;
+        }
+
+        m_files[index].hash = hash;
+        callbacks.push_back(m_files[index].callback);
+        ++m_statistics.callbacks;
+    }
+
+    for (const auto& callback : callbacks)
+    {
+        callback();
     }
 }
@@ -1,19 +1,94 @@
 #pragma once
 
-#include "pch.h"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
+class DirectoryChangeNotifier;
+
+/**
+ * Calls back when the contents of watched files change, on one thread for all of the files.
+ *
+ * The thread sleeps until the system reports a change in the directory of a watched file: a directory
+ * change notification on Windows, inotify on Linux. Changes are debounced, as an editor saving a file
+ * makes several of them, and the callback is only called when the hash of the contents changed. Files
+ * written by this process are announced with SetKnownContents, so that they are not reloaded.
+ *
+ * Builds without the precompiled header and runs on Linux, see tests/FileWatcher.
+ */
 class FileWatcher
 {
-    DWORD m_refreshPeriod;
-    std::wstring m_path;
-    std::optional<FILETIME> m_lastWrite;
-    std::function<void()> m_callback;
-    HANDLE m_abortEvent;
-    std::thread m_thread;
-    
-    std::optional<FILETIME> MyFileTime();
-    void Run();
 public:
-    FileWatcher(const std::wstring& path, std::function<void()> callback, DWORD refreshPeriod = 1000);
+    using Callback = std::function<void()>;
+
+    struct Statistics
+    {
+        // Directory changes reported by the system
+        size_t notifications = 0;
+        // Files read after a change, once the debounce period ended
+        size_t checks = 0;
+        // Checks that found the known contents
+        size_t unchanged = 0;
+        size_t callbacks = 0;
+    };
+
+    static constexpr std::chrono::milliseconds DefaultDebounce{ 50 };
+
+    explicit FileWatcher(std::chrono::milliseconds debounce = DefaultDebounce);
+    FileWatcher(const std::wstring& path, Callback callback, std::chrono::milliseconds debounce = DefaultDebounce);
     ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /**
+     * Watch a file, which does not need to exist yet.
+     * @returns False if the directory of the file cannot be watched.
+     */
+    bool Watch(const std::wstring& path, Callback callback);
+
+    /**
+     * Set the contents of a file written by this process, a change to these contents does not call back.
+     */
+    void SetKnownContents(const std::wstring& path, std::string_view contents);
+
+    Statistics GetStatistics() const;
+
+private:
+    using Hash = std::optional<uint64_t>;
+
+    struct File
+    {
+        std::filesystem::path path;
+        size_t directory;
+        Callback callback;
+        // Hash of the last contents seen or announced, empty while the file does not exist
+        Hash hash;
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+    };
+
+    static Hash ReadHash(const std::filesystem::path& path);
+    static uint64_t HashContents(std::string_view contents) noexcept;
+
+    void Run();
+    std::optional<std::chrono::milliseconds> NextTimeout();
+    void CheckFiles();
+
+    const std::chrono::milliseconds m_debounce;
+    std::unique_ptr<DirectoryChangeNotifier> m_notifier;
+
+    mutable std::mutex m_mutex;
+    std::vector<File> m_files;
+    std::vector<std::filesystem::path> m_directories;
+    Statistics m_statistics;
+
+    std::thread m_thread;
 };
@@ -562,7 +562,7 @@ namespace JSONHelpers
         }
     }
 
-    void SaveZoneSettings(const std::wstring& zonesSettingsFileName, const TDeviceInfoMap& deviceInfoMap, const TCustomZoneSetsMap& customZoneSetsMap, const TLayoutQuickKeysMap& quickKeysMap)
+    std::optional<std::string> SaveZoneSettings(const std::wstring& zonesSettingsFileName, const TDeviceInfoMap& deviceInfoMap, const TCustomZoneSetsMap& customZoneSetsMap, const TLayoutQuickKeysMap& quickKeysMap)
     {
         auto before = json::from_file(zonesSettingsFileName);
 
@@ -589,21 +589,51 @@ namespace JSONHelpers
         if (!before.has_value() || before.value().Stringify() != root.Stringify())
         {
             Trace::FancyZones::DataChanged();
-            json::to_file(zonesSettingsFileName, root);
+            std::string contents = winrt::to_string(root.Stringify());
+            json::native::to_file(zonesSettingsFileName, contents);
+            return contents;
         }
+
+        return std::nullopt;
     }
 
-    void SaveAppZoneHistory(const std::wstring& appZoneHistoryFileName, const TAppZoneHistoryMap& appZoneHistoryMap)
+    std::string SerializeAppZoneHistoryFile(const TAppZoneHistoryMap& appZoneHistoryMap)
     {
-        json::JsonObject root{};
-
-        root.SetNamedValue(NonLocalizable::AppZoneHistoryStr, JSONHelpers::SerializeAppZoneHistory(appZoneHistoryMap));
-
-        auto before = json::from_file(appZoneHistoryFileName);
-        if (!before.has_value() || before.value().Stringify() != root.Stringify())
+        // Written with json::native, same layout as AppZoneHistoryJSON::ToJson
+        json::native::Writer writer;
+        writer.StartObject();
+        writer.Key(NonLocalizable::AppZoneHistoryStr);
+        writer.StartArray();
+        for (const auto& [appPath, appZoneHistoryData] : appZoneHistoryMap)
         {
-            json::to_file(appZoneHistoryFileName, root);
+            writer.StartObject();
+            writer.Key(NonLocalizable::AppPathStr);
+            writer.String(appPath);
+            writer.Key(NonLocalizable::HistoryStr);
+            writer.StartArray();
+            for (const auto& data : appZoneHistoryData)
+            {
+                writer.StartObject();
+                writer.Key(NonLocalizable::ZoneIndexSetStr);
+                writer.StartArray();
+                for (size_t index : data.zoneIndexSet)
+                {
+                    writer.Number(static_cast<int64_t>(index));
+                }
+                writer.EndArray();
+                writer.Key(NonLocalizable::DeviceIdStr);
+                writer.String(data.deviceId);
+                writer.Key(NonLocalizable::ZoneSetUuidStr);
+                writer.String(data.zoneSetUuid);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
         }
+        writer.EndArray();
+        writer.EndObject();
+
+        return writer.Release();
     }
 
     TAppZoneHistoryMap ParseAppZoneHistory(const json::JsonObject& fancyZonesDataJSON)
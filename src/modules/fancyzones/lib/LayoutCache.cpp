@@ -0,0 +1,82 @@
+// Built without the precompiled header, see LayoutCache.h
+#include "LayoutCache.h"
+
+#include <algorithm>
+
+namespace FancyZonesLayout
+{
+    LayoutCache::LayoutCache(size_t capacity) noexcept :
+        m_capacity(std::max<size_t>(capacity, 1))
+    {
+    }
+
+    LayoutCache::Result LayoutCache::GetOrCalculate(const LayoutKey& key, const Calculation& calculate)
+    {
+        uint64_t generation;
+        {
+            std::scoped_lock lock{ m_mutex };
+            if (auto entry = m_entries.find(key); entry != m_entries.end())
+            {
+                ++m_statistics.hits;
+                entry->second.lastUse = ++m_useCounter;
+                return entry->second.result;
+            }
+
+            ++m_statistics.misses;
+            generation = m_generation;
+        }
+
+        // Calculated without the lock, custom layouts are read from the settings, which may invalidate the cache
+        auto layout = std::make_shared<ZoneSetLayout>(key.sensitivityRadius, key.selectionAlgorithm);
+        Result result{ .layout = layout, .success = calculate(*layout) };
+        layout->UpdateIndexes();
+
+        std::scoped_lock lock{ m_mutex };
+        if (generation != m_generation)
+        {
+            return result;
+        }
+
+        if (m_entries.size() >= m_capacity && !m_entries.contains(key))
+        {
+            auto leastRecentlyUsed = std::min_element(m_entries.begin(), m_entries.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.second.lastUse < rhs.second.lastUse;
+            });
+            m_entries.erase(leastRecentlyUsed);
+        }
+
+        // Another thread may have calculated the same layout meanwhile, its result is kept
+        auto [entry, inserted] = m_entries.try_emplace(key, Entry{ .result = result, .lastUse = ++m_useCounter });
+        m_statistics.entries = m_entries.size();
+        return entry->second.result;
+    }
+
+    void LayoutCache::Invalidate(const std::wstring& customLayoutId)
+    {
+        std::scoped_lock lock{ m_mutex };
+        ++m_generation;
+        std::erase_if(m_entries, [&customLayoutId](const auto& entry) { return entry.first.customLayoutId == customLayoutId; });
+        ++m_statistics.invalidations;
+        m_statistics.entries = m_entries.size();
+    }
+
+    void LayoutCache::Clear()
+    {
+        std::scoped_lock lock{ m_mutex };
+        ++m_generation;
+        m_entries.clear();
+        m_statistics.entries = 0;
+    }
+
+    LayoutCache::Statistics LayoutCache::GetStatistics() const
+    {
+        std::scoped_lock lock{ m_mutex };
+        return m_statistics;
+    }
+
+    LayoutCache& LayoutCacheInstance()
+    {
+        static LayoutCache instance;
+        return instance;
+    }
+}
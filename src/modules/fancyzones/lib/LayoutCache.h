@@ -0,0 +1,101 @@
+#pragma once
+
+#include "ZoneSetLayout.h"
+
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace FancyZonesLayout
+{
+    // Everything the zones of a layout depend on
+    struct LayoutKey
+    {
+        // Id of a custom layout, empty for the predefined layouts, which only depend on the other fields
+        std::wstring customLayoutId;
+        // FancyZonesDataTypes::ZoneSetLayoutType
+        int layoutType = 0;
+        int zoneCount = 0;
+        int spacing = 0;
+        // The zones are relative to the work area, so work areas of the same size share them
+        int workAreaWidth = 0;
+        int workAreaHeight = 0;
+        // Canvas layouts are scaled to the DPI of the monitor, 0 for the other layouts
+        unsigned int dpi = 0;
+        int sensitivityRadius = 0;
+        SelectionAlgorithm selectionAlgorithm = SelectionAlgorithm::Smallest;
+
+        auto operator<=>(const LayoutKey&) const = default;
+    };
+
+    /**
+     * Zones of the layouts computed so far. The same layout on monitors of the same size, and on every
+     * virtual desktop, is computed once and shared: the layouts are immutable, with their hit-testing
+     * index and navigation graph built. Custom layouts are invalidated when they are edited.
+     *
+     * Builds without the precompiled header, see tests/LayoutEngine.
+     */
+    class LayoutCache
+    {
+    public:
+        struct Result
+        {
+            std::shared_ptr<const ZoneSetLayout> layout;
+            // Value returned by the calculation
+            bool success = false;
+        };
+
+        struct Statistics
+        {
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t invalidations = 0;
+            size_t entries = 0;
+
+            double HitRate() const noexcept { return hits + misses ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+        };
+
+        // Fills an empty layout, constructed with the sensitivity radius and selection algorithm of the key
+        using Calculation = std::function<bool(ZoneSetLayout&)>;
+
+        static constexpr size_t DefaultCapacity = 64;
+
+        explicit LayoutCache(size_t capacity = DefaultCapacity) noexcept;
+
+        /**
+         * Layout of the key, calculated if it is not cached. The least recently used layout is dropped
+         * when the cache is full.
+         */
+        Result GetOrCalculate(const LayoutKey& key, const Calculation& calculate);
+
+        /**
+         * Drop the layouts of a custom layout, after it changed or was deleted.
+         */
+        void Invalidate(const std::wstring& customLayoutId);
+        void Clear();
+
+        Statistics GetStatistics() const;
+
+    private:
+        struct Entry
+        {
+            Result result;
+            uint64_t lastUse;
+        };
+
+        const size_t m_capacity;
+
+        mutable std::mutex m_mutex;
+        std::map<LayoutKey, Entry> m_entries;
+        uint64_t m_useCounter = 0;
+        // Incremented by the invalidations, a layout calculated meanwhile may be stale and is not cached
+        uint64_t m_generation = 0;
+        Statistics m_statistics;
+    };
+
+    LayoutCache& LayoutCacheInstance();
+}
@@ -0,0 +1,113 @@
+#include "pch.h"
+
+#include "ProcessPathCache.h"
+
+#include <common/utils/process_path.h>
+
+namespace NonLocalizable
+{
+    const wchar_t ApplicationFrameHost[] = L"ApplicationFrameHost.exe";
+}
+
+ProcessPathCache::ProcessPathCache(size_t capacity) :
+    m_capacity(capacity)
+{
+    m_paths.emplace_back();
+    m_pathIds[L""] = EmptyPathId;
+}
+
+ProcessPathCache::PathId ProcessPathCache::GetPathId(HWND window)
+{
+    DWORD processId = 0;
+    GetWindowThreadProcessId(window, &processId);
+
+    {
+        std::scoped_lock lock{ m_mutex };
+        auto it = m_windows.find(window);
+        if (it != m_windows.end())
+        {
+            if (it->second.processId == processId)
+            {
+                ++m_statistics.hits;
+                m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+                return it->second.pathId;
+            }
+
+            // The handle was reused by another process
+            m_lru.erase(it->second.lruPosition);
+            m_windows.erase(it);
+        }
+        ++m_statistics.misses;
+    }
+
+    // Query the process without holding the lock
+    const std::wstring path = get_process_path(window);
+
+    std::scoped_lock lock{ m_mutex };
+    const PathId pathId = InternPathLocked(path);
+
+    // A UWP app window is only found once the frame host has a child window of the app,
+    // and the process cannot be queried before it is fully started.
+    if (path.empty() || path.ends_with(NonLocalizable::ApplicationFrameHost) || m_windows.contains(window))
+    {
+        return pathId;
+    }
+
+    m_lru.push_front(window);
+    m_windows[window] = Entry{ .processId = processId, .pathId = pathId, .lruPosition = m_lru.begin() };
+
+    if (m_windows.size() > m_capacity)
+    {
+        m_windows.erase(m_lru.back());
+        m_lru.pop_back();
+        ++m_statistics.evictions;
+    }
+
+    return pathId;
+}
+
+ProcessPathCache::PathId ProcessPathCache::InternPath(const std::wstring& path)
+{
+    std::scoped_lock lock{ m_mutex };
+    return InternPathLocked(path);
+}
+
+std::wstring ProcessPathCache::GetPath(PathId id) const
+{
+    std::scoped_lock lock{ m_mutex };
+    return id < m_paths.size() ? m_paths[id] : std::wstring{};
+}
+
+void ProcessPathCache::InvalidateWindow(HWND window)
+{
+    std::scoped_lock lock{ m_mutex };
+    auto it = m_windows.find(window);
+    if (it != m_windows.end())
+    {
+        m_lru.erase(it->second.lruPosition);
+        m_windows.erase(it);
+    }
+}
+
+void ProcessPathCache::Clear()
+{
+    std::scoped_lock lock{ m_mutex };
+    m_windows.clear();
+    m_lru.clear();
+}
+
+ProcessPathCache::Statistics ProcessPathCache::GetStatistics() const
+{
+    std::scoped_lock lock{ m_mutex };
+    return m_statistics;
+}
+
+ProcessPathCache::PathId ProcessPathCache::InternPathLocked(const std::wstring& path)
+{
+    auto [it, inserted] = m_pathIds.try_emplace(path, static_cast<PathId>(m_paths.size()));
+    if (inserted)
+    {
+        m_paths.push_back(path);
+    }
+    return it->second;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Process paths of windows, cached by window handle and process id.
+ *
+ * Paths are interned as small integer ids, so that the app zone history can be looked up by id.
+ * The window entries are evicted in least recently used order past the capacity, and invalidated
+ * when a window is created or destroyed, as handles get reused. The process id is checked on
+ * every lookup, which does not need to open the process.
+ */
+class ProcessPathCache
+{
+public:
+    using PathId = uint32_t;
+
+    // Id of the empty path, for windows whose process could not be queried
+    static constexpr PathId EmptyPathId = 0;
+    static constexpr size_t DefaultCapacity = 256;
+
+    struct Statistics
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+    };
+
+    explicit ProcessPathCache(size_t capacity = DefaultCapacity);
+
+    /**
+     * @returns Id of the process path of the window, resolved with get_process_path on a miss.
+     */
+    PathId GetPathId(HWND window);
+
+    /**
+     * @returns Id of a path, such as a path read from the app zone history file.
+     */
+    PathId InternPath(const std::wstring& path);
+
+    std::wstring GetPath(PathId id) const;
+
+    void InvalidateWindow(HWND window);
+    void Clear();
+
+    Statistics GetStatistics() const;
+
+private:
+    struct Entry
+    {
+        DWORD processId;
+        PathId pathId;
+        std::list<HWND>::iterator lruPosition;
+    };
+
+    PathId InternPathLocked(const std::wstring& path);
+
+    const size_t m_capacity;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<HWND, Entry> m_windows;
+    // Most recently used window first
+    std::list<HWND> m_lru;
+    std::unordered_map<std::wstring, PathId> m_pathIds;
+    // Path of each id, never shrinks
+    std::deque<std::wstring> m_paths;
+
+    Statistics m_statistics;
+};
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "ZoneGeometry.h"
+
 namespace ZoneConstants
 {
-    constexpr int MAX_NEGATIVE_SPACING = -10;
+    constexpr int MAX_NEGATIVE_SPACING = FancyZonesLayout::MaxNegativeSpacing;
 }
 
 /**
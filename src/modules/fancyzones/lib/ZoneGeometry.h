@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+// Plain geometry types of the zone layout engine. They only need the standard library, so that the
+// layout computations build and run without the Windows SDK (see ZoneSetLayout.h).
+namespace FancyZonesLayout
+{
+    // Same layout as RECT: the right and bottom edges are outside the rectangle.
+    struct Rect
+    {
+        int left;
+        int top;
+        int right;
+        int bottom;
+
+        int width() const noexcept { return right - left; }
+        int height() const noexcept { return bottom - top; }
+    };
+
+    // Same layout as POINT
+    struct Point
+    {
+        int x;
+        int y;
+    };
+
+    struct Zone
+    {
+        size_t id;
+        Rect rect;
+    };
+
+    enum class Direction
+    {
+        Left,
+        Up,
+        Right,
+        Down
+    };
+
+    // Zones may start slightly outside the work area, when the spacing is negative
+    constexpr int MaxNegativeSpacing = -10;
+
+    inline bool IsValidZoneRect(const Rect& rect) noexcept
+    {
+        return rect.left >= MaxNegativeSpacing &&
+               rect.right >= MaxNegativeSpacing &&
+               rect.top >= MaxNegativeSpacing &&
+               rect.bottom >= MaxNegativeSpacing &&
+               rect.width() >= 0 && rect.height() >= 0;
+    }
+}
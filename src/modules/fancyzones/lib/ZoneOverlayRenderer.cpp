@@ -0,0 +1,302 @@
+#include "pch.h"
+#include "ZoneOverlayRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace NonLocalizable
+{
+    const wchar_t SegoeUiFont[] = L"Segoe ui";
+    const wchar_t LabelLocale[] = L"en-US";
+}
+
+namespace
+{
+    constexpr float LabelFontSize = 80.f;
+
+    // Redrawing this many regions costs about as much as the whole overlay
+    constexpr size_t MaxDirtyRects = 8;
+
+    constexpr D2D1_COLOR_F LabelColor{ 0.f, 0.f, 0.f, 1.f };
+    constexpr D2D1_COLOR_F Transparent{ 0.f, 0.f, 0.f, 0.f };
+
+    uint32_t ColorKey(const D2D1_COLOR_F& color) noexcept
+    {
+        auto channel = [](float value) { return static_cast<uint32_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f)); };
+        return (channel(color.r) << 24) | (channel(color.g) << 16) | (channel(color.b) << 8) | channel(color.a);
+    }
+
+    bool operator==(const D2D1_RECT_F& lhs, const D2D1_RECT_F& rhs) noexcept
+    {
+        return lhs.left == rhs.left && lhs.top == rhs.top && lhs.right == rhs.right && lhs.bottom == rhs.bottom;
+    }
+
+    bool IsSame(const ZoneOverlayRenderer::DrawableRect& lhs, const ZoneOverlayRenderer::DrawableRect& rhs) noexcept
+    {
+        return lhs.id == rhs.id && lhs.rect == rhs.rect &&
+               ColorKey(lhs.borderColor) == ColorKey(rhs.borderColor) &&
+               ColorKey(lhs.fillColor) == ColorKey(rhs.fillColor);
+    }
+
+    // Region covered by a zone, the border straddles the edges of the rect
+    D2D1_RECT_F Bounds(const D2D1_RECT_F& rect) noexcept
+    {
+        return D2D1::RectF(std::floor(rect.left) - 1.f, std::floor(rect.top) - 1.f, std::ceil(rect.right) + 1.f, std::ceil(rect.bottom) + 1.f);
+    }
+
+    bool Intersects(const D2D1_RECT_F& lhs, const D2D1_RECT_F& rhs) noexcept
+    {
+        return lhs.left < rhs.right && rhs.left < lhs.right && lhs.top < rhs.bottom && rhs.top < lhs.bottom;
+    }
+}
+
+void ZoneOverlayRenderer::SetScene(std::vector<DrawableRect> rects)
+{
+    // Zones are matched by id, highlighting a zone moves it to the end of the scene
+    std::map<size_t, const DrawableRect*> previousRects;
+    for (const auto& drawableRect : m_sceneRects)
+    {
+        previousRects[drawableRect.id] = &drawableRect;
+    }
+
+    for (const auto& drawableRect : rects)
+    {
+        if (m_fullRedraw)
+        {
+            break;
+        }
+
+        auto previous = previousRects.find(drawableRect.id);
+        if (previous != previousRects.end())
+        {
+            if (!IsSame(drawableRect, *previous->second))
+            {
+                m_dirtyRects.push_back(Bounds(previous->second->rect));
+                m_dirtyRects.push_back(Bounds(drawableRect.rect));
+            }
+            previousRects.erase(previous);
+        }
+        else
+        {
+            m_dirtyRects.push_back(Bounds(drawableRect.rect));
+        }
+
+        if (m_dirtyRects.size() > MaxDirtyRects)
+        {
+            Invalidate();
+        }
+    }
+
+    // Zones that are gone
+    for (const auto& previous : previousRects)
+    {
+        if (m_fullRedraw)
+        {
+            break;
+        }
+
+        m_dirtyRects.push_back(Bounds(previous.second->rect));
+        if (m_dirtyRects.size() > MaxDirtyRects)
+        {
+            Invalidate();
+        }
+    }
+
+    // Labels of the zones that are gone are released
+    std::map<LabelKey, winrt::com_ptr<IDWriteTextLayout>> labels;
+    for (const auto& drawableRect : rects)
+    {
+        const LabelKey key{ drawableRect.id, drawableRect.rect.right - drawableRect.rect.left, drawableRect.rect.bottom - drawableRect.rect.top };
+        if (auto label = m_labels.find(key); label != m_labels.end())
+        {
+            labels.insert(*label);
+        }
+    }
+
+    m_labels = std::move(labels);
+    m_sceneRects = std::move(rects);
+}
+
+void ZoneOverlayRenderer::Invalidate() noexcept
+{
+    m_fullRedraw = true;
+    m_dirtyRects.clear();
+}
+
+bool ZoneOverlayRenderer::NeedsRender(float alpha) const noexcept
+{
+    return m_fullRedraw || !m_dirtyRects.empty() || alpha != m_renderedAlpha;
+}
+
+bool ZoneOverlayRenderer::Render(ID2D1RenderTarget* target, float alpha)
+{
+    if (target != m_target)
+    {
+        DiscardDeviceResources();
+        m_target = target;
+    }
+
+    if (!m_target || !NeedsRender(alpha))
+    {
+        return false;
+    }
+
+    const auto renderStart = std::chrono::steady_clock::now();
+    m_resourcesCreatedThisFrame = 0;
+
+    // Fades change every pixel, only a change of the scene at the same opacity is drawn partially
+    const bool partial = !m_fullRedraw && alpha == m_renderedAlpha;
+    if (partial)
+    {
+        for (const auto& dirtyRect : m_dirtyRects)
+        {
+            m_target->PushAxisAlignedClip(dirtyRect, D2D1_ANTIALIAS_MODE_ALIASED);
+            m_target->Clear(Transparent);
+            for (const auto& drawableRect : m_sceneRects)
+            {
+                if (Intersects(Bounds(drawableRect.rect), dirtyRect))
+                {
+                    DrawRect(drawableRect, alpha);
+                }
+            }
+            m_target->PopAxisAlignedClip();
+        }
+    }
+    else
+    {
+        m_target->Clear(Transparent);
+        for (const auto& drawableRect : m_sceneRects)
+        {
+            DrawRect(drawableRect, alpha);
+        }
+    }
+
+    m_dirtyRects.clear();
+    m_fullRedraw = false;
+    m_renderedAlpha = alpha;
+
+    RecordFrame(std::chrono::steady_clock::now() - renderStart, partial);
+    return true;
+}
+
+void ZoneOverlayRenderer::DiscardDeviceResources() noexcept
+{
+    m_brushes.clear();
+    m_target = nullptr;
+    Invalidate();
+}
+
+ZoneOverlayRenderer::Statistics ZoneOverlayRenderer::GetStatistics() const
+{
+    Statistics statistics = m_statistics;
+
+    const size_t samples = (std::min)(m_statistics.frames, FrameTimeSamples);
+    if (samples > 0)
+    {
+        std::vector<std::chrono::steady_clock::duration> frameTimes(m_frameTimes.begin(), m_frameTimes.begin() + samples);
+        auto percentile = [&frameTimes](size_t percent) {
+            auto nth = frameTimes.begin() + (frameTimes.size() - 1) * percent / 100;
+            std::nth_element(frameTimes.begin(), nth, frameTimes.end());
+            return std::chrono::duration<double, std::milli>(*nth).count();
+        };
+
+        statistics.p50RenderMs = percentile(50);
+        statistics.p99RenderMs = percentile(99);
+    }
+
+    return statistics;
+}
+
+IDWriteFactory* ZoneOverlayRenderer::GetWriteFactory()
+{
+    static auto pDWriteFactory = [] {
+        IUnknown* res = nullptr;
+        DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), &res);
+        return reinterpret_cast<IDWriteFactory*>(res);
+    }();
+    return pDWriteFactory;
+}
+
+ID2D1SolidColorBrush* ZoneOverlayRenderer::GetBrush(const D2D1_COLOR_F& color)
+{
+    auto& brush = m_brushes[ColorKey(color)];
+    if (!brush && SUCCEEDED(m_target->CreateSolidColorBrush(color, brush.put())))
+    {
+        ++m_resourcesCreatedThisFrame;
+    }
+    return brush.get();
+}
+
+IDWriteTextLayout* ZoneOverlayRenderer::GetLabel(const DrawableRect& drawableRect)
+{
+    const float width = drawableRect.rect.right - drawableRect.rect.left;
+    const float height = drawableRect.rect.bottom - drawableRect.rect.top;
+
+    auto& label = m_labels[LabelKey{ drawableRect.id, width, height }];
+    if (label)
+    {
+        return label.get();
+    }
+
+    auto writeFactory = GetWriteFactory();
+    if (!writeFactory)
+    {
+        return nullptr;
+    }
+
+    if (!m_textFormat)
+    {
+        if (FAILED(writeFactory->CreateTextFormat(NonLocalizable::SegoeUiFont, nullptr, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, LabelFontSize, NonLocalizable::LabelLocale, m_textFormat.put())))
+        {
+            return nullptr;
+        }
+
+        m_textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
+        m_textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
+        ++m_resourcesCreatedThisFrame;
+    }
+
+    const std::wstring text = std::to_wstring(drawableRect.id + 1);
+    if (SUCCEEDED(writeFactory->CreateTextLayout(text.c_str(), static_cast<UINT32>(text.size()), m_textFormat.get(), width, height, label.put())))
+    {
+        ++m_resourcesCreatedThisFrame;
+    }
+    return label.get();
+}
+
+void ZoneOverlayRenderer::DrawRect(const DrawableRect& drawableRect, float alpha)
+{
+    if (auto fillBrush = GetBrush(drawableRect.fillColor))
+    {
+        fillBrush->SetOpacity(alpha);
+        m_target->FillRectangle(drawableRect.rect, fillBrush);
+    }
+
+    if (auto borderBrush = GetBrush(drawableRect.borderColor))
+    {
+        borderBrush->SetOpacity(alpha);
+        m_target->DrawRectangle(drawableRect.rect, borderBrush);
+    }
+
+    auto textBrush = GetBrush(LabelColor);
+    auto label = GetLabel(drawableRect);
+    if (textBrush && label)
+    {
+        textBrush->SetOpacity(alpha);
+        m_target->DrawTextLayout(D2D1::Point2F(drawableRect.rect.left, drawableRect.rect.top), label, textBrush);
+    }
+}
+
+void ZoneOverlayRenderer::RecordFrame(std::chrono::steady_clock::duration renderTime, bool partial)
+{
+    m_frameTimes[m_statistics.frames % FrameTimeSamples] = renderTime;
+    ++m_statistics.frames;
+    if (partial)
+    {
+        ++m_statistics.partialFrames;
+    }
+
+    m_statistics.resourcesCreated += m_resourcesCreatedThisFrame;
+    m_statistics.resourcesCreatedLastFrame = m_resourcesCreatedThisFrame;
+}
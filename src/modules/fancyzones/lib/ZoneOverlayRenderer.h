@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <winrt/base.h>
+#include <d2d1.h>
+#include <dwrite.h>
+
+/**
+ * Retained scene of the zone overlay, drawn into any Direct2D render target.
+ *
+ * Brushes and the label text format live as long as the render target, and the label text layouts
+ * as long as the zone keeps its id and size, so a frame creates nothing once the scene is built.
+ * Fades only change the opacity of the brushes. When the scene changes at full opacity, only the
+ * regions of the zones that changed are redrawn.
+ */
+class ZoneOverlayRenderer
+{
+public:
+    struct DrawableRect
+    {
+        D2D1_RECT_F rect;
+        D2D1_COLOR_F borderColor;
+        D2D1_COLOR_F fillColor;
+        size_t id;
+    };
+
+    struct Statistics
+    {
+        size_t frames = 0;
+        // Frames that redrew the changed zones only
+        size_t partialFrames = 0;
+        // Time to record a frame, over the last frames, without the wait for the vertical sync in EndDraw
+        double p50RenderMs = 0;
+        double p99RenderMs = 0;
+        // Brushes, text formats and text layouts
+        size_t resourcesCreated = 0;
+        size_t resourcesCreatedLastFrame = 0;
+    };
+
+    /**
+     * Replace the scene. The zones that did not change are not redrawn.
+     */
+    void SetScene(std::vector<DrawableRect> rects);
+
+    /**
+     * Redraw everything on the next frame, e.g. when the window was hidden.
+     */
+    void Invalidate() noexcept;
+
+    bool NeedsRender(float alpha) const noexcept;
+
+    /**
+     * Draw the scene, between BeginDraw and EndDraw of the target.
+     * @returns False if nothing needed to be drawn.
+     */
+    bool Render(ID2D1RenderTarget* target, float alpha);
+
+    /**
+     * Release the resources of the render target, after EndDraw returned D2DERR_RECREATE_TARGET.
+     */
+    void DiscardDeviceResources() noexcept;
+
+    Statistics GetStatistics() const;
+
+private:
+    // Key of a cached label: zone id, width and height
+    using LabelKey = std::tuple<size_t, float, float>;
+
+    static constexpr size_t FrameTimeSamples = 256;
+
+    static IDWriteFactory* GetWriteFactory();
+
+    ID2D1SolidColorBrush* GetBrush(const D2D1_COLOR_F& color);
+    IDWriteTextLayout* GetLabel(const DrawableRect& drawableRect);
+    void DrawRect(const DrawableRect& drawableRect, float alpha);
+    void RecordFrame(std::chrono::steady_clock::duration renderTime, bool partial);
+
+    std::vector<DrawableRect> m_sceneRects;
+    std::vector<D2D1_RECT_F> m_dirtyRects;
+    bool m_fullRedraw = true;
+    float m_renderedAlpha = -1.f;
+
+    // Device resources, valid for m_target, with brushes by color
+    ID2D1RenderTarget* m_target = nullptr;
+    std::map<uint32_t, winrt::com_ptr<ID2D1SolidColorBrush>> m_brushes;
+
+    // Device independent, kept when the target changes
+    winrt::com_ptr<IDWriteTextFormat> m_textFormat;
+    std::map<LabelKey, winrt::com_ptr<IDWriteTextLayout>> m_labels;
+
+    size_t m_resourcesCreatedThisFrame = 0;
+    Statistics m_statistics;
+    std::array<std::chrono::steady_clock::duration, FrameTimeSamples> m_frameTimes{};
+};
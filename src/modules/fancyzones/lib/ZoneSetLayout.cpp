@@ -0,0 +1,720 @@
+// Built without the precompiled header, see ZoneGeometry.h
+#include "ZoneSetLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+    using FancyZonesLayout::GridLayout;
+
+    constexpr int C_MULTIPLIER = 10000;
+
+    // PriorityGrid layout is unique for zoneCount <= 11. For zoneCount > 11 PriorityGrid is same as Grid
+    const GridLayout predefinedPriorityGridLayouts[11] = {
+        /* 1 */
+        GridLayout{ .rows = 1, .columns = 1, .rowsPercents = { 10000 }, .columnsPercents = { 10000 }, .cellChildMap = { 0 } },
+        /* 2 */
+        GridLayout{ .rows = 1, .columns = 2, .rowsPercents = { 10000 }, .columnsPercents = { 6667, 3333 }, .cellChildMap = { 0, 1 } },
+        /* 3 */
+        GridLayout{ .rows = 1, .columns = 3, .rowsPercents = { 10000 }, .columnsPercents = { 2500, 5000, 2500 }, .cellChildMap = { 0, 1, 2 } },
+        /* 4 */
+        GridLayout{ .rows = 2, .columns = 3, .rowsPercents = { 5000, 5000 }, .columnsPercents = { 2500, 5000, 2500 }, .cellChildMap = { 0, 1, 2, 0, 1, 3 } },
+        /* 5 */
+        GridLayout{ .rows = 2, .columns = 3, .rowsPercents = { 5000, 5000 }, .columnsPercents = { 2500, 5000, 2500 }, .cellChildMap = { 0, 1, 2, 3, 1, 4 } },
+        /* 6 */
+        GridLayout{ .rows = 3, .columns = 3, .rowsPercents = { 3333, 3334, 3333 }, .columnsPercents = { 2500, 5000, 2500 }, .cellChildMap = { 0, 1, 2, 0, 1, 3, 4, 1, 5 } },
+        /* 7 */
+        GridLayout{ .rows = 3, .columns = 3, .rowsPercents = { 3333, 3334, 3333 }, .columnsPercents = { 2500, 5000, 2500 }, .cellChildMap = { 0, 1, 2, 3, 1, 4, 5, 1, 6 } },
+        /* 8 */
+        GridLayout{ .rows = 3, .columns = 4, .rowsPercents = { 3333, 3334, 3333 }, .columnsPercents = { 2500, 2500, 2500, 2500 }, .cellChildMap = { 0, 1, 2, 3, 4, 1, 2, 5, 6, 1, 2, 7 } },
+        /* 9 */
+        GridLayout{ .rows = 3, .columns = 4, .rowsPercents = { 3333, 3334, 3333 }, .columnsPercents = { 2500, 2500, 2500, 2500 }, .cellChildMap = { 0, 1, 2, 3, 4, 1, 2, 5, 6, 1, 7, 8 } },
+        /* 10 */
+        GridLayout{ .rows = 3, .columns = 4, .rowsPercents = { 3333, 3334, 3333 }, .columnsPercents = { 2500, 2500, 2500, 2500 }, .cellChildMap = { 0, 1, 2, 3, 4, 1, 5, 6, 7, 1, 8, 9 } },
+        /* 11 */
+        GridLayout{ .rows = 3, .columns = 4, .rowsPercents = { 3333, 3334, 3333 }, .columnsPercents = { 2500, 2500, 2500, 2500 }, .cellChildMap = { 0, 1, 2, 3, 4, 1, 5, 6, 7, 8, 9, 10 } },
+    };
+
+    int ZoneArea(const FancyZonesLayout::Rect& rect) noexcept
+    {
+        return std::max(rect.height(), 0) * std::max(rect.width(), 0);
+    }
+
+    constexpr double NoDistance = 1e100;
+
+    /**
+     * Distance of the zones to a window for directional navigation. The distance is measured along an
+     * ellipse with eccentricity 2 whose major axis points in the direction, so that zones in line with the
+     * window are preferred. Zones behind the window, or at an angle whose tangent exceeds 10, are not
+     * reachable. With tan = cross / dot, the distance is (dot^2 + e^2 cross^2) / (2 e dot), which is
+     * computed without branches so that the loops over the zones vectorize.
+     */
+    class DirectionalDistance
+    {
+    public:
+        DirectionalDistance(FancyZonesLayout::Direction direction, const FancyZonesLayout::Rect& windowRect) noexcept :
+            m_windowX(0.5 * windowRect.left + 0.5 * windowRect.right),
+            m_windowY(0.5 * windowRect.top + 0.5 * windowRect.bottom)
+        {
+            switch (direction)
+            {
+            case FancyZonesLayout::Direction::Up:
+                m_directionY = -1.0;
+                break;
+            case FancyZonesLayout::Direction::Down:
+                m_directionY = 1.0;
+                break;
+            case FancyZonesLayout::Direction::Left:
+                m_directionX = -1.0;
+                break;
+            case FancyZonesLayout::Direction::Right:
+                m_directionX = 1.0;
+                break;
+            }
+        }
+
+        // Distance to the candidate zone at the given index, NoDistance if it is not reachable
+        double operator()(const FancyZonesLayout::Rect& zoneRect, size_t index) const noexcept
+        {
+            // Offset the zone slightly, to differentiate in case there are overlapping zones
+            const double x = (0.5 * zoneRect.left + 0.5 * zoneRect.right + 0.001 * static_cast<double>(index + 1)) - m_windowX;
+            const double y = (0.5 * zoneRect.top + 0.5 * zoneRect.bottom) - m_windowY;
+
+            const double dot = m_directionX * x + m_directionY * y;
+            const double cross = m_directionX * y - m_directionY * x;
+            const bool reachable = dot > 0.0 && std::abs(cross) <= 10.0 * dot;
+
+            // The denominator is never zero, the result is discarded when the zone is not reachable
+            const double distance = (dot * dot + Eccentricity * Eccentricity * cross * cross) / (2.0 * Eccentricity * (reachable ? dot : 1.0));
+            return reachable ? distance : NoDistance;
+        }
+
+    private:
+        static constexpr double Eccentricity = 2.0;
+
+        double m_directionX = 0.0;
+        double m_directionY = 0.0;
+        double m_windowX;
+        double m_windowY;
+    };
+}
+
+namespace FancyZonesLayout
+{
+    ZoneSetLayout::ZoneSetLayout(int sensitivityRadius, SelectionAlgorithm selectionAlgorithm) noexcept :
+        m_sensitivityRadius(sensitivityRadius),
+        m_selectionAlgorithm(selectionAlgorithm)
+    {
+    }
+
+    bool ZoneSetLayout::AddZone(const Zone& zone)
+    {
+        auto it = std::lower_bound(m_zones.begin(), m_zones.end(), zone.id, [](const Zone& existing, size_t zoneId) { return existing.id < zoneId; });
+        if (it != m_zones.end() && it->id == zone.id)
+        {
+            return false;
+        }
+
+        m_zones.insert(it, zone);
+        m_spatialIndexDirty = true;
+        m_navigationGraphDirty = true;
+        return true;
+    }
+
+    void ZoneSetLayout::Clear() noexcept
+    {
+        m_zones.clear();
+        m_spatialIndexDirty = true;
+        m_navigationGraphDirty = true;
+    }
+
+    const Zone* ZoneSetLayout::FindZone(size_t id) const noexcept
+    {
+        // Ids are usually 0 to n - 1
+        if (id < m_zones.size() && m_zones[id].id == id)
+        {
+            return &m_zones[id];
+        }
+
+        auto it = std::lower_bound(m_zones.begin(), m_zones.end(), id, [](const Zone& existing, size_t zoneId) { return existing.id < zoneId; });
+        return it != m_zones.end() && it->id == id ? &*it : nullptr;
+    }
+
+    bool ZoneSetLayout::CalculateZones(LayoutType type, int width, int height, int zoneCount, int spacing)
+    {
+        //invalid work area
+        if (width == 0 || height == 0)
+        {
+            return false;
+        }
+
+        //invalid zoneCount, may cause division by zero
+        if (zoneCount <= 0)
+        {
+            return false;
+        }
+
+        bool success = true;
+        switch (type)
+        {
+        case LayoutType::Focus:
+            success = CalculateFocusLayout(width, height, zoneCount);
+            break;
+        case LayoutType::Columns:
+        case LayoutType::Rows:
+            success = CalculateColumnsAndRowsLayout(type, width, height, zoneCount, spacing);
+            break;
+        case LayoutType::Grid:
+        case LayoutType::PriorityGrid:
+            success = CalculateGridLayout(type, width, height, zoneCount, spacing);
+            break;
+        }
+
+        UpdateSpatialIndex();
+        UpdateNavigationGraph();
+        return success;
+    }
+
+    bool ZoneSetLayout::CalculateFocusLayout(int width, int height, int zoneCount)
+    {
+        int left{ 100 };
+        int top{ 100 };
+        int right{ left + static_cast<int>(width * 0.4) };
+        int bottom{ top + static_cast<int>(height * 0.4) };
+
+        Rect focusZoneRect{ left, top, right, bottom };
+
+        int focusRectXIncrement = (zoneCount <= 1) ? 0 : 50;
+        int focusRectYIncrement = (zoneCount <= 1) ? 0 : 50;
+
+        for (int i = 0; i < zoneCount; i++)
+        {
+            if (!AddCalculatedZone(focusZoneRect, m_zones.size()))
+            {
+                return false;
+            }
+            focusZoneRect.left += focusRectXIncrement;
+            focusZoneRect.right += focusRectXIncrement;
+            focusZoneRect.bottom += focusRectYIncrement;
+            focusZoneRect.top += focusRectYIncrement;
+        }
+
+        return true;
+    }
+
+    bool ZoneSetLayout::CalculateColumnsAndRowsLayout(LayoutType type, int width, int height, int zoneCount, int spacing)
+    {
+        int64_t totalWidth;
+        int64_t totalHeight;
+
+        if (type == LayoutType::Columns)
+        {
+            totalWidth = width - (static_cast<int64_t>(spacing) * (zoneCount + 1));
+            totalHeight = height - (static_cast<int64_t>(spacing) * 2);
+        }
+        else
+        { //Rows
+            totalWidth = width - (static_cast<int64_t>(spacing) * 2);
+            totalHeight = height - (static_cast<int64_t>(spacing) * (zoneCount + 1));
+        }
+
+        int64_t top = spacing;
+        int64_t left = spacing;
+        int64_t bottom;
+        int64_t right;
+
+        // Note: The expressions below are NOT equal to total{Width|Height} / zoneCount and are done
+        // like this to make the sum of all zones' sizes exactly total{Width|Height}.
+        for (int zoneIndex = 0; zoneIndex < zoneCount; ++zoneIndex)
+        {
+            if (type == LayoutType::Columns)
+            {
+                right = left + (zoneIndex + 1) * totalWidth / zoneCount - zoneIndex * totalWidth / zoneCount;
+                bottom = totalHeight + spacing;
+            }
+            else
+            { //Rows
+                right = totalWidth + spacing;
+                bottom = top + (zoneIndex + 1) * totalHeight / zoneCount - zoneIndex * totalHeight / zoneCount;
+            }
+
+            const Rect rect{ static_cast<int>(left), static_cast<int>(top), static_cast<int>(right), static_cast<int>(bottom) };
+            if (!AddCalculatedZone(rect, m_zones.size()))
+            {
+                return false;
+            }
+
+            if (type == LayoutType::Columns)
+            {
+                left = right + spacing;
+            }
+            else
+            { //Rows
+                top = bottom + spacing;
+            }
+        }
+
+        return true;
+    }
+
+    bool ZoneSetLayout::CalculateGridLayout(LayoutType type, int width, int height, int zoneCount, int spacing)
+    {
+        const int count = static_cast<int>(std::size(predefinedPriorityGridLayouts));
+        if (type == LayoutType::PriorityGrid && zoneCount < count)
+        {
+            return AddGridZones(width, height, predefinedPriorityGridLayouts[zoneCount - 1], spacing);
+        }
+
+        int rows = 1, columns = 1;
+        while (zoneCount / rows >= rows)
+        {
+            rows++;
+        }
+        rows--;
+        columns = zoneCount / rows;
+        if (zoneCount % rows == 0)
+        {
+            // even grid
+        }
+        else
+        {
+            columns++;
+        }
+
+        GridLayout grid;
+        grid.rows = rows;
+        grid.columns = columns;
+
+        // Note: The expressions below are NOT equal to C_MULTIPLIER / {rows|columns} and are done
+        // like this to make the sum of all percents exactly C_MULTIPLIER
+        for (int row = 0; row < rows; row++)
+        {
+            grid.rowsPercents.push_back(C_MULTIPLIER * (row + 1) / rows - C_MULTIPLIER * row / rows);
+        }
+        for (int col = 0; col < columns; col++)
+        {
+            grid.columnsPercents.push_back(C_MULTIPLIER * (col + 1) / columns - C_MULTIPLIER * col / columns);
+        }
+
+        int index = 0;
+        grid.cellChildMap.reserve(static_cast<size_t>(rows) * columns);
+        for (int row = 0; row < rows; row++)
+        {
+            for (int col = 0; col < columns; col++)
+            {
+                grid.cellChildMap.push_back(index++);
+                if (index == zoneCount)
+                {
+                    index--;
+                }
+            }
+        }
+        return AddGridZones(width, height, grid, spacing);
+    }
+
+    bool ZoneSetLayout::CalculateGridZones(int width, int height, const GridLayout& grid, int spacing)
+    {
+        bool success = AddGridZones(width, height, grid, spacing);
+        UpdateSpatialIndex();
+        UpdateNavigationGraph();
+        return success;
+    }
+
+    bool ZoneSetLayout::AddGridZones(int width, int height, const GridLayout& grid, int spacing)
+    {
+        if (grid.rows < 0 || grid.columns < 0 ||
+            grid.rowsPercents.size() < static_cast<size_t>(grid.rows) ||
+            grid.columnsPercents.size() < static_cast<size_t>(grid.columns) ||
+            grid.cellChildMap.size() < static_cast<size_t>(grid.rows) * grid.columns)
+        {
+            return false;
+        }
+
+        const int64_t totalWidth = width;
+        const int64_t totalHeight = height;
+        struct Info
+        {
+            int64_t Extent;
+            int64_t Start;
+            int64_t End;
+        };
+        std::vector<Info> rowInfo(grid.rows);
+        std::vector<Info> columnInfo(grid.columns);
+
+        // Note: The expressions below are carefully written to
+        // make the sum of all zones' sizes exactly total{Width|Height}
+        int64_t totalPercents = 0;
+        for (int row = 0; row < grid.rows; row++)
+        {
+            rowInfo[row].Start = totalPercents * totalHeight / C_MULTIPLIER;
+            totalPercents += grid.rowsPercents[row];
+            rowInfo[row].End = totalPercents * totalHeight / C_MULTIPLIER;
+            rowInfo[row].Extent = rowInfo[row].End - rowInfo[row].Start;
+        }
+
+        totalPercents = 0;
+        for (int col = 0; col < grid.columns; col++)
+        {
+            columnInfo[col].Start = totalPercents * totalWidth / C_MULTIPLIER;
+            totalPercents += grid.columnsPercents[col];
+            columnInfo[col].End = totalPercents * totalWidth / C_MULTIPLIER;
+            columnInfo[col].Extent = columnInfo[col].End - columnInfo[col].Start;
+        }
+
+        for (int row = 0; row < grid.rows; row++)
+        {
+            for (int col = 0; col < grid.columns; col++)
+            {
+                int i = grid.CellZone(row, col);
+                if (((row == 0) || (grid.CellZone(row - 1, col) != i)) &&
+                    ((col == 0) || (grid.CellZone(row, col - 1) != i)))
+                {
+                    int64_t left = columnInfo[col].Start;
+                    int64_t top = rowInfo[row].Start;
+
+                    int maxRow = row;
+                    while (((maxRow + 1) < grid.rows) && (grid.CellZone(maxRow + 1, col) == i))
+                    {
+                        maxRow++;
+                    }
+                    int maxCol = col;
+                    while (((maxCol + 1) < grid.columns) && (grid.CellZone(row, maxCol + 1) == i))
+                    {
+                        maxCol++;
+                    }
+
+                    int64_t right = columnInfo[maxCol].End;
+                    int64_t bottom = rowInfo[maxRow].End;
+
+                    top += row == 0 ? spacing : spacing / 2;
+                    bottom -= maxRow == grid.rows - 1 ? spacing : spacing / 2;
+                    left += col == 0 ? spacing : spacing / 2;
+                    right -= maxCol == grid.columns - 1 ? spacing : spacing / 2;
+
+                    const Rect rect{ static_cast<int>(left), static_cast<int>(top), static_cast<int>(right), static_cast<int>(bottom) };
+                    if (!AddCalculatedZone(rect, static_cast<size_t>(i)))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool ZoneSetLayout::CalculateCanvasZones(const std::vector<Rect>& zones)
+    {
+        bool success = true;
+        for (const Rect& rect : zones)
+        {
+            if (!AddCalculatedZone(rect, m_zones.size()))
+            {
+                success = false;
+                break;
+            }
+        }
+
+        UpdateSpatialIndex();
+        UpdateNavigationGraph();
+        return success;
+    }
+
+    bool ZoneSetLayout::AddCalculatedZone(const Rect& rect, size_t id)
+    {
+        if (!IsValidZoneRect(rect))
+        {
+            // All zones within zone set should be valid in order to use its functionality.
+            Clear();
+            return false;
+        }
+
+        AddZone({ id, rect });
+        return true;
+    }
+
+    void ZoneSetLayout::UpdateIndexes() const
+    {
+        if (m_spatialIndexDirty)
+        {
+            UpdateSpatialIndex();
+        }
+        if (m_navigationGraphDirty)
+        {
+            UpdateNavigationGraph();
+        }
+    }
+
+    void ZoneSetLayout::UpdateSpatialIndex() const
+    {
+        m_spatialIndex.Build(m_zones, m_sensitivityRadius);
+        m_spatialIndexDirty = false;
+    }
+
+    void ZoneSetLayout::UpdateNavigationGraph() const
+    {
+        m_navigationGraph.assign(m_zones.size(), { NoNeighbor, NoNeighbor, NoNeighbor, NoNeighbor });
+        for (size_t zoneIndex = 0; zoneIndex < m_zones.size(); ++zoneIndex)
+        {
+            for (Direction direction : { Direction::Left, Direction::Up, Direction::Right, Direction::Down })
+            {
+                const DirectionalDistance distance(direction, m_zones[zoneIndex].rect);
+                double smallestDistance = NoDistance;
+                size_t& neighbor = m_navigationGraph[zoneIndex][static_cast<size_t>(direction)];
+
+                // The other zones, numbered as ZoneByDirection numbers them when this zone is ignored
+                for (size_t i = 0; i < m_zones.size(); ++i)
+                {
+                    if (i != zoneIndex)
+                    {
+                        const double dist = distance(m_zones[i].rect, i < zoneIndex ? i : i - 1);
+                        if (dist < smallestDistance)
+                        {
+                            smallestDistance = dist;
+                            neighbor = i;
+                        }
+                    }
+                }
+            }
+        }
+
+        m_navigationGraphDirty = false;
+    }
+
+    std::vector<size_t> ZoneSetLayout::ZonesFromPoint(Point pt) const
+    {
+        if (m_spatialIndexDirty)
+        {
+            UpdateSpatialIndex();
+        }
+
+        ZoneSpatialIndex::Hit hit;
+        m_spatialIndex.Query(pt, hit);
+        std::vector<size_t> capturedZones = std::move(hit.capturedZones);
+
+        // If only one zone is captured, but it's not strictly captured
+        // don't consider it as captured
+        if (capturedZones.size() == 1 && !hit.strictlyCaptured)
+        {
+            return {};
+        }
+
+        // If captured zones do not overlap, return all of them
+        // Otherwise, return one of them based on the chosen selection algorithm.
+        if (hit.overlap)
+        {
+            switch (m_selectionAlgorithm)
+            {
+            case SelectionAlgorithm::Smallest:
+                return { capturedZones[ZoneSelectPriority(capturedZones, true)] };
+            case SelectionAlgorithm::Largest:
+                return { capturedZones[ZoneSelectPriority(capturedZones, false)] };
+            case SelectionAlgorithm::Positional:
+                return ZoneSelectSubregion(capturedZones, pt);
+            }
+        }
+
+        return capturedZones;
+    }
+
+    std::vector<size_t> ZoneSetLayout::ZoneSelectSubregion(const std::vector<size_t>& capturedZones, Point pt) const
+    {
+        auto expand = [&](Rect& rect) {
+            rect.top -= m_sensitivityRadius / 2;
+            rect.bottom += m_sensitivityRadius / 2;
+            rect.left -= m_sensitivityRadius / 2;
+            rect.right += m_sensitivityRadius / 2;
+        };
+
+        // Compute the overlapped rectangle.
+        Rect overlap = FindZone(capturedZones[0])->rect;
+        expand(overlap);
+
+        for (size_t i = 1; i < capturedZones.size(); ++i)
+        {
+            Rect current = FindZone(capturedZones[i])->rect;
+            expand(current);
+
+            overlap.top = std::max(overlap.top, current.top);
+            overlap.left = std::max(overlap.left, current.left);
+            overlap.bottom = std::min(overlap.bottom, current.bottom);
+            overlap.right = std::min(overlap.right, current.right);
+        }
+
+        // Avoid division by zero
+        int width = std::max(overlap.width(), 1);
+        int height = std::max(overlap.height(), 1);
+
+        bool verticalSplit = height > width;
+        size_t zoneIndex;
+
+        // A point before the overlapped rectangle wraps around to a large index, clamped to the last zone
+        if (verticalSplit)
+        {
+            zoneIndex = static_cast<size_t>(pt.y - overlap.top) * capturedZones.size() / static_cast<size_t>(height);
+        }
+        else
+        {
+            zoneIndex = static_cast<size_t>(pt.x - overlap.left) * capturedZones.size() / static_cast<size_t>(width);
+        }
+
+        zoneIndex = std::clamp(zoneIndex, size_t(0), capturedZones.size() - 1);
+
+        return { capturedZones[zoneIndex] };
+    }
+
+    size_t ZoneSetLayout::ZoneSelectPriority(const std::vector<size_t>& capturedZones, bool smallest) const
+    {
+        size_t chosen = 0;
+        int chosenArea = ZoneArea(FindZone(capturedZones[0])->rect);
+
+        for (size_t i = 1; i < capturedZones.size(); ++i)
+        {
+            const int area = ZoneArea(FindZone(capturedZones[i])->rect);
+            if (smallest ? area < chosenArea : area > chosenArea)
+            {
+                chosen = i;
+                chosenArea = area;
+            }
+        }
+
+        return chosen;
+    }
+
+    std::vector<size_t> ZoneSetLayout::GetCombinedZoneRange(const std::vector<size_t>& initialZones, const std::vector<size_t>& finalZones) const
+    {
+        std::vector<size_t> combinedZones, result;
+        std::set_union(begin(initialZones), end(initialZones), begin(finalZones), end(finalZones), std::back_inserter(combinedZones));
+
+        Rect boundingRect{};
+        bool boundingRectEmpty = true;
+
+        for (size_t zoneId : combinedZones)
+        {
+            if (const Zone* zone = FindZone(zoneId))
+            {
+                const Rect& rect = zone->rect;
+                if (boundingRectEmpty)
+                {
+                    boundingRect = rect;
+                    boundingRectEmpty = false;
+                }
+                else
+                {
+                    boundingRect.left = std::min(boundingRect.left, rect.left);
+                    boundingRect.top = std::min(boundingRect.top, rect.top);
+                    boundingRect.right = std::max(boundingRect.right, rect.right);
+                    boundingRect.bottom = std::max(boundingRect.bottom, rect.bottom);
+                }
+            }
+        }
+
+        if (!boundingRectEmpty)
+        {
+            for (const auto& zone : m_zones)
+            {
+                const Rect& rect = zone.rect;
+                if (boundingRect.left <= rect.left && rect.right <= boundingRect.right &&
+                    boundingRect.top <= rect.top && rect.bottom <= boundingRect.bottom)
+                {
+                    result.push_back(zone.id);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    std::optional<size_t> ZoneSetLayout::ZoneByDirection(Direction direction, const Rect& windowRect, const std::vector<size_t>& ignoredZones) const
+    {
+        const DirectionalDistance distance(direction, windowRect);
+        double smallestDistance = NoDistance;
+        std::optional<size_t> result;
+
+        size_t candidate = 0;
+        for (const auto& zone : m_zones)
+        {
+            if (std::find(ignoredZones.begin(), ignoredZones.end(), zone.id) == ignoredZones.end())
+            {
+                const double dist = distance(zone.rect, candidate++);
+                if (dist < smallestDistance)
+                {
+                    smallestDistance = dist;
+                    result = zone.id;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    std::optional<size_t> ZoneSetLayout::NeighborZone(size_t zoneId, Direction direction) const
+    {
+        const Zone* zone = FindZone(zoneId);
+        if (!zone)
+        {
+            return std::nullopt;
+        }
+
+        if (m_navigationGraphDirty)
+        {
+            UpdateNavigationGraph();
+        }
+
+        const size_t neighbor = m_navigationGraph[static_cast<size_t>(zone - m_zones.data())][static_cast<size_t>(direction)];
+        if (neighbor == NoNeighbor)
+        {
+            return std::nullopt;
+        }
+
+        return m_zones[neighbor].id;
+    }
+
+    size_t ZoneSetLayout::ChooseNextZoneByPosition(Direction direction, const Rect& windowRect, const std::vector<Rect>& zoneRects) noexcept
+    {
+        const DirectionalDistance distance(direction, windowRect);
+        double smallestDistance = NoDistance;
+        size_t closestIdx = zoneRects.size();
+
+        for (size_t i = 0; i < zoneRects.size(); i++)
+        {
+            const double dist = distance(zoneRects[i], i);
+            if (dist < smallestDistance)
+            {
+                smallestDistance = dist;
+                closestIdx = i;
+            }
+        }
+
+        return closestIdx;
+    }
+
+    Rect ZoneSetLayout::PrepareRectForCycling(Rect windowRect, const Rect& workAreaRect, Direction direction) noexcept
+    {
+        int deltaX = 0, deltaY = 0;
+        switch (direction)
+        {
+        case Direction::Up:
+            deltaY = workAreaRect.bottom - workAreaRect.top;
+            break;
+        case Direction::Down:
+            deltaY = workAreaRect.top - workAreaRect.bottom;
+            break;
+        case Direction::Left:
+            deltaX = workAreaRect.right - workAreaRect.left;
+            break;
+        case Direction::Right:
+            deltaX = workAreaRect.left - workAreaRect.right;
+        }
+
+        windowRect.left += deltaX;
+        windowRect.right += deltaX;
+        windowRect.top += deltaY;
+        windowRect.bottom += deltaY;
+
+        return windowRect;
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "ZoneGeometry.h"
+#include "ZoneSpatialIndex.h"
+
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace FancyZonesLayout
+{
+    // Layouts computed from a number of zones. Custom layouts are either a grid or a canvas.
+    enum class LayoutType
+    {
+        Focus,
+        Columns,
+        Rows,
+        Grid,
+        PriorityGrid
+    };
+
+    // Same values as Settings::OverlappingZonesAlgorithm
+    enum class SelectionAlgorithm : int
+    {
+        Smallest = 0,
+        Largest = 1,
+        Positional = 2
+    };
+
+    /**
+     * Rows and columns of a grid layout. Each cell belongs to a zone, and a zone is the bounding
+     * rectangle of the first cell of the zone found in each direction.
+     */
+    struct GridLayout
+    {
+        int rows = 0;
+        int columns = 0;
+        // Sizes of the rows and columns, in 1/10000 of the work area
+        std::vector<int> rowsPercents;
+        std::vector<int> columnsPercents;
+        // Zone of each cell, row by row
+        std::vector<int> cellChildMap;
+
+        int CellZone(int row, int column) const noexcept { return cellChildMap[static_cast<size_t>(row) * columns + column]; }
+    };
+
+    /**
+     * Zones of a zone layout as plain rectangles, and the computations of ZoneSet that do not involve
+     * windows: zone calculation, hit-testing, directional navigation and range combining.
+     *
+     * Zones are kept by ascending id in a contiguous array. Coordinates are relative to the work area.
+     */
+    class ZoneSetLayout
+    {
+    public:
+        ZoneSetLayout(int sensitivityRadius, SelectionAlgorithm selectionAlgorithm) noexcept;
+
+        /**
+         * Add a zone.
+         *
+         * @returns false if there is already a zone with this id.
+         */
+        bool AddZone(const Zone& zone);
+        void Clear() noexcept;
+
+        const std::vector<Zone>& Zones() const noexcept { return m_zones; }
+        const Zone* FindZone(size_t id) const noexcept;
+
+        /**
+         * Add the zones of a layout computed from the number of zones.
+         *
+         * @param   width, height Size of the work area.
+         * @returns false, with no zones left, if the parameters give an invalid zone.
+         */
+        bool CalculateZones(LayoutType type, int width, int height, int zoneCount, int spacing);
+        bool CalculateGridZones(int width, int height, const GridLayout& grid, int spacing);
+        bool CalculateCanvasZones(const std::vector<Rect>& zones);
+
+        /**
+         * Build the hit-testing index and the navigation graph now rather than on first use, so that
+         * the const methods do not modify a layout shared between threads.
+         */
+        void UpdateIndexes() const;
+
+        /**
+         * Zones activated by the cursor during a drag: the zones within the sensitivity radius of the point,
+         * or one of them chosen by the selection algorithm if some of them overlap.
+         */
+        std::vector<size_t> ZonesFromPoint(Point pt) const;
+
+        /**
+         * Zones inside the bounding rectangle of the initial and final zones, as when a window is dragged
+         * or extended over several zones.
+         */
+        std::vector<size_t> GetCombinedZoneRange(const std::vector<size_t>& initialZones, const std::vector<size_t>& finalZones) const;
+
+        /**
+         * Closest zone to a window in a direction, ignoring the given zones.
+         *
+         * @returns The zone id, if any zone lies in that direction.
+         */
+        std::optional<size_t> ZoneByDirection(Direction direction, const Rect& windowRect, const std::vector<size_t>& ignoredZones) const;
+
+        /**
+         * Closest zone to a zone in a direction, as ZoneByDirection from the zone rectangle ignoring the zone,
+         * looked up in the navigation graph built with the zones.
+         *
+         * @returns The zone id, if the zone exists and another zone lies in that direction.
+         */
+        std::optional<size_t> NeighborZone(size_t zoneId, Direction direction) const;
+
+        /**
+         * Index of the closest rectangle to a window in a direction, zoneRects.size() if none.
+         */
+        static size_t ChooseNextZoneByPosition(Direction direction, const Rect& windowRect, const std::vector<Rect>& zoneRects) noexcept;
+
+        /**
+         * Window rectangle moved by the size of the work area in the direction opposite to a move, to cycle
+         * from the last zones in that direction to the first ones.
+         */
+        static Rect PrepareRectForCycling(Rect windowRect, const Rect& workAreaRect, Direction direction) noexcept;
+
+    private:
+        bool CalculateFocusLayout(int width, int height, int zoneCount);
+        bool CalculateColumnsAndRowsLayout(LayoutType type, int width, int height, int zoneCount, int spacing);
+        bool CalculateGridLayout(LayoutType type, int width, int height, int zoneCount, int spacing);
+        bool AddGridZones(int width, int height, const GridLayout& grid, int spacing);
+        bool AddCalculatedZone(const Rect& rect, size_t id);
+        void UpdateSpatialIndex() const;
+        void UpdateNavigationGraph() const;
+        std::vector<size_t> ZoneSelectSubregion(const std::vector<size_t>& capturedZones, Point pt) const;
+        size_t ZoneSelectPriority(const std::vector<size_t>& capturedZones, bool smallest) const;
+
+        std::vector<Zone> m_zones;
+        int m_sensitivityRadius;
+        SelectionAlgorithm m_selectionAlgorithm;
+
+        // Hit-testing index over m_zones, rebuilt after the zones change
+        mutable ZoneSpatialIndex m_spatialIndex;
+        mutable bool m_spatialIndexDirty = true;
+
+        // Neighbor of each zone of m_zones in each direction, by index in m_zones, rebuilt after the zones change
+        static constexpr size_t NoNeighbor = static_cast<size_t>(-1);
+        mutable std::vector<std::array<size_t, 4>> m_navigationGraph;
+        mutable bool m_navigationGraphDirty = true;
+    };
+}
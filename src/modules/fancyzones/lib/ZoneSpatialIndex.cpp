@@ -0,0 +1,193 @@
+// Built without the precompiled header, see ZoneGeometry.h
+#include "ZoneSpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace FancyZonesLayout
+{
+    void ZoneSpatialIndex::Build(const std::vector<Zone>& zones, int sensitivityRadius)
+    {
+        m_zones = zones;
+        m_sensitivityRadius = sensitivityRadius;
+        m_cellStarts.clear();
+        m_cellZones.clear();
+        m_cellHasOverlap.clear();
+        m_overlapStarts.clear();
+        m_overlaps.clear();
+        m_columns = 0;
+        m_rows = 0;
+
+        if (m_zones.empty())
+        {
+            return;
+        }
+
+        // A zone is captured up to the sensitivity radius around it, and strictly captured inside it,
+        // so it belongs to the cells touched by the larger of the two rectangles.
+        const int64_t margin = std::max(sensitivityRadius, 0);
+        int64_t left = std::numeric_limits<int64_t>::max();
+        int64_t top = std::numeric_limits<int64_t>::max();
+        int64_t right = std::numeric_limits<int64_t>::min();
+        int64_t bottom = std::numeric_limits<int64_t>::min();
+        for (const auto& zone : m_zones)
+        {
+            left = std::min(left, zone.rect.left - margin);
+            top = std::min(top, zone.rect.top - margin);
+            right = std::max(right, zone.rect.right + margin);
+            bottom = std::max(bottom, zone.rect.bottom + margin);
+        }
+
+        m_left = left;
+        m_top = top;
+        m_width = right - left + 1;
+        m_height = bottom - top + 1;
+
+        // About four cells per zone, so that most cells hold a zone or two
+        const int64_t cellsPerSide = std::clamp(static_cast<int64_t>(std::ceil(std::sqrt(static_cast<double>(m_zones.size())))) * 2, static_cast<int64_t>(1), static_cast<int64_t>(MaxCellsPerSide));
+        m_columns = static_cast<int>(std::min(cellsPerSide, m_width));
+        m_rows = static_cast<int>(std::min(cellsPerSide, m_height));
+
+        // Overlapping pairs, checked once here instead of for every captured pair on every query
+        std::vector<std::vector<uint32_t>> overlaps(m_zones.size());
+        for (uint32_t i = 0; i < m_zones.size(); ++i)
+        {
+            for (uint32_t j = i + 1; j < m_zones.size(); ++j)
+            {
+                if (Overlap(m_zones[i].rect, m_zones[j].rect))
+                {
+                    overlaps[i].push_back(j);
+                    overlaps[j].push_back(i);
+                }
+            }
+        }
+
+        m_overlapStarts.reserve(m_zones.size() + 1);
+        for (auto& zoneOverlaps : overlaps)
+        {
+            m_overlapStarts.push_back(static_cast<uint32_t>(m_overlaps.size()));
+            std::sort(zoneOverlaps.begin(), zoneOverlaps.end());
+            m_overlaps.insert(m_overlaps.end(), zoneOverlaps.begin(), zoneOverlaps.end());
+        }
+        m_overlapStarts.push_back(static_cast<uint32_t>(m_overlaps.size()));
+
+        // Count, then fill, the zones of every cell. Zones are added in index order, so every cell lists its zones in id order.
+        const size_t cellCount = static_cast<size_t>(m_columns) * m_rows;
+        std::vector<uint32_t> counts(cellCount + 1, 0);
+        auto forEachCell = [&](const Rect& rect, auto callback) {
+            const int firstColumn = Column(rect.left - margin);
+            const int lastColumn = Column(rect.right + margin);
+            const int firstRow = Row(rect.top - margin);
+            const int lastRow = Row(rect.bottom + margin);
+            for (int row = firstRow; row <= lastRow; ++row)
+            {
+                for (int column = firstColumn; column <= lastColumn; ++column)
+                {
+                    callback(static_cast<size_t>(row) * m_columns + column);
+                }
+            }
+        };
+
+        for (const auto& zone : m_zones)
+        {
+            forEachCell(zone.rect, [&](size_t cell) { ++counts[cell + 1]; });
+        }
+
+        for (size_t cell = 0; cell < cellCount; ++cell)
+        {
+            counts[cell + 1] += counts[cell];
+        }
+
+        m_cellStarts = counts;
+        m_cellZones.resize(m_cellStarts[cellCount]);
+        for (uint32_t zone = 0; zone < m_zones.size(); ++zone)
+        {
+            forEachCell(m_zones[zone].rect, [&](size_t cell) { m_cellZones[counts[cell]++] = zone; });
+        }
+
+        // A cell has overlapping zones if one of its zones overlaps another one of its zones
+        m_cellHasOverlap.assign(cellCount, false);
+        std::vector<bool> inCell(m_zones.size(), false);
+        for (size_t cell = 0; cell < cellCount; ++cell)
+        {
+            const auto begin = m_cellZones.begin() + m_cellStarts[cell];
+            const auto end = m_cellZones.begin() + m_cellStarts[cell + 1];
+            for (auto it = begin; it != end; ++it)
+            {
+                inCell[*it] = true;
+            }
+
+            for (auto it = begin; it != end && !m_cellHasOverlap[cell]; ++it)
+            {
+                for (uint32_t i = m_overlapStarts[*it]; i < m_overlapStarts[*it + 1]; ++i)
+                {
+                    if (inCell[m_overlaps[i]])
+                    {
+                        m_cellHasOverlap[cell] = true;
+                        break;
+                    }
+                }
+            }
+
+            for (auto it = begin; it != end; ++it)
+            {
+                inCell[*it] = false;
+            }
+        }
+    }
+
+    void ZoneSpatialIndex::Query(Point pt, Hit& hit) const noexcept
+    {
+        hit.capturedZones.clear();
+        hit.strictlyCaptured = false;
+        hit.overlap = false;
+
+        if (m_zones.empty() || pt.x < m_left || pt.y < m_top || pt.x - m_left >= m_width || pt.y - m_top >= m_height)
+        {
+            return;
+        }
+
+        const size_t cell = static_cast<size_t>(Row(pt.y)) * m_columns + Column(pt.x);
+        const bool cellHasOverlap = m_cellHasOverlap[cell];
+        for (uint32_t i = m_cellStarts[cell]; i < m_cellStarts[cell + 1]; ++i)
+        {
+            const uint32_t zone = m_cellZones[i];
+            const Rect& rect = m_zones[zone].rect;
+            if (rect.left - m_sensitivityRadius <= pt.x && pt.x <= rect.right + m_sensitivityRadius &&
+                rect.top - m_sensitivityRadius <= pt.y && pt.y <= rect.bottom + m_sensitivityRadius)
+            {
+                // Overlaps are symmetric, so checking each captured zone against the ones captured before covers every pair
+                if (cellHasOverlap && !hit.overlap)
+                {
+                    hit.overlap = OverlapsCaptured(zone, hit.capturedZones);
+                }
+                hit.capturedZones.push_back(m_zones[zone].id);
+            }
+
+            if (rect.left <= pt.x && pt.x < rect.right &&
+                rect.top <= pt.y && pt.y < rect.bottom)
+            {
+                hit.strictlyCaptured = true;
+            }
+        }
+    }
+
+    bool ZoneSpatialIndex::Overlap(const Rect& first, const Rect& second) const noexcept
+    {
+        return std::max(first.top, second.top) + m_sensitivityRadius < std::min(first.bottom, second.bottom) &&
+                   std::max(first.left, second.left) + m_sensitivityRadius < std::min(first.right, second.right);
+    }
+
+    bool ZoneSpatialIndex::OverlapsCaptured(uint32_t zone, const std::vector<size_t>& capturedZones) const noexcept
+    {
+        for (uint32_t i = m_overlapStarts[zone]; i < m_overlapStarts[zone + 1]; ++i)
+        {
+            if (std::binary_search(capturedZones.begin(), capturedZones.end(), m_zones[m_overlaps[i]].id))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
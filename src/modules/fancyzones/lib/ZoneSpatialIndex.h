@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ZoneGeometry.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace FancyZonesLayout
+{
+    /**
+     * Uniform grid over the zones of a zone set, used to find the zones under the cursor while a window is dragged.
+     *
+     * Each cell lists, in ascending id order, the zones whose rectangle grown by the sensitivity radius touches the
+     * cell, and whether two of them overlap. A query only tests the zones of the cell containing the point, and only
+     * looks for overlapping zones when the cell has some.
+     */
+    class ZoneSpatialIndex
+    {
+    public:
+        /**
+         * Result of a query, as computed by testing every zone of the zone set.
+         */
+        struct Hit
+        {
+            // Zones whose rectangle grown by the sensitivity radius contains the point, in ascending id order.
+            std::vector<size_t> capturedZones;
+            // Whether the rectangle itself of one of the captured zones contains the point.
+            bool strictlyCaptured = false;
+            // Whether two of the captured zones overlap by more than the sensitivity radius.
+            bool overlap = false;
+        };
+
+        /**
+         * Build the index.
+         *
+         * @param   zones             Zones of the zone set, in ascending id order.
+         * @param   sensitivityRadius Distance from a zone at which the zone is still captured.
+         */
+        void Build(const std::vector<Zone>& zones, int sensitivityRadius);
+
+        /**
+         * Find the zones captured by a point.
+         *
+         * @param   pt  The point, in the coordinates of the zones.
+         * @param   hit Receives the captured zones.
+         */
+        void Query(Point pt, Hit& hit) const noexcept;
+
+        bool Empty() const noexcept { return m_zones.empty(); }
+        size_t CellCount() const noexcept { return m_cellHasOverlap.size(); }
+
+    private:
+        bool Overlap(const Rect& first, const Rect& second) const noexcept;
+        bool OverlapsCaptured(uint32_t zone, const std::vector<size_t>& capturedZones) const noexcept;
+        int Column(int64_t x) const noexcept { return static_cast<int>((x - m_left) * m_columns / m_width); }
+        int Row(int64_t y) const noexcept { return static_cast<int>((y - m_top) * m_rows / m_height); }
+
+        // Maximum number of columns and rows
+        static constexpr int MaxCellsPerSide = 64;
+
+        std::vector<Zone> m_zones;
+        int m_sensitivityRadius = 0;
+
+        // Bounds of the grid, the union of the zone rectangles grown by the sensitivity radius, bounds included
+        int64_t m_left = 0;
+        int64_t m_top = 0;
+        int64_t m_width = 0;
+        int64_t m_height = 0;
+        int m_columns = 0;
+        int m_rows = 0;
+
+        // Zones of cell c are m_cellZones[m_cellStarts[c]] to m_cellZones[m_cellStarts[c + 1] - 1], as indices in m_zones
+        std::vector<uint32_t> m_cellStarts;
+        std::vector<uint32_t> m_cellZones;
+        std::vector<bool> m_cellHasOverlap;
+
+        // Zones overlapping zone z are m_overlaps[m_overlapStarts[z]] to m_overlaps[m_overlapStarts[z + 1] - 1], as indices in m_zones
+        std::vector<uint32_t> m_overlapStarts;
+        std::vector<uint32_t> m_overlaps;
+    };
+}
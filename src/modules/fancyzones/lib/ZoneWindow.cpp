@@ -532,6 +532,15 @@ LRESULT ZoneWindow::WndProc(UINT message, WPARAM wparam, LPARAM lparam) noexcept
     case WM_ERASEBKGND:
         return 1;
 
+    case ZoneWindowDrawing::WM_HIDE_ZONES:
+    {
+        if (m_zoneWindowDrawing)
+        {
+            m_zoneWindowDrawing->OnHideZones();
+        }
+    }
+    break;
+
     default:
     {
         return DefWindowProc(m_window, message, wparam, lparam);
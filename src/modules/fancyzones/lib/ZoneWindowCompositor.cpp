@@ -0,0 +1,236 @@
+// Built without the precompiled header, see ZoneWindowCompositor.h
+#include "ZoneWindowCompositor.h"
+
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <dwmapi.h>
+#endif
+
+namespace
+{
+    void WaitForDisplayRefresh()
+    {
+#ifdef _WIN32
+        // Returns once the desktop window manager composed the next frame
+        if (SUCCEEDED(DwmFlush()))
+        {
+            return;
+        }
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    }
+}
+
+ZoneWindowCompositor::ZoneWindowCompositor(WaitForRefresh waitForRefresh, std::chrono::milliseconds idleTimeout) :
+    m_waitForRefresh(waitForRefresh ? std::move(waitForRefresh) : WaitForDisplayRefresh),
+    m_idleTimeout(idleTimeout)
+{
+}
+
+ZoneWindowCompositor::~ZoneWindowCompositor()
+{
+    {
+        std::scoped_lock lock{ m_mutex };
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void ZoneWindowCompositor::AddClient(Client* client)
+{
+    std::scoped_lock lock{ m_mutex };
+    m_clients.emplace(client, ClientState{});
+}
+
+void ZoneWindowCompositor::RemoveClient(Client* client)
+{
+    std::unique_lock frameLock{ m_frameMutex };
+    std::unique_lock lock{ m_mutex };
+    m_clients.erase(client);
+    frameLock.unlock();
+
+    if (!m_clients.empty())
+    {
+        return;
+    }
+
+    // The thread exits without clients, it is joined here rather than when the module is unloaded
+    m_cv.notify_all();
+    m_cv.wait(lock, [this]() { return !m_running || !m_clients.empty(); });
+    if (!m_running && m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void ZoneWindowCompositor::RequestFrame(Client* client)
+{
+    std::scoped_lock lock{ m_mutex };
+    if (auto state = m_clients.find(client); state != m_clients.end())
+    {
+        state->second.frameRequested = true;
+        StartThread();
+        m_cv.notify_all();
+    }
+}
+
+void ZoneWindowCompositor::RequestFrameAt(Client* client, std::chrono::steady_clock::time_point time)
+{
+    std::scoped_lock lock{ m_mutex };
+    if (auto state = m_clients.find(client); state != m_clients.end())
+    {
+        state->second.frameTime = time;
+        StartThread();
+        m_cv.notify_all();
+    }
+}
+
+bool ZoneWindowCompositor::IsThreadRunning() const
+{
+    std::scoped_lock lock{ m_mutex };
+    return m_running;
+}
+
+ZoneWindowCompositor::Statistics ZoneWindowCompositor::GetStatistics() const
+{
+    std::scoped_lock lock{ m_mutex };
+    return m_statistics;
+}
+
+void ZoneWindowCompositor::StartThread()
+{
+    // Lock is held by the caller
+
+    if (m_running || m_stop)
+    {
+        return;
+    }
+
+    // A thread that exited when idle has released the lock and is about to return
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    m_running = true;
+    ++m_statistics.threadStarts;
+    m_thread = std::thread([this]() { Run(); });
+}
+
+void ZoneWindowCompositor::Run()
+{
+    std::vector<Client*> dueClients;
+    bool idle = false;
+
+    while (true)
+    {
+        // The frame lock is taken first, as in RemoveClient
+        std::unique_lock frameLock{ m_frameMutex };
+        std::unique_lock lock{ m_mutex };
+
+        if (m_stop || m_clients.empty())
+        {
+            break;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        std::optional<std::chrono::steady_clock::time_point> nextFrameTime;
+        dueClients.clear();
+        for (auto& [client, state] : m_clients)
+        {
+            if (state.frameTime && *state.frameTime <= now)
+            {
+                state.frameTime.reset();
+                state.frameRequested = true;
+            }
+
+            if (state.frameRequested)
+            {
+                state.frameRequested = false;
+                dueClients.push_back(client);
+            }
+            else if (state.frameTime && (!nextFrameTime || *state.frameTime < *nextFrameTime))
+            {
+                nextFrameTime = state.frameTime;
+            }
+        }
+
+        if (dueClients.empty())
+        {
+            if (idle && !nextFrameTime)
+            {
+                break;
+            }
+
+            frameLock.unlock();
+            if (nextFrameTime)
+            {
+                m_cv.wait_until(lock, *nextFrameTime);
+                idle = false;
+            }
+            else
+            {
+                idle = m_cv.wait_for(lock, m_idleTimeout) == std::cv_status::timeout;
+            }
+            continue;
+        }
+
+        idle = false;
+        lock.unlock();
+
+        std::vector<Client*> renderedClients;
+        for (Client* client : dueClients)
+        {
+            if (client->RenderFrame())
+            {
+                renderedClients.push_back(client);
+            }
+        }
+        frameLock.unlock();
+
+        // Clients that drew keep rendering on the next refresh, until they draw nothing
+        if (!renderedClients.empty())
+        {
+            m_waitForRefresh();
+        }
+
+        lock.lock();
+        for (Client* client : renderedClients)
+        {
+            if (auto state = m_clients.find(client); state != m_clients.end())
+            {
+                state->second.frameRequested = true;
+            }
+        }
+
+        m_statistics.clientFrames += dueClients.size();
+        m_statistics.idleClientFrames += dueClients.size() - renderedClients.size();
+        if (!renderedClients.empty())
+        {
+            ++m_statistics.frames;
+        }
+    }
+
+    std::scoped_lock lock{ m_mutex };
+    m_running = false;
+    m_cv.notify_all();
+}
+
+ZoneWindowCompositor& ZoneWindowCompositorInstance()
+{
+    static ZoneWindowCompositor instance;
+    return instance;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+/**
+ * Renders the overlays of all zone windows on one thread, paced to the display refresh.
+ *
+ * A client asks for a frame when its state changes, or for a frame at a given time, e.g. when a flash
+ * ends, and keeps getting a frame per refresh while it reports that it rendered, i.e. while an
+ * animation is in progress. Windows present without waiting for the vertical sync and the thread
+ * waits once per frame for all of them. The thread sleeps while no client needs a frame, and exits
+ * when it was idle for IdleTimeout, until the next request.
+ *
+ * Builds without the precompiled header, see tests/UnitTests/ZoneWindowCompositor.Spec.cpp.
+ */
+class ZoneWindowCompositor
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        /**
+         * Render a frame, on the compositor thread.
+         * Called under the frame lock, which RemoveClient also takes: the client must not wait
+         * on its window's thread, e.g. with a synchronous ShowWindow or SendMessage.
+         * @returns True if something was drawn, the client gets another frame on the next refresh.
+         */
+        virtual bool RenderFrame() = 0;
+    };
+
+    struct Statistics
+    {
+        // Refreshes waited for, each rendering the clients that needed a frame
+        size_t frames = 0;
+        // Frames rendered by the clients
+        size_t clientFrames = 0;
+        // Client frames that drew nothing
+        size_t idleClientFrames = 0;
+        size_t threadStarts = 0;
+    };
+
+    using WaitForRefresh = std::function<void()>;
+
+    static constexpr std::chrono::milliseconds IdleTimeout{ 5000 };
+
+    /**
+     * @param waitForRefresh Blocks until the next display refresh, DwmFlush by default.
+     */
+    explicit ZoneWindowCompositor(WaitForRefresh waitForRefresh = nullptr, std::chrono::milliseconds idleTimeout = IdleTimeout);
+    ~ZoneWindowCompositor();
+
+    ZoneWindowCompositor(const ZoneWindowCompositor&) = delete;
+    ZoneWindowCompositor& operator=(const ZoneWindowCompositor&) = delete;
+
+    void AddClient(Client* client);
+
+    /**
+     * Remove a client, waits until a frame rendering it has ended.
+     */
+    void RemoveClient(Client* client);
+
+    /**
+     * Render the client on the next refresh.
+     */
+    void RequestFrame(Client* client);
+
+    /**
+     * Render the client at the given time, replacing an earlier request for a time.
+     */
+    void RequestFrameAt(Client* client, std::chrono::steady_clock::time_point time);
+
+    bool IsThreadRunning() const;
+    Statistics GetStatistics() const;
+
+private:
+    struct ClientState
+    {
+        bool frameRequested = false;
+        std::optional<std::chrono::steady_clock::time_point> frameTime;
+    };
+
+    void StartThread();
+    void Run();
+
+    const WaitForRefresh m_waitForRefresh;
+    const std::chrono::milliseconds m_idleTimeout;
+
+    // Held while the clients render, so that a client is not removed during its frame
+    std::mutex m_frameMutex;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<Client*, ClientState> m_clients;
+    bool m_running = false;
+    bool m_stop = false;
+    Statistics m_statistics;
+    std::thread m_thread;
+};
+
+ZoneWindowCompositor& ZoneWindowCompositorInstance();
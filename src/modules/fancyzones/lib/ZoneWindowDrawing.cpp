@@ -15,11 +15,6 @@ namespace
     const int FlashZonesDurationMillis = 700;
 }
 
-namespace NonLocalizable
-{
-    const wchar_t SegoeUiFont[] = L"Segoe ui";
-}
-
 float ZoneWindowDrawing::GetAnimationAlpha()
 {
     // Lock is held by the caller
@@ -51,16 +46,6 @@ ID2D1Factory* ZoneWindowDrawing::GetD2DFactory()
     return pD2DFactory;
 }
 
-IDWriteFactory* ZoneWindowDrawing::GetWriteFactory()
-{
-    static auto pDWriteFactory = [] {
-        IUnknown* res = nullptr;
-        DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), &res);
-        return reinterpret_cast<IDWriteFactory*>(res);
-    }();
-    return pDWriteFactory;
-}
-
 D2D1_COLOR_F ZoneWindowDrawing::ConvertColor(COLORREF color)
 {
     return D2D1::ColorF(GetRValue(color) / 255.f,
@@ -76,7 +61,6 @@ D2D1_RECT_F ZoneWindowDrawing::ConvertRect(RECT rect)
 
 ZoneWindowDrawing::ZoneWindowDrawing(HWND window)
 {
-    HRESULT hr;
     m_window = window;
     m_renderTarget = nullptr;
     m_shouldRender = false;
@@ -88,6 +72,16 @@ ZoneWindowDrawing::ZoneWindowDrawing(HWND window)
         return;
     }
 
+    if (!CreateRenderTarget())
+    {
+        return;
+    }
+
+    ZoneWindowCompositorInstance().AddClient(this);
+}
+
+bool ZoneWindowDrawing::CreateRenderTarget()
+{
     // Create a Direct2D render target
     // We should always use the DPI value of 96 since we're running in DPI aware mode
     auto renderTargetProperties = D2D1::RenderTargetProperties(
@@ -96,18 +90,21 @@ ZoneWindowDrawing::ZoneWindowDrawing(HWND window)
         96.f,
         96.f);
 
+    // The contents are retained between frames, as frames only redraw the zones that changed.
+    // Presenting does not wait for the vertical sync, the compositor waits once for all windows.
     auto renderTargetSize = D2D1::SizeU(m_clientRect.right - m_clientRect.left, m_clientRect.bottom - m_clientRect.top);
-    auto hwndRenderTargetProperties = D2D1::HwndRenderTargetProperties(window, renderTargetSize);
+    auto hwndRenderTargetProperties = D2D1::HwndRenderTargetProperties(m_window, renderTargetSize, D2D1_PRESENT_OPTIONS_RETAIN_CONTENTS | D2D1_PRESENT_OPTIONS_IMMEDIATELY);
 
-    hr = GetD2DFactory()->CreateHwndRenderTarget(renderTargetProperties, hwndRenderTargetProperties, &m_renderTarget);
+    HRESULT hr = GetD2DFactory()->CreateHwndRenderTarget(renderTargetProperties, hwndRenderTargetProperties, &m_renderTarget);
 
     if (!SUCCEEDED(hr))
     {
         Logger::error("couldn't initialize ZoneWindowDrawing: CreateHwndRenderTarget failed with {}", hr);
-        return;
+        m_renderTarget = nullptr;
+        return false;
     }
 
-    m_renderThread = std::thread([this]() { RenderLoop(); });
+    return true;
 }
 
 ZoneWindowDrawing::RenderResult ZoneWindowDrawing::Render()
@@ -119,6 +116,11 @@ ZoneWindowDrawing::RenderResult ZoneWindowDrawing::Render()
         return RenderResult::Failed;
     }
 
+    if (!m_shouldRender)
+    {
+        return RenderResult::Idle;
+    }
+
     float animationAlpha = GetAnimationAlpha();
 
     if (animationAlpha <= 0.f)
@@ -126,104 +128,73 @@ ZoneWindowDrawing::RenderResult ZoneWindowDrawing::Render()
         return RenderResult::AnimationEnded;
     }
 
-    m_renderTarget->BeginDraw();
-
-    // Draw backdrop
-    m_renderTarget->Clear(D2D1::ColorF(0.f, 0.f, 0.f, 0.f));
-
-    ID2D1SolidColorBrush* textBrush = nullptr;
-    IDWriteTextFormat* textFormat = nullptr;
-
-    m_renderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black, animationAlpha), &textBrush);
-    auto writeFactory = GetWriteFactory();
-
-    if (writeFactory)
+    if (!m_renderer.NeedsRender(animationAlpha))
     {
-        writeFactory->CreateTextFormat(NonLocalizable::SegoeUiFont, nullptr, DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, 80.f, L"en-US", &textFormat);
+        return RenderResult::Idle;
     }
 
-    for (auto drawableRect : m_sceneRects)
-    {
-        ID2D1SolidColorBrush* borderBrush = nullptr;
-        ID2D1SolidColorBrush* fillBrush = nullptr;
-
-        // Need to copy the rect from m_sceneRects
-        drawableRect.borderColor.a *= animationAlpha;
-        drawableRect.fillColor.a *= animationAlpha;
-
-        m_renderTarget->CreateSolidColorBrush(drawableRect.borderColor, &borderBrush);
-        m_renderTarget->CreateSolidColorBrush(drawableRect.fillColor, &fillBrush);
-
-        if (fillBrush)
-        {
-            m_renderTarget->FillRectangle(drawableRect.rect, fillBrush);
-            fillBrush->Release();
-        }
+    m_renderTarget->BeginDraw();
+    m_renderer.Render(m_renderTarget, animationAlpha);
 
-        if (borderBrush)
-        {
-            m_renderTarget->DrawRectangle(drawableRect.rect, borderBrush);
-            borderBrush->Release();
-        }
+    // The lock is released while the frame is presented
+    lock.unlock();
 
-        std::wstring idStr = std::to_wstring(drawableRect.id + 1);
+    HRESULT hr = m_renderTarget->EndDraw();
+    if (hr == D2DERR_RECREATE_TARGET)
+    {
+        lock.lock();
+        m_renderer.DiscardDeviceResources();
+        m_renderTarget->Release();
+        m_renderTarget = nullptr;
 
-        if (textFormat && textBrush)
+        if (!CreateRenderTarget())
         {
-            textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
-            textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
-            m_renderTarget->DrawTextW(idStr.c_str(), (UINT32)idStr.size(), textFormat, drawableRect.rect, textBrush);
+            return RenderResult::Failed;
         }
     }
 
-    if (textFormat)
-    {
-        textFormat->Release();
-    }
-
-    if (textBrush)
-    {
-        textBrush->Release();
-    }
-
-    // The lock must be released here, as EndDraw() will wait for vertical sync
-    lock.unlock();
-
-    m_renderTarget->EndDraw();
     return RenderResult::Ok;
 }
 
-void ZoneWindowDrawing::RenderLoop()
+bool ZoneWindowDrawing::RenderFrame()
 {
-    while (!m_abortThread)
+    auto result = Render();
+
+    if (result == RenderResult::AnimationEnded || result == RenderResult::Failed)
     {
+        // The window's thread may be waiting in RemoveClient for this frame to end, so the
+        // window is hidden by its thread, unless it was shown again in the meantime
+        if (StopRendering())
         {
-            // Wait here while rendering is disabled
-            std::unique_lock lock(m_mutex);
-            m_cv.wait(lock, [this]() { return (bool)m_shouldRender; });
+            PostMessage(m_window, WM_HIDE_ZONES, 0, 0);
         }
+    }
 
-        auto result = Render();
+    return result == RenderResult::Ok;
+}
 
-        if (result == RenderResult::AnimationEnded || result == RenderResult::Failed)
-        {
-            Hide();
-        }
-    }
+bool ZoneWindowDrawing::StopRendering()
+{
+    std::unique_lock lock(m_mutex);
+    m_animation.reset();
+    bool wasRendering = m_shouldRender;
+    m_shouldRender = false;
+    return wasRendering;
 }
 
 void ZoneWindowDrawing::Hide()
 {
     _TRACER_;
-    bool shouldHideWindow = true;
+    if (StopRendering())
     {
-        std::unique_lock lock(m_mutex);
-        m_animation.reset();
-        shouldHideWindow = m_shouldRender;
-        m_shouldRender = false;
+        ShowWindow(m_window, SW_HIDE);
     }
+}
 
-    if (shouldHideWindow)
+void ZoneWindowDrawing::OnHideZones()
+{
+    _TRACER_;
+    if (!m_shouldRender)
     {
         ShowWindow(m_window, SW_HIDE);
     }
@@ -237,6 +208,7 @@ void ZoneWindowDrawing::Show()
         std::unique_lock lock(m_mutex);
         shouldShowWindow = !m_shouldRender;
         m_shouldRender = true;
+        m_renderer.Invalidate();
 
         if (!m_animation)
         {
@@ -254,19 +226,21 @@ void ZoneWindowDrawing::Show()
         ShowWindow(m_window, SW_SHOWNA);
     }
 
-    m_cv.notify_all();
+    ZoneWindowCompositorInstance().RequestFrame(this);
 }
 
 void ZoneWindowDrawing::Flash()
 {
     _TRACER_;
     bool shouldShowWindow = true;
+    auto tStart = std::chrono::steady_clock().now();
     {
         std::unique_lock lock(m_mutex);
         shouldShowWindow = !m_shouldRender;
         m_shouldRender = true;
+        m_renderer.Invalidate();
 
-        m_animation.emplace(AnimationInfo{ .tStart = std::chrono::steady_clock().now(), .autoHide = true });
+        m_animation.emplace(AnimationInfo{ .tStart = tStart, .autoHide = true });
     }
 
     if (shouldShowWindow)
@@ -274,7 +248,10 @@ void ZoneWindowDrawing::Flash()
         ShowWindow(m_window, SW_SHOWNA);
     }
 
-    m_cv.notify_all();
+    // The zones are hidden by the first frame after the flash
+    auto& compositor = ZoneWindowCompositorInstance();
+    compositor.RequestFrame(this);
+    compositor.RequestFrameAt(this, tStart + std::chrono::milliseconds(FlashZonesDurationMillis + 1));
 }
 
 void ZoneWindowDrawing::DrawActiveZoneSet(const IZoneSet::ZonesMap& zones,
@@ -282,9 +259,7 @@ void ZoneWindowDrawing::DrawActiveZoneSet(const IZoneSet::ZonesMap& zones,
                                           winrt::com_ptr<IZoneWindowHost> host)
 {
     _TRACER_;
-    std::unique_lock lock(m_mutex);
-
-    m_sceneRects = {};
+    std::vector<ZoneOverlayRenderer::DrawableRect> sceneRects;
 
     auto borderColor = ConvertColor(host->GetZoneBorderColor());
     auto inactiveColor = ConvertColor(host->GetZoneColor());
@@ -309,14 +284,14 @@ void ZoneWindowDrawing::DrawActiveZoneSet(const IZoneSet::ZonesMap& zones,
 
         if (!isHighlighted[zoneId])
         {
-            DrawableRect drawableRect{
+            ZoneOverlayRenderer::DrawableRect drawableRect{
                 .rect = ConvertRect(zone->GetZoneRect()),
                 .borderColor = borderColor,
                 .fillColor = inactiveColor,
                 .id = zone->Id()
             };
 
-            m_sceneRects.push_back(drawableRect);
+            sceneRects.push_back(drawableRect);
         }
     }
 
@@ -330,27 +305,34 @@ void ZoneWindowDrawing::DrawActiveZoneSet(const IZoneSet::ZonesMap& zones,
 
         if (isHighlighted[zoneId])
         {
-            DrawableRect drawableRect{
+            ZoneOverlayRenderer::DrawableRect drawableRect{
                 .rect = ConvertRect(zone->GetZoneRect()),
                 .borderColor = borderColor,
                 .fillColor = highlightColor,
                 .id = zone->Id()
             };
 
-            m_sceneRects.push_back(drawableRect);
+            sceneRects.push_back(drawableRect);
         }
     }
-}
 
-ZoneWindowDrawing::~ZoneWindowDrawing()
-{
     {
         std::unique_lock lock(m_mutex);
-        m_abortThread = true;
-        m_shouldRender = true;
+        m_renderer.SetScene(std::move(sceneRects));
     }
-    m_cv.notify_all();
-    m_renderThread.join();
+
+    ZoneWindowCompositorInstance().RequestFrame(this);
+}
+
+ZoneOverlayRenderer::Statistics ZoneWindowDrawing::GetRenderStatistics()
+{
+    std::unique_lock lock(m_mutex);
+    return m_renderer.GetStatistics();
+}
+
+ZoneWindowDrawing::~ZoneWindowDrawing()
+{
+    ZoneWindowCompositorInstance().RemoveClient(this);
 
     if (m_renderTarget)
     {
@@ -11,17 +11,11 @@
 #include "Zone.h"
 #include "ZoneSet.h"
 #include "FancyZones.h"
+#include "ZoneOverlayRenderer.h"
+#include "ZoneWindowCompositor.h"
 
-class ZoneWindowDrawing
+class ZoneWindowDrawing : private ZoneWindowCompositor::Client
 {
-    struct DrawableRect
-    {
-        D2D1_RECT_F rect;
-        D2D1_COLOR_F borderColor;
-        D2D1_COLOR_F fillColor;
-        size_t id;
-    };
-
     struct AnimationInfo
     {
         std::chrono::steady_clock::time_point tStart;
@@ -31,6 +25,8 @@ class ZoneWindowDrawing
     enum struct RenderResult
     {
         Ok,
+        // Nothing changed since the last frame
+        Idle,
         AnimationEnded,
         Failed,
     };
@@ -41,29 +37,33 @@ class ZoneWindowDrawing
     std::optional<AnimationInfo> m_animation;
 
     std::mutex m_mutex;
-    std::vector<DrawableRect> m_sceneRects;
+    ZoneOverlayRenderer m_renderer;
 
     float GetAnimationAlpha();
     static ID2D1Factory* GetD2DFactory();
-    static IDWriteFactory* GetWriteFactory();
     static D2D1_COLOR_F ConvertColor(COLORREF color);
     static D2D1_RECT_F ConvertRect(RECT rect);
+    bool CreateRenderTarget();
     RenderResult Render();
-    void RenderLoop();
+    // Returns true if the window was shown
+    bool StopRendering();
+    bool RenderFrame() override;
 
     std::atomic<bool> m_shouldRender = false;
-    std::atomic<bool> m_abortThread = false;
-    std::condition_variable m_cv;
-    std::thread m_renderThread;
 
 public:
+    // Posted to the window by the compositor thread when the zones should be hidden,
+    // the window procedure must call OnHideZones
+    static constexpr UINT WM_HIDE_ZONES = WM_APP + 1;
 
     ~ZoneWindowDrawing();
     ZoneWindowDrawing(HWND window);
     void Hide();
+    void OnHideZones();
     void Show();
     void Flash();
     void DrawActiveZoneSet(const IZoneSet::ZonesMap& zones,
                            const std::vector<size_t>& highlightZones,
                            winrt::com_ptr<IZoneWindowHost> host);
+    ZoneOverlayRenderer::Statistics GetRenderStatistics();
 };
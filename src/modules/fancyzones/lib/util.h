@@ -1,6 +1,9 @@
 #pragma once
 
 #include "gdiplus.h"
+#include "ZoneGeometry.h"
+
+#include <optional>
 #include <common/utils/string_utils.h>
 
 namespace FancyZonesDataTypes
@@ -40,6 +43,39 @@ namespace FancyZonesUtils
         RECT m_rect{};
     };
 
+    // Conversions to and from the types of the zone layout engine
+    inline FancyZonesLayout::Rect ToLayoutRect(const RECT& rect) noexcept
+    {
+        return { rect.left, rect.top, rect.right, rect.bottom };
+    }
+
+    inline RECT ToRECT(const FancyZonesLayout::Rect& rect) noexcept
+    {
+        return { rect.left, rect.top, rect.right, rect.bottom };
+    }
+
+    inline FancyZonesLayout::Point ToLayoutPoint(const POINT& pt) noexcept
+    {
+        return { pt.x, pt.y };
+    }
+
+    inline std::optional<FancyZonesLayout::Direction> DirectionFromVkCode(DWORD vkCode) noexcept
+    {
+        switch (vkCode)
+        {
+        case VK_LEFT:
+            return FancyZonesLayout::Direction::Left;
+        case VK_UP:
+            return FancyZonesLayout::Direction::Up;
+        case VK_RIGHT:
+            return FancyZonesLayout::Direction::Right;
+        case VK_DOWN:
+            return FancyZonesLayout::Direction::Down;
+        default:
+            return std::nullopt;
+        }
+    }
+
     inline void MakeWindowTransparent(HWND window)
     {
         int const pos = -GetSystemMetrics(SM_CXVIRTUALSCREEN) - 8;
@@ -0,0 +1,122 @@
+// Checks FileWatcher with the inotify backend: change detection, debouncing, content hashes and latency.
+//
+// FileWatcher builds without the Windows SDK, so this harness runs on Linux, for instance from src/modules/fancyzones:
+//
+//   g++ -std=c++20 -O2 -pthread -Ilib tests/FileWatcher/FileWatcherHarness.cpp lib/FileWatcher.cpp -o FileWatcherHarness
+//
+// The exit code is the number of failures.
+
+#include "FileWatcher.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    constexpr auto Debounce = 20ms;
+
+    int failures = 0;
+
+    void Check(bool condition, const char* description)
+    {
+        if (!condition)
+        {
+            std::printf("FAILED: %s\n", description);
+            ++failures;
+        }
+    }
+
+    void WriteFile(const std::filesystem::path& path, const std::string& contents)
+    {
+        std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+        file << contents;
+    }
+
+    // Waits for the callbacks with a generous timeout, then for more than the debounce period to catch extra ones
+    bool WaitForCount(const std::atomic<int>& count, int expected)
+    {
+        for (int i = 0; i < 400 && count < expected; ++i)
+        {
+            std::this_thread::sleep_for(5ms);
+        }
+        std::this_thread::sleep_for(Debounce * 4);
+        return count == expected;
+    }
+}
+
+int main()
+{
+    const auto directory = std::filesystem::temp_directory_path() / "FileWatcherHarness";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sub");
+
+    const auto settings = directory / "zones-settings.json";
+    const auto history = directory / "app-zone-history.json";
+    const auto other = directory / "sub" / "other.json";
+    WriteFile(settings, "{}");
+
+    std::atomic<int> settingsChanges = 0;
+    std::atomic<int> historyChanges = 0;
+    std::atomic<int> otherChanges = 0;
+    {
+        FileWatcher watcher{ Debounce };
+        Check(watcher.Watch(settings.wstring(), [&] { ++settingsChanges; }), "watch an existing file");
+        Check(watcher.Watch(history.wstring(), [&] { ++historyChanges; }), "watch a missing file");
+        Check(watcher.Watch(other.wstring(), [&] { ++otherChanges; }), "watch a file in another directory");
+        Check(WaitForCount(settingsChanges, 0), "no callback without changes");
+
+        const auto start = std::chrono::steady_clock::now();
+        WriteFile(settings, "{\"devices\":[]}");
+        for (int i = 0; i < 400 && settingsChanges == 0; ++i)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::printf("Reaction time %lld ms, debounce %lld ms\n", static_cast<long long>(latency.count()), static_cast<long long>(Debounce.count()));
+        Check(WaitForCount(settingsChanges, 1), "change calls back once");
+
+        for (int i = 0; i < 20; ++i)
+        {
+            WriteFile(settings, "{\"devices\":[" + std::to_string(i) + "]}");
+        }
+        Check(WaitForCount(settingsChanges, 2), "burst of writes calls back once");
+
+        WriteFile(settings, "{\"devices\":[19]}");
+        Check(WaitForCount(settingsChanges, 2), "same contents do not call back");
+
+        watcher.SetKnownContents(settings.wstring(), "{\"devices\":[\"self\"]}");
+        WriteFile(settings, "{\"devices\":[\"self\"]}");
+        Check(WaitForCount(settingsChanges, 2), "known contents do not call back");
+
+        WriteFile(history, "[]");
+        WriteFile(other, "[]");
+        Check(WaitForCount(historyChanges, 1), "created file calls back");
+        Check(WaitForCount(otherChanges, 1), "file in another directory calls back");
+        Check(WaitForCount(settingsChanges, 2), "other files do not call back");
+
+        std::filesystem::remove(history);
+        Check(WaitForCount(historyChanges, 2), "deleted file calls back");
+
+        WriteFile(directory / "zones-settings.json.tmp", "{\"renamed\":true}");
+        std::filesystem::rename(directory / "zones-settings.json.tmp", settings);
+        Check(WaitForCount(settingsChanges, 3), "file replaced by a rename calls back");
+
+        const auto statistics = watcher.GetStatistics();
+        std::printf("%zu notifications, %zu checks, %zu unchanged, %zu callbacks\n", statistics.notifications, statistics.checks, statistics.unchanged, statistics.callbacks);
+    }
+
+    // Idle watchers are stopped without waiting for a timeout
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i)
+    {
+        FileWatcher watcher{ settings.wstring(), [] {} };
+    }
+    Check(std::chrono::steady_clock::now() - start < 1s, "watchers stop promptly");
+
+    std::filesystem::remove_all(directory);
+    std::printf("%d failures\n", failures);
+    return failures;
+}
@@ -0,0 +1,524 @@
+// Replays drag paths and directional navigation through the zone layout engine and checks them against
+// brute-force references, then measures the layout calculations of virtual desktop switches with and
+// without the layout cache.
+//
+// The engine (ZoneGeometry.h, ZoneSpatialIndex, ZoneSetLayout, LayoutCache) only needs the standard library,
+// so this harness builds on any platform with a C++20 compiler, for instance from src/modules/fancyzones:
+//
+//   g++ -std=c++20 -O2 -Ilib tests/LayoutEngine/LayoutEngineHarness.cpp lib/ZoneSpatialIndex.cpp lib/ZoneSetLayout.cpp lib/LayoutCache.cpp -o LayoutEngineHarness
+//
+// Usage: LayoutEngineHarness [recorded drag paths]
+// A recorded file holds one "x y" cursor position per line, relative to a 3440x1440 work area, with an empty
+// line between drags. Without it, only synthetic drags are replayed. The exit code is the number of failures.
+
+#include "LayoutCache.h"
+#include "ZoneSetLayout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace FancyZonesLayout;
+
+namespace
+{
+    constexpr int WorkAreaWidth = 3440;
+    constexpr int WorkAreaHeight = 1440;
+
+    int failures = 0;
+
+    void Check(bool condition, const char* what, const std::string& context)
+    {
+        if (!condition)
+        {
+            if (++failures <= 20)
+            {
+                std::printf("FAILED: %s (%s)\n", what, context.c_str());
+            }
+        }
+    }
+
+    int Area(const Rect& rect)
+    {
+        return std::max(rect.height(), 0) * std::max(rect.width(), 0);
+    }
+
+    // ZoneSet::ZonesFromPoint before the spatial index: every zone is tested, then every captured pair
+    std::vector<size_t> ReferenceZonesFromPoint(const std::vector<Zone>& zones, int sensitivityRadius, SelectionAlgorithm algorithm, Point pt)
+    {
+        std::vector<size_t> capturedZones;
+        std::vector<Rect> capturedRects;
+        bool strictlyCaptured = false;
+        for (const Zone& zone : zones)
+        {
+            const Rect& rect = zone.rect;
+            if (rect.left - sensitivityRadius <= pt.x && pt.x <= rect.right + sensitivityRadius &&
+                rect.top - sensitivityRadius <= pt.y && pt.y <= rect.bottom + sensitivityRadius)
+            {
+                capturedZones.push_back(zone.id);
+                capturedRects.push_back(rect);
+            }
+
+            if (rect.left <= pt.x && pt.x < rect.right && rect.top <= pt.y && pt.y < rect.bottom)
+            {
+                strictlyCaptured = true;
+            }
+        }
+
+        if (capturedZones.size() == 1 && !strictlyCaptured)
+        {
+            return {};
+        }
+
+        bool overlap = false;
+        for (size_t i = 0; i < capturedRects.size() && !overlap; ++i)
+        {
+            for (size_t j = i + 1; j < capturedRects.size() && !overlap; ++j)
+            {
+                const Rect& first = capturedRects[i];
+                const Rect& second = capturedRects[j];
+                overlap = std::max(first.top, second.top) + sensitivityRadius < std::min(first.bottom, second.bottom) &&
+                          std::max(first.left, second.left) + sensitivityRadius < std::min(first.right, second.right);
+            }
+        }
+
+        if (!overlap)
+        {
+            return capturedZones;
+        }
+
+        if (algorithm == SelectionAlgorithm::Positional)
+        {
+            const int half = sensitivityRadius / 2;
+            Rect common{ capturedRects[0].left - half, capturedRects[0].top - half, capturedRects[0].right + half, capturedRects[0].bottom + half };
+            for (const Rect& rect : capturedRects)
+            {
+                common.left = std::max(common.left, rect.left - half);
+                common.top = std::max(common.top, rect.top - half);
+                common.right = std::min(common.right, rect.right + half);
+                common.bottom = std::min(common.bottom, rect.bottom + half);
+            }
+
+            const int width = std::max(common.width(), 1);
+            const int height = std::max(common.height(), 1);
+            const size_t count = capturedZones.size();
+            size_t index = height > width ? static_cast<size_t>(pt.y - common.top) * count / static_cast<size_t>(height) :
+                                            static_cast<size_t>(pt.x - common.left) * count / static_cast<size_t>(width);
+            index = std::clamp(index, static_cast<size_t>(0), count - 1);
+            return { capturedZones[index] };
+        }
+
+        size_t chosen = 0;
+        for (size_t i = 1; i < capturedRects.size(); ++i)
+        {
+            const bool better = algorithm == SelectionAlgorithm::Smallest ? Area(capturedRects[i]) < Area(capturedRects[chosen]) :
+                                                                            Area(capturedRects[i]) > Area(capturedRects[chosen]);
+            if (better)
+            {
+                chosen = i;
+            }
+        }
+        return { capturedZones[chosen] };
+    }
+
+    // Layouts as the editor produces them: every predefined type, plus canvas layouts with overlapping zones
+    std::vector<ZoneSetLayout> MakeLayouts(int sensitivityRadius, SelectionAlgorithm algorithm, std::mt19937& random)
+    {
+        std::vector<ZoneSetLayout> layouts;
+        for (LayoutType type : { LayoutType::Focus, LayoutType::Columns, LayoutType::Rows, LayoutType::Grid, LayoutType::PriorityGrid })
+        {
+            for (int zoneCount : { 1, 3, 7, 16, 40 })
+            {
+                for (int spacing : { MaxNegativeSpacing, 0, 16 })
+                {
+                    ZoneSetLayout layout(sensitivityRadius, algorithm);
+                    Check(layout.CalculateZones(type, WorkAreaWidth, WorkAreaHeight, zoneCount, spacing), "predefined layout is valid", std::to_string(zoneCount));
+                    Check(layout.Zones().size() == static_cast<size_t>(zoneCount), "predefined layout has zoneCount zones", std::to_string(zoneCount));
+                    layouts.push_back(std::move(layout));
+                }
+            }
+        }
+
+        for (int zoneCount : { 2, 8, 32, 128 })
+        {
+            std::vector<Rect> zones;
+            for (int i = 0; i < zoneCount; ++i)
+            {
+                const int left = static_cast<int>(random() % (WorkAreaWidth - 200));
+                const int top = static_cast<int>(random() % (WorkAreaHeight - 200));
+                zones.push_back({ left, top, left + 50 + static_cast<int>(random() % 900), top + 50 + static_cast<int>(random() % 700) });
+            }
+
+            ZoneSetLayout layout(sensitivityRadius, algorithm);
+            Check(layout.CalculateCanvasZones(zones), "canvas layout is valid", std::to_string(zoneCount));
+            layouts.push_back(std::move(layout));
+        }
+
+        return layouts;
+    }
+
+    // Cursor positions of drags across the work area, a little past its edges
+    std::vector<std::vector<Point>> SyntheticDrags(size_t dragCount, size_t dragLength, std::mt19937& random)
+    {
+        std::vector<std::vector<Point>> drags(dragCount);
+        for (auto& drag : drags)
+        {
+            Point pt{ static_cast<int>(random() % WorkAreaWidth), static_cast<int>(random() % WorkAreaHeight) };
+            const int dx = static_cast<int>(random() % 17) - 8;
+            const int dy = static_cast<int>(random() % 17) - 8;
+            for (size_t i = 0; i < dragLength; ++i)
+            {
+                pt.x = std::clamp(pt.x + dx + static_cast<int>(random() % 5) - 2, -50, WorkAreaWidth + 50);
+                pt.y = std::clamp(pt.y + dy + static_cast<int>(random() % 5) - 2, -50, WorkAreaHeight + 50);
+                drag.push_back(pt);
+            }
+        }
+        return drags;
+    }
+
+    std::vector<std::vector<Point>> RecordedDrags(const char* path)
+    {
+        std::vector<std::vector<Point>> drags(1);
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream stream(line);
+            Point pt{};
+            if (stream >> pt.x >> pt.y)
+            {
+                drags.back().push_back(pt);
+            }
+            else if (!drags.back().empty())
+            {
+                drags.emplace_back();
+            }
+        }
+
+        if (drags.back().empty())
+        {
+            drags.pop_back();
+        }
+        return drags;
+    }
+
+    void CheckInvariants(const ZoneSetLayout& layout, const std::vector<size_t>& result, Point pt)
+    {
+        Check(std::is_sorted(result.begin(), result.end()), "zones are sorted by id", std::to_string(pt.x) + "," + std::to_string(pt.y));
+        for (size_t id : result)
+        {
+            Check(layout.FindZone(id) != nullptr, "zones exist in the layout", std::to_string(id));
+        }
+
+        // Moving the window over a zone range keeps all of the initial and final zones
+        if (result.size() >= 2)
+        {
+            const auto range = layout.GetCombinedZoneRange({ result.front() }, { result.back() });
+            Check(std::find(range.begin(), range.end(), result.front()) != range.end() &&
+                      std::find(range.begin(), range.end(), result.back()) != range.end(),
+                  "combined range includes its ends",
+                  std::to_string(result.front()) + "-" + std::to_string(result.back()));
+        }
+    }
+
+    // ChooseNextZoneByPosition as it was first written, with the angle to the zone from acos and tan
+    std::optional<size_t> ReferenceZoneByDirection(const std::vector<Zone>& zones, Direction direction, const Rect& windowRect, const std::vector<size_t>& ignoredZones)
+    {
+        using complex = std::complex<double>;
+        const double inf = 1e100;
+        const double eccentricity = 2.0;
+
+        auto rectCenter = [](const Rect& rect) {
+            return complex{ 0.5 * rect.left + 0.5 * rect.right, 0.5 * rect.top + 0.5 * rect.bottom };
+        };
+
+        auto distance = [&](complex arrowDirection, complex zoneDirection) {
+            double scalarProduct = (arrowDirection * conj(zoneDirection)).real();
+            if (scalarProduct <= 0.0)
+            {
+                return inf;
+            }
+
+            double cosAngle = scalarProduct / std::abs(zoneDirection);
+            double tanAngle = std::abs(std::tan(std::acos(cosAngle)));
+            if (tanAngle > 10)
+            {
+                return inf;
+            }
+
+            double intersectY = 2 * eccentricity / (1.0 + eccentricity * eccentricity * tanAngle * tanAngle);
+            double distanceEstimate = scalarProduct / intersectY;
+            return std::isfinite(distanceEstimate) ? distanceEstimate : inf;
+        };
+
+        const complex directionVector = direction == Direction::Up ? complex{ 0.0, -1.0 } :
+                                        direction == Direction::Down ? complex{ 0.0, 1.0 } :
+                                        direction == Direction::Left ? complex{ -1.0, 0.0 } :
+                                                                       complex{ 1.0, 0.0 };
+
+        std::optional<size_t> closest;
+        double smallestDistance = inf;
+        size_t candidate = 0;
+        for (const Zone& zone : zones)
+        {
+            if (std::find(ignoredZones.begin(), ignoredZones.end(), zone.id) != ignoredZones.end())
+            {
+                continue;
+            }
+
+            complex zoneCenter = rectCenter(zone.rect) + 0.001 * static_cast<double>(++candidate);
+            double dist = distance(directionVector, zoneCenter - rectCenter(windowRect));
+            if (dist < smallestDistance)
+            {
+                smallestDistance = dist;
+                closest = zone.id;
+            }
+        }
+
+        return closest;
+    }
+
+    std::string ToString(const std::optional<size_t>& zone)
+    {
+        return zone ? std::to_string(*zone) : "none";
+    }
+
+    size_t navigationQueries = 0;
+    std::chrono::duration<double> neighborTime{};
+    std::chrono::duration<double> directionTime{};
+    std::chrono::duration<double> referenceDirectionTime{};
+
+    void CheckNavigation(const ZoneSetLayout& layout, std::mt19937& random)
+    {
+        const auto& zones = layout.Zones();
+        for (const Zone& zone : zones)
+        {
+            for (Direction direction : { Direction::Left, Direction::Up, Direction::Right, Direction::Down })
+            {
+                const auto neighborStart = std::chrono::steady_clock::now();
+                const auto neighbor = layout.NeighborZone(zone.id, direction);
+                const auto directionStart = std::chrono::steady_clock::now();
+                const auto next = layout.ZoneByDirection(direction, zone.rect, { zone.id });
+                const auto referenceStart = std::chrono::steady_clock::now();
+                const auto expected = ReferenceZoneByDirection(zones, direction, zone.rect, { zone.id });
+                const auto referenceEnd = std::chrono::steady_clock::now();
+
+                neighborTime += directionStart - neighborStart;
+                directionTime += referenceStart - directionStart;
+                referenceDirectionTime += referenceEnd - referenceStart;
+                ++navigationQueries;
+
+                const std::string context = std::to_string(zones.size()) + " zones from " + std::to_string(zone.id) + ": " + ToString(next) + " expected " + ToString(expected);
+                Check(!next || *next != zone.id, "navigation ignores the current zone", context);
+                Check(next == expected, "ZoneByDirection matches the reference", context);
+                Check(neighbor == next, "NeighborZone matches ZoneByDirection", context);
+
+                // Windows are larger than their zone by their invisible borders, or placed anywhere when not zoned
+                const Rect windowRect{ zone.rect.left - static_cast<int>(random() % 8), zone.rect.top, zone.rect.right + static_cast<int>(random() % 8), zone.rect.bottom + static_cast<int>(random() % 8) };
+                Check(layout.ZoneByDirection(direction, windowRect, { zone.id }) == ReferenceZoneByDirection(zones, direction, windowRect, { zone.id }), "ZoneByDirection matches the reference for a window", context);
+
+                const int x = static_cast<int>(random() % WorkAreaWidth);
+                const int y = static_cast<int>(random() % WorkAreaHeight);
+                const Rect freeRect{ x, y, x + 1 + static_cast<int>(random() % 800), y + 1 + static_cast<int>(random() % 600) };
+                Check(layout.ZoneByDirection(direction, freeRect, {}) == ReferenceZoneByDirection(zones, direction, freeRect, {}), "ZoneByDirection matches the reference for a free window", context);
+
+                // Cycling always finds a zone when there is another one
+                const Rect cyclingRect = ZoneSetLayout::PrepareRectForCycling(zone.rect, { 0, 0, WorkAreaWidth, WorkAreaHeight }, direction);
+                const auto cycled = layout.ZoneByDirection(direction, cyclingRect, {});
+                Check(zones.size() < 2 || cycled.has_value(), "cycling finds a zone", std::to_string(zone.id));
+                Check(cycled == ReferenceZoneByDirection(zones, direction, cyclingRect, {}), "cycling matches the reference", context);
+            }
+        }
+    }
+
+    bool SameZones(const ZoneSetLayout& lhs, const ZoneSetLayout& rhs)
+    {
+        return std::equal(lhs.Zones().begin(), lhs.Zones().end(), rhs.Zones().begin(), rhs.Zones().end(), [](const Zone& a, const Zone& b) {
+            return a.id == b.id && a.rect.left == b.rect.left && a.rect.top == b.rect.top && a.rect.right == b.rect.right && a.rect.bottom == b.rect.bottom;
+        });
+    }
+
+    struct DesktopLayout
+    {
+        LayoutType type;
+        int zoneCount;
+        int spacing;
+        // Custom grid layout instead of the predefined type
+        bool custom;
+    };
+
+    // Every monitor recalculates its layout when the virtual desktop changes, as ZoneSet::CalculateZones does
+    void SimulateDesktopSwitches(std::mt19937& random)
+    {
+        struct Monitor
+        {
+            int width;
+            int height;
+            unsigned int dpi;
+        };
+        const std::vector<Monitor> monitors{ { 2560, 1400, 144 }, { 2560, 1400, 144 }, { WorkAreaWidth, WorkAreaHeight, 96 } };
+        constexpr size_t DesktopCount = 8;
+        constexpr int SwitchCount = 2000;
+
+        // A few layouts per monitor, as users seldom pick a different one on every desktop
+        const std::vector<DesktopLayout> layouts{
+            { LayoutType::Grid, 4, 16, false },
+            { LayoutType::PriorityGrid, 5, 16, false },
+            { LayoutType::Columns, 3, 0, false },
+            { LayoutType::Grid, 0, 16, true },
+        };
+        std::vector<std::vector<DesktopLayout>> desktops(DesktopCount);
+        for (auto& desktop : desktops)
+        {
+            for (size_t monitor = 0; monitor < monitors.size(); ++monitor)
+            {
+                desktop.push_back(layouts[random() % layouts.size()]);
+            }
+        }
+
+        GridLayout customGrid{ .rows = 2, .columns = 3, .rowsPercents = { 5000, 5000 }, .columnsPercents = { 2500, 5000, 2500 }, .cellChildMap = { 0, 1, 2, 0, 3, 4 } };
+        const std::wstring customLayoutId = L"{C51D3D4A-0A3E-4E63-9A0D-1B2D8B6A1C10}";
+
+        auto calculate = [&customGrid](const DesktopLayout& desktopLayout, const Monitor& monitor, ZoneSetLayout& layout) {
+            return desktopLayout.custom ?
+                       layout.CalculateGridZones(monitor.width, monitor.height, customGrid, desktopLayout.spacing) :
+                       layout.CalculateZones(desktopLayout.type, monitor.width, monitor.height, desktopLayout.zoneCount, desktopLayout.spacing);
+        };
+
+        LayoutCache cache;
+        std::chrono::duration<double> uncachedTime{};
+        std::chrono::duration<double> cachedTime{};
+        std::vector<double> cachedSwitches;
+        for (int i = 0; i < SwitchCount; ++i)
+        {
+            // The custom layout is edited now and then
+            if (i % 500 == 250)
+            {
+                std::swap(customGrid.columnsPercents[0], customGrid.columnsPercents[1]);
+                cache.Invalidate(customLayoutId);
+            }
+
+            const auto& desktop = desktops[random() % DesktopCount];
+
+            const auto uncachedStart = std::chrono::steady_clock::now();
+            std::vector<ZoneSetLayout> uncached;
+            for (size_t monitor = 0; monitor < monitors.size(); ++monitor)
+            {
+                ZoneSetLayout& layout = uncached.emplace_back(20, SelectionAlgorithm::Smallest);
+                calculate(desktop[monitor], monitors[monitor], layout);
+            }
+
+            const auto cachedStart = std::chrono::steady_clock::now();
+            std::vector<std::shared_ptr<const ZoneSetLayout>> cached;
+            for (size_t monitor = 0; monitor < monitors.size(); ++monitor)
+            {
+                const auto& desktopLayout = desktop[monitor];
+                const LayoutKey key{
+                    .customLayoutId = desktopLayout.custom ? customLayoutId : std::wstring(),
+                    .layoutType = static_cast<int>(desktopLayout.type),
+                    .zoneCount = desktopLayout.zoneCount,
+                    .spacing = desktopLayout.spacing,
+                    .workAreaWidth = monitors[monitor].width,
+                    .workAreaHeight = monitors[monitor].height,
+                    .dpi = desktopLayout.custom ? monitors[monitor].dpi : 0,
+                    .sensitivityRadius = 20,
+                    .selectionAlgorithm = SelectionAlgorithm::Smallest
+                };
+                cached.push_back(cache.GetOrCalculate(key, [&](ZoneSetLayout& layout) { return calculate(desktopLayout, monitors[monitor], layout); }).layout);
+            }
+            const auto cachedEnd = std::chrono::steady_clock::now();
+
+            uncachedTime += cachedStart - uncachedStart;
+            cachedTime += cachedEnd - cachedStart;
+            cachedSwitches.push_back(std::chrono::duration<double, std::micro>(cachedEnd - cachedStart).count());
+
+            for (size_t monitor = 0; monitor < monitors.size(); ++monitor)
+            {
+                Check(SameZones(*cached[monitor], uncached[monitor]), "cached layout matches the calculated layout", std::to_string(i));
+            }
+        }
+
+        std::sort(cachedSwitches.begin(), cachedSwitches.end());
+        const auto statistics = cache.GetStatistics();
+        Check(statistics.entries <= layouts.size() * monitors.size(), "layouts of monitors of the same size are shared", std::to_string(statistics.entries));
+        std::printf("%d desktop switches on %zu monitors: uncached %.2f us, cached %.2f us (p99 %.2f us), hit rate %.1f%%, %zu layouts\n",
+                    SwitchCount,
+                    monitors.size(),
+                    uncachedTime.count() * 1e6 / SwitchCount,
+                    cachedTime.count() * 1e6 / SwitchCount,
+                    cachedSwitches[cachedSwitches.size() * 99 / 100],
+                    statistics.HitRate() * 100,
+                    statistics.entries);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::mt19937 random(12345);
+    std::vector<std::vector<Point>> drags = SyntheticDrags(2000, 200, random);
+    if (argc > 1)
+    {
+        const auto recorded = RecordedDrags(argv[1]);
+        std::printf("%zu recorded drags\n", recorded.size());
+        drags.insert(drags.end(), recorded.begin(), recorded.end());
+    }
+
+    size_t queries = 0;
+    std::chrono::duration<double> engineTime{};
+    std::chrono::duration<double> referenceTime{};
+
+    for (int sensitivityRadius : { 0, 20, 60 })
+    {
+        for (SelectionAlgorithm algorithm : { SelectionAlgorithm::Smallest, SelectionAlgorithm::Largest, SelectionAlgorithm::Positional })
+        {
+            for (const ZoneSetLayout& layout : MakeLayouts(sensitivityRadius, algorithm, random))
+            {
+                CheckNavigation(layout, random);
+
+                // A sample of the drags for each layout keeps the run short
+                for (size_t i = random() % 50; i < drags.size(); i += 50)
+                {
+                    for (const Point& pt : drags[i])
+                    {
+                        const auto engineStart = std::chrono::steady_clock::now();
+                        const auto result = layout.ZonesFromPoint(pt);
+                        const auto referenceStart = std::chrono::steady_clock::now();
+                        const auto expected = ReferenceZonesFromPoint(layout.Zones(), sensitivityRadius, algorithm, pt);
+                        const auto referenceEnd = std::chrono::steady_clock::now();
+
+                        engineTime += referenceStart - engineStart;
+                        referenceTime += referenceEnd - referenceStart;
+                        ++queries;
+
+                        Check(result == expected, "ZonesFromPoint matches the reference",
+                              std::to_string(layout.Zones().size()) + " zones at " + std::to_string(pt.x) + "," + std::to_string(pt.y));
+                        CheckInvariants(layout, result, pt);
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("%zu queries: engine %.1f ns/query, reference %.1f ns/query\n",
+                queries,
+                engineTime.count() * 1e9 / static_cast<double>(queries),
+                referenceTime.count() * 1e9 / static_cast<double>(queries));
+    std::printf("%zu navigations: neighbor %.1f ns, engine %.1f ns, reference %.1f ns\n",
+                navigationQueries,
+                neighborTime.count() * 1e9 / static_cast<double>(navigationQueries),
+                directionTime.count() * 1e9 / static_cast<double>(navigationQueries),
+                referenceDirectionTime.count() * 1e9 / static_cast<double>(navigationQueries));
+
+    SimulateDesktopSwitches(random);
+
+    std::printf("%d failures\n", failures);
+    return failures;
+}
@@ -0,0 +1,119 @@
+#include "pch.h"
+#include <filesystem>
+#include <thread>
+
+#include <lib/AppZoneHistoryWriter.h>
+#include <lib/FancyZonesDataTypes.h>
+#include <lib/JsonHelpers.h>
+
+using namespace JSONHelpers;
+using namespace FancyZonesDataTypes;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FancyZonesUnitTests
+{
+    TEST_CLASS (AppZoneHistoryWriterUnitTests)
+    {
+        std::wstring m_fileName;
+        std::recursive_mutex m_dataLock;
+        TAppZoneHistoryMap m_history;
+
+        AppZoneHistoryWriter::SnapshotCallback Snapshot()
+        {
+            return [this] { return m_history; };
+        }
+
+        TEST_METHOD_INITIALIZE(Init)
+        {
+            m_fileName = (std::filesystem::temp_directory_path() / L"FancyZonesUnitTests-app-zone-history.json").wstring();
+            std::filesystem::remove(m_fileName);
+
+            m_history.clear();
+            m_history[L"app-path"] = { AppZoneHistoryData{ .zoneSetUuid = L"zoneset-uuid", .deviceId = L"device-id", .zoneIndexSet = { 1 } } };
+        }
+
+        TEST_METHOD_CLEANUP(CleanUp)
+        {
+            std::filesystem::remove(m_fileName);
+        }
+
+    public:
+        TEST_METHOD (FlushWritesHistory)
+        {
+            AppZoneHistoryWriter writer(m_dataLock, Snapshot());
+            writer.SetFileName(m_fileName);
+            writer.Flush();
+
+            auto saved = json::from_file(m_fileName);
+            Assert::IsTrue(saved.has_value());
+            Assert::AreEqual(static_cast<size_t>(1), ParseAppZoneHistory(*saved).size());
+            Assert::IsFalse(std::filesystem::exists(m_fileName + L".tmp"));
+            Assert::AreEqual(static_cast<size_t>(1), writer.GetStatistics().writes);
+        }
+
+        TEST_METHOD (IdenticalHistoryIsNotWritten)
+        {
+            AppZoneHistoryWriter writer(m_dataLock, Snapshot());
+            writer.SetFileName(m_fileName);
+            writer.Flush();
+            writer.Flush();
+
+            const auto statistics = writer.GetStatistics();
+            Assert::AreEqual(static_cast<size_t>(1), statistics.writes);
+            Assert::AreEqual(static_cast<size_t>(1), statistics.writesAvoided);
+        }
+
+        TEST_METHOD (ChangesAreCoalesced)
+        {
+            AppZoneHistoryWriter writer(m_dataLock, Snapshot(), std::chrono::seconds(60));
+            writer.SetFileName(m_fileName);
+            for (size_t i = 0; i < 100; ++i)
+            {
+                {
+                    std::scoped_lock lock{ m_dataLock };
+                    m_history[L"app-path"][0].zoneIndexSet = { i };
+                }
+                writer.Schedule();
+            }
+
+            // Nothing is written before the interval ends, then stopping writes the last history
+            Assert::IsFalse(std::filesystem::exists(m_fileName));
+            writer.Stop();
+
+            const auto statistics = writer.GetStatistics();
+            Assert::AreEqual(static_cast<size_t>(1), statistics.writes);
+            Assert::AreEqual(static_cast<size_t>(99), statistics.writesAvoided);
+
+            auto saved = json::from_file(m_fileName);
+            Assert::IsTrue(saved.has_value());
+            Assert::IsTrue(std::vector<size_t>{ 99 } == ParseAppZoneHistory(*saved)[L"app-path"][0].zoneIndexSet);
+        }
+
+        TEST_METHOD (ChangesAreWrittenInTheBackground)
+        {
+            AppZoneHistoryWriter writer(m_dataLock, Snapshot(), std::chrono::milliseconds(10));
+            writer.SetFileName(m_fileName);
+            writer.Schedule();
+
+            for (int i = 0; i < 500 && writer.GetStatistics().writes == 0; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            Assert::AreEqual(static_cast<size_t>(1), writer.GetStatistics().writes);
+            Assert::IsTrue(std::filesystem::exists(m_fileName));
+        }
+
+        TEST_METHOD (SnapshotTimeIsMeasured)
+        {
+            AppZoneHistoryWriter writer(m_dataLock, [this] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                return m_history;
+            });
+            writer.SetFileName(m_fileName);
+            writer.Flush();
+
+            Assert::IsTrue(writer.GetStatistics().maxSnapshotTime >= std::chrono::milliseconds(5));
+        }
+    };
+}
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <lib/FileWatcher.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FancyZonesUnitTests
+{
+    TEST_CLASS (FileWatcherUnitTests)
+    {
+        static constexpr std::chrono::milliseconds Debounce{ 20 };
+
+        std::filesystem::path m_directory;
+        std::filesystem::path m_fileName;
+
+        static void WriteFile(const std::filesystem::path& path, const std::string& contents)
+        {
+            std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+            file << contents;
+        }
+
+        // Waits for the expected number of callbacks, then for a few debounce periods to catch extra ones
+        static bool WaitForCount(const std::atomic<int>& count, int expected)
+        {
+            for (int i = 0; i < 400 && count < expected; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            std::this_thread::sleep_for(Debounce * 4);
+            return count == expected;
+        }
+
+        TEST_METHOD_INITIALIZE(Init)
+        {
+            m_directory = std::filesystem::temp_directory_path() / L"FancyZonesUnitTests-FileWatcher";
+            std::filesystem::remove_all(m_directory);
+            std::filesystem::create_directories(m_directory);
+
+            m_fileName = m_directory / L"zones-settings.json";
+            WriteFile(m_fileName, "{}");
+        }
+
+        TEST_METHOD_CLEANUP(CleanUp)
+        {
+            std::filesystem::remove_all(m_directory);
+        }
+
+    public:
+        TEST_METHOD (ChangeCallsBack)
+        {
+            std::atomic<int> changes = 0;
+            FileWatcher watcher{ m_fileName.wstring(), [&] { ++changes; }, Debounce };
+
+            WriteFile(m_fileName, "{\"devices\":[]}");
+            Assert::IsTrue(WaitForCount(changes, 1));
+        }
+
+        TEST_METHOD (WritesAreDebounced)
+        {
+            std::atomic<int> changes = 0;
+            FileWatcher watcher{ m_fileName.wstring(), [&] { ++changes; }, Debounce };
+
+            for (int i = 0; i < 20; ++i)
+            {
+                WriteFile(m_fileName, "{\"devices\":[" + std::to_string(i) + "]}");
+            }
+            Assert::IsTrue(WaitForCount(changes, 1));
+        }
+
+        TEST_METHOD (SameContentsDoNotCallBack)
+        {
+            std::atomic<int> changes = 0;
+            FileWatcher watcher{ m_fileName.wstring(), [&] { ++changes; }, Debounce };
+
+            WriteFile(m_fileName, "{}");
+            Assert::IsTrue(WaitForCount(changes, 0));
+        }
+
+        TEST_METHOD (KnownContentsDoNotCallBack)
+        {
+            std::atomic<int> changes = 0;
+            FileWatcher watcher{ m_fileName.wstring(), [&] { ++changes; }, Debounce };
+
+            watcher.SetKnownContents(m_fileName.wstring(), "{\"written-by\":\"FancyZones\"}");
+            WriteFile(m_fileName, "{\"written-by\":\"FancyZones\"}");
+            Assert::IsTrue(WaitForCount(changes, 0));
+            Assert::IsTrue(watcher.GetStatistics().unchanged > 0);
+        }
+
+        TEST_METHOD (ManyFilesOnOneWatcher)
+        {
+            std::atomic<int> settingsChanges = 0;
+            std::atomic<int> historyChanges = 0;
+            FileWatcher watcher{ Debounce };
+            Assert::IsTrue(watcher.Watch(m_fileName.wstring(), [&] { ++settingsChanges; }));
+            Assert::IsTrue(watcher.Watch((m_directory / L"app-zone-history.json").wstring(), [&] { ++historyChanges; }));
+
+            WriteFile(m_directory / L"app-zone-history.json", "{}");
+            Assert::IsTrue(WaitForCount(historyChanges, 1));
+            Assert::AreEqual(0, settingsChanges.load());
+        }
+    };
+}
@@ -1849,6 +1849,28 @@ namespace FancyZonesUnitTests
                 Assert::IsTrue(std::vector<size_t>{ expectedZoneIndex } == data.GetAppLastZoneIndexSet(window, deviceId, zoneSetId));
             }
 
+            TEST_METHOD (AppLastZoneIndexProcessPathIsCached)
+            {
+                const std::wstring deviceId = L"device-id";
+                const std::wstring zoneSetId = L"zoneset-uuid";
+                const auto window = Mocks::WindowCreate(m_hInst);
+                FancyZonesData data;
+                data.SetSettingsModulePath(m_moduleName);
+
+                Assert::IsTrue(data.SetAppLastZones(window, deviceId, zoneSetId, { 1 }));
+                Assert::IsTrue(std::vector<size_t>{ 1 } == data.GetAppLastZoneIndexSet(window, deviceId, zoneSetId));
+
+                // The process is only queried by the first lookup
+                const auto statistics = data.GetProcessPathCacheStatistics();
+                Assert::AreEqual(static_cast<size_t>(1), statistics.misses);
+                Assert::IsTrue(statistics.hits > 0);
+
+                // History saved for the path is found once the window is invalidated
+                data.InvalidateProcessPath(window);
+                Assert::IsTrue(std::vector<size_t>{ 1 } == data.GetAppLastZoneIndexSet(window, deviceId, zoneSetId));
+                Assert::AreEqual(static_cast<size_t>(2), data.GetProcessPathCacheStatistics().misses);
+            }
+
             TEST_METHOD (AppLastZoneIndexZero)
             {
                 const std::wstring zoneSetId = L"zoneset-uuid";
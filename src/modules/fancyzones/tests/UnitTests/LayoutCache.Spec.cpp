@@ -0,0 +1,150 @@
+#include "pch.h"
+#include "lib\LayoutCache.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FancyZonesLayout;
+
+namespace FancyZonesUnitTests
+{
+    TEST_CLASS (LayoutCacheUnitTests)
+    {
+        static LayoutKey GridKey(int width, int height)
+        {
+            return LayoutKey{
+                .layoutType = static_cast<int>(LayoutType::Grid),
+                .zoneCount = 4,
+                .spacing = 16,
+                .workAreaWidth = width,
+                .workAreaHeight = height,
+                .sensitivityRadius = 20
+            };
+        }
+
+        static LayoutKey CustomKey(const std::wstring& id)
+        {
+            LayoutKey key = GridKey(1920, 1080);
+            key.customLayoutId = id;
+            key.dpi = 96;
+            return key;
+        }
+
+        // Calculates the key as ZoneSet does, and counts the calculations
+        static LayoutCache::Calculation Calculate(const LayoutKey& key, int& calculations)
+        {
+            return [key, &calculations](ZoneSetLayout& layout) {
+                ++calculations;
+                return layout.CalculateZones(LayoutType::Grid, key.workAreaWidth, key.workAreaHeight, key.zoneCount, key.spacing);
+            };
+        }
+
+    public:
+        TEST_METHOD (SameKeySharesLayout)
+        {
+            LayoutCache cache;
+            int calculations = 0;
+            const auto key = GridKey(1920, 1080);
+
+            const auto first = cache.GetOrCalculate(key, Calculate(key, calculations));
+            const auto second = cache.GetOrCalculate(key, Calculate(key, calculations));
+
+            Assert::IsTrue(first.success);
+            Assert::IsTrue(second.success);
+            Assert::IsTrue(first.layout == second.layout);
+            Assert::AreEqual<size_t>(4, first.layout->Zones().size());
+            Assert::AreEqual(1, calculations);
+
+            const auto statistics = cache.GetStatistics();
+            Assert::AreEqual<size_t>(1, statistics.hits);
+            Assert::AreEqual<size_t>(1, statistics.misses);
+            Assert::AreEqual(0.5, statistics.HitRate());
+        }
+
+        TEST_METHOD (DifferentWorkAreaIsCalculated)
+        {
+            LayoutCache cache;
+            int calculations = 0;
+            const auto key = GridKey(1920, 1080);
+            const auto otherKey = GridKey(2560, 1440);
+
+            const auto layout = cache.GetOrCalculate(key, Calculate(key, calculations)).layout;
+            const auto otherLayout = cache.GetOrCalculate(otherKey, Calculate(otherKey, calculations)).layout;
+
+            Assert::IsTrue(layout != otherLayout);
+            Assert::AreEqual(2, calculations);
+            Assert::AreEqual<size_t>(2, cache.GetStatistics().entries);
+        }
+
+        TEST_METHOD (FailedCalculationIsCached)
+        {
+            LayoutCache cache;
+            int calculations = 0;
+            auto fail = [&calculations](ZoneSetLayout&) {
+                ++calculations;
+                return false;
+            };
+
+            Assert::IsFalse(cache.GetOrCalculate(GridKey(1920, 1080), fail).success);
+            Assert::IsFalse(cache.GetOrCalculate(GridKey(1920, 1080), fail).success);
+            Assert::AreEqual(1, calculations);
+        }
+
+        TEST_METHOD (InvalidateCustomLayout)
+        {
+            LayoutCache cache;
+            int calculations = 0;
+            const auto key = CustomKey(L"{33A2B101-06E0-437B-A61E-CDBECF502906}");
+            const auto otherKey = CustomKey(L"{2CB8B6A6-4E3E-4C0A-9D9B-6C0A3FDBE2D1}");
+            const auto predefinedKey = GridKey(1920, 1080);
+
+            const auto layout = cache.GetOrCalculate(key, Calculate(key, calculations)).layout;
+            cache.GetOrCalculate(otherKey, Calculate(otherKey, calculations));
+            cache.GetOrCalculate(predefinedKey, Calculate(predefinedKey, calculations));
+            Assert::AreEqual(3, calculations);
+
+            cache.Invalidate(key.customLayoutId);
+            Assert::AreEqual<size_t>(2, cache.GetStatistics().entries);
+
+            // Only the edited layout is recalculated, the layout given out before is unchanged
+            Assert::IsTrue(layout != cache.GetOrCalculate(key, Calculate(key, calculations)).layout);
+            cache.GetOrCalculate(otherKey, Calculate(otherKey, calculations));
+            cache.GetOrCalculate(predefinedKey, Calculate(predefinedKey, calculations));
+            Assert::AreEqual(4, calculations);
+            Assert::AreEqual<size_t>(4, layout->Zones().size());
+        }
+
+        TEST_METHOD (LeastRecentlyUsedIsEvicted)
+        {
+            LayoutCache cache(2);
+            int calculations = 0;
+            const auto first = GridKey(1920, 1080);
+            const auto second = GridKey(2560, 1440);
+            const auto third = GridKey(3440, 1440);
+
+            cache.GetOrCalculate(first, Calculate(first, calculations));
+            cache.GetOrCalculate(second, Calculate(second, calculations));
+            cache.GetOrCalculate(first, Calculate(first, calculations));
+            cache.GetOrCalculate(third, Calculate(third, calculations));
+            Assert::AreEqual(3, calculations);
+            Assert::AreEqual<size_t>(2, cache.GetStatistics().entries);
+
+            cache.GetOrCalculate(first, Calculate(first, calculations));
+            Assert::AreEqual(3, calculations);
+            cache.GetOrCalculate(second, Calculate(second, calculations));
+            Assert::AreEqual(4, calculations);
+        }
+
+        TEST_METHOD (CachedLayoutIsIndexed)
+        {
+            LayoutCache cache;
+            const auto key = GridKey(1920, 1080);
+            const auto layout = cache.GetOrCalculate(key, [](ZoneSetLayout& layout) {
+                layout.AddZone({ 0, { 0, 0, 960, 1080 } });
+                layout.AddZone({ 1, { 960, 0, 1920, 1080 } });
+                return true;
+            }).layout;
+
+            Assert::AreEqual<size_t>(1, layout->ZonesFromPoint({ 1500, 500 }).at(0));
+            Assert::AreEqual<size_t>(1, *layout->NeighborZone(0, Direction::Right));
+        }
+    };
+}
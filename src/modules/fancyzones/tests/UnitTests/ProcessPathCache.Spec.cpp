@@ -0,0 +1,116 @@
+#include "pch.h"
+
+#include <lib/ProcessPathCache.h>
+#include <common/utils/process_path.h>
+
+#include "Util.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FancyZonesUnitTests
+{
+    TEST_CLASS (ProcessPathCacheUnitTests)
+    {
+        HINSTANCE m_hInst{};
+
+        TEST_METHOD_INITIALIZE(Init)
+        {
+            m_hInst = (HINSTANCE)GetModuleHandleW(nullptr);
+        }
+
+    public:
+        TEST_METHOD (PathOfWindow)
+        {
+            ProcessPathCache cache;
+            const auto window = Mocks::WindowCreate(m_hInst);
+
+            const auto pathId = cache.GetPathId(window);
+            Assert::AreNotEqual(ProcessPathCache::EmptyPathId, pathId);
+            Assert::AreEqual(get_process_path(window), cache.GetPath(pathId));
+        }
+
+        TEST_METHOD (PathIsCached)
+        {
+            ProcessPathCache cache;
+            const auto window = Mocks::WindowCreate(m_hInst);
+
+            const auto pathId = cache.GetPathId(window);
+            Assert::AreEqual(pathId, cache.GetPathId(window));
+            Assert::AreEqual(pathId, cache.GetPathId(window));
+
+            const auto statistics = cache.GetStatistics();
+            Assert::AreEqual(static_cast<size_t>(1), statistics.misses);
+            Assert::AreEqual(static_cast<size_t>(2), statistics.hits);
+        }
+
+        TEST_METHOD (WindowsOfSameProcessShareId)
+        {
+            ProcessPathCache cache;
+            const auto window1 = Mocks::WindowCreate(m_hInst);
+            const auto window2 = Mocks::WindowCreate(m_hInst);
+
+            Assert::AreEqual(cache.GetPathId(window1), cache.GetPathId(window2));
+        }
+
+        TEST_METHOD (InvalidatedWindowIsQueriedAgain)
+        {
+            ProcessPathCache cache;
+            const auto window = Mocks::WindowCreate(m_hInst);
+
+            const auto pathId = cache.GetPathId(window);
+            cache.InvalidateWindow(window);
+            Assert::AreEqual(pathId, cache.GetPathId(window));
+            Assert::AreEqual(static_cast<size_t>(2), cache.GetStatistics().misses);
+        }
+
+        TEST_METHOD (InvalidWindowIsNotCached)
+        {
+            ProcessPathCache cache;
+            const auto window = Mocks::Window();
+
+            Assert::AreEqual(ProcessPathCache::EmptyPathId, cache.GetPathId(window));
+            Assert::AreEqual(ProcessPathCache::EmptyPathId, cache.GetPathId(window));
+            Assert::AreEqual(static_cast<size_t>(2), cache.GetStatistics().misses);
+        }
+
+        TEST_METHOD (LeastRecentlyUsedWindowIsEvicted)
+        {
+            ProcessPathCache cache(2);
+            const auto window1 = Mocks::WindowCreate(m_hInst);
+            const auto window2 = Mocks::WindowCreate(m_hInst);
+            const auto window3 = Mocks::WindowCreate(m_hInst);
+
+            cache.GetPathId(window1);
+            cache.GetPathId(window2);
+            cache.GetPathId(window1);
+            cache.GetPathId(window3);
+            Assert::AreEqual(static_cast<size_t>(1), cache.GetStatistics().evictions);
+
+            // window2 was evicted, window1 was used after it
+            cache.GetPathId(window1);
+            Assert::AreEqual(static_cast<size_t>(3), cache.GetStatistics().misses);
+            cache.GetPathId(window2);
+            Assert::AreEqual(static_cast<size_t>(4), cache.GetStatistics().misses);
+        }
+
+        TEST_METHOD (InternPath)
+        {
+            ProcessPathCache cache;
+
+            const auto id = cache.InternPath(L"C:\\app.exe");
+            Assert::AreEqual(id, cache.InternPath(L"C:\\app.exe"));
+            Assert::AreNotEqual(id, cache.InternPath(L"C:\\other-app.exe"));
+            Assert::AreEqual(ProcessPathCache::EmptyPathId, cache.InternPath(L""));
+            Assert::AreEqual(std::wstring(L"C:\\app.exe"), cache.GetPath(id));
+        }
+
+        TEST_METHOD (InternedPathIsFoundForWindow)
+        {
+            ProcessPathCache cache;
+            const auto window = Mocks::WindowCreate(m_hInst);
+
+            const auto id = cache.InternPath(get_process_path(window));
+            Assert::AreEqual(id, cache.GetPathId(window));
+        }
+    };
+}
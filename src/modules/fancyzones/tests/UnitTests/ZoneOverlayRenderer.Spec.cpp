@@ -0,0 +1,196 @@
+#include "pch.h"
+
+#include <lib/ZoneOverlayRenderer.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FancyZonesUnitTests
+{
+    // Software render target drawing into a bitmap, which does not need a window or a GPU
+    class OffscreenTarget
+    {
+    public:
+        OffscreenTarget(int width, int height)
+        {
+            winrt::check_hresult(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, m_factory.put()));
+
+            auto properties = D2D1::RenderTargetProperties(
+                D2D1_RENDER_TARGET_TYPE_SOFTWARE,
+                D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED),
+                96.f,
+                96.f);
+            winrt::check_hresult(m_factory->CreateDCRenderTarget(&properties, m_target.put()));
+
+            BITMAPINFO info{};
+            info.bmiHeader.biSize = sizeof(info.bmiHeader);
+            info.bmiHeader.biWidth = width;
+            info.bmiHeader.biHeight = -height;
+            info.bmiHeader.biPlanes = 1;
+            info.bmiHeader.biBitCount = 32;
+            info.bmiHeader.biCompression = BI_RGB;
+
+            m_dc.reset(CreateCompatibleDC(nullptr));
+            m_bitmap.reset(CreateDIBSection(m_dc.get(), &info, DIB_RGB_COLORS, reinterpret_cast<void**>(&m_pixels), nullptr, 0));
+            SelectObject(m_dc.get(), m_bitmap.get());
+
+            RECT rect{ 0, 0, width, height };
+            winrt::check_hresult(m_target->BindDC(m_dc.get(), &rect));
+            m_width = width;
+        }
+
+        bool Render(ZoneOverlayRenderer& renderer, float alpha)
+        {
+            m_target->BeginDraw();
+            const bool rendered = renderer.Render(m_target.get(), alpha);
+            winrt::check_hresult(m_target->EndDraw());
+            return rendered;
+        }
+
+        uint32_t Pixel(int x, int y) const
+        {
+            GdiFlush();
+            return m_pixels[y * m_width + x];
+        }
+
+    private:
+        winrt::com_ptr<ID2D1Factory> m_factory;
+        winrt::com_ptr<ID2D1DCRenderTarget> m_target;
+        wil::unique_hdc m_dc;
+        wil::unique_hbitmap m_bitmap;
+        uint32_t* m_pixels = nullptr;
+        int m_width = 0;
+    };
+
+    TEST_CLASS (ZoneOverlayRendererUnitTests)
+    {
+        static constexpr D2D1_COLOR_F Border{ 1.f, 1.f, 1.f, 1.f };
+        static constexpr D2D1_COLOR_F Inactive{ 0.f, 0.f, 1.f, 0.5f };
+        static constexpr D2D1_COLOR_F Highlight{ 1.f, 0.f, 0.f, 0.5f };
+
+        static std::vector<ZoneOverlayRenderer::DrawableRect> Scene()
+        {
+            std::vector<ZoneOverlayRenderer::DrawableRect> rects;
+            for (size_t id = 0; id < 4; ++id)
+            {
+                const float left = 100.f * static_cast<float>(id) + 0.5f;
+                rects.push_back(ZoneOverlayRenderer::DrawableRect{
+                    .rect = D2D1::RectF(left, 0.5f, left + 99.f, 199.5f),
+                    .borderColor = Border,
+                    .fillColor = Inactive,
+                    .id = id });
+            }
+            return rects;
+        }
+
+    public:
+        TEST_METHOD (FirstFrameCreatesResources)
+        {
+            OffscreenTarget target(400, 200);
+            ZoneOverlayRenderer renderer;
+            renderer.SetScene(Scene());
+
+            Assert::IsTrue(target.Render(renderer, 1.f));
+
+            // Text format, four labels and the border, fill and text brushes
+            const auto statistics = renderer.GetStatistics();
+            Assert::AreEqual<size_t>(1, statistics.frames);
+            Assert::AreEqual<size_t>(8, statistics.resourcesCreatedLastFrame);
+        }
+
+        TEST_METHOD (NothingToRenderWithoutChanges)
+        {
+            OffscreenTarget target(400, 200);
+            ZoneOverlayRenderer renderer;
+            renderer.SetScene(Scene());
+            target.Render(renderer, 1.f);
+
+            Assert::IsFalse(renderer.NeedsRender(1.f));
+            Assert::IsFalse(target.Render(renderer, 1.f));
+
+            renderer.SetScene(Scene());
+            Assert::IsFalse(renderer.NeedsRender(1.f));
+            Assert::AreEqual<size_t>(1, renderer.GetStatistics().frames);
+        }
+
+        TEST_METHOD (FadeCreatesNoResources)
+        {
+            OffscreenTarget target(400, 200);
+            ZoneOverlayRenderer renderer;
+            renderer.SetScene(Scene());
+            target.Render(renderer, 0.05f);
+            const auto created = renderer.GetStatistics().resourcesCreated;
+
+            for (int frame = 2; frame <= 20; ++frame)
+            {
+                Assert::IsTrue(renderer.NeedsRender(frame / 20.f));
+                Assert::IsTrue(target.Render(renderer, frame / 20.f));
+            }
+
+            const auto statistics = renderer.GetStatistics();
+            Assert::AreEqual<size_t>(20, statistics.frames);
+            Assert::AreEqual<size_t>(0, statistics.partialFrames);
+            Assert::AreEqual(created, statistics.resourcesCreated);
+            Assert::IsTrue(statistics.p50RenderMs <= statistics.p99RenderMs);
+        }
+
+        TEST_METHOD (HighlightRedrawsChangedZones)
+        {
+            OffscreenTarget target(400, 200);
+            ZoneOverlayRenderer renderer;
+            renderer.SetScene(Scene());
+            target.Render(renderer, 1.f);
+
+            const uint32_t inactivePixel = target.Pixel(10, 10);
+            Assert::AreEqual(inactivePixel, target.Pixel(110, 10));
+
+            // The highlighted zone is drawn last, on top of the others
+            auto highlightedScene = Scene();
+            std::rotate(highlightedScene.begin() + 1, highlightedScene.begin() + 2, highlightedScene.end());
+            highlightedScene.back().fillColor = Highlight;
+            renderer.SetScene(std::move(highlightedScene));
+
+            Assert::IsTrue(target.Render(renderer, 1.f));
+
+            const auto statistics = renderer.GetStatistics();
+            Assert::AreEqual<size_t>(1, statistics.partialFrames);
+            Assert::AreEqual<size_t>(1, statistics.resourcesCreatedLastFrame);
+
+            Assert::AreEqual(inactivePixel, target.Pixel(10, 10));
+            Assert::AreNotEqual(inactivePixel, target.Pixel(110, 10));
+            Assert::AreEqual(inactivePixel, target.Pixel(310, 10));
+        }
+
+        TEST_METHOD (RemovedZoneIsCleared)
+        {
+            OffscreenTarget target(400, 200);
+            ZoneOverlayRenderer renderer;
+            renderer.SetScene(Scene());
+            target.Render(renderer, 1.f);
+            Assert::AreNotEqual(0u, target.Pixel(310, 10));
+
+            auto scene = Scene();
+            scene.pop_back();
+            renderer.SetScene(std::move(scene));
+            target.Render(renderer, 1.f);
+
+            Assert::AreEqual<size_t>(1, renderer.GetStatistics().partialFrames);
+            Assert::AreEqual(0u, target.Pixel(310, 10));
+            Assert::AreNotEqual(0u, target.Pixel(210, 10));
+        }
+
+        TEST_METHOD (NewTargetRecreatesBrushesOnly)
+        {
+            OffscreenTarget target(400, 200);
+            ZoneOverlayRenderer renderer;
+            renderer.SetScene(Scene());
+            target.Render(renderer, 1.f);
+
+            OffscreenTarget otherTarget(400, 200);
+            Assert::IsTrue(otherTarget.Render(renderer, 1.f));
+
+            // The labels do not depend on the target
+            Assert::AreEqual<size_t>(3, renderer.GetStatistics().resourcesCreatedLastFrame);
+            Assert::AreEqual(target.Pixel(10, 10), otherTarget.Pixel(10, 10));
+        }
+    };
+}
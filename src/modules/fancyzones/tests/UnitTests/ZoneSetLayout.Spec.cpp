@@ -0,0 +1,255 @@
+#include "pch.h"
+#include "lib\ZoneSetLayout.h"
+
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FancyZonesLayout;
+
+namespace FancyZonesUnitTests
+{
+    namespace
+    {
+        bool AreEqual(const Rect& expected, const Rect& actual)
+        {
+            return expected.left == actual.left && expected.top == actual.top &&
+                   expected.right == actual.right && expected.bottom == actual.bottom;
+        }
+
+        // Zones must not overlap each other and must lie inside the work area, spacing included
+        void CheckTiling(const ZoneSetLayout& layout, int width, int height, int spacing)
+        {
+            const auto& zones = layout.Zones();
+            for (size_t i = 0; i < zones.size(); ++i)
+            {
+                const Rect& rect = zones[i].rect;
+                Assert::IsTrue(rect.left >= spacing && rect.top >= spacing);
+                Assert::IsTrue(rect.right <= width - spacing && rect.bottom <= height - spacing);
+                for (size_t j = i + 1; j < zones.size(); ++j)
+                {
+                    const Rect& other = zones[j].rect;
+                    const bool disjoint = rect.right <= other.left || other.right <= rect.left ||
+                                          rect.bottom <= other.top || other.bottom <= rect.top;
+                    Assert::IsTrue(disjoint);
+                }
+            }
+        }
+    }
+
+    TEST_CLASS (ZoneSetLayoutUnitTests)
+    {
+        const int m_width = 1920;
+        const int m_height = 1080;
+
+    public:
+        TEST_METHOD (AddZoneKeepsIdOrder)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            Assert::IsTrue(layout.AddZone({ 2, { 0, 0, 10, 10 } }));
+            Assert::IsTrue(layout.AddZone({ 0, { 10, 0, 20, 10 } }));
+            Assert::IsFalse(layout.AddZone({ 2, { 20, 0, 30, 10 } }));
+
+            Assert::AreEqual(static_cast<size_t>(2), layout.Zones().size());
+            Assert::AreEqual(static_cast<size_t>(0), layout.Zones()[0].id);
+            Assert::AreEqual(static_cast<size_t>(2), layout.Zones()[1].id);
+            Assert::IsNotNull(layout.FindZone(2));
+            Assert::IsNull(layout.FindZone(1));
+        }
+
+        TEST_METHOD (InvalidParameters)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            Assert::IsFalse(layout.CalculateZones(LayoutType::Columns, 0, m_height, 3, 0));
+            Assert::IsFalse(layout.CalculateZones(LayoutType::Columns, m_width, m_height, 0, 0));
+            Assert::IsTrue(layout.Zones().empty());
+        }
+
+        TEST_METHOD (InvalidSpacingClearsZones)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            Assert::IsFalse(layout.CalculateZones(LayoutType::Grid, m_width, m_height, 4, MaxNegativeSpacing - 1));
+            Assert::IsTrue(layout.Zones().empty());
+        }
+
+        TEST_METHOD (FocusLayout)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            Assert::IsTrue(layout.CalculateZones(LayoutType::Focus, m_width, m_height, 3, 0));
+            Assert::AreEqual(static_cast<size_t>(3), layout.Zones().size());
+            Assert::IsTrue(AreEqual({ 100, 100, 868, 532 }, layout.Zones()[0].rect));
+            Assert::IsTrue(AreEqual({ 200, 200, 968, 632 }, layout.Zones()[2].rect));
+        }
+
+        TEST_METHOD (ColumnsAndRowsLayouts)
+        {
+            for (int spacing : { 0, 5, 16 })
+            {
+                for (int zoneCount = 1; zoneCount <= 10; ++zoneCount)
+                {
+                    for (LayoutType type : { LayoutType::Columns, LayoutType::Rows })
+                    {
+                        ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+                        Assert::IsTrue(layout.CalculateZones(type, m_width, m_height, zoneCount, spacing));
+                        Assert::AreEqual(static_cast<size_t>(zoneCount), layout.Zones().size());
+                        CheckTiling(layout, m_width, m_height, spacing);
+
+                        // The last zone ends exactly at the spacing from the work area edge
+                        const Rect& last = layout.Zones().back().rect;
+                        Assert::AreEqual(m_width - spacing, last.right);
+                        Assert::AreEqual(m_height - spacing, last.bottom);
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD (GridAndPriorityGridLayouts)
+        {
+            for (int zoneCount = 1; zoneCount <= 20; ++zoneCount)
+            {
+                for (LayoutType type : { LayoutType::Grid, LayoutType::PriorityGrid })
+                {
+                    ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+                    Assert::IsTrue(layout.CalculateZones(type, m_width, m_height, zoneCount, 10));
+                    Assert::AreEqual(static_cast<size_t>(zoneCount), layout.Zones().size());
+                    CheckTiling(layout, m_width, m_height, 10);
+                }
+            }
+        }
+
+        TEST_METHOD (CustomGridLayout)
+        {
+            GridLayout grid{ .rows = 2, .columns = 2, .rowsPercents = { 5000, 5000 }, .columnsPercents = { 5000, 5000 }, .cellChildMap = { 0, 1, 0, 2 } };
+
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            Assert::IsTrue(layout.CalculateGridZones(m_width, m_height, grid, 0));
+            Assert::AreEqual(static_cast<size_t>(3), layout.Zones().size());
+            Assert::IsTrue(AreEqual({ 0, 0, 960, 1080 }, layout.Zones()[0].rect));
+            Assert::IsTrue(AreEqual({ 960, 0, 1920, 540 }, layout.Zones()[1].rect));
+            Assert::IsTrue(AreEqual({ 960, 540, 1920, 1080 }, layout.Zones()[2].rect));
+        }
+
+        TEST_METHOD (CanvasLayout)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            Assert::IsTrue(layout.CalculateCanvasZones({ { 0, 0, 100, 100 }, { 50, 50, 300, 300 } }));
+            Assert::AreEqual(static_cast<size_t>(2), layout.Zones().size());
+            Assert::AreEqual(static_cast<size_t>(1), layout.Zones()[1].id);
+
+            Assert::IsFalse(layout.CalculateCanvasZones({ { 0, 0, 100, 100 }, { 0, 0, -100, 100 } }));
+            Assert::IsTrue(layout.Zones().empty());
+        }
+
+        TEST_METHOD (ZonesFromPointSelectionAlgorithms)
+        {
+            const std::vector<Rect> zones{ { 0, 0, 1000, 1000 }, { 100, 100, 400, 400 } };
+            const Point pt{ 200, 200 };
+
+            ZoneSetLayout smallest(0, SelectionAlgorithm::Smallest);
+            smallest.CalculateCanvasZones(zones);
+            Assert::IsTrue(std::vector<size_t>{ 1 } == smallest.ZonesFromPoint(pt));
+
+            ZoneSetLayout largest(0, SelectionAlgorithm::Largest);
+            largest.CalculateCanvasZones(zones);
+            Assert::IsTrue(std::vector<size_t>{ 0 } == largest.ZonesFromPoint(pt));
+
+            ZoneSetLayout positional(0, SelectionAlgorithm::Positional);
+            positional.CalculateCanvasZones(zones);
+            Assert::AreEqual(static_cast<size_t>(1), positional.ZonesFromPoint(pt).size());
+
+            // Outside of both zones
+            Assert::IsTrue(smallest.ZonesFromPoint(Point{ 1100, 1100 }).empty());
+        }
+
+        TEST_METHOD (ZonesFromPointBetweenAdjacentZones)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            layout.CalculateZones(LayoutType::Columns, m_width, m_height, 2, 0);
+            Assert::IsTrue((std::vector<size_t>{ 0, 1 }) == layout.ZonesFromPoint(Point{ 960, 500 }));
+            Assert::IsTrue(std::vector<size_t>{ 0 } == layout.ZonesFromPoint(Point{ 500, 500 }));
+        }
+
+        TEST_METHOD (CombinedZoneRange)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            layout.CalculateZones(LayoutType::Grid, m_width, m_height, 9, 0);
+
+            // Opposite corners of a 3x3 grid cover all of it
+            Assert::AreEqual(static_cast<size_t>(9), layout.GetCombinedZoneRange({ 0 }, { 8 }).size());
+            Assert::IsTrue((std::vector<size_t>{ 0, 1, 3, 4 }) == layout.GetCombinedZoneRange({ 0 }, { 4 }));
+            Assert::IsTrue(layout.GetCombinedZoneRange({ 42 }, {}).empty());
+        }
+
+        TEST_METHOD (ZoneByDirection)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            layout.CalculateZones(LayoutType::Columns, m_width, m_height, 3, 0);
+            const Rect middle = layout.Zones()[1].rect;
+
+            Assert::AreEqual(static_cast<size_t>(2), *layout.ZoneByDirection(Direction::Right, middle, { 1 }));
+            Assert::AreEqual(static_cast<size_t>(0), *layout.ZoneByDirection(Direction::Left, middle, { 1 }));
+            Assert::IsFalse(layout.ZoneByDirection(Direction::Up, middle, { 1 }).has_value());
+            Assert::IsFalse(layout.ZoneByDirection(Direction::Right, layout.Zones()[2].rect, { 2 }).has_value());
+        }
+
+        TEST_METHOD (NeighborZone)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            layout.CalculateZones(LayoutType::Grid, m_width, m_height, 9, 0);
+
+            // 3x3 grid, the middle zone has a neighbor in every direction
+            Assert::AreEqual(static_cast<size_t>(3), *layout.NeighborZone(4, Direction::Left));
+            Assert::AreEqual(static_cast<size_t>(1), *layout.NeighborZone(4, Direction::Up));
+            Assert::AreEqual(static_cast<size_t>(5), *layout.NeighborZone(4, Direction::Right));
+            Assert::AreEqual(static_cast<size_t>(7), *layout.NeighborZone(4, Direction::Down));
+            Assert::IsFalse(layout.NeighborZone(0, Direction::Up).has_value());
+            Assert::IsFalse(layout.NeighborZone(42, Direction::Up).has_value());
+        }
+
+        TEST_METHOD (NeighborZoneMatchesZoneByDirection)
+        {
+            std::mt19937 random(42);
+            for (int zoneCount : { 2, 8, 32 })
+            {
+                std::vector<Rect> rects;
+                for (int i = 0; i < zoneCount; ++i)
+                {
+                    const int left = static_cast<int>(random() % (m_width - 200));
+                    const int top = static_cast<int>(random() % (m_height - 200));
+                    rects.push_back({ left, top, left + 50 + static_cast<int>(random() % 600), top + 50 + static_cast<int>(random() % 400) });
+                }
+
+                ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+                Assert::IsTrue(layout.CalculateCanvasZones(rects));
+                for (const Zone& zone : layout.Zones())
+                {
+                    for (Direction direction : { Direction::Left, Direction::Up, Direction::Right, Direction::Down })
+                    {
+                        Assert::IsTrue(layout.ZoneByDirection(direction, zone.rect, { zone.id }) == layout.NeighborZone(zone.id, direction));
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD (NeighborZoneAfterAddZone)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            layout.AddZone({ 0, { 0, 0, 100, 100 } });
+            Assert::IsFalse(layout.NeighborZone(0, Direction::Right).has_value());
+
+            layout.AddZone({ 1, { 100, 0, 200, 100 } });
+            Assert::AreEqual(static_cast<size_t>(1), *layout.NeighborZone(0, Direction::Right));
+            Assert::AreEqual(static_cast<size_t>(0), *layout.NeighborZone(1, Direction::Left));
+        }
+
+        TEST_METHOD (CyclingFindsFirstZone)
+        {
+            ZoneSetLayout layout(20, SelectionAlgorithm::Smallest);
+            layout.CalculateZones(LayoutType::Columns, m_width, m_height, 3, 0);
+
+            const Rect workArea{ 0, 0, m_width, m_height };
+            const Rect cyclingRect = ZoneSetLayout::PrepareRectForCycling(layout.Zones()[2].rect, workArea, Direction::Right);
+            Assert::AreEqual(layout.Zones()[2].rect.left - m_width, cyclingRect.left);
+            Assert::AreEqual(static_cast<size_t>(0), *layout.ZoneByDirection(Direction::Right, cyclingRect, {}));
+        }
+    };
+}
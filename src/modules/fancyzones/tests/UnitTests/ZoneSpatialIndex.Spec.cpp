@@ -0,0 +1,263 @@
+#include "pch.h"
+#include "lib\FancyZonesData.h"
+#include "lib\Settings.h"
+#include "lib\Zone.h"
+#include "lib\ZoneSet.h"
+#include "lib\ZoneSpatialIndex.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "Util.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using FancyZonesLayout::Point;
+using FancyZonesLayout::ZoneSpatialIndex;
+
+namespace FancyZonesUnitTests
+{
+    namespace
+    {
+        // ZoneSet::ZonesFromPoint as it was before the spatial index: every zone is tested, then every captured pair.
+        std::vector<size_t> ScanZonesFromPoint(const ZonesMap& zones, int sensitivityRadius, POINT pt)
+        {
+            std::vector<size_t> capturedZones;
+            bool strictlyCaptured = false;
+            for (const auto& [zoneId, zone] : zones)
+            {
+                const RECT& zoneRect = zone->GetZoneRect();
+                if (zoneRect.left - sensitivityRadius <= pt.x && pt.x <= zoneRect.right + sensitivityRadius &&
+                    zoneRect.top - sensitivityRadius <= pt.y && pt.y <= zoneRect.bottom + sensitivityRadius)
+                {
+                    capturedZones.emplace_back(zoneId);
+                }
+
+                if (zoneRect.left <= pt.x && pt.x < zoneRect.right &&
+                    zoneRect.top <= pt.y && pt.y < zoneRect.bottom)
+                {
+                    strictlyCaptured = true;
+                }
+            }
+
+            if (capturedZones.size() == 1 && !strictlyCaptured)
+            {
+                return {};
+            }
+
+            bool overlap = false;
+            for (size_t i = 0; i < capturedZones.size() && !overlap; ++i)
+            {
+                for (size_t j = i + 1; j < capturedZones.size() && !overlap; ++j)
+                {
+                    RECT rectI = zones.at(capturedZones[i])->GetZoneRect();
+                    RECT rectJ = zones.at(capturedZones[j])->GetZoneRect();
+                    overlap = max(rectI.top, rectJ.top) + sensitivityRadius < min(rectI.bottom, rectJ.bottom) &&
+                              max(rectI.left, rectJ.left) + sensitivityRadius < min(rectI.right, rectJ.right);
+                }
+            }
+
+            if (overlap)
+            {
+                // Smallest zone first
+                auto zoneArea = [&](size_t id) {
+                    RECT rect = zones.at(id)->GetZoneRect();
+                    return max(rect.bottom - rect.top, 0) * max(rect.right - rect.left, 0);
+                };
+
+                size_t chosen = 0;
+                for (size_t i = 1; i < capturedZones.size(); ++i)
+                {
+                    if (zoneArea(capturedZones[i]) < zoneArea(capturedZones[chosen]))
+                    {
+                        chosen = i;
+                    }
+                }
+                return { capturedZones[chosen] };
+            }
+
+            return capturedZones;
+        }
+
+        winrt::com_ptr<IZoneSet> MakeTestZoneSet(int sensitivityRadius)
+        {
+            GUID id;
+            CoCreateGuid(&id);
+            ZoneSetConfig config(id, FancyZonesDataTypes::ZoneSetLayoutType::Custom, Mocks::Monitor(), sensitivityRadius, Settings::OverlappingZonesAlgorithm::Smallest);
+            return MakeZoneSet(config);
+        }
+
+        // Grid of zoneCount zones with some spacing, and as many canvas zones on top of it when overlapping is set
+        void AddZones(winrt::com_ptr<IZoneSet>& set, int zoneCount, bool overlapping, std::mt19937& random)
+        {
+            const LONG width = 3440, height = 1440, spacing = 16;
+            const int columns = static_cast<int>(std::ceil(std::sqrt(zoneCount * 2.0)));
+            const int rows = (zoneCount + columns - 1) / columns;
+            size_t id = 0;
+            for (int i = 0; i < zoneCount; ++i)
+            {
+                const LONG left = (i % columns) * width / columns + spacing;
+                const LONG top = (i / columns) * height / rows + spacing;
+                const LONG right = (i % columns + 1) * width / columns;
+                const LONG bottom = (i / columns + 1) * height / rows;
+                set->AddZone(MakeZone({ left, top, right, bottom }, id++));
+            }
+
+            if (overlapping)
+            {
+                for (int i = 0; i < zoneCount; ++i)
+                {
+                    const LONG left = static_cast<LONG>(random() % (width - 200));
+                    const LONG top = static_cast<LONG>(random() % (height - 200));
+                    set->AddZone(MakeZone({ left, top, left + 100 + static_cast<LONG>(random() % 800), top + 100 + static_cast<LONG>(random() % 600) }, id++));
+                }
+            }
+        }
+
+        // Cursor positions of a drag across the whole monitor, a little past its edges
+        std::vector<POINT> DragPath(size_t count, std::mt19937& random)
+        {
+            std::vector<POINT> path;
+            path.reserve(count);
+            LONG x = 0;
+            POINT pt{ -50, static_cast<LONG>(random() % 1440) };
+            while (path.size() < count)
+            {
+                x = (x + 1 + static_cast<LONG>(random() % 8)) % 3540;
+                pt.x = x - 50;
+                pt.y = std::clamp(pt.y + static_cast<LONG>(random() % 9) - 4, -50L, 1490L);
+                path.push_back(pt);
+            }
+            return path;
+        }
+    }
+
+    TEST_CLASS (ZoneSpatialIndexUnitTests)
+    {
+    public:
+        TEST_METHOD (EmptyIndex)
+        {
+            ZoneSpatialIndex index;
+            index.Build({}, 20);
+
+            ZoneSpatialIndex::Hit hit;
+            index.Query(Point{ 0, 0 }, hit);
+            Assert::IsTrue(index.Empty());
+            Assert::IsTrue(hit.capturedZones.empty());
+            Assert::IsFalse(hit.overlap);
+        }
+
+        TEST_METHOD (SensitivityRadiusIsIncluded)
+        {
+            ZoneSpatialIndex index;
+            index.Build({ { 1, { 0, 0, 100, 100 } }, { 2, { 100, 0, 200, 100 } } }, 20);
+
+            ZoneSpatialIndex::Hit hit;
+            index.Query(Point{ 85, 50 }, hit);
+            Assert::AreEqual(static_cast<size_t>(2), hit.capturedZones.size());
+            Assert::AreEqual(static_cast<size_t>(1), hit.capturedZones[0]);
+            Assert::IsTrue(hit.strictlyCaptured);
+            Assert::IsFalse(hit.overlap);
+
+            index.Query(Point{ 220, 120 }, hit);
+            Assert::AreEqual(static_cast<size_t>(1), hit.capturedZones.size());
+            Assert::IsFalse(hit.strictlyCaptured);
+
+            index.Query(Point{ 221, 50 }, hit);
+            Assert::IsTrue(hit.capturedZones.empty());
+        }
+
+        TEST_METHOD (OverlapIsFound)
+        {
+            ZoneSpatialIndex index;
+            index.Build({ { 1, { 0, 0, 100, 100 } }, { 2, { 10, 10, 90, 90 } }, { 3, { 500, 500, 600, 600 } } }, 20);
+
+            ZoneSpatialIndex::Hit hit;
+            index.Query(Point{ 50, 50 }, hit);
+            Assert::AreEqual(static_cast<size_t>(2), hit.capturedZones.size());
+            Assert::IsTrue(hit.overlap);
+
+            index.Query(Point{ 550, 550 }, hit);
+            Assert::AreEqual(static_cast<size_t>(1), hit.capturedZones.size());
+            Assert::IsFalse(hit.overlap);
+        }
+
+        TEST_METHOD (ZonesFromPointMatchesScan)
+        {
+            std::mt19937 random(7);
+            for (int zoneCount : { 1, 4, 16, 64 })
+            {
+                for (bool overlapping : { false, true })
+                {
+                    for (int sensitivityRadius : { 0, 20, 60 })
+                    {
+                        auto set = MakeTestZoneSet(sensitivityRadius);
+                        AddZones(set, zoneCount, overlapping, random);
+                        const ZonesMap zones = set->GetZones();
+
+                        for (const POINT& pt : DragPath(5000, random))
+                        {
+                            Assert::IsTrue(ScanZonesFromPoint(zones, sensitivityRadius, pt) == set->ZonesFromPoint(pt));
+                        }
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD (ZonesFromPointAfterAddZone)
+        {
+            auto set = MakeTestZoneSet(20);
+            set->AddZone(MakeZone({ 0, 0, 100, 100 }, 0));
+            Assert::AreEqual(static_cast<size_t>(1), set->ZonesFromPoint(POINT{ 50, 50 }).size());
+
+            // Zones added after a query are found by the next one
+            set->AddZone(MakeZone({ 100, 0, 200, 100 }, 1));
+            Assert::AreEqual(static_cast<size_t>(2), set->ZonesFromPoint(POINT{ 100, 50 }).size());
+            Assert::AreEqual(static_cast<size_t>(1), set->ZonesFromPoint(POINT{ 150, 50 })[0]);
+        }
+    };
+
+    TEST_CLASS (ZonesFromPointBenchmark)
+    {
+        static constexpr size_t QueryCount = 200000;
+
+        template<class QueryF>
+        double QueriesPerSecond(const std::vector<POINT>& path, QueryF query)
+        {
+            size_t found = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (const POINT& pt : path)
+            {
+                found += query(pt).size();
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            Assert::IsTrue(found > 0);
+            return path.size() / elapsed.count();
+        }
+
+    public:
+        TEST_METHOD (QueriesPerSecond)
+        {
+            std::mt19937 random(11);
+            for (int zoneCount : { 4, 16, 64, 256 })
+            {
+                for (bool overlapping : { false, true })
+                {
+                    auto set = MakeTestZoneSet(DefaultValues::SensitivityRadius);
+                    AddZones(set, zoneCount, overlapping, random);
+                    const ZonesMap zones = set->GetZones();
+                    const std::vector<POINT> path = DragPath(QueryCount, random);
+
+                    const double scan = QueriesPerSecond(path, [&](POINT pt) { return ScanZonesFromPoint(zones, DefaultValues::SensitivityRadius, pt); });
+                    const double indexed = QueriesPerSecond(path, [&](POINT pt) { return set->ZonesFromPoint(pt); });
+
+                    const std::wstring message = std::to_wstring(zones.size()) + (overlapping ? L" overlapping" : L"") + L" zones: " +
+                                                 std::to_wstring(static_cast<long long>(scan)) + L" queries/s scanning, " +
+                                                 std::to_wstring(static_cast<long long>(indexed)) + L" queries/s indexed\n";
+                    Logger::WriteMessage(message.c_str());
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,191 @@
+#include "pch.h"
+
+#include <lib/ZoneWindowCompositor.h>
+
+#include <atomic>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FancyZonesUnitTests
+{
+    // Draws for a number of frames, like an animation
+    class CountingClient : public ZoneWindowCompositor::Client
+    {
+    public:
+        bool RenderFrame() override
+        {
+            ++frames;
+            if (framesToDraw > 0)
+            {
+                --framesToDraw;
+                return true;
+            }
+            return false;
+        }
+
+        std::atomic<int> framesToDraw = 0;
+        std::atomic<int> frames = 0;
+    };
+
+    TEST_CLASS (ZoneWindowCompositorUnitTests)
+    {
+        static constexpr std::chrono::milliseconds Refresh{ 16 };
+
+        static void WaitForRefresh()
+        {
+            std::this_thread::sleep_for(Refresh);
+        }
+
+        template<typename Predicate>
+        static bool WaitFor(Predicate predicate, std::chrono::milliseconds timeout = std::chrono::milliseconds(2000))
+        {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (!predicate())
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return true;
+        }
+
+    public:
+        TEST_METHOD (NoFramesWithoutRequests)
+        {
+            ZoneWindowCompositor compositor(WaitForRefresh);
+            CountingClient client;
+            compositor.AddClient(&client);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            Assert::AreEqual(0, client.frames.load());
+            Assert::IsFalse(compositor.IsThreadRunning());
+
+            compositor.RemoveClient(&client);
+        }
+
+        TEST_METHOD (AnimationRendersUntilIdle)
+        {
+            ZoneWindowCompositor compositor(WaitForRefresh);
+            CountingClient client;
+            compositor.AddClient(&client);
+
+            client.framesToDraw = 5;
+            compositor.RequestFrame(&client);
+
+            // Five frames that drew and the frame that found nothing to draw
+            Assert::IsTrue(WaitFor([&]() { return compositor.GetStatistics().idleClientFrames == 1; }));
+            std::this_thread::sleep_for(Refresh * 3);
+
+            const auto statistics = compositor.GetStatistics();
+            Assert::AreEqual(6, client.frames.load());
+            Assert::AreEqual<size_t>(5, statistics.frames);
+            Assert::AreEqual<size_t>(6, statistics.clientFrames);
+
+            compositor.RemoveClient(&client);
+        }
+
+        TEST_METHOD (RequestsDuringDragAreCoalesced)
+        {
+            ZoneWindowCompositor compositor(WaitForRefresh);
+            CountingClient client;
+            compositor.AddClient(&client);
+
+            // A drag updates the highlighted zone on every mouse move
+            const auto dragStart = std::chrono::steady_clock::now();
+            for (int move = 0; move < 200; ++move)
+            {
+                client.framesToDraw = 1;
+                compositor.RequestFrame(&client);
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+            const auto dragDuration = std::chrono::steady_clock::now() - dragStart;
+
+            Assert::IsTrue(WaitFor([&]() { return client.framesToDraw == 0; }));
+            std::this_thread::sleep_for(Refresh * 3);
+
+            // At most a frame per refresh, and the frame finding nothing to draw
+            const auto refreshes = static_cast<size_t>(dragDuration / Refresh) + 2;
+            const auto statistics = compositor.GetStatistics();
+            Assert::IsTrue(statistics.frames <= refreshes);
+            Assert::IsTrue(statistics.clientFrames <= 2 * refreshes);
+
+            compositor.RemoveClient(&client);
+        }
+
+        TEST_METHOD (ClientsShareFrames)
+        {
+            ZoneWindowCompositor compositor(WaitForRefresh);
+            std::vector<CountingClient> clients(6);
+            for (auto& client : clients)
+            {
+                compositor.AddClient(&client);
+                client.framesToDraw = 10;
+                compositor.RequestFrame(&client);
+            }
+
+            Assert::IsTrue(WaitFor([&]() { return compositor.GetStatistics().idleClientFrames == clients.size(); }));
+
+            // The clients drew in the same refreshes, rather than one after the other
+            Assert::IsTrue(compositor.GetStatistics().frames <= 12);
+            for (auto& client : clients)
+            {
+                Assert::AreEqual(11, client.frames.load());
+                compositor.RemoveClient(&client);
+            }
+        }
+
+        TEST_METHOD (FrameAtTime)
+        {
+            ZoneWindowCompositor compositor(WaitForRefresh);
+            CountingClient client;
+            compositor.AddClient(&client);
+
+            const auto requestTime = std::chrono::steady_clock::now();
+            compositor.RequestFrameAt(&client, requestTime + std::chrono::milliseconds(100));
+
+            Assert::IsTrue(WaitFor([&]() { return client.frames == 1; }));
+            Assert::IsTrue(std::chrono::steady_clock::now() - requestTime >= std::chrono::milliseconds(100));
+
+            compositor.RemoveClient(&client);
+        }
+
+        TEST_METHOD (ThreadExitsWhenIdle)
+        {
+            ZoneWindowCompositor compositor(WaitForRefresh, std::chrono::milliseconds(50));
+            CountingClient client;
+            compositor.AddClient(&client);
+
+            compositor.RequestFrame(&client);
+            Assert::IsTrue(WaitFor([&]() { return client.frames == 1; }));
+            Assert::IsTrue(WaitFor([&]() { return !compositor.IsThreadRunning(); }));
+
+            compositor.RequestFrame(&client);
+            Assert::IsTrue(WaitFor([&]() { return client.frames == 2; }));
+            Assert::AreEqual<size_t>(2, compositor.GetStatistics().threadStarts);
+
+            compositor.RemoveClient(&client);
+        }
+
+        TEST_METHOD (ThreadExitsWithoutClients)
+        {
+            ZoneWindowCompositor compositor(WaitForRefresh);
+            CountingClient client;
+            compositor.AddClient(&client);
+
+            client.framesToDraw = 1000;
+            compositor.RequestFrame(&client);
+            Assert::IsTrue(WaitFor([&]() { return client.frames > 2; }));
+
+            compositor.RemoveClient(&client);
+            Assert::IsFalse(compositor.IsThreadRunning());
+
+            // Requests for removed clients are ignored
+            const int frames = client.frames;
+            compositor.RequestFrame(&client);
+            std::this_thread::sleep_for(Refresh * 3);
+            Assert::AreEqual(frames, client.frames.load());
+        }
+    };
+}
@@ -5,6 +5,7 @@
 
 #include <keyboardmanager/common/InputInterface.h>
 #include <keyboardmanager/common/Helpers.h>
+#include <keyboardmanager/common/KeyEventBatch.h>
 #include <keyboardmanager/KeyboardManagerEngineLibrary/trace.h>
 
 namespace KeyboardEventHandlers
@@ -32,18 +33,7 @@ namespace KeyboardEventHandlers
                     }
                 }
 
-                int key_count;
-                if (remapToKey)
-                {
-                    key_count = 1;
-                }
-                else
-                {
-                    key_count = std::get<Shortcut>(it->second).Size();
-                }
-
-                LPINPUT keyEventList = new INPUT[size_t(key_count)]();
-                memset(keyEventList, 0, sizeof(keyEventList));
+                KeyEventBatch keyEvents;
 
                 // Handle remaps to VK_WIN_BOTH
                 DWORD target;
@@ -59,63 +49,62 @@ namespace KeyboardEventHandlers
                 // If Ctrl/Alt/Shift is being remapped to Caps Lock, then reset the modifier key state to fix issues in certain IME keyboards where the IME shortcut gets invoked since it detects that the modifier and Caps Lock is pressed even though it is suppressed by the hook - More information at the GitHub issue https://github.com/microsoft/PowerToys/issues/3397
                 if (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN)
                 {
-                    ResetIfModifierKeyForLowerLevelKeyHandlers(ii, it->first, target);
+                    ResetIfModifierKeyForLowerLevelKeyHandlers(keyEvents, it->first, target);
                 }
 
                 if (remapToKey)
                 {
                     if (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP)
                     {
-                        Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)target, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEvents.AddKeyEvent((WORD)target, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
                     }
                     else
                     {
-                        Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)target, 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEvents.AddKeyEvent((WORD)target, 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
                     }
                 }
                 else
                 {
-                    int i = 0;
-                    Shortcut targetShortcut = std::get<Shortcut>(it->second);
+                    const Shortcut& targetShortcut = std::get<Shortcut>(it->second);
                     if (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP)
                     {
-                        Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)targetShortcut.GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        i++;
-                        Helpers::SetModifierKeyEvents(targetShortcut, ModifierKey::Disabled, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        // Dummy key is not required here since SetModifierKeyEvents will only add key-up events for the modifiers here, and the action key key-up is already sent before it
+                        keyEvents.AddKeyEvent((WORD)targetShortcut.GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEvents.AddModifierKeyEvents(targetShortcut, ModifierKey::Disabled, false, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        // Dummy key is not required here since AddModifierKeyEvents will only add key-up events for the modifiers here, and the action key key-up is already sent before it
                     }
                     else
                     {
-                        // Dummy key is not required here since SetModifierKeyEvents will only add key-down events for the modifiers here, and the action key key-down is already sent after it
-                        Helpers::SetModifierKeyEvents(targetShortcut, ModifierKey::Disabled, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)targetShortcut.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        i++;
+                        // Dummy key is not required here since AddModifierKeyEvents will only add key-down events for the modifiers here, and the action key key-down is already sent after it
+                        keyEvents.AddModifierKeyEvents(targetShortcut, ModifierKey::Disabled, true, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEvents.AddKeyEvent((WORD)targetShortcut.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
                     }
                 }
 
-                UINT res = ii.SendVirtualInput(key_count, keyEventList, sizeof(INPUT));
-                delete[] keyEventList;
-
                 if (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN)
                 {
-                    // Log telemetry event when the key remap is invoked
-                    Trace::KeyRemapInvoked(remapToKey);
-
                     // If Caps Lock is being remapped to Ctrl/Alt/Shift, then reset the modifier key state to fix issues in certain IME keyboards where the IME shortcut gets invoked since it detects that the modifier and Caps Lock is pressed even though it is suppressed by the hook - More information at the GitHub issue https://github.com/microsoft/PowerToys/issues/3397
                     if (remapToKey)
                     {
-                        ResetIfModifierKeyForLowerLevelKeyHandlers(ii, target, it->first);
+                        ResetIfModifierKeyForLowerLevelKeyHandlers(keyEvents, target, it->first);
                     }
                     else
                     {
-                        std::vector<DWORD> shortcutKeys = std::get<Shortcut>(it->second).GetKeyCodes();
-                        for (auto& itSk : shortcutKeys)
+                        const Shortcut& targetShortcut = std::get<Shortcut>(it->second);
+                        for (DWORD key : { targetShortcut.GetWinKey(ModifierKey::Both), targetShortcut.GetCtrlKey(), targetShortcut.GetAltKey(), targetShortcut.GetShiftKey(), targetShortcut.GetActionKey() })
                         {
-                            ResetIfModifierKeyForLowerLevelKeyHandlers(ii, itSk, it->first);
+                            ResetIfModifierKeyForLowerLevelKeyHandlers(keyEvents, key, it->first);
                         }
                     }
                 }
 
+                keyEvents.Send(ii);
+
+                if (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN)
+                {
+                    // Log telemetry event when the key remap is invoked
+                    Trace::KeyRemapInvoked(remapToKey);
+                }
+
                 return 1;
             }
         }
@@ -176,33 +165,32 @@ namespace KeyboardEventHandlers
     */
 
     // Function to a handle a shortcut remap
-    intptr_t HandleShortcutRemapEvent(KeyboardManagerInput::InputInterface& ii, LowlevelKeyboardEvent* data, State& state, const std::optional<std::wstring>& activatedApp) noexcept
+    intptr_t HandleShortcutRemapEvent(KeyboardManagerInput::InputInterface& ii, LowlevelKeyboardEvent* data, State& state, const std::optional<size_t>& activatedAppId) noexcept
     {
-        // Check if any shortcut is currently in the invoked state
-        bool isShortcutInvoked = state.CheckShortcutRemapInvoked(activatedApp);
+        // Get the compiled shortcut table for given activatedAppId
+        ShortcutRemapDispatchTable& dispatchTable = state.GetShortcutRemapDispatchTable(activatedAppId);
+
+        // If a shortcut is currently in the invoked state then only that shortcut handles the event, otherwise only the shortcuts with this action key can be pressed
+        const auto remaps = dispatchTable.GetRemapsForKeyEvent(data->lParam->vkCode, data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN);
+        if (remaps.empty())
+        {
+            return 0;
+        }
 
-        // Get shortcut table for given activatedApp
-        ShortcutRemapTable& reMap = state.GetShortcutRemapTable(activatedApp);
+        const uint32_t modifiersState = ShortcutRemapDispatchTable::GetModifiersKeyboardState(ii);
 
         // Iterate through the shortcut remaps and apply whichever has been pressed
-        for (auto& itShortcut : state.GetSortedShortcutRemapVector(activatedApp))
+        for (const auto& remap : remaps)
         {
-            const auto it = reMap.find(itShortcut);
-
-            // If a shortcut is currently in the invoked state then skip till the shortcut that is currently invoked
-            if (isShortcutInvoked && !it->second.isShortcutInvoked)
-            {
-                continue;
-            }
+            const auto it = remap.entry;
 
             // Check if the remap is to a key or a shortcut
             bool remapToShortcut = (it->second.targetShortcut.index() == 1);
 
             const size_t src_size = it->first.Size();
-            const size_t dest_size = remapToShortcut ? std::get<Shortcut>(it->second.targetShortcut).Size() : 1;
 
             // If the shortcut has been pressed down
-            if (!it->second.isShortcutInvoked && it->first.CheckModifiersKeyboardState(ii))
+            if (!it->second.isShortcutInvoked && ShortcutRemapDispatchTable::CheckModifiersKeyboardState(remap, modifiersState))
             {
                 if (data->lParam->vkCode == it->first.GetActionKey() && (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN))
                 {
@@ -212,8 +200,7 @@ namespace KeyboardEventHandlers
                         continue;
                     }
 
-                    size_t key_count;
-                    LPINPUT keyEventList;
+                    KeyEventBatch keyEvents;
 
                     // Remember which win key was pressed initially
                     if (ii.GetVirtualKeyState(VK_RWIN))
@@ -227,100 +214,80 @@ namespace KeyboardEventHandlers
 
                     if (remapToShortcut)
                     {
+                        const Shortcut& targetShortcut = std::get<Shortcut>(it->second.targetShortcut);
+
+                        // Modifier state reset might be required for this key depending on the shortcut's action and target modifiers - ex: Win+Caps -> Ctrl+A. It is sent before the remap
+                        if (it->first.GetCtrlKey() == NULL && it->first.GetAltKey() == NULL && it->first.GetShiftKey() == NULL)
+                        {
+                            for (DWORD key : { targetShortcut.GetWinKey(ModifierKey::Both), targetShortcut.GetCtrlKey(), targetShortcut.GetAltKey(), targetShortcut.GetShiftKey(), targetShortcut.GetActionKey() })
+                            {
+                                ResetIfModifierKeyForLowerLevelKeyHandlers(keyEvents, key, data->lParam->vkCode);
+                            }
+                        }
+
                         // Get the common keys between the two shortcuts
-                        int commonKeys = it->first.GetCommonModifiersCount(std::get<Shortcut>(it->second.targetShortcut));
+                        int commonKeys = it->first.GetCommonModifiersCount(targetShortcut);
 
                         // If the original shortcut modifiers are a subset of the new shortcut
                         if (commonKeys == src_size - 1)
                         {
                             // key down for all new shortcut keys except the common modifiers
-                            key_count = dest_size - commonKeys;
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
-                            int i = 0;
-                            Helpers::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
-                            Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
+                            keyEvents.AddModifierKeyEvents(targetShortcut, it->second.winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
+                            keyEvents.AddKeyEvent((WORD)targetShortcut.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
                         else
                         {
                             // Dummy key, key up for all the original shortcut modifier keys and key down for all the new shortcut keys but common keys in each are not repeated
-                            key_count = KeyboardManagerConstants::DUMMY_KEY_EVENT_SIZE + (src_size - 1) + (dest_size) - (2 * (size_t)commonKeys);
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
-
                             // Send a dummy key event to prevent modifier press+release from being triggered. Example: Win+A->Ctrl+V, press Win+A, since Win will be released here we need to send a dummy event before it
-                            int i = 0;
-                            Helpers::SetDummyKeyEvent(keyEventList, i, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                            keyEvents.AddDummyKeyEvent(KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                             // Release original shortcut state (release in reverse order of shortcut to be accurate)
-                            Helpers::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, std::get<Shortcut>(it->second.targetShortcut));
+                            keyEvents.AddModifierKeyEvents(it->first, it->second.winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, targetShortcut);
 
                             // Set new shortcut key down state
-                            Helpers::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
-                            Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
-                        }
-
-                        // Modifier state reset might be required for this key depending on the shortcut's action and target modifiers - ex: Win+Caps -> Ctrl+A
-                        if (it->first.GetCtrlKey() == NULL && it->first.GetAltKey() == NULL && it->first.GetShiftKey() == NULL)
-                        {
-                            Shortcut temp = std::get<Shortcut>(it->second.targetShortcut);
-                            for (auto keys : temp.GetKeyCodes())
-                            {
-                                ResetIfModifierKeyForLowerLevelKeyHandlers(ii, keys, data->lParam->vkCode);
-                            }
+                            keyEvents.AddModifierKeyEvents(targetShortcut, it->second.winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
+                            keyEvents.AddKeyEvent((WORD)targetShortcut.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
                     }
                     else
                     {
-                        // Dummy key, key up for all the original shortcut modifier keys and key down for remapped key
-                        key_count = KeyboardManagerConstants::DUMMY_KEY_EVENT_SIZE + (src_size - 1) + dest_size;
-
-                        // Do not send Disable key
-                        if (std::get<DWORD>(it->second.targetShortcut) == CommonSharedConstants::VK_DISABLED)
+                        // Modifier state reset might be required for this key depending on the shortcut's action and target modifier - ex: Win+Caps -> Ctrl. It is sent before the remap
+                        if (it->first.GetCtrlKey() == NULL && it->first.GetAltKey() == NULL && it->first.GetShiftKey() == NULL)
                         {
-                            key_count--;
-                            // Since the original shortcut's action key is pressed, set it to true
-                            it->second.isOriginalActionKeyPressed = true;
+                            ResetIfModifierKeyForLowerLevelKeyHandlers(keyEvents, (WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), data->lParam->vkCode);
                         }
 
-                        keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
-
+                        // Dummy key, key up for all the original shortcut modifier keys and key down for remapped key
                         // Send a dummy key event to prevent modifier press+release from being triggered. Example: Win+A->V, press Win+A, since Win will be released here we need to send a dummy event before it
-                        int i = 0;
-                        Helpers::SetDummyKeyEvent(keyEventList, i, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                        keyEvents.AddDummyKeyEvent(KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                         // Release original shortcut state (release in reverse order of shortcut to be accurate)
-                        Helpers::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                        keyEvents.AddModifierKeyEvents(it->first, it->second.winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
-                        // Set target key down state
+                        // Set target key down state. Do not send Disable key
                         if (std::get<DWORD>(it->second.targetShortcut) != CommonSharedConstants::VK_DISABLED)
                         {
-                            Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
+                            keyEvents.AddKeyEvent((WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
-
-                        // Modifier state reset might be required for this key depending on the shortcut's action and target modifier - ex: Win+Caps -> Ctrl
-                        if (it->first.GetCtrlKey() == NULL && it->first.GetAltKey() == NULL && it->first.GetShiftKey() == NULL)
+                        else
                         {
-                            ResetIfModifierKeyForLowerLevelKeyHandlers(ii, (WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), data->lParam->vkCode);
+                            // Since the original shortcut's action key is pressed, set it to true
+                            it->second.isOriginalActionKeyPressed = true;
                         }
                     }
 
                     it->second.isShortcutInvoked = true;
+                    dispatchTable.SetInvokedRemap(remap);
                     // If app specific shortcut is invoked, store the target application
-                    if (activatedApp)
+                    if (activatedAppId)
                     {
-                        state.SetActivatedApp(*activatedApp);
+                        state.SetActivatedAppId(activatedAppId);
                     }
 
-                    UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                    delete[] keyEventList;
+                    keyEvents.Send(ii);
 
                     // Log telemetry event when shortcut remap is invoked
-                    Trace::ShortcutRemapInvoked(remapToShortcut, activatedApp.has_value());
+                    Trace::ShortcutRemapInvoked(remapToShortcut, activatedAppId.has_value());
 
                     return 1;
                 }
@@ -343,85 +310,39 @@ namespace KeyboardEventHandlers
                 if ((it->first.CheckWinKey(data->lParam->vkCode) || it->first.CheckCtrlKey(data->lParam->vkCode) || it->first.CheckAltKey(data->lParam->vkCode) || it->first.CheckShiftKey(data->lParam->vkCode)) && (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP))
                 {
                     // Release new shortcut, and set original shortcut keys except the one released
-                    size_t key_count;
-                    LPINPUT keyEventList;
+                    KeyEventBatch keyEvents;
                     if (remapToShortcut)
                     {
-                        // if the released key is present in both shortcuts' modifiers (i.e part of the common modifiers)
-                        if (std::get<Shortcut>(it->second.targetShortcut).CheckWinKey(data->lParam->vkCode) || std::get<Shortcut>(it->second.targetShortcut).CheckCtrlKey(data->lParam->vkCode) || std::get<Shortcut>(it->second.targetShortcut).CheckAltKey(data->lParam->vkCode) || std::get<Shortcut>(it->second.targetShortcut).CheckShiftKey(data->lParam->vkCode))
-                        {
-                            // release all new shortcut keys and the common released modifier except the other common modifiers, and add all original shortcut modifiers except the common ones, and dummy key
-                            key_count = (dest_size - commonKeys) + (src_size - 1 - commonKeys) + KeyboardManagerConstants::DUMMY_KEY_EVENT_SIZE;
-                        }
-                        else
-                        {
-                            // release all new shortcut keys except the common modifiers and add all original shortcut modifiers except the common ones, and dummy key
-                            key_count = (dest_size - 1) + (src_size - 2) - (2 * (size_t)commonKeys) + KeyboardManagerConstants::DUMMY_KEY_EVENT_SIZE;
-                        }
+                        const Shortcut& targetShortcut = std::get<Shortcut>(it->second.targetShortcut);
 
-                        // If the target shortcut's action key is pressed, then it should be released
-                        bool isActionKeyPressed = false;
-                        if (ii.GetVirtualKeyState((std::get<Shortcut>(it->second.targetShortcut).GetActionKey())))
+                        // Release new shortcut state (release in reverse order of shortcut to be accurate). If the target shortcut's action key is pressed, then it should be released
+                        if (ii.GetVirtualKeyState(targetShortcut.GetActionKey()))
                         {
-                            isActionKeyPressed = true;
-                            key_count += 1;
+                            keyEvents.AddKeyEvent((WORD)targetShortcut.GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
 
-                        keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
-
-                        // Release new shortcut state (release in reverse order of shortcut to be accurate)
-                        int i = 0;
-                        if (isActionKeyPressed)
-                        {
-                            Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
-                        }
-                        Helpers::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first, data->lParam->vkCode);
+                        // If the released key is present in both shortcuts' modifiers (i.e part of the common modifiers), it is released along with all new shortcut keys except the other common modifiers
+                        keyEvents.AddModifierKeyEvents(targetShortcut, it->second.winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first, data->lParam->vkCode);
 
                         // Set original shortcut key down state except the action key and the released modifier since the original action key may or may not be held down. If it is held down it will generate it's own key message
-                        Helpers::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, std::get<Shortcut>(it->second.targetShortcut), data->lParam->vkCode);
+                        keyEvents.AddModifierKeyEvents(it->first, it->second.winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, targetShortcut, data->lParam->vkCode);
 
                         // Send a dummy key event to prevent modifier press+release from being triggered. Example: Win+Ctrl+A->Ctrl+V, press Win+Ctrl+A and release A then Ctrl, since Win will be pressed here we need to send a dummy event after it
-                        Helpers::SetDummyKeyEvent(keyEventList, i, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                        keyEvents.AddDummyKeyEvent(KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                     }
                     else
                     {
-                        // 1 for releasing new key and original shortcut modifiers except the one released and dummy key
-                        key_count = dest_size + src_size - 2 + KeyboardManagerConstants::DUMMY_KEY_EVENT_SIZE;
-                        bool isTargetKeyPressed = false;
-
-                        // Do not send Disable key up
-                        if (std::get<DWORD>(it->second.targetShortcut) == CommonSharedConstants::VK_DISABLED)
-                        {
-                            key_count--;
-                        }
-                        else if (ii.GetVirtualKeyState(Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut))))
-                        {
-                            isTargetKeyPressed = true;
-                        }
-                        else
+                        // Release new key state. Do not send Disable key up, nor the key up of a target key which is not pressed
+                        if (std::get<DWORD>(it->second.targetShortcut) != CommonSharedConstants::VK_DISABLED && ii.GetVirtualKeyState(Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut))))
                         {
-                            isTargetKeyPressed = false;
-                            key_count--;
-                        }
-
-                        keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
-
-                        // Release new key state
-                        int i = 0;
-                        if (std::get<DWORD>(it->second.targetShortcut) != CommonSharedConstants::VK_DISABLED && isTargetKeyPressed)
-                        {
-                            Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
+                            keyEvents.AddKeyEvent((WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
 
                         // Set original shortcut key down state except the action key and the released modifier since the original action key may or may not be held down. If it is held down it will generate it's own key message
-                        Helpers::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, Shortcut(), data->lParam->vkCode);
+                        keyEvents.AddModifierKeyEvents(it->first, it->second.winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, Shortcut(), data->lParam->vkCode);
 
                         // Send a dummy key event to prevent modifier press+release from being triggered. Example: Win+Ctrl+A->V, press Win+Ctrl+A and release A then Ctrl, since Win will be pressed here we need to send a dummy event after it
-                        Helpers::SetDummyKeyEvent(keyEventList, i, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                        keyEvents.AddDummyKeyEvent(KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                     }
 
                     // Reset the remap state
@@ -430,17 +351,12 @@ namespace KeyboardEventHandlers
                     it->second.isOriginalActionKeyPressed = false;
 
                     // If app specific shortcut has finished invoking, reset the target application
-                    if (activatedApp)
+                    if (activatedAppId)
                     {
-                        state.SetActivatedApp(KeyboardManagerConstants::NoActivatedApp);
+                        state.SetActivatedAppId(std::nullopt);
                     }
 
-                    // key count can be 0 if both shortcuts have same modifiers and the action key is not held down. delete will throw an error if keyEventList is empty
-                    if (key_count > 0)
-                    {
-                        UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                        delete[] keyEventList;
-                    }
+                    keyEvents.Send(ii);
                     return 1;
                 }
 
@@ -458,33 +374,27 @@ namespace KeyboardEventHandlers
                             return 1;
                         }
 
-                        size_t key_count = 1;
-                        LPINPUT keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
+                        KeyEventBatch keyEvents;
                         if (remapToShortcut)
                         {
-                            Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                            keyEvents.AddKeyEvent((WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
                         else
                         {
-                            Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                            keyEvents.AddKeyEvent((WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
 
-                        UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                        delete[] keyEventList;
+                        keyEvents.Send(ii);
                         return 1;
                     }
 
                     // Case 3: If the action key is released from the original shortcut, keep modifiers of the new shortcut until some other key event which doesn't apply to the original shortcut
                     if (data->lParam->vkCode == it->first.GetActionKey() && (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP))
                     {
-                        size_t key_count = 1;
-                        LPINPUT keyEventList;
+                        KeyEventBatch keyEvents;
                         if (remapToShortcut)
                         {
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
-                            Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                            keyEvents.AddKeyEvent((WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
                         else if (std::get<DWORD>(it->second.targetShortcut) == CommonSharedConstants::VK_DISABLED)
                         {
@@ -496,36 +406,28 @@ namespace KeyboardEventHandlers
                         else
                         {
                             // Check if the keyboard state is clear apart from the target remap key (by creating a temp Shortcut object with the target key)
-                            bool isKeyboardStateClear = Shortcut(std::vector<int32_t>({ Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)) })).IsKeyboardStateClearExceptShortcut(ii);
-                            
+                            Shortcut targetKeyShortcut;
+                            targetKeyShortcut.SetKey(Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)));
+                            bool isKeyboardStateClear = targetKeyShortcut.IsKeyboardStateClearExceptShortcut(ii);
+
                             // If the keyboard state is clear, we release the target key but do not reset the remap state
                             if (isKeyboardStateClear)
                             {
-                                keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
-                                Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                                keyEvents.AddKeyEvent((WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                             }
                             else
                             {
                                 // If any other key is pressed, then the keyboard state must be reverted back to the physical keys.
                                 // This is to take cases like Ctrl+A->D remap and user presses B+Ctrl+A and releases A, or Ctrl+A+B and releases A
 
-                                // 1 for releasing new key and original shortcut modifiers, and dummy key
-                                key_count = dest_size + (src_size - 1) + KeyboardManagerConstants::DUMMY_KEY_EVENT_SIZE;
-
-                                keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
-
                                 // Release new key state
-                                int i = 0;
-                                Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                i++;
+                                keyEvents.AddKeyEvent((WORD)Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                                 // Set original shortcut key down state except the action key
-                                Helpers::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                                keyEvents.AddModifierKeyEvents(it->first, it->second.winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                                 // Send a dummy key event to prevent modifier press+release from being triggered. Example: Win+A->V, press Shift+Win+A and release A, since Win will be pressed here we need to send a dummy event after it
-                                Helpers::SetDummyKeyEvent(keyEventList, i, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                                keyEvents.AddDummyKeyEvent(KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                                 // Reset the remap state
                                 it->second.isShortcutInvoked = false;
@@ -533,129 +435,99 @@ namespace KeyboardEventHandlers
                                 it->second.isOriginalActionKeyPressed = false;
 
                                 // If app specific shortcut has finished invoking, reset the target application
-                                if (activatedApp != KeyboardManagerConstants::NoActivatedApp)
+                                if (activatedAppId)
                                 {
-                                    state.SetActivatedApp(KeyboardManagerConstants::NoActivatedApp);
+                                    state.SetActivatedAppId(std::nullopt);
                                 }
                             }
                         }
 
-                        UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                        delete[] keyEventList;
+                        keyEvents.Send(ii);
                         return 1;
                     }
 
                     // Case 4: If a modifier key in the original shortcut is pressed then suppress that key event since the original shortcut is already held down physically - This case can occur only if a user has a duplicated modifier key (possibly by remapping) or if user presses both L/R versions of a modifier remapped with "Both"
                     if ((it->first.CheckWinKey(data->lParam->vkCode) || it->first.CheckCtrlKey(data->lParam->vkCode) || it->first.CheckAltKey(data->lParam->vkCode) || it->first.CheckShiftKey(data->lParam->vkCode)) && (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN))
                     {
+                        KeyEventBatch keyEvents;
                         if (remapToShortcut)
                         {
                             // Modifier state reset might be required for this key depending on the target shortcut action key - ex: Ctrl+A -> Win+Caps
                             if (std::get<Shortcut>(it->second.targetShortcut).GetCtrlKey() == NULL && std::get<Shortcut>(it->second.targetShortcut).GetAltKey() == NULL && std::get<Shortcut>(it->second.targetShortcut).GetShiftKey() == NULL)
                             {
-                                ResetIfModifierKeyForLowerLevelKeyHandlers(ii, data->lParam->vkCode, std::get<Shortcut>(it->second.targetShortcut).GetActionKey());
+                                ResetIfModifierKeyForLowerLevelKeyHandlers(keyEvents, data->lParam->vkCode, std::get<Shortcut>(it->second.targetShortcut).GetActionKey());
                             }
                         }
                         else if (std::get<DWORD>(it->second.targetShortcut) != CommonSharedConstants::VK_DISABLED)
                         {
                             // If it is not remapped to Disable
                             // Modifier state reset might be required for this key depending on the target key - ex: Ctrl+A -> Caps
-                            ResetIfModifierKeyForLowerLevelKeyHandlers(ii, data->lParam->vkCode, Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)));
+                            ResetIfModifierKeyForLowerLevelKeyHandlers(keyEvents, data->lParam->vkCode, Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)));
                         }
 
                         // Suppress the modifier as it is already physically pressed
+                        keyEvents.Send(ii);
                         return 1;
                     }
 
                     // Case 5: If any key apart from the action key or a modifier key in the original shortcut is pressed then revert the keyboard state to just the original modifiers being held down along with the current key press
                     if (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN)
                     {
+                        KeyEventBatch keyEvents;
                         if (remapToShortcut)
                         {
+                            const Shortcut& targetShortcut = std::get<Shortcut>(it->second.targetShortcut);
+
                             // Modifier state reset might be required for this key depending on the target shortcut action key - ex: Ctrl+A -> Win+Caps, Shift is pressed. System should not see Shift and Caps pressed together
-                            if (std::get<Shortcut>(it->second.targetShortcut).GetCtrlKey() == NULL && std::get<Shortcut>(it->second.targetShortcut).GetAltKey() == NULL && std::get<Shortcut>(it->second.targetShortcut).GetShiftKey() == NULL)
+                            if (targetShortcut.GetCtrlKey() == NULL && targetShortcut.GetAltKey() == NULL && targetShortcut.GetShiftKey() == NULL)
                             {
-                                ResetIfModifierKeyForLowerLevelKeyHandlers(ii, data->lParam->vkCode, std::get<Shortcut>(it->second.targetShortcut).GetActionKey());
+                                ResetIfModifierKeyForLowerLevelKeyHandlers(keyEvents, data->lParam->vkCode, targetShortcut.GetActionKey());
                             }
 
-                            size_t key_count;
-                            LPINPUT keyEventList;
+                            // If the target shortcut's action key is pressed, then it should be released and original shortcut's action key should be set
+                            bool isActionKeyPressed = ii.GetVirtualKeyState(targetShortcut.GetActionKey());
 
                             // If the original shortcut is a subset of the new shortcut
                             if (commonKeys == src_size - 1)
                             {
-                                key_count = dest_size - commonKeys;
-
-                                // If the target shortcut's action key is pressed, then it should be released and original shortcut's action key should be set
-                                bool isActionKeyPressed = false;
-                                if (ii.GetVirtualKeyState((std::get<Shortcut>(it->second.targetShortcut).GetActionKey())))
-                                {
-                                    isActionKeyPressed = true;
-                                    key_count += 2;
-                                }
-
-                                keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
-
-                                int i = 0;
                                 if (isActionKeyPressed)
                                 {
-                                    Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                    i++;
+                                    keyEvents.AddKeyEvent((WORD)targetShortcut.GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                 }
-                                Helpers::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
+                                keyEvents.AddModifierKeyEvents(targetShortcut, it->second.winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
 
                                 // key down for original shortcut action key with shortcut flag so that we don't invoke the same shortcut remap again
                                 if (isActionKeyPressed)
                                 {
-                                    Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                    i++;
+                                    keyEvents.AddKeyEvent((WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                 }
 
                                 // Send current key pressed without shortcut flag so that it can be reprocessed in case the physical keys pressed are a different remapped shortcut
-                                Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)data->lParam->vkCode, 0, 0);
-                                i++;
+                                keyEvents.AddKeyEvent((WORD)data->lParam->vkCode, 0, 0);
 
                                 // Do not send a dummy key as we want the current key press to behave as normal i.e. it can do press+release functionality if required. Required to allow a shortcut to Win key remap invoked directly after shortcut to shortcut is released to open start menu
                             }
                             else
                             {
                                 // Key up for all new shortcut keys, key down for original shortcut modifiers and current key press but common keys aren't repeated
-                                key_count = (dest_size) + (src_size - 1) - (2 * (size_t)commonKeys);
-
-                                // If the target shortcut's action key is pressed, then it should be released and original shortcut's action key should be set
-                                bool isActionKeyPressed = false;
-                                if (ii.GetVirtualKeyState((std::get<Shortcut>(it->second.targetShortcut).GetActionKey())))
-                                {
-                                    isActionKeyPressed = true;
-                                    key_count += 2;
-                                }
-
-                                keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
-
                                 // Release new shortcut state (release in reverse order of shortcut to be accurate)
-                                int i = 0;
                                 if (isActionKeyPressed)
                                 {
-                                    Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                    i++;
+                                    keyEvents.AddKeyEvent((WORD)targetShortcut.GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                 }
-                                Helpers::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
+                                keyEvents.AddModifierKeyEvents(targetShortcut, it->second.winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
 
                                 // Set old shortcut key down state
-                                Helpers::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, std::get<Shortcut>(it->second.targetShortcut));
+                                keyEvents.AddModifierKeyEvents(it->first, it->second.winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, targetShortcut);
 
                                 // key down for original shortcut action key with shortcut flag so that we don't invoke the same shortcut remap again
                                 if (isActionKeyPressed)
                                 {
-                                    Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                    i++;
+                                    keyEvents.AddKeyEvent((WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                 }
 
                                 // Send current key pressed without shortcut flag so that it can be reprocessed in case the physical keys pressed are a different remapped shortcut
-                                Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)data->lParam->vkCode, 0, 0);
-                                i++;
+                                keyEvents.AddKeyEvent((WORD)data->lParam->vkCode, 0, 0);
 
                                 // Do not send a dummy key as we want the current key press to behave as normal i.e. it can do press+release functionality if required. Required to allow a shortcut to Win key remap invoked directly after shortcut to shortcut is released to open start menu
                             }
@@ -666,13 +538,12 @@ namespace KeyboardEventHandlers
                             it->second.isOriginalActionKeyPressed = false;
 
                             // If app specific shortcut has finished invoking, reset the target application
-                            if (activatedApp)
+                            if (activatedAppId)
                             {
-                                state.SetActivatedApp(KeyboardManagerConstants::NoActivatedApp);
+                                state.SetActivatedAppId(std::nullopt);
                             }
 
-                            UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                            delete[] keyEventList;
+                            keyEvents.Send(ii);
                             return 1;
                         }
                         else
@@ -680,7 +551,7 @@ namespace KeyboardEventHandlers
                             // For remap to key, if the original action key is not currently pressed, we should revert the keyboard state to the physical keys. If it is pressed we should not suppress the event so that shortcut to key remaps can be pressed with other keys. Example use-case: Alt+D->Win, allows Alt+D+A to perform Win+A
 
                             // Modifier state reset might be required for this key depending on the target key - ex: Ctrl+A -> Caps, Shift is pressed. System should not see Shift and Caps pressed together
-                            ResetIfModifierKeyForLowerLevelKeyHandlers(ii, data->lParam->vkCode, Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)));
+                            ResetIfModifierKeyForLowerLevelKeyHandlers(keyEvents, data->lParam->vkCode, Helpers::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)));
 
                             // If the shortcut is remapped to Disable then we have to revert the keyboard state to the physical keys
                             bool isRemapToDisable = (std::get<DWORD>(it->second.targetShortcut) == CommonSharedConstants::VK_DISABLED);
@@ -702,30 +573,18 @@ namespace KeyboardEventHandlers
                             if (isRemapToDisable || !isOriginalActionKeyPressed)
                             {
                                 // Key down for original shortcut modifiers and action key, and current key press
-                                size_t key_count = src_size + 1;
-
-                                LPINPUT keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
-
                                 // Set original shortcut key down state
-                                int i = 0;
-                                Helpers::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                                keyEvents.AddModifierKeyEvents(it->first, it->second.winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                                 // Send the original action key only if it is physically pressed. For remappings to keys other than disabled we already check earlier that it is not pressed in this scenario. For remap to disable
                                 if (isRemapToDisable && isOriginalActionKeyPressed)
                                 {
                                     // Set original action key
-                                    Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                    i++;
-                                }
-                                else
-                                {
-                                    key_count--;
+                                    keyEvents.AddKeyEvent((WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                 }
 
                                 // Send current key pressed without shortcut flag so that it can be reprocessed in case the physical keys pressed are a different remapped shortcut
-                                Helpers::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)data->lParam->vkCode, 0, 0);
-                                i++;
+                                keyEvents.AddKeyEvent((WORD)data->lParam->vkCode, 0, 0);
 
                                 // Do not send a dummy key as we want the current key press to behave as normal i.e. it can do press+release functionality if required. Required to allow a shortcut to Win key remap invoked directly after another shortcut to key remap is released to open start menu
 
@@ -735,17 +594,17 @@ namespace KeyboardEventHandlers
                                 it->second.isOriginalActionKeyPressed = false;
 
                                 // If app specific shortcut has finished invoking, reset the target application
-                                if (activatedApp != KeyboardManagerConstants::NoActivatedApp)
+                                if (activatedAppId)
                                 {
-                                    state.SetActivatedApp(KeyboardManagerConstants::NoActivatedApp);
+                                    state.SetActivatedAppId(std::nullopt);
                                 }
 
-                                UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                                delete[] keyEventList;
+                                keyEvents.Send(ii);
                                 return 1;
                             }
                             else
                             {
+                                keyEvents.Send(ii);
                                 return 0;
                             }
                         }
@@ -777,60 +636,31 @@ namespace KeyboardEventHandlers
         // Check if the key event was generated by KeyboardManager to avoid remapping events generated by us.
         if (data->lParam->dwExtraInfo != KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG)
         {
-            std::wstring process_name;
-
-            // Allocate MAX_PATH amount of memory
-            process_name.resize(MAX_PATH);
-            ii.GetForegroundProcess(process_name);
-
-            // Remove elements after null character
-            process_name.erase(std::find(process_name.begin(), process_name.end(), L'\0'), process_name.end());
-
-            if (process_name.empty())
+            // The foreground process is read when the foreground window changes, with its name in lower case
+            const auto& foregroundProcess = ii.GetForegroundProcess();
+            if (foregroundProcess.name.empty())
             {
                 return 0;
             }
 
-            // Convert process name to lower case
-            std::transform(process_name.begin(), process_name.end(), process_name.begin(), towlower);
-
-            std::wstring query_string;
-
-            AppSpecificShortcutRemapTable::iterator it;
-            
-            // Check if an app-specific shortcut is already activated
-            if (state.GetActivatedApp() == KeyboardManagerConstants::NoActivatedApp)
+            // Check if an app-specific shortcut is already activated, otherwise use the app-specific remaps of the foreground process, which are found again only when it changes
+            std::optional<size_t> appId = state.GetForegroundAppId(foregroundProcess);
+            if (state.GetActivatedAppId())
             {
-                query_string = process_name;
-                it = state.appSpecificShortcutReMap.find(query_string);
-
-                // If no entry is found, search for the process name without it's file extension
-                if (it == state.appSpecificShortcutReMap.end())
-                {
-                    // Find index of the file extension
-                    size_t extensionIndex = process_name.find_last_of(L".");
-                    query_string = process_name.substr(0, extensionIndex);
-                    it = state.appSpecificShortcutReMap.find(query_string);
-                }
-            }
-            else
-            {
-                query_string = state.GetActivatedApp();
-                it = state.appSpecificShortcutReMap.find(query_string);
+                appId = state.GetActivatedAppId();
             }
 
-            if (it != state.appSpecificShortcutReMap.end())
+            if (appId)
             {
-                bool result = HandleShortcutRemapEvent(ii, data, state, query_string);
-                return result;
+                return HandleShortcutRemapEvent(ii, data, state, appId);
             }
         }
 
         return 0;
     }
 
-    // Function to ensure Ctrl/Shift/Alt modifier key state is not detected as pressed down by applications which detect keys at a lower level than hooks when it is remapped for scenarios where its required
-    void ResetIfModifierKeyForLowerLevelKeyHandlers(KeyboardManagerInput::InputInterface& ii, DWORD key, DWORD target)
+    // Function to ensure Ctrl/Shift/Alt modifier key state is not detected as pressed down by applications which detect keys at a lower level than hooks when it is remapped for scenarios where its required. The key event is added to the key events sent for the remap
+    void ResetIfModifierKeyForLowerLevelKeyHandlers(KeyEventBatch& keyEvents, DWORD key, DWORD target)
     {
         // If the target is Caps Lock and the other key is either Ctrl/Alt/Shift then reset the modifier state to lower level handlers
         if (target == VK_CAPITAL)
@@ -838,14 +668,8 @@ namespace KeyboardEventHandlers
             // If the argument is either of the Ctrl/Shift/Alt modifier key codes
             if (Helpers::IsModifierKey(key) && !(key == VK_LWIN || key == VK_RWIN || key == CommonSharedConstants::VK_WIN_BOTH))
             {
-                int key_count = 1;
-                LPINPUT keyEventList = new INPUT[size_t(key_count)]();
-                memset(keyEventList, 0, sizeof(keyEventList));
-
                 // Use the suppress flag to ensure these are not intercepted by any remapped keys or shortcuts
-                Helpers::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)key, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG);
-                UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                delete[] keyEventList;
+                keyEvents.AddKeyEvent((WORD)key, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG);
             }
         }
     }
@@ -7,6 +7,7 @@ namespace KeyboardManagerInput
 {
     class InputInterface;
 }
+class KeyEventBatch;
 
 namespace KeyboardEventHandlers
 {
@@ -19,7 +20,7 @@ namespace KeyboardEventHandlers
     */
 
     // Function to a handle a shortcut remap
-    intptr_t HandleShortcutRemapEvent(KeyboardManagerInput::InputInterface& ii, LowlevelKeyboardEvent* data, State& state, const std::optional<std::wstring>& activatedApp = std::nullopt) noexcept;
+    intptr_t HandleShortcutRemapEvent(KeyboardManagerInput::InputInterface& ii, LowlevelKeyboardEvent* data, State& state, const std::optional<size_t>& activatedAppId = std::nullopt) noexcept;
 
     // Function to a handle an os-level shortcut remap
     intptr_t HandleOSLevelShortcutRemapEvent(KeyboardManagerInput::InputInterface& ii, LowlevelKeyboardEvent* data, State& state) noexcept;
@@ -27,6 +28,6 @@ namespace KeyboardEventHandlers
     // Function to a handle an app-specific shortcut remap
     intptr_t HandleAppSpecificShortcutRemapEvent(KeyboardManagerInput::InputInterface& ii, LowlevelKeyboardEvent* data, State& state) noexcept;
 
-    // Function to ensure Ctrl/Shift/Alt modifier key state is not detected as pressed down by applications which detect keys at a lower level than hooks when it is remapped for scenarios where its required
-    void ResetIfModifierKeyForLowerLevelKeyHandlers(KeyboardManagerInput::InputInterface& ii, DWORD key, DWORD target);
+    // Function to ensure Ctrl/Shift/Alt modifier key state is not detected as pressed down by applications which detect keys at a lower level than hooks when it is remapped for scenarios where its required. The key event is added to the key events sent for the remap
+    void ResetIfModifierKeyForLowerLevelKeyHandlers(KeyEventBatch& keyEvents, DWORD key, DWORD target);
 };
@@ -37,7 +37,6 @@ KeyboardManager::KeyboardManager()
             Logger::error(L"Failed to watch settings changes. {}", get_last_error_or_default(err));
         }
 
-        loadingSettings = true;
         try
         {
             LoadSettings();
@@ -46,8 +45,6 @@ KeyboardManager::KeyboardManager()
         {
             Logger::error("Failed to load settings");
         }
-
-        loadingSettings = false;
     };
 
     editorIsRunningEvent = CreateEvent(nullptr, true, false, KeyboardManagerConstants::EditorWindowEventName.c_str());
@@ -56,14 +53,19 @@ KeyboardManager::KeyboardManager()
 
 void KeyboardManager::LoadSettings()
 {
-    bool loadedSuccessful = state.LoadSettings();
+    // The settings are loaded into a new state, the hook keeps remapping with the current one until it is published
+    auto newState = std::make_unique<State>();
+    bool loadedSuccessful = newState->LoadSettings();
     if (!loadedSuccessful)
     {
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
 
         // retry once
-        state.LoadSettings();
+        newState->LoadSettings();
     }
+
+    newState->CompileShortcutRemaps();
+    statePublisher.Publish(std::move(newState));
 }
 
 LRESULT CALLBACK KeyboardManager::HookProc(int nCode, WPARAM wParam, LPARAM lParam)
@@ -82,11 +84,66 @@ LRESULT CALLBACK KeyboardManager::HookProc(int nCode, WPARAM wParam, LPARAM lPar
             }
             return 1;
         }
+
+        // The key event reaches the system, so the key state is updated as GetAsyncKeyState would report it. Events injected by the handlers are tracked when they reach the hook
+        keyboardManagerObjectPtr->inputHandler.UpdateKeyboardState(event.lParam->vkCode, event.wParam == WM_KEYDOWN || event.wParam == WM_SYSKEYDOWN);
     }
     
     return CallNextHookEx(hookHandleCopy, nCode, wParam, lParam);
 }
 
+void CALLBACK KeyboardManager::WinEventProc(HWINEVENTHOOK hWinEventHook, DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD idEventThread, DWORD dwmsEventTime)
+{
+    // The hook misses the key events while another desktop is active, e.g. the lock screen or a UAC prompt, and those sent to elevated windows when the process is not elevated
+    keyboardManagerObjectPtr->inputHandler.SynchronizeKeyboardState();
+
+    // The foreground process is read here rather than for each key event, the app-specific remaps are found again only when it changes
+    keyboardManagerObjectPtr->inputHandler.UpdateForegroundProcess();
+    keyboardManagerObjectPtr->UpdateFrameHostEventHooks();
+}
+
+void CALLBACK KeyboardManager::FrameHostWinEventProc(HWINEVENTHOOK hWinEventHook, DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD idEventThread, DWORD dwmsEventTime)
+{
+    // A UWP app can become the foreground window before its window is created in the ApplicationFrameHost window, the foreground process is read again once it appears there
+    if (idObject != OBJID_WINDOW || idChild != CHILDID_SELF || !IsChild(GetForegroundWindow(), hwnd))
+    {
+        return;
+    }
+
+    keyboardManagerObjectPtr->inputHandler.UpdateForegroundProcess();
+    keyboardManagerObjectPtr->UpdateFrameHostEventHooks();
+}
+
+void KeyboardManager::UpdateFrameHostEventHooks()
+{
+    if (inputHandler.IsForegroundProcessFrameHost())
+    {
+        if (!frameHostShowEventHook)
+        {
+            frameHostShowEventHook = SetWinEventHook(EVENT_OBJECT_CREATE, EVENT_OBJECT_SHOW, nullptr, FrameHostWinEventProc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+        }
+
+        if (!frameHostNameChangeEventHook)
+        {
+            frameHostNameChangeEventHook = SetWinEventHook(EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE, nullptr, FrameHostWinEventProc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+        }
+    }
+    else
+    {
+        if (frameHostShowEventHook)
+        {
+            UnhookWinEvent(frameHostShowEventHook);
+            frameHostShowEventHook = nullptr;
+        }
+
+        if (frameHostNameChangeEventHook)
+        {
+            UnhookWinEvent(frameHostNameChangeEventHook);
+            frameHostNameChangeEventHook = nullptr;
+        }
+    }
+}
+
 void KeyboardManager::StartLowlevelKeyboardHook()
 {
 #if defined(DISABLE_LOWLEVEL_HOOKS_WHEN_DEBUGGED)
@@ -106,7 +163,15 @@ void KeyboardManager::StartLowlevelKeyboardHook()
             show_last_error_message(L"SetWindowsHookEx", errorCode, L"PowerToys - Keyboard Manager");
             auto errorMessage = get_last_error_message(errorCode);
             Trace::Error(errorCode, errorMessage.has_value() ? errorMessage.value() : L"", L"StartLowlevelKeyboardHook::SetWindowsHookEx");
+            return;
         }
+
+        // The key state is tracked from the hook events, and read from the system again only when the hook may have missed some of them. The foreground process is read again when it changes
+        inputHandler.SynchronizeKeyboardState();
+        inputHandler.UpdateForegroundProcess();
+        foregroundEventHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr, WinEventProc, 0, 0, WINEVENT_OUTOFCONTEXT);
+        desktopSwitchEventHook = SetWinEventHook(EVENT_SYSTEM_DESKTOPSWITCH, EVENT_SYSTEM_DESKTOPSWITCH, nullptr, WinEventProc, 0, 0, WINEVENT_OUTOFCONTEXT);
+        UpdateFrameHostEventHooks();
     }
 }
 
@@ -117,15 +182,34 @@ void KeyboardManager::StopLowlevelKeyboardHook()
         UnhookWindowsHookEx(hookHandle);
         hookHandle = nullptr;
     }
-}
 
-intptr_t KeyboardManager::HandleKeyboardHookEvent(LowlevelKeyboardEvent* data) noexcept
-{
-    if (loadingSettings)
+    if (foregroundEventHook)
     {
-        return 0;
+        UnhookWinEvent(foregroundEventHook);
+        foregroundEventHook = nullptr;
+    }
+
+    if (desktopSwitchEventHook)
+    {
+        UnhookWinEvent(desktopSwitchEventHook);
+        desktopSwitchEventHook = nullptr;
+    }
+
+    if (frameHostShowEventHook)
+    {
+        UnhookWinEvent(frameHostShowEventHook);
+        frameHostShowEventHook = nullptr;
+    }
+
+    if (frameHostNameChangeEventHook)
+    {
+        UnhookWinEvent(frameHostNameChangeEventHook);
+        frameHostNameChangeEventHook = nullptr;
     }
+}
 
+intptr_t KeyboardManager::HandleKeyboardHookEvent(LowlevelKeyboardEvent* data) noexcept
+{
     // Suspend remapping if remap key/shortcut window is opened
     if (editorIsRunningEvent != nullptr && WaitForSingleObject(editorIsRunningEvent, 0) == WAIT_OBJECT_0)
     {
@@ -138,6 +222,9 @@ intptr_t KeyboardManager::HandleKeyboardHookEvent(LowlevelKeyboardEvent* data) n
         return 1;
     }
 
+    // Use the newest state published after loading the settings
+    State& state = statePublisher.Acquire();
+
     // Remap a key
     intptr_t SingleKeyRemapResult = KeyboardEventHandlers::HandleSingleKeyRemapEvent(inputHandler, data, state);
 
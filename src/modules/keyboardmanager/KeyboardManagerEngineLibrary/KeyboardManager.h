@@ -2,7 +2,7 @@
 #include <common/hooks/LowlevelKeyboardEvent.h>
 #include <common/utils/EventWaiter.h>
 #include <keyboardmanager/common/Input.h>
-#include "State.h"
+#include "StatePublisher.h"
 
 class KeyboardManager
 {
@@ -35,8 +35,8 @@ private:
     // Only global or static variables can be accessed in a hook procedure CALLBACK
     static KeyboardManager* keyboardManagerObjectPtr;
 
-    // Variable which stores all the state information to be shared between the UI and back-end
-    State state;
+    // Publishes the state loaded from the settings to the hook, which keeps using the previous state while the settings are loaded
+    StatePublisher statePublisher;
 
     // Object of class which implements InputInterface. Required for calling library functions while enabling testing
     KeyboardManagerInput::Input inputHandler;
@@ -44,13 +44,28 @@ private:
     // Auto reset event for waiting for settings changes. The event is signaled when settings are changed
     EventWaiter settingsEventWaiter;
 
-    std::atomic_bool loadingSettings = false;
-
     HANDLE editorIsRunningEvent = nullptr;
 
+    // Win event hook handles for the changes after which the key state is read from the system
+    HWINEVENTHOOK foregroundEventHook = nullptr;
+    HWINEVENTHOOK desktopSwitchEventHook = nullptr;
+
+    // Win event hook handles for the windows created, shown or renamed, set only while the foreground process is resolved as ApplicationFrameHost
+    HWINEVENTHOOK frameHostShowEventHook = nullptr;
+    HWINEVENTHOOK frameHostNameChangeEventHook = nullptr;
+
     // Hook procedure definition
     static LRESULT CALLBACK HookProc(int nCode, WPARAM wParam, LPARAM lParam);
 
+    // Win event hook procedure definition, called when the foreground window or the desktop changes
+    static void CALLBACK WinEventProc(HWINEVENTHOOK hWinEventHook, DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD idEventThread, DWORD dwmsEventTime);
+
+    // Win event hook procedure definition, called when a window is created, shown or renamed while the foreground process is resolved as ApplicationFrameHost
+    static void CALLBACK FrameHostWinEventProc(HWINEVENTHOOK hWinEventHook, DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD idEventThread, DWORD dwmsEventTime);
+
+    // Function to set the frame host win event hooks while the foreground process is resolved as ApplicationFrameHost, and remove them otherwise
+    void UpdateFrameHostEventHooks();
+
     // Load settings from the file.
     void LoadSettings();
 
@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "ShortcutRemapDispatchTable.h"
+
+#include <keyboardmanager/common/InputInterface.h>
+
+namespace
+{
+    // Modifier keys read by Shortcut::CheckModifiersKeyboardState, in the order of their bits in the modifiers state
+    constexpr std::array<int, 11> ModifierKeyCodes = { VK_LWIN, VK_RWIN, VK_LCONTROL, VK_RCONTROL, VK_CONTROL, VK_LMENU, VK_RMENU, VK_MENU, VK_LSHIFT, VK_RSHIFT, VK_SHIFT };
+
+    constexpr uint32_t ModifierBit(int keyCode)
+    {
+        for (size_t i = 0; i < ModifierKeyCodes.size(); i++)
+        {
+            if (ModifierKeyCodes[i] == keyCode)
+            {
+                return 1u << i;
+            }
+        }
+
+        return 0;
+    }
+
+    // Function to get the bit of the modifier key expected by the shortcut, 0 if it is not part of the shortcut
+    uint32_t ModifierBit(ModifierKey modifier, int leftKey, int rightKey, int bothKey)
+    {
+        switch (modifier)
+        {
+        case ModifierKey::Left:
+            return ModifierBit(leftKey);
+        case ModifierKey::Right:
+            return ModifierBit(rightKey);
+        case ModifierKey::Both:
+            return ModifierBit(bothKey);
+        default:
+            return 0;
+        }
+    }
+}
+
+// Function to compile the remaps of a table, which are tried in the order of the sorted shortcuts
+void ShortcutRemapDispatchTable::Compile(ShortcutRemapTable& table, const std::vector<Shortcut>& sortedShortcuts)
+{
+    remaps.clear();
+    actionKeyOffsets.fill(0);
+    invokedRemap = nullptr;
+
+    // Count the remaps of each action key, shortcuts of other keys can't be invoked by a key event
+    for (const auto& shortcut : sortedShortcuts)
+    {
+        if (shortcut.GetActionKey() < KeyCount && table.contains(shortcut))
+        {
+            actionKeyOffsets[shortcut.GetActionKey() + 1]++;
+        }
+    }
+
+    for (size_t key = 0; key < KeyCount; key++)
+    {
+        actionKeyOffsets[key + 1] += actionKeyOffsets[key];
+    }
+
+    // Place the remaps of each action key in the order of the sorted shortcuts
+    remaps.resize(actionKeyOffsets[KeyCount]);
+    std::array<uint32_t, KeyCount> nextRemap;
+    std::copy(actionKeyOffsets.begin(), actionKeyOffsets.end() - 1, nextRemap.begin());
+    for (const auto& shortcut : sortedShortcuts)
+    {
+        auto it = table.find(shortcut);
+        if (shortcut.GetActionKey() >= KeyCount || it == table.end())
+        {
+            continue;
+        }
+
+        Remap& remap = remaps[nextRemap[shortcut.GetActionKey()]++];
+        remap.entry = &*it;
+        remap.requiredModifiers = ModifierBit(shortcut.ctrlKey, VK_LCONTROL, VK_RCONTROL, VK_CONTROL) |
+                                  ModifierBit(shortcut.altKey, VK_LMENU, VK_RMENU, VK_MENU) |
+                                  ModifierBit(shortcut.shiftKey, VK_LSHIFT, VK_RSHIFT, VK_SHIFT);
+        remap.anyModifiers = 0;
+
+        // Since VK_WIN does not exist, both VK_LWIN and VK_RWIN are accepted
+        if (shortcut.winKey == ModifierKey::Both)
+        {
+            remap.anyModifiers = ModifierBit(VK_LWIN) | ModifierBit(VK_RWIN);
+        }
+        else
+        {
+            remap.requiredModifiers |= ModifierBit(shortcut.winKey, VK_LWIN, VK_RWIN, 0);
+        }
+    }
+
+    // Keep a shortcut invoked before the remaps were compiled again
+    for (const auto& shortcut : sortedShortcuts)
+    {
+        auto it = table.find(shortcut);
+        if (it != table.end() && it->second.isShortcutInvoked)
+        {
+            auto invoked = std::find_if(remaps.begin(), remaps.end(), [&](const Remap& remap) { return remap.entry == &*it; });
+            invokedRemap = invoked != remaps.end() ? &*invoked : nullptr;
+            break;
+        }
+    }
+}
+
+// Function to get the remaps which can handle a key event, in the order they are tried. This is the invoked remap if there is one, otherwise the remaps of the key for a key down event
+std::span<const ShortcutRemapDispatchTable::Remap> ShortcutRemapDispatchTable::GetRemapsForKeyEvent(DWORD vkCode, bool isKeyDown)
+{
+    // The remap is no longer invoked once its shortcut has been released
+    if (invokedRemap && !invokedRemap->entry->second.isShortcutInvoked)
+    {
+        invokedRemap = nullptr;
+    }
+
+    if (invokedRemap)
+    {
+        return { invokedRemap, 1 };
+    }
+
+    if (!isKeyDown || vkCode >= KeyCount)
+    {
+        return {};
+    }
+
+    return std::span<const Remap>(remaps).subspan(actionKeyOffsets[vkCode], actionKeyOffsets[vkCode + 1] - actionKeyOffsets[vkCode]);
+}
+
+// Function to remember the remap which was invoked, it handles the next key events until it is released
+void ShortcutRemapDispatchTable::SetInvokedRemap(const Remap& remap)
+{
+    invokedRemap = &remap;
+}
+
+// Function to get the state of the modifier keys as a bitmask, to check the modifiers of the remaps of a key event with a single read of the keyboard state
+uint32_t ShortcutRemapDispatchTable::GetModifiersKeyboardState(KeyboardManagerInput::InputInterface& ii)
+{
+    const KeyboardState keyboardState = ii.GetKeyboardState();
+    uint32_t modifiersState = 0;
+    for (size_t i = 0; i < ModifierKeyCodes.size(); i++)
+    {
+        if (keyboardState.IsKeyPressed(ModifierKeyCodes[i]))
+        {
+            modifiersState |= 1u << i;
+        }
+    }
+
+    return modifiersState;
+}
+
+// Function to check if all the modifiers of the remap are pressed down. Same as Shortcut::CheckModifiersKeyboardState
+bool ShortcutRemapDispatchTable::CheckModifiersKeyboardState(const Remap& remap, uint32_t modifiersState)
+{
+    return (modifiersState & remap.requiredModifiers) == remap.requiredModifiers && (remap.anyModifiers == 0 || (modifiersState & remap.anyModifiers) != 0);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <span>
+#include <keyboardmanager/common/MappingConfiguration.h>
+
+namespace KeyboardManagerInput
+{
+    class InputInterface;
+}
+
+// Shortcut remaps of a remap table compiled for the keyboard hook. Until a shortcut is invoked, a key event can only invoke the remaps whose action key is pressed down, so the remaps are grouped by action key, in the order they are tried, with the modifier keys they require as a bitmask. After a shortcut is invoked, only that remap handles the key events until it is released.
+class ShortcutRemapDispatchTable
+{
+public:
+    struct Remap
+    {
+        ShortcutRemapTable::value_type* entry;
+
+        // Modifier keys which must all be pressed down
+        uint32_t requiredModifiers;
+
+        // Modifier keys of which one must be pressed down, used for the win key when the shortcut accepts both of them
+        uint32_t anyModifiers;
+    };
+
+    // Function to compile the remaps of a table, which are tried in the order of the sorted shortcuts
+    void Compile(ShortcutRemapTable& table, const std::vector<Shortcut>& sortedShortcuts);
+
+    // Function to get the remaps which can handle a key event, in the order they are tried. This is the invoked remap if there is one, otherwise the remaps of the key for a key down event
+    std::span<const Remap> GetRemapsForKeyEvent(DWORD vkCode, bool isKeyDown);
+
+    // Function to remember the remap which was invoked, it handles the next key events until it is released
+    void SetInvokedRemap(const Remap& remap);
+
+    // Function to get the state of the modifier keys as a bitmask, to check the modifiers of the remaps of a key event with a single read of the keyboard state
+    static uint32_t GetModifiersKeyboardState(KeyboardManagerInput::InputInterface& ii);
+
+    // Function to check if all the modifiers of the remap are pressed down. Same as Shortcut::CheckModifiersKeyboardState
+    static bool CheckModifiersKeyboardState(const Remap& remap, uint32_t modifiersState);
+
+private:
+    static constexpr size_t KeyCount = 256;
+
+    // Remaps grouped by action key, the remaps of a key are those from actionKeyOffsets[key] to actionKeyOffsets[key + 1]
+    std::vector<Remap> remaps;
+    std::array<uint32_t, KeyCount + 1> actionKeyOffsets{};
+
+    const Remap* invokedRemap = nullptr;
+};
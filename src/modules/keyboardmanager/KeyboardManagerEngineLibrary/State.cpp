@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "State.h"
 #include <optional>
+#include <algorithm>
 
 // Function to get the iterator of a single key remap given the source key. Returns nullopt if it isn't remapped
 std::optional<SingleKeyRemapTable::iterator> State::GetSingleKeyRemap(const DWORD& originalKey)
@@ -14,50 +15,164 @@ std::optional<SingleKeyRemapTable::iterator> State::GetSingleKeyRemap(const DWOR
     return std::nullopt;
 }
 
-bool State::CheckShortcutRemapInvoked(const std::optional<std::wstring>& appName)
+// Function to get the id of an app with app-specific remaps. Returns nullopt if it has none
+std::optional<size_t> State::FindAppId(std::wstring_view appName) const
 {
-    // Assumes appName exists in the app-specific remap table
-    ShortcutRemapTable& currentRemapTable = appName ? appSpecificShortcutReMap[*appName] : osLevelShortcutReMap;
-    for (auto& it : currentRemapTable)
+    auto it = std::lower_bound(appNames.begin(), appNames.end(), appName);
+    if (it != appNames.end() && *it == appName)
     {
-        if (it.second.isShortcutInvoked)
-        {
-            return true;
-        }
+        return it - appNames.begin();
+    }
+
+    return std::nullopt;
+}
+
+// Function to compile the shortcut remaps for the keyboard hook, so that a key event is dispatched to the remaps of its key
+void State::CompileShortcutRemaps()
+{
+    // The ids of the apps are assigned again, the activated app is kept by its name
+    const std::wstring activatedApp = GetActivatedApp();
+
+    osLevelShortcutRemapDispatchTable.Compile(osLevelShortcutReMap, osLevelShortcutReMapSortedKeys);
+
+    // The apps are in the order of their names in the map, so the id of an app is found by a binary search
+    appNames.clear();
+    appSpecificShortcutRemapDispatchTables.clear();
+    appSpecificShortcutRemapDispatchTables.resize(appSpecificShortcutReMap.size());
+    for (auto& [appName, table] : appSpecificShortcutReMap)
+    {
+        appSpecificShortcutRemapDispatchTables[appNames.size()].Compile(table, appSpecificShortcutReMapSortedKeys[appName]);
+        appNames.push_back(appName);
     }
 
-    return false;
+    compiledShortcutRemapsVersion = shortcutRemapsVersion;
+    activatedAppId = FindAppId(activatedApp);
+    foregroundProcessVersion = std::nullopt;
 }
 
-// Function to get the source and target of a shortcut remap given the source shortcut. Returns nullopt if it isn't remapped
-ShortcutRemapTable& State::GetShortcutRemapTable(const std::optional<std::wstring>& appName)
+// Function to get the compiled shortcut remaps of the app, or the os-level ones if appId is nullopt. The remaps are compiled again if they changed
+ShortcutRemapDispatchTable& State::GetShortcutRemapDispatchTable(const std::optional<size_t>& appId)
 {
-    if (appName)
+    if (compiledShortcutRemapsVersion != shortcutRemapsVersion)
+    {
+        CompileShortcutRemaps();
+    }
+
+    if (appId && *appId < appSpecificShortcutRemapDispatchTables.size())
     {
-        auto itTable = appSpecificShortcutReMap.find(*appName);
-        if (itTable != appSpecificShortcutReMap.end())
+        return appSpecificShortcutRemapDispatchTables[*appId];
+    }
+
+    return osLevelShortcutRemapDispatchTable;
+}
+
+// Function to get the id of the app-specific remaps of the foreground process, by its name or its name without the file extension. Returns nullopt if it has none. The id is cached until the foreground process or the remaps change
+std::optional<size_t> State::GetForegroundAppId(const KeyboardManagerInput::ForegroundProcess& foregroundProcess)
+{
+    if (compiledShortcutRemapsVersion != shortcutRemapsVersion)
+    {
+        CompileShortcutRemaps();
+    }
+
+    if (foregroundProcessVersion != foregroundProcess.version)
+    {
+        const std::wstring_view processName = foregroundProcess.name;
+        foregroundAppId = FindAppId(processName);
+
+        // If no entry is found, search for the process name without it's file extension
+        if (!foregroundAppId)
         {
-            return itTable->second;
+            foregroundAppId = FindAppId(processName.substr(0, processName.find_last_of(L'.')));
         }
+
+        foregroundProcessVersion = foregroundProcess.version;
     }
 
-    return osLevelShortcutReMap;
+    return foregroundAppId;
 }
 
-std::vector<Shortcut>& State::GetSortedShortcutRemapVector(const std::optional<std::wstring>& appName)
+// Function to carry over the pressed shortcuts and the activated app of the state used before reloading the settings. Returns false without changing the state if a pressed shortcut was changed or removed, since its keys have to be released with the remap they were pressed with
+bool State::CarryOverRuntimeState(const State& previousState)
 {
-    // Assumes appName exists in the app-specific remap table
-    return appName ? appSpecificShortcutReMapSortedKeys[*appName] : osLevelShortcutReMapSortedKeys;
+    // Pairs of the remaps which are pressed down and the same remaps in this state
+    std::vector<std::pair<const RemapShortcut*, RemapShortcut*>> pressedRemaps;
+    auto findPressedRemaps = [&pressedRemaps](const ShortcutRemapTable& previousTable, ShortcutRemapTable* table) {
+        for (const auto& [shortcut, remap] : previousTable)
+        {
+            if (!remap.isShortcutInvoked && !remap.isOriginalActionKeyPressed)
+            {
+                continue;
+            }
+
+            if (table == nullptr)
+            {
+                return false;
+            }
+
+            auto it = table->find(shortcut);
+            if (it == table->end() || !(it->second.targetShortcut == remap.targetShortcut))
+            {
+                return false;
+            }
+
+            pressedRemaps.emplace_back(&remap, &it->second);
+        }
+
+        return true;
+    };
+
+    if (!findPressedRemaps(previousState.osLevelShortcutReMap, &osLevelShortcutReMap))
+    {
+        return false;
+    }
+
+    for (const auto& [appName, previousTable] : previousState.appSpecificShortcutReMap)
+    {
+        auto itTable = appSpecificShortcutReMap.find(appName);
+        if (!findPressedRemaps(previousTable, itTable != appSpecificShortcutReMap.end() ? &itTable->second : nullptr))
+        {
+            return false;
+        }
+    }
+
+    for (const auto& [previousRemap, remap] : pressedRemaps)
+    {
+        remap->isShortcutInvoked = previousRemap->isShortcutInvoked;
+        remap->winKeyInvoked = previousRemap->winKeyInvoked;
+        remap->isOriginalActionKeyPressed = previousRemap->isOriginalActionKeyPressed;
+    }
+
+    SetActivatedApp(previousState.GetActivatedApp());
+
+    // The compiled remaps keep track of the invoked shortcut
+    if (!pressedRemaps.empty())
+    {
+        CompileShortcutRemaps();
+    }
+
+    return true;
 }
 
 // Sets the activated target application in app-specific shortcut
 void State::SetActivatedApp(const std::wstring& appName)
 {
-    activatedAppSpecificShortcutTarget = appName;
+    activatedAppId = FindAppId(appName);
+}
+
+// Sets the activated target application in app-specific shortcut by its id
+void State::SetActivatedAppId(const std::optional<size_t>& appId)
+{
+    activatedAppId = appId;
 }
 
 // Gets the activated target application in app-specific shortcut
-std::wstring State::GetActivatedApp()
+const std::wstring& State::GetActivatedApp() const
+{
+    return activatedAppId ? appNames[*activatedAppId] : KeyboardManagerConstants::NoActivatedApp;
+}
+
+// Gets the id of the activated target application in app-specific shortcut
+std::optional<size_t> State::GetActivatedAppId() const
 {
-    return activatedAppSpecificShortcutTarget;
+    return activatedAppId;
 }
@@ -1,26 +1,52 @@
 #pragma once
 #include <keyboardmanager/common/MappingConfiguration.h>
+#include <keyboardmanager/common/InputInterface.h>
+#include "ShortcutRemapDispatchTable.h"
 
 class State : public MappingConfiguration
 {
 private:
-    // Stores the activated target application in app-specific shortcut
-    std::wstring activatedAppSpecificShortcutTarget;
+    // Stores the id of the activated target application in app-specific shortcut
+    std::optional<size_t> activatedAppId;
+
+    // Stores the shortcut remaps compiled for the keyboard hook, and the version of the remaps they were compiled from. The apps with app-specific remaps are identified by the index of their name in appNames, which is sorted
+    ShortcutRemapDispatchTable osLevelShortcutRemapDispatchTable;
+    std::vector<std::wstring> appNames;
+    std::vector<ShortcutRemapDispatchTable> appSpecificShortcutRemapDispatchTables;
+    std::optional<unsigned int> compiledShortcutRemapsVersion;
+
+    // Stores the id of the app-specific remaps of the foreground process, and the version of the foreground process it was found for
+    std::optional<size_t> foregroundAppId;
+    std::optional<unsigned int> foregroundProcessVersion;
+
+    // Function to get the id of an app with app-specific remaps. Returns nullopt if it has none
+    std::optional<size_t> FindAppId(std::wstring_view appName) const;
 
 public:
     // Function to get the iterator of a single key remap given the source key. Returns nullopt if it isn't remapped
     std::optional<SingleKeyRemapTable::iterator> GetSingleKeyRemap(const DWORD& originalKey);
 
-    bool CheckShortcutRemapInvoked(const std::optional<std::wstring>& appName);
+    // Function to compile the shortcut remaps for the keyboard hook, so that a key event is dispatched to the remaps of its key
+    void CompileShortcutRemaps();
 
-    // Function to get the source and target of a shortcut remap given the source shortcut. Returns nullopt if it isn't remapped
-    ShortcutRemapTable& GetShortcutRemapTable(const std::optional<std::wstring>& appName);
+    // Function to get the compiled shortcut remaps of the app, or the os-level ones if appId is nullopt. The remaps are compiled again if they changed
+    ShortcutRemapDispatchTable& GetShortcutRemapDispatchTable(const std::optional<size_t>& appId);
 
-    std::vector<Shortcut>& GetSortedShortcutRemapVector(const std::optional<std::wstring>& appName);
+    // Function to get the id of the app-specific remaps of the foreground process, by its name or its name without the file extension. Returns nullopt if it has none. The id is cached until the foreground process or the remaps change
+    std::optional<size_t> GetForegroundAppId(const KeyboardManagerInput::ForegroundProcess& foregroundProcess);
+
+    // Function to carry over the pressed shortcuts and the activated app of the state used before reloading the settings. Returns false without changing the state if a pressed shortcut was changed or removed, since its keys have to be released with the remap they were pressed with
+    bool CarryOverRuntimeState(const State& previousState);
 
     // Sets the activated target application in app-specific shortcut
     void SetActivatedApp(const std::wstring& appName);
 
+    // Sets the activated target application in app-specific shortcut by its id
+    void SetActivatedAppId(const std::optional<size_t>& appId);
+
     // Gets the activated target application in app-specific shortcut
-    std::wstring GetActivatedApp();
-};
\ No newline at end of file
+    const std::wstring& GetActivatedApp() const;
+
+    // Gets the id of the activated target application in app-specific shortcut
+    std::optional<size_t> GetActivatedAppId() const;
+};
@@ -0,0 +1,44 @@
+#include "pch.h"
+#include "StatePublisher.h"
+
+StatePublisher::StatePublisher() :
+    currentState(std::make_unique<State>())
+{
+}
+
+StatePublisher::~StatePublisher()
+{
+    delete publishedState.exchange(nullptr);
+}
+
+// Function called after loading the settings to publish the new state. A state published before which was not swapped in yet is dropped
+void StatePublisher::Publish(std::unique_ptr<State> newState)
+{
+    delete publishedState.exchange(newState.release());
+}
+
+// Function called by the keyboard hook to get the state to handle a key event with. The newest published state is swapped in, unless a shortcut which is pressed down can't be carried over to it, in which case it is swapped in once the shortcut is released
+State& StatePublisher::Acquire()
+{
+    if (publishedState.load(std::memory_order_relaxed) == nullptr)
+    {
+        return *currentState;
+    }
+
+    std::unique_ptr<State> newState(publishedState.exchange(nullptr));
+    if (newState && newState->CarryOverRuntimeState(*currentState))
+    {
+        currentState = std::move(newState);
+    }
+    else if (newState)
+    {
+        // Keep the state for the next key events, unless a newer one was published meanwhile
+        State* expected = nullptr;
+        if (publishedState.compare_exchange_strong(expected, newState.get()))
+        {
+            newState.release();
+        }
+    }
+
+    return *currentState;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include "State.h"
+
+// Publishes the states loaded from the settings to the keyboard hook. A new state is loaded and compiled apart from the one used by the hook, which swaps it in before handling a key event, so the remaps keep working while the settings are reloaded and the two threads never use the same state
+class StatePublisher
+{
+public:
+    StatePublisher();
+    ~StatePublisher();
+
+    StatePublisher(const StatePublisher&) = delete;
+    StatePublisher& operator=(const StatePublisher&) = delete;
+
+    // Function called after loading the settings to publish the new state. A state published before which was not swapped in yet is dropped
+    void Publish(std::unique_ptr<State> newState);
+
+    // Function called by the keyboard hook to get the state to handle a key event with. The newest published state is swapped in, unless a shortcut which is pressed down can't be carried over to it, in which case it is swapped in once the shortcut is released
+    State& Acquire();
+
+private:
+    // State used by the keyboard hook, only accessed by the hook thread
+    std::unique_ptr<State> currentState;
+
+    // Newest published state which was not swapped in yet, owned by this pointer
+    std::atomic<State*> publishedState = nullptr;
+};
@@ -342,5 +342,69 @@ namespace RemappingLogicTests
             Assert::AreEqual(mockedInputHandler.GetVirtualKeyState(VK_CONTROL), false);
             Assert::AreEqual(mockedInputHandler.GetVirtualKeyState(actionKey), false);
         }
+
+        // Test if the app specific remap takes place when it is added after key events were handled with the same foreground app
+        TEST_METHOD (AppSpecificShortcut_ShouldGetRemapped_WhenAddedAfterKeyEvents)
+        {
+            // Set the testApp as the foreground process
+            mockedInputHandler.SetForegroundProcess(testApp1);
+
+            const int nInputs = 2;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = 0x41;
+
+            // Send Ctrl+A keydown and keyup without any remap
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+            input[0].ki.dwFlags = KEYEVENTF_KEYUP;
+            input[1].ki.dwFlags = KEYEVENTF_KEYUP;
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            // Remap Ctrl+A to V
+            Shortcut src;
+            src.SetKey(VK_CONTROL);
+            src.SetKey(0x41);
+            testState.AddAppSpecificShortcut(testApp1, src, (DWORD)0x56);
+
+            // Send Ctrl+A keydown
+            input[0].ki.dwFlags = 0;
+            input[1].ki.dwFlags = 0;
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            // V key state should be true, A key state should be false
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x56));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x41));
+            Assert::AreEqual(testApp1, testState.GetActivatedApp());
+        }
+
+        // Test if the app specific remap takes place when the name of the foreground process differs in case or has an extension which is not in the remapped app name
+        TEST_METHOD (AppSpecificShortcut_ShouldGetRemapped_WhenForegroundProcessNameDiffersInCaseOrExtension)
+        {
+            // Remap Ctrl+A to V for testApp2 without its extension
+            Shortcut src;
+            src.SetKey(VK_CONTROL);
+            src.SetKey(0x41);
+            testState.AddAppSpecificShortcut(L"testprocess2", src, (DWORD)0x56);
+
+            // Set the testApp as the foreground process, in upper case
+            mockedInputHandler.SetForegroundProcess(L"TestProcess2.EXE");
+
+            const int nInputs = 2;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = 0x41;
+
+            // Send Ctrl+A keydown
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            // V key state should be true, A key state should be false
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x56));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x41));
+            Assert::AreEqual(std::wstring(L"testprocess2"), testState.GetActivatedApp());
+        }
     };
 }
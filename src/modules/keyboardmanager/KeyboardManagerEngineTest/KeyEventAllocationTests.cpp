@@ -0,0 +1,248 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/KeyboardManagerEngineLibrary/State.h>
+#include <keyboardmanager/KeyboardManagerEngineLibrary/KeyboardEventHandlers.h>
+#include "TestHelpers.h"
+#include <common/interop/shared_constants.h>
+#include <cstdlib>
+#include <new>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+    // Number of allocations made by the thread of the test while they are counted
+    thread_local bool isCountingAllocations = false;
+    thread_local size_t allocationCount = 0;
+}
+
+// The allocation functions are replaced in the test module to count the allocations made while the key events are handled. The array and sized forms call these ones
+void* operator new(size_t size)
+{
+    if (isCountingAllocations)
+    {
+        allocationCount++;
+    }
+
+    if (void* memory = std::malloc(size != 0 ? size : 1))
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+namespace RemappingLogicTests
+{
+    // Tests for the memory allocated by the keyboard hook
+    TEST_CLASS (KeyEventAllocationTests)
+    {
+    private:
+        KeyboardManagerInput::MockedInput mockedInputHandler;
+        State testState;
+        std::wstring testApp = L"testprocess.exe";
+
+        // Function to create a shortcut from a list of keys
+        static Shortcut CreateShortcut(const std::vector<DWORD>& keys)
+        {
+            Shortcut shortcut;
+            for (auto key : keys)
+            {
+                shortcut.SetKey(key);
+            }
+            return shortcut;
+        }
+
+        // Function to send the key down or key up event of a key and return the number of allocations made while it is handled
+        size_t SendKeyAndCountAllocations(WORD key, bool isKeyUp)
+        {
+            INPUT input = {};
+            input.type = INPUT_KEYBOARD;
+            input.ki.wVk = key;
+            input.ki.dwFlags = isKeyUp ? KEYEVENTF_KEYUP : 0;
+
+            allocationCount = 0;
+            isCountingAllocations = true;
+            mockedInputHandler.SendVirtualInput(1, &input, sizeof(INPUT));
+            isCountingAllocations = false;
+            return allocationCount;
+        }
+
+        // Function to check that no key is pressed down after a key sequence
+        void AssertNoKeyIsPressed()
+        {
+            for (int key = 1; key < 256; key++)
+            {
+                Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(key));
+            }
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+
+            // Set the handlers as the hook procedure, in the order of KeyboardManager::HandleKeyboardHookEvent
+            mockedInputHandler.SetHookProc([this](LowlevelKeyboardEvent* data) {
+                if (data->lParam->dwExtraInfo == KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG)
+                {
+                    return (intptr_t)1;
+                }
+
+                if (KeyboardEventHandlers::HandleSingleKeyRemapEvent(mockedInputHandler, data, testState) == 1)
+                {
+                    return (intptr_t)1;
+                }
+
+                if (KeyboardEventHandlers::HandleAppSpecificShortcutRemapEvent(mockedInputHandler, data, testState) == 1)
+                {
+                    return (intptr_t)1;
+                }
+
+                return KeyboardEventHandlers::HandleOSLevelShortcutRemapEvent(mockedInputHandler, data, testState);
+            });
+
+            // Remap F1 to Ctrl+C and RShift to Caps Lock, which also sends a key event for lower level key handlers
+            testState.AddSingleKeyRemap(VK_F1, CreateShortcut({ VK_CONTROL, 0x43 }));
+            testState.AddSingleKeyRemap(VK_RSHIFT, (DWORD)VK_CAPITAL);
+
+            // Remap Ctrl+A to Ctrl+Shift+V, Alt+D to Win+E, Ctrl+S to F and Ctrl+Q to Disable
+            testState.AddOSLevelShortcut(CreateShortcut({ VK_CONTROL, 0x41 }), CreateShortcut({ VK_CONTROL, VK_SHIFT, 0x56 }));
+            testState.AddOSLevelShortcut(CreateShortcut({ VK_MENU, 0x44 }), CreateShortcut({ CommonSharedConstants::VK_WIN_BOTH, 0x45 }));
+            testState.AddOSLevelShortcut(CreateShortcut({ VK_CONTROL, 0x53 }), (DWORD)0x46);
+            testState.AddOSLevelShortcut(CreateShortcut({ VK_CONTROL, 0x51 }), (DWORD)CommonSharedConstants::VK_DISABLED);
+
+            // Remap Ctrl+W to Alt+X for the test app
+            testState.AddAppSpecificShortcut(testApp, CreateShortcut({ VK_CONTROL, 0x57 }), CreateShortcut({ VK_MENU, 0x58 }));
+
+            // The remaps are compiled when they are loaded from the settings, before the hook uses them
+            testState.CompileShortcutRemaps();
+        }
+
+        // Test if the single key remaps do not allocate memory
+        TEST_METHOD (SingleKeyRemaps_ShouldNotAllocate_WhenKeyEventsAreHandled)
+        {
+            // Send F1 keydown, Ctrl and C should be pressed down
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_F1, false));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_CONTROL));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x43));
+
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_F1, true));
+            AssertNoKeyIsPressed();
+
+            // Send RShift keydown, Caps Lock should be pressed down
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_RSHIFT, false));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_CAPITAL));
+
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_RSHIFT, true));
+            AssertNoKeyIsPressed();
+        }
+
+        // Test if the shortcut remaps do not allocate memory while a shortcut is invoked, repeated, mixed with other keys and released
+        TEST_METHOD (ShortcutRemaps_ShouldNotAllocate_WhenKeyEventsAreHandled)
+        {
+            // Send Ctrl+A keydown and a repeated A keydown, Ctrl+Shift+V should be pressed down
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, false));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x41, false));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x41, false));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_SHIFT));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x56));
+
+            // Release A then Ctrl
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x41, true));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, true));
+            AssertNoKeyIsPressed();
+
+            // Send Alt+D keydown, Win+E should be pressed down
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_MENU, false));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x44, false));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_LWIN));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x45));
+
+            // Send B keydown, the keyboard state should be reverted to Alt+D+B
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x42, false));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_MENU));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x42));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(VK_LWIN));
+
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x42, true));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x44, true));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_MENU, true));
+            AssertNoKeyIsPressed();
+
+            // Send Ctrl+S keydown, F should be pressed down, then release Ctrl before S
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, false));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x53, false));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x46));
+
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, true));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x53, true));
+            AssertNoKeyIsPressed();
+
+            // Send Ctrl+Q keydown, nothing should be pressed down apart from Ctrl
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, false));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x51, false));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x51));
+
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x51, true));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, true));
+            AssertNoKeyIsPressed();
+        }
+
+        // Test if the app-specific shortcut remaps do not allocate memory
+        TEST_METHOD (AppSpecificShortcutRemaps_ShouldNotAllocate_WhenKeyEventsAreHandled)
+        {
+            // Set the testApp as the foreground process
+            mockedInputHandler.SetForegroundProcess(testApp);
+
+            // Send Ctrl+W keydown, Alt+X should be pressed down
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, false));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x57, false));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_MENU));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x58));
+            Assert::AreEqual(testApp, testState.GetActivatedApp());
+
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x57, true));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, true));
+            AssertNoKeyIsPressed();
+        }
+
+        // Test if the key events do not allocate memory while a UWP app is still resolved as ApplicationFrameHost, and the app-specific remaps apply once it is resolved
+        TEST_METHOD (AppSpecificShortcutRemaps_ShouldNotAllocate_WhenForegroundProcessIsFrameHost)
+        {
+            // Set ApplicationFrameHost as the foreground process, as it is read before the window of the UWP app appears
+            mockedInputHandler.SetForegroundProcess(L"ApplicationFrameHost.exe");
+
+            // Send Ctrl+W keydown, it should not be remapped
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, false));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x57, false));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x57));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x58));
+
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x57, true));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, true));
+            AssertNoKeyIsPressed();
+
+            // The foreground process is read again when the window of the UWP app appears
+            mockedInputHandler.SetForegroundProcess(testApp);
+
+            // Send Ctrl+W keydown, Alt+X should be pressed down
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, false));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x57, false));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_MENU));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x58));
+            Assert::AreEqual(testApp, testState.GetActivatedApp());
+
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(0x57, true));
+            Assert::AreEqual((size_t)0, SendKeyAndCountAllocations(VK_CONTROL, true));
+            AssertNoKeyIsPressed();
+        }
+    };
+}
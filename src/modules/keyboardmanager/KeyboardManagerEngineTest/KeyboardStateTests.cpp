@@ -0,0 +1,193 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/KeyboardManagerEngineLibrary/State.h>
+#include <keyboardmanager/common/Input.h>
+#include <keyboardmanager/common/Shortcut.h>
+#include "TestHelpers.h"
+#include <common/interop/shared_constants.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Input which reads the state of each key from the system, as it was done for every key event before the key state was tracked from the hook events
+    class PollingInput : public KeyboardManagerInput::Input
+    {
+    public:
+        bool GetVirtualKeyState(int key)
+        {
+            return (GetAsyncKeyState(key) & 0x8000);
+        }
+
+        KeyboardState GetKeyboardState()
+        {
+            KeyboardState keyboardState;
+            keyboardState.Synchronize();
+            return keyboardState;
+        }
+    };
+
+    // Tests for the key state bitmap and the shortcut checks which use it
+    TEST_CLASS (KeyboardStateTests)
+    {
+    private:
+        KeyboardManagerInput::MockedInput mockedInputHandler;
+        State testState;
+
+        // Function to check if a pressed key is allowed along with a shortcut, as each key was checked before the keys were checked as a set
+        static bool IsKeyAllowedWithShortcut(const Shortcut& shortcut, DWORD key)
+        {
+            switch (key)
+            {
+            case VK_LBUTTON:
+                return true;
+            case VK_LWIN:
+                return shortcut.winKey == ModifierKey::Left || shortcut.winKey == ModifierKey::Both;
+            case VK_RWIN:
+                return shortcut.winKey == ModifierKey::Right || shortcut.winKey == ModifierKey::Both;
+            case VK_LCONTROL:
+                return shortcut.ctrlKey == ModifierKey::Left || shortcut.ctrlKey == ModifierKey::Both;
+            case VK_RCONTROL:
+                return shortcut.ctrlKey == ModifierKey::Right || shortcut.ctrlKey == ModifierKey::Both;
+            case VK_CONTROL:
+                return shortcut.ctrlKey != ModifierKey::Disabled;
+            case VK_LMENU:
+                return shortcut.altKey == ModifierKey::Left || shortcut.altKey == ModifierKey::Both;
+            case VK_RMENU:
+                return shortcut.altKey == ModifierKey::Right || shortcut.altKey == ModifierKey::Both;
+            case VK_MENU:
+                return shortcut.altKey != ModifierKey::Disabled;
+            case VK_LSHIFT:
+                return shortcut.shiftKey == ModifierKey::Left || shortcut.shiftKey == ModifierKey::Both;
+            case VK_RSHIFT:
+                return shortcut.shiftKey == ModifierKey::Right || shortcut.shiftKey == ModifierKey::Both;
+            case VK_SHIFT:
+                return shortcut.shiftKey != ModifierKey::Disabled;
+            default:
+                return key == shortcut.actionKey;
+            }
+        }
+
+        // Function to measure the average time of checking the keyboard state for a key event of a shortcut
+        static double MeasureKeyEventTime(KeyboardManagerInput::InputInterface& ii, const Shortcut& shortcut, int events)
+        {
+            int invokedCount = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < events; i++)
+            {
+                // Both checks are done, as for the key events of a remapped shortcut
+                const bool isModifiersPressed = shortcut.CheckModifiersKeyboardState(ii);
+                const bool isKeyboardStateClear = shortcut.IsKeyboardStateClearExceptShortcut(ii);
+                if (isModifiersPressed && isKeyboardStateClear)
+                {
+                    invokedCount++;
+                }
+            }
+            auto duration = std::chrono::steady_clock::now() - start;
+
+            // The shortcut is not pressed down while the test runs
+            Assert::AreEqual(0, invokedCount);
+            return std::chrono::duration<double, std::nano>(duration).count() / events;
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+        }
+
+        // Test if a generic modifier key code is pressed down while its left or right key is pressed down
+        TEST_METHOD (UpdateKeyState_ShouldPressGenericModifier_WhileLeftOrRightModifierIsPressed)
+        {
+            KeyboardState keyboardState;
+            keyboardState.UpdateKeyState(VK_LCONTROL, true);
+            keyboardState.UpdateKeyState(VK_RCONTROL, true);
+            Assert::AreEqual(true, keyboardState.IsKeyPressed(VK_CONTROL));
+
+            keyboardState.UpdateKeyState(VK_LCONTROL, false);
+            Assert::AreEqual(true, keyboardState.IsKeyPressed(VK_CONTROL));
+
+            keyboardState.UpdateKeyState(VK_RCONTROL, false);
+            Assert::AreEqual(false, keyboardState.IsKeyPressed(VK_CONTROL));
+        }
+
+        // Test if a generic modifier key code presses the left key down and releases both keys
+        TEST_METHOD (UpdateKeyState_ShouldPressLeftModifier_OnGenericModifierKeyDown)
+        {
+            KeyboardState keyboardState;
+            keyboardState.UpdateKeyState(VK_SHIFT, true);
+            Assert::AreEqual(true, keyboardState.IsKeyPressed(VK_LSHIFT));
+            Assert::AreEqual(true, keyboardState.IsKeyPressed(VK_SHIFT));
+
+            keyboardState.UpdateKeyState(VK_RSHIFT, true);
+            keyboardState.UpdateKeyState(VK_SHIFT, false);
+            Assert::AreEqual(false, keyboardState.IsKeyPressed(VK_LSHIFT));
+            Assert::AreEqual(false, keyboardState.IsKeyPressed(VK_RSHIFT));
+            Assert::AreEqual(false, keyboardState.IsKeyPressed(VK_SHIFT));
+        }
+
+        // Test if the keyboard state is clear except the shortcut exactly when each pressed key is allowed along with the shortcut
+        TEST_METHOD (IsKeyboardStateClearExceptShortcut_ShouldMatchCheckingEachKey)
+        {
+            const DWORD keys[] = { VK_LWIN, VK_RWIN, VK_LCONTROL, VK_RCONTROL, VK_CONTROL, VK_LMENU, VK_RMENU, VK_MENU, VK_LSHIFT, VK_RSHIFT, VK_SHIFT, VK_LBUTTON, 0x41, 0x42, VK_F5, VK_SPACE };
+            std::vector<Shortcut> shortcuts;
+            for (const auto& shortcutKeys : std::vector<std::vector<DWORD>>{ { VK_CONTROL, 0x41 }, { VK_LCONTROL, VK_SHIFT, 0x42 }, { CommonSharedConstants::VK_WIN_BOTH, VK_RMENU, VK_F5 }, { VK_LWIN, VK_RSHIFT, VK_SPACE } })
+            {
+                Shortcut shortcut;
+                for (auto key : shortcutKeys)
+                {
+                    shortcut.SetKey(key);
+                }
+                shortcuts.push_back(shortcut);
+            }
+
+            std::mt19937 random(5);
+            for (int i = 0; i < 2000; i++)
+            {
+                mockedInputHandler.ResetKeyboardState();
+                for (auto key : keys)
+                {
+                    if (random() % 4 == 0)
+                    {
+                        INPUT input = {};
+                        input.type = INPUT_KEYBOARD;
+                        input.ki.wVk = (WORD)key;
+                        mockedInputHandler.SendVirtualInput(1, &input, sizeof(INPUT));
+                    }
+                }
+
+                for (const auto& shortcut : shortcuts)
+                {
+                    bool expected = std::all_of(std::begin(keys), std::end(keys), [&](DWORD key) {
+                        return !mockedInputHandler.GetVirtualKeyState(key) || IsKeyAllowedWithShortcut(shortcut, key);
+                    });
+                    Assert::AreEqual(expected, shortcut.IsKeyboardStateClearExceptShortcut(mockedInputHandler));
+                }
+            }
+        }
+
+        // Benchmark of checking the keyboard state for a key event with the key state tracked from the hook events and with the key state read from the system for each key, only logged as timings depend on the machine
+        TEST_METHOD (KeyEventTime_TrackedAndPolledKeyState)
+        {
+            Shortcut shortcut;
+            shortcut.SetKey(VK_CONTROL);
+            shortcut.SetKey(VK_SHIFT);
+            shortcut.SetKey(0x41);
+
+            PollingInput pollingInput;
+            KeyboardManagerInput::Input trackingInput;
+            trackingInput.SynchronizeKeyboardState();
+
+            const double pollingTime = MeasureKeyEventTime(pollingInput, shortcut, 2000);
+            const double trackingTime = MeasureKeyEventTime(trackingInput, shortcut, 200000);
+
+            Logger::WriteMessage((L"Key event time with the key state read from the system: " + std::to_wstring(pollingTime) + L" ns\n").c_str());
+            Logger::WriteMessage((L"Key event time with the key state tracked from the hook events: " + std::to_wstring(trackingTime) + L" ns\n").c_str());
+        }
+    };
+}
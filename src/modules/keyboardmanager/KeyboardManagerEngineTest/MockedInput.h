@@ -13,7 +13,7 @@ namespace KeyboardManagerInput
     {
     private:
         // Stores the states for all the keys - false for key up, and true for key down
-        std::vector<bool> keyboardState;
+        KeyboardState keyboardState;
 
         // Function to be executed as a low level hook. By default it is nullptr so the hook is skipped
         std::function<intptr_t(LowlevelKeyboardEvent*)> hookProc;
@@ -22,14 +22,9 @@ namespace KeyboardManagerInput
         int sendVirtualInputCallCount = 0;
         std::function<bool(LowlevelKeyboardEvent*)> sendVirtualInputCallCondition;
 
-        std::wstring currentProcess;
+        ForegroundProcess foregroundProcess;
 
     public:
-        MockedInput()
-        {
-            keyboardState.resize(256, false);
-        }
-
         // Set the keyboard hook procedure to be tested
         void SetHookProc(std::function<intptr_t(LowlevelKeyboardEvent*)> hookProcedure);
 
@@ -42,6 +37,9 @@ namespace KeyboardManagerInput
         // Function to get the state of a particular key
         bool GetVirtualKeyState(int key);
 
+        // Function to get the state of all the keys
+        KeyboardState GetKeyboardState();
+
         // Function to reset the mocked keyboard state
         void ResetKeyboardState();
 
@@ -51,11 +49,11 @@ namespace KeyboardManagerInput
         // Function to get SendVirtualInput call count
         int GetSendVirtualInputCallCount();
 
-        // Function to get the foreground process name
+        // Function to set the foreground process name
         void SetForegroundProcess(std::wstring process);
 
-        // Function to get the foreground process name
-        void GetForegroundProcess(_Out_ std::wstring& foregroundProcess);
+        // Function to get the foreground process
+        const ForegroundProcess& GetForegroundProcess();
     };
 }
 
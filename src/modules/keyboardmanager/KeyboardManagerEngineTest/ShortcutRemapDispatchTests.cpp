@@ -0,0 +1,271 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/KeyboardManagerEngineLibrary/State.h>
+#include <keyboardmanager/KeyboardManagerEngineLibrary/KeyboardEventHandlers.h>
+#include "TestHelpers.h"
+#include <common/interop/shared_constants.h>
+#include <algorithm>
+#include <chrono>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Tests for the dispatch of key events to the compiled shortcut remaps
+    TEST_CLASS (ShortcutRemapDispatchTests)
+    {
+    private:
+        KeyboardManagerInput::MockedInput mockedInputHandler;
+        State testState;
+
+        // Function to generate distinct shortcuts: Ctrl, Alt and Shift are each absent, left, right or both, with at least one of them, and the action key is a letter, a digit or a function key
+        static Shortcut GeneratedShortcut(int index)
+        {
+            const DWORD ctrlKeys[] = { 0, VK_LCONTROL, VK_RCONTROL, VK_CONTROL };
+            const DWORD altKeys[] = { 0, VK_LMENU, VK_RMENU, VK_MENU };
+            const DWORD shiftKeys[] = { 0, VK_LSHIFT, VK_RSHIFT, VK_SHIFT };
+            std::vector<DWORD> actionKeys;
+            for (DWORD key = 0x41; key <= 0x5A; key++)
+            {
+                actionKeys.push_back(key);
+            }
+            for (DWORD key = 0x30; key <= 0x39; key++)
+            {
+                actionKeys.push_back(key);
+            }
+            for (DWORD key = VK_F1; key <= VK_F12; key++)
+            {
+                actionKeys.push_back(key);
+            }
+
+            const int modifiers = 1 + index % 63;
+            Shortcut shortcut;
+            if (ctrlKeys[modifiers % 4])
+            {
+                shortcut.SetKey(ctrlKeys[modifiers % 4]);
+            }
+            if (altKeys[modifiers / 4 % 4])
+            {
+                shortcut.SetKey(altKeys[modifiers / 4 % 4]);
+            }
+            if (shiftKeys[modifiers / 16])
+            {
+                shortcut.SetKey(shiftKeys[modifiers / 16]);
+            }
+            shortcut.SetKey(actionKeys[(index / 63) % actionKeys.size()]);
+            return shortcut;
+        }
+
+        // Function to send the key events of a list of keys, all pressed then released in reverse order
+        void SendKeys(const std::vector<WORD>& keys)
+        {
+            std::vector<INPUT> input(keys.size() * 2);
+            for (size_t i = 0; i < keys.size(); i++)
+            {
+                input[i].type = INPUT_KEYBOARD;
+                input[i].ki.wVk = keys[i];
+                input[input.size() - 1 - i].type = INPUT_KEYBOARD;
+                input[input.size() - 1 - i].ki.wVk = keys[i];
+                input[input.size() - 1 - i].ki.dwFlags = KEYEVENTF_KEYUP;
+            }
+            mockedInputHandler.SendVirtualInput((UINT)input.size(), input.data(), sizeof(INPUT));
+        }
+
+        // Function to measure the average time of the key events of typing with remaps of count shortcuts
+        double MeasureKeyEventTime(int count)
+        {
+            testState.ClearOSLevelShortcuts();
+            for (int i = 0; i < count; i++)
+            {
+                testState.AddOSLevelShortcut(GeneratedShortcut(i), (DWORD)0x56);
+            }
+            testState.CompileShortcutRemaps();
+
+            // Typing letters with and without modifiers which are not remapped
+            const int repeats = 200;
+            size_t events = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int repeat = 0; repeat < repeats; repeat++)
+            {
+                for (WORD key = 0x41; key <= 0x5A; key++)
+                {
+                    SendKeys({ key });
+                    SendKeys({ VK_LWIN, key });
+                    events += 6;
+                }
+            }
+            auto duration = std::chrono::steady_clock::now() - start;
+
+            return std::chrono::duration<double, std::nano>(duration).count() / events;
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+
+            // Set HandleOSLevelShortcutRemapEvent as the hook procedure
+            std::function<intptr_t(LowlevelKeyboardEvent*)> currentHookProc = std::bind(&KeyboardEventHandlers::HandleOSLevelShortcutRemapEvent, std::ref(mockedInputHandler), std::placeholders::_1, std::ref(testState));
+            mockedInputHandler.SetHookProc([currentHookProc](LowlevelKeyboardEvent* data) {
+                if (data->lParam->dwExtraInfo != KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG)
+                {
+                    return currentHookProc(data);
+                }
+                else
+                {
+                    return (intptr_t)1;
+                }
+            });
+        }
+
+        // Test if the shortcut with the most keys is invoked when several remapped shortcuts have the same action key
+        TEST_METHOD (ShortcutsWithSameActionKey_ShouldInvokeLargestPressedShortcut)
+        {
+            // Remap Ctrl+A to B and Ctrl+Shift+A to C
+            Shortcut src1;
+            src1.SetKey(VK_CONTROL);
+            src1.SetKey(0x41);
+            testState.AddOSLevelShortcut(src1, (DWORD)0x42);
+            Shortcut src2;
+            src2.SetKey(VK_CONTROL);
+            src2.SetKey(VK_SHIFT);
+            src2.SetKey(0x41);
+            testState.AddOSLevelShortcut(src2, (DWORD)0x43);
+
+            const int nInputs = 3;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = VK_SHIFT;
+            input[2].type = INPUT_KEYBOARD;
+            input[2].ki.wVk = 0x41;
+
+            // Send Ctrl+Shift+A keydown
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            // C key state should be true, B and A key states should be false
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x43));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x42));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x41));
+            Assert::AreEqual(true, testState.osLevelShortcutReMap[src2].isShortcutInvoked);
+            Assert::AreEqual(false, testState.osLevelShortcutReMap[src1].isShortcutInvoked);
+        }
+
+        // Test if the shortcut remaps require the modifiers on the side they are remapped with
+        TEST_METHOD (ShortcutWithLeftModifier_ShouldNotBeInvoked_WhenRightModifierIsPressed)
+        {
+            // Remap LCtrl+A to B
+            Shortcut src;
+            src.SetKey(VK_LCONTROL);
+            src.SetKey(0x41);
+            testState.AddOSLevelShortcut(src, (DWORD)0x42);
+
+            const int nInputs = 2;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_RCONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = 0x41;
+
+            // Send RCtrl+A keydown
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            // RCtrl and A key states should be true, B key state should be false
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_RCONTROL));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x41));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x42));
+        }
+
+        // Test if a remap added after key events were handled is applied
+        TEST_METHOD (ShortcutRemapAddedAfterKeyEvents_ShouldBeInvoked)
+        {
+            SendKeys({ VK_CONTROL, 0x41 });
+
+            // Remap Ctrl+A to B
+            Shortcut src;
+            src.SetKey(VK_CONTROL);
+            src.SetKey(0x41);
+            testState.AddOSLevelShortcut(src, (DWORD)0x42);
+
+            const int nInputs = 2;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = 0x41;
+
+            // Send Ctrl+A keydown
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            // B key state should be true
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x42));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x41));
+        }
+
+        // Test if the shortcut invoked among many remapped shortcuts is the first pressed one in the sorted order, as when the remaps were tried one by one
+        TEST_METHOD (ManyRemappedShortcuts_ShouldInvokeFirstPressedShortcutInSortedOrder)
+        {
+            const int count = 1000;
+            for (int i = 0; i < count; i++)
+            {
+                testState.AddOSLevelShortcut(GeneratedShortcut(i), (DWORD)0x56);
+            }
+            testState.CompileShortcutRemaps();
+
+            for (int i = 0; i < count; i += 37)
+            {
+                std::vector<INPUT> input;
+                for (auto key : GeneratedShortcut(i).GetKeyCodes())
+                {
+                    INPUT keyInput = {};
+                    keyInput.type = INPUT_KEYBOARD;
+                    keyInput.ki.wVk = (WORD)key;
+                    input.push_back(keyInput);
+                }
+
+                // Send the modifiers keydown
+                mockedInputHandler.SendVirtualInput((UINT)input.size() - 1, input.data(), sizeof(INPUT));
+
+                // Find the shortcut which is expected to be invoked by trying the remaps one by one
+                const DWORD actionKey = input.back().ki.wVk;
+                auto expected = std::find_if(testState.osLevelShortcutReMapSortedKeys.begin(), testState.osLevelShortcutReMapSortedKeys.end(), [&](const Shortcut& shortcut) {
+                    return shortcut.GetActionKey() == actionKey && shortcut.CheckModifiersKeyboardState(mockedInputHandler);
+                });
+                Assert::IsTrue(expected != testState.osLevelShortcutReMapSortedKeys.end());
+                const Shortcut expectedShortcut = *expected;
+
+                // Send the action key keydown
+                mockedInputHandler.SendVirtualInput(1, &input.back(), sizeof(INPUT));
+                Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x56));
+                Assert::AreEqual(true, testState.osLevelShortcutReMap[expectedShortcut].isShortcutInvoked);
+
+                // Release the keys in reverse order
+                for (auto& keyInput : input)
+                {
+                    keyInput.ki.dwFlags = KEYEVENTF_KEYUP;
+                }
+                std::reverse(input.begin(), input.end());
+                mockedInputHandler.SendVirtualInput((UINT)input.size(), input.data(), sizeof(INPUT));
+                Assert::AreEqual(false, testState.osLevelShortcutReMap[expectedShortcut].isShortcutInvoked);
+
+                mockedInputHandler.ResetKeyboardState();
+            }
+        }
+
+        // Benchmark of the time of a key event with a growing number of remapped shortcuts, only logged as timings depend on the machine
+        TEST_METHOD (KeyEventTime_WithRemapCount)
+        {
+            MeasureKeyEventTime(10);
+            const double time10 = MeasureKeyEventTime(10);
+            const double time100 = MeasureKeyEventTime(100);
+            const double time1000 = MeasureKeyEventTime(1000);
+
+            Logger::WriteMessage((L"Key event time with 10 remaps: " + std::to_wstring(time10) + L" ns\n").c_str());
+            Logger::WriteMessage((L"Key event time with 100 remaps: " + std::to_wstring(time100) + L" ns\n").c_str());
+            Logger::WriteMessage((L"Key event time with 1000 remaps: " + std::to_wstring(time1000) + L" ns\n").c_str());
+        }
+    };
+}
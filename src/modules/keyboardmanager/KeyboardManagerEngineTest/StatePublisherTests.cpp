@@ -0,0 +1,202 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/KeyboardManagerEngineLibrary/StatePublisher.h>
+#include <keyboardmanager/KeyboardManagerEngineLibrary/KeyboardEventHandlers.h>
+#include "TestHelpers.h"
+#include <atomic>
+#include <set>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Tests for the states published to the keyboard hook when the settings are reloaded
+    TEST_CLASS (StatePublisherTests)
+    {
+    private:
+        KeyboardManagerInput::MockedInput mockedInputHandler;
+        State testState;
+        std::unique_ptr<StatePublisher> statePublisher;
+
+        // State of the key event handled by the hook. The mocked input calls the hook again for the key events sent by the handlers, which keep using the state of the key event they handle
+        State* handledState = nullptr;
+        int hookDepth = 0;
+
+        // Function to create a shortcut of Ctrl and a key
+        static Shortcut CtrlShortcut(DWORD key)
+        {
+            Shortcut shortcut;
+            shortcut.SetKey(VK_CONTROL);
+            shortcut.SetKey(key);
+            return shortcut;
+        }
+
+        // Function to create a state as it is loaded from the settings, with Ctrl+key remaps to keys
+        static std::unique_ptr<State> LoadedState(const std::vector<std::pair<DWORD, DWORD>>& remaps)
+        {
+            auto state = std::make_unique<State>();
+            for (const auto& [key, targetKey] : remaps)
+            {
+                state->AddOSLevelShortcut(CtrlShortcut(key), targetKey);
+            }
+            state->CompileShortcutRemaps();
+            return state;
+        }
+
+        // Function to send the key down or key up events of a list of keys
+        void SendKeys(const std::vector<WORD>& keys, bool isKeyUp)
+        {
+            std::vector<INPUT> input(keys.size());
+            for (size_t i = 0; i < keys.size(); i++)
+            {
+                input[i].type = INPUT_KEYBOARD;
+                input[i].ki.wVk = keys[i];
+                input[i].ki.dwFlags = isKeyUp ? KEYEVENTF_KEYUP : 0;
+            }
+            mockedInputHandler.SendVirtualInput((UINT)input.size(), input.data(), sizeof(INPUT));
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+            statePublisher = std::make_unique<StatePublisher>();
+
+            // Set a hook procedure which gets the state from the publisher, as KeyboardManager::HandleKeyboardHookEvent
+            mockedInputHandler.SetHookProc([this](LowlevelKeyboardEvent* data) {
+                if (data->lParam->dwExtraInfo == KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG)
+                {
+                    return (intptr_t)1;
+                }
+
+                State* previousState = handledState;
+                if (hookDepth == 0)
+                {
+                    handledState = &statePublisher->Acquire();
+                }
+
+                hookDepth++;
+                intptr_t result = KeyboardEventHandlers::HandleOSLevelShortcutRemapEvent(mockedInputHandler, data, *handledState);
+                hookDepth--;
+
+                if (hookDepth == 0)
+                {
+                    handledState = previousState;
+                }
+
+                return result;
+            });
+        }
+
+        // Test if a shortcut pressed down while the settings are reloaded is released with the new state when its remap is unchanged
+        TEST_METHOD (PressedShortcut_ShouldBeCarriedOver_WhenRemapIsUnchanged)
+        {
+            // Remap Ctrl+A to B
+            statePublisher->Publish(LoadedState({ { 0x41, 0x42 } }));
+
+            // Send Ctrl+A keydown
+            SendKeys({ VK_CONTROL, 0x41 }, false);
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x42));
+
+            // Reload the settings with Ctrl+D remapped to E
+            auto newState = LoadedState({ { 0x41, 0x42 }, { 0x44, 0x45 } });
+            State* newStatePtr = newState.get();
+            statePublisher->Publish(std::move(newState));
+
+            // Send A keyup, B should be released by the new state
+            SendKeys({ 0x41 }, true);
+            Assert::IsTrue(newStatePtr == &statePublisher->Acquire());
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x42));
+            Assert::AreEqual(false, newStatePtr->osLevelShortcutReMap[CtrlShortcut(0x41)].isShortcutInvoked);
+
+            // Send D keydown while Ctrl is pressed down, E should be pressed down
+            SendKeys({ 0x44 }, false);
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x45));
+
+            SendKeys({ 0x44, VK_CONTROL }, true);
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x45));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(VK_CONTROL));
+        }
+
+        // Test if a new state is swapped in once a pressed shortcut is released when its remap was changed
+        TEST_METHOD (PressedShortcut_ShouldBeReleasedWithPreviousState_WhenRemapIsChanged)
+        {
+            // Remap Ctrl+A to B
+            statePublisher->Publish(LoadedState({ { 0x41, 0x42 } }));
+
+            // Send Ctrl+A keydown
+            SendKeys({ VK_CONTROL, 0x41 }, false);
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x42));
+
+            // Reload the settings with Ctrl+A remapped to C
+            auto newState = LoadedState({ { 0x41, 0x43 } });
+            State* newStatePtr = newState.get();
+            statePublisher->Publish(std::move(newState));
+
+            // Send A keyup and Ctrl keyup, B should be released by the previous state
+            SendKeys({ 0x41, VK_CONTROL }, true);
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x42));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(VK_CONTROL));
+
+            // Send Ctrl+A keydown, C should be pressed down with the new state
+            SendKeys({ VK_CONTROL, 0x41 }, false);
+            Assert::IsTrue(newStatePtr == &statePublisher->Acquire());
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x43));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x42));
+        }
+
+        // Test if the remaps keep working and no key stays pressed down while the settings are reloaded continuously
+        TEST_METHOD (KeyEvents_ShouldBeRemapped_WhileSettingsAreReloaded)
+        {
+            statePublisher->Publish(LoadedState({ { 0x41, 0x42 } }));
+
+            // Reload the settings on another thread, with Ctrl+A always remapped to B along with a varying number of other remaps
+            std::atomic_bool isReplaying = true;
+            std::atomic_int reloadCount = 0;
+            std::thread settingsThread([&] {
+                while (isReplaying)
+                {
+                    std::vector<std::pair<DWORD, DWORD>> remaps = { { 0x41, 0x42 } };
+                    for (int i = 0; i < reloadCount % 20; i++)
+                    {
+                        remaps.push_back({ (DWORD)VK_F1 + i, (DWORD)0x43 });
+                    }
+
+                    statePublisher->Publish(LoadedState(remaps));
+                    reloadCount++;
+                }
+            });
+
+            // Replay key streams of the remapped shortcut and of keys which are not remapped
+            std::set<State*> usedStates;
+            for (int i = 0; i < 5000; i++)
+            {
+                SendKeys({ VK_CONTROL, 0x41 }, false);
+                Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x42));
+                Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x41));
+
+                SendKeys({ 0x41 }, true);
+                SendKeys({ 0x44 }, false);
+                Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x44));
+                Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x42));
+
+                SendKeys({ 0x44, VK_CONTROL }, true);
+                for (WORD key : { VK_CONTROL, VK_LCONTROL, 0x41, 0x42, 0x44 })
+                {
+                    Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(key));
+                }
+
+                usedStates.insert(&statePublisher->Acquire());
+            }
+
+            isReplaying = false;
+            settingsThread.join();
+
+            // The states loaded meanwhile were used
+            Assert::IsTrue(usedStates.size() > 1);
+        }
+    };
+}
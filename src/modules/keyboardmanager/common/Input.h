@@ -2,12 +2,20 @@
 
 #include <keyboardmanager/common/InputInterface.h>
 #include <keyboardmanager/common/Helpers.h>
+#include <algorithm>
 
 namespace KeyboardManagerInput
 {
-    // Class used to wrap keyboard input library methods
+    // Class used to wrap keyboard input library methods. The key state is tracked from the key events seen by the keyboard hook, which must call UpdateKeyboardState, instead of calling GetAsyncKeyState for each key. Similarly the foreground process is read when the foreground window changes, or when a UWP app window appears in the foreground ApplicationFrameHost window, with UpdateForegroundProcess
     class Input : public InputInterface
     {
+    private:
+        // Stores the state of the keys after the key events which reached the system, including the injected ones
+        KeyboardState keyboardState;
+
+        // Stores the foreground process, read again when the foreground window changes
+        ForegroundProcess foregroundProcess;
+
     public:
         // Function to simulate input
         UINT SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
@@ -18,13 +26,51 @@ namespace KeyboardManagerInput
         // Function to get the state of a particular key
         bool GetVirtualKeyState(int key)
         {
-            return (GetAsyncKeyState(key) & 0x8000);
+            return keyboardState.IsKeyPressed(key);
+        }
+
+        // Function to get the state of all the keys
+        KeyboardState GetKeyboardState()
+        {
+            return keyboardState;
+        }
+
+        // Function to update the key state with a key event which was not suppressed by the keyboard hook
+        void UpdateKeyboardState(DWORD key, bool isKeyDown)
+        {
+            keyboardState.UpdateKeyState(key, isKeyDown);
+        }
+
+        // Function to read the key state from the system, when the keyboard hook may have missed key events, e.g. while another desktop was active
+        void SynchronizeKeyboardState()
+        {
+            keyboardState.Synchronize();
+        }
+
+        // Function to get the foreground process
+        const ForegroundProcess& GetForegroundProcess()
+        {
+            return foregroundProcess;
         }
 
-        // Function to get the foreground process name
-        void GetForegroundProcess(_Out_ std::wstring& foregroundProcess)
+        // Function to check if the foreground process is still resolved as the host of the UWP app windows, which have not appeared yet
+        bool IsForegroundProcessFrameHost() const
         {
-            foregroundProcess = Helpers::GetCurrentApplication(false);
+            return foregroundProcess.name == L"applicationframehost.exe";
+        }
+
+        // Function to read the foreground process from the system, when the foreground window may have changed
+        void UpdateForegroundProcess()
+        {
+            std::wstring processName = Helpers::GetCurrentApplication(false);
+
+            // Convert process name to lower case
+            std::transform(processName.begin(), processName.end(), processName.begin(), towlower);
+            if (processName != foregroundProcess.name)
+            {
+                foregroundProcess.name = std::move(processName);
+                foregroundProcess.version++;
+            }
         }
     };
 }
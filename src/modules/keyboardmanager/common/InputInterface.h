@@ -1,7 +1,19 @@
 #pragma once
+#include <string>
+#include <keyboardmanager/common/KeyboardState.h>
 
 namespace KeyboardManagerInput
 {
+    // Foreground process as it is used to find the app-specific remaps
+    struct ForegroundProcess
+    {
+        // Name of the process in lower case
+        std::wstring name;
+
+        // Incremented when the foreground process changes, so that what is found from its name can be cached
+        unsigned int version = 0;
+    };
+
     // Interface used to wrap keyboard input library methods
     class InputInterface
     {
@@ -12,7 +24,10 @@ namespace KeyboardManagerInput
         // Function to get the state of a particular key
         virtual bool GetVirtualKeyState(int key) = 0;
 
-        // Function to get the foreground process name
-        virtual void GetForegroundProcess(_Out_ std::wstring& foregroundProcess) = 0;
+        // Function to get the state of all the keys
+        virtual KeyboardState GetKeyboardState() = 0;
+
+        // Function to get the foreground process
+        virtual const ForegroundProcess& GetForegroundProcess() = 0;
     };
 }
\ No newline at end of file
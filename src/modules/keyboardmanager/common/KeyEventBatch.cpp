@@ -0,0 +1,48 @@
+#include "pch.h"
+#include "KeyEventBatch.h"
+#include "Helpers.h"
+#include "InputInterface.h"
+#include "KeyboardManagerConstants.h"
+
+// Function to add a key event
+void KeyEventBatch::AddKeyEvent(WORD keyCode, DWORD flags, ULONG_PTR extraInfo)
+{
+    if (size < Capacity)
+    {
+        Helpers::SetKeyEvent(keyEvents.data(), size, INPUT_KEYBOARD, keyCode, flags, extraInfo);
+        size++;
+    }
+}
+
+// Function to add the dummy key events used for remapping shortcuts, required to ensure releasing a modifier doesn't trigger another action (For example, Win->Start Menu or Alt->Menu bar)
+void KeyEventBatch::AddDummyKeyEvent(ULONG_PTR extraInfo)
+{
+    if (size + (int)KeyboardManagerConstants::DUMMY_KEY_EVENT_SIZE <= Capacity)
+    {
+        Helpers::SetDummyKeyEvent(keyEvents.data(), size, extraInfo);
+    }
+}
+
+// Function to add the key events for the modifier keys of a shortcut. The arguments are the same as for Helpers::SetModifierKeyEvents
+void KeyEventBatch::AddModifierKeyEvents(const Shortcut& shortcutToBeSent, const ModifierKey& winKeyInvoked, bool isKeyDown, ULONG_PTR extraInfoFlag, const Shortcut& shortcutToCompare, const DWORD& keyToBeReleased)
+{
+    if (size + ModifierKeyEventsSize <= Capacity)
+    {
+        Helpers::SetModifierKeyEvents(shortcutToBeSent, winKeyInvoked, keyEvents.data(), size, isKeyDown, extraInfoFlag, shortcutToCompare, keyToBeReleased);
+    }
+}
+
+// Function to return the number of key events
+int KeyEventBatch::Size() const
+{
+    return size;
+}
+
+// Function to send the key events with a single call. Nothing is sent if there are none
+void KeyEventBatch::Send(KeyboardManagerInput::InputInterface& ii)
+{
+    if (size > 0)
+    {
+        ii.SendVirtualInput((UINT)size, keyEvents.data(), sizeof(INPUT));
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <array>
+#include "Shortcut.h"
+
+namespace KeyboardManagerInput
+{
+    class InputInterface;
+}
+
+// Key events sent by a remap with a single call of SendInput, so that no other input can come in between them. The events are stored in a fixed-size buffer, so the keyboard hook does not allocate memory to send them
+class KeyEventBatch
+{
+public:
+    // Largest number of key events sent for a key event: releasing a shortcut, pressing another one and a dummy key event, along with the key ups for lower level key handlers, take less than half of it
+    static constexpr int Capacity = 32;
+
+    // Function to add a key event
+    void AddKeyEvent(WORD keyCode, DWORD flags, ULONG_PTR extraInfo);
+
+    // Function to add the dummy key events used for remapping shortcuts, required to ensure releasing a modifier doesn't trigger another action (For example, Win->Start Menu or Alt->Menu bar)
+    void AddDummyKeyEvent(ULONG_PTR extraInfo);
+
+    // Function to add the key events for the modifier keys of a shortcut. The arguments are the same as for Helpers::SetModifierKeyEvents
+    void AddModifierKeyEvents(const Shortcut& shortcutToBeSent, const ModifierKey& winKeyInvoked, bool isKeyDown, ULONG_PTR extraInfoFlag, const Shortcut& shortcutToCompare = Shortcut(), const DWORD& keyToBeReleased = NULL);
+
+    // Function to return the number of key events
+    int Size() const;
+
+    // Function to send the key events with a single call. Nothing is sent if there are none
+    void Send(KeyboardManagerInput::InputInterface& ii);
+
+private:
+    // Number of key events for the modifier keys of a shortcut at most
+    static constexpr int ModifierKeyEventsSize = 4;
+
+    std::array<INPUT, Capacity> keyEvents{};
+    int size = 0;
+};
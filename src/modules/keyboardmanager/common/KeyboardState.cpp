@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "KeyboardState.h"
+
+namespace
+{
+    struct ModifierKeyCodes
+    {
+        DWORD genericKey;
+        DWORD leftKey;
+        DWORD rightKey;
+    };
+
+    constexpr ModifierKeyCodes GenericModifierKeys[] = {
+        { VK_CONTROL, VK_LCONTROL, VK_RCONTROL },
+        { VK_MENU, VK_LMENU, VK_RMENU },
+        { VK_SHIFT, VK_LSHIFT, VK_RSHIFT }
+    };
+}
+
+// Function to set the state of a key
+void KeyboardState::SetKeyState(DWORD key, bool isPressed) noexcept
+{
+    if (key >= KeyCount)
+    {
+        return;
+    }
+
+    const uint64_t bit = uint64_t(1) << (key % 64);
+    if (isPressed)
+    {
+        words[key / 64] |= bit;
+    }
+    else
+    {
+        words[key / 64] &= ~bit;
+    }
+}
+
+// Function to update the state with a key event which reached the system. As with GetAsyncKeyState, a generic modifier key code is pressed down while its left or right key is
+void KeyboardState::UpdateKeyState(DWORD key, bool isKeyDown) noexcept
+{
+    for (const auto& modifier : GenericModifierKeys)
+    {
+        if (key != modifier.genericKey && key != modifier.leftKey && key != modifier.rightKey)
+        {
+            continue;
+        }
+
+        // A generic modifier key down presses the left key, and a generic modifier key up releases both keys
+        if (key == modifier.genericKey)
+        {
+            SetKeyState(modifier.leftKey, isKeyDown);
+            if (!isKeyDown)
+            {
+                SetKeyState(modifier.rightKey, false);
+            }
+        }
+        else
+        {
+            SetKeyState(key, isKeyDown);
+        }
+
+        SetKeyState(modifier.genericKey, IsKeyPressed(modifier.leftKey) || IsKeyPressed(modifier.rightKey));
+        return;
+    }
+
+    SetKeyState(key, isKeyDown);
+}
+
+// Function to check if all the keys of a set are pressed down
+bool KeyboardState::AreAllKeysPressed(const KeyboardState& keys) const noexcept
+{
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        if ((words[i] & keys.words[i]) != keys.words[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Function to check if any key of a set is pressed down
+bool KeyboardState::IsAnyKeyPressed(const KeyboardState& keys) const noexcept
+{
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        if (words[i] & keys.words[i])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Function to check if any key is pressed down apart from the keys of a set
+bool KeyboardState::IsAnyKeyPressedExcept(const KeyboardState& keys) const noexcept
+{
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        if (words[i] & ~keys.words[i])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Function to release all the keys
+void KeyboardState::Clear() noexcept
+{
+    words.fill(0);
+}
+
+// Function to read the state of all the keys from the system, for when key events may have been missed
+void KeyboardState::Synchronize()
+{
+    Clear();
+    for (DWORD key = 1; key < KeyCount; key++)
+    {
+        SetKeyState(key, GetAsyncKeyState(key) & 0x8000);
+    }
+}
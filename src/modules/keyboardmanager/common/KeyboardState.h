@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+
+// State of the 256 virtual key codes as a bitmap, one bit per key. It holds the keys pressed down on the keyboard as well as sets of keys, so that checking several keys takes a few word-wide bit operations instead of a call per key
+class KeyboardState
+{
+public:
+    static constexpr DWORD KeyCount = 256;
+
+    // Function to check if a key is pressed down
+    bool IsKeyPressed(DWORD key) const noexcept
+    {
+        return key < KeyCount && ((words[key / 64] >> (key % 64)) & 1);
+    }
+
+    // Function to set the state of a key
+    void SetKeyState(DWORD key, bool isPressed) noexcept;
+
+    // Function to update the state with a key event which reached the system. As with GetAsyncKeyState, a generic modifier key code is pressed down while its left or right key is
+    void UpdateKeyState(DWORD key, bool isKeyDown) noexcept;
+
+    // Function to check if all the keys of a set are pressed down
+    bool AreAllKeysPressed(const KeyboardState& keys) const noexcept;
+
+    // Function to check if any key of a set is pressed down
+    bool IsAnyKeyPressed(const KeyboardState& keys) const noexcept;
+
+    // Function to check if any key is pressed down apart from the keys of a set
+    bool IsAnyKeyPressedExcept(const KeyboardState& keys) const noexcept;
+
+    // Function to release all the keys
+    void Clear() noexcept;
+
+    // Function to read the state of all the keys from the system, for when key events may have been missed
+    void Synchronize();
+
+private:
+    std::array<uint64_t, KeyCount / 64> words{};
+};
@@ -15,6 +15,7 @@ void MappingConfiguration::ClearOSLevelShortcuts()
 {
     osLevelShortcutReMap.clear();
     osLevelShortcutReMapSortedKeys.clear();
+    shortcutRemapsVersion++;
 }
 
 
@@ -29,6 +30,7 @@ void MappingConfiguration::ClearAppSpecificShortcuts()
 {
     appSpecificShortcutReMap.clear();
     appSpecificShortcutReMapSortedKeys.clear();
+    shortcutRemapsVersion++;
 }
 
 // Function to add a new OS level shortcut remapping
@@ -44,6 +46,7 @@ bool MappingConfiguration::AddOSLevelShortcut(const Shortcut& originalSC, const
     osLevelShortcutReMap[originalSC] = RemapShortcut(newSC);
     osLevelShortcutReMapSortedKeys.push_back(originalSC);
     Helpers::SortShortcutVectorBasedOnSize(osLevelShortcutReMapSortedKeys);
+    shortcutRemapsVersion++;
 
     return true;
 }
@@ -89,6 +92,7 @@ bool MappingConfiguration::AddAppSpecificShortcut(const std::wstring& app, const
     appSpecificShortcutReMap[process_name][originalSC] = RemapShortcut(newSC);
     appSpecificShortcutReMapSortedKeys[process_name].push_back(originalSC);
     Helpers::SortShortcutVectorBasedOnSize(appSpecificShortcutReMapSortedKeys[process_name]);
+    shortcutRemapsVersion++;
     return true;
 }
 
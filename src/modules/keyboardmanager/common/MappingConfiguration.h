@@ -54,6 +54,9 @@ public:
     AppSpecificShortcutRemapTable appSpecificShortcutReMap;
     std::map<std::wstring, std::vector<Shortcut>> appSpecificShortcutReMapSortedKeys;
 
+    // Incremented when the shortcut remaps change, so that the tables built from them can be rebuilt
+    unsigned int shortcutRemapsVersion = 0;
+
     // Stores the current configuration name.
     std::wstring currentConfig = KeyboardManagerConstants::DefaultConfiguration;
 
@@ -492,100 +492,37 @@ void Shortcut::SetKeyCodes(const std::vector<int32_t>& keys)
     }
 }
 
+// Function to get the modifier keys of the shortcut which have to be pressed down, the win key accepting both sides is left out since VK_WIN does not exist
+KeyboardState Shortcut::GetRequiredModifierKeys() const
+{
+    KeyboardState keys;
+    keys.SetKeyState(VK_LWIN, winKey == ModifierKey::Left);
+    keys.SetKeyState(VK_RWIN, winKey == ModifierKey::Right);
+    keys.SetKeyState(VK_LCONTROL, ctrlKey == ModifierKey::Left);
+    keys.SetKeyState(VK_RCONTROL, ctrlKey == ModifierKey::Right);
+    keys.SetKeyState(VK_CONTROL, ctrlKey == ModifierKey::Both);
+    keys.SetKeyState(VK_LMENU, altKey == ModifierKey::Left);
+    keys.SetKeyState(VK_RMENU, altKey == ModifierKey::Right);
+    keys.SetKeyState(VK_MENU, altKey == ModifierKey::Both);
+    keys.SetKeyState(VK_LSHIFT, shiftKey == ModifierKey::Left);
+    keys.SetKeyState(VK_RSHIFT, shiftKey == ModifierKey::Right);
+    keys.SetKeyState(VK_SHIFT, shiftKey == ModifierKey::Both);
+    return keys;
+}
+
 // Function to check if all the modifiers in the shortcut have been pressed down
 bool Shortcut::CheckModifiersKeyboardState(KeyboardManagerInput::InputInterface& ii) const
 {
-    // Check the win key state
-    if (winKey == ModifierKey::Both)
-    {
-        // Since VK_WIN does not exist, we check both VK_LWIN and VK_RWIN
-        if ((!(ii.GetVirtualKeyState(VK_LWIN))) && (!(ii.GetVirtualKeyState(VK_RWIN))))
-        {
-            return false;
-        }
-    }
-    else if (winKey == ModifierKey::Left)
-    {
-        if (!(ii.GetVirtualKeyState(VK_LWIN)))
-        {
-            return false;
-        }
-    }
-    else if (winKey == ModifierKey::Right)
-    {
-        if (!(ii.GetVirtualKeyState(VK_RWIN)))
-        {
-            return false;
-        }
-    }
-
-    // Check the ctrl key state
-    if (ctrlKey == ModifierKey::Left)
-    {
-        if (!(ii.GetVirtualKeyState(VK_LCONTROL)))
-        {
-            return false;
-        }
-    }
-    else if (ctrlKey == ModifierKey::Right)
-    {
-        if (!(ii.GetVirtualKeyState(VK_RCONTROL)))
-        {
-            return false;
-        }
-    }
-    else if (ctrlKey == ModifierKey::Both)
-    {
-        if (!(ii.GetVirtualKeyState(VK_CONTROL)))
-        {
-            return false;
-        }
-    }
-
-    // Check the alt key state
-    if (altKey == ModifierKey::Left)
-    {
-        if (!(ii.GetVirtualKeyState(VK_LMENU)))
-        {
-            return false;
-        }
-    }
-    else if (altKey == ModifierKey::Right)
-    {
-        if (!(ii.GetVirtualKeyState(VK_RMENU)))
-        {
-            return false;
-        }
-    }
-    else if (altKey == ModifierKey::Both)
+    const KeyboardState keyboardState = ii.GetKeyboardState();
+    if (!keyboardState.AreAllKeysPressed(GetRequiredModifierKeys()))
     {
-        if (!(ii.GetVirtualKeyState(VK_MENU)))
-        {
-            return false;
-        }
+        return false;
     }
 
-    // Check the shift key state
-    if (shiftKey == ModifierKey::Left)
-    {
-        if (!(ii.GetVirtualKeyState(VK_LSHIFT)))
-        {
-            return false;
-        }
-    }
-    else if (shiftKey == ModifierKey::Right)
+    // Since VK_WIN does not exist, we check both VK_LWIN and VK_RWIN
+    if (winKey == ModifierKey::Both && !keyboardState.IsKeyPressed(VK_LWIN) && !keyboardState.IsKeyPressed(VK_RWIN))
     {
-        if (!(ii.GetVirtualKeyState(VK_RSHIFT)))
-        {
-            return false;
-        }
-    }
-    else if (shiftKey == ModifierKey::Both)
-    {
-        if (!(ii.GetVirtualKeyState(VK_SHIFT)))
-        {
-            return false;
-        }
+        return false;
     }
 
     return true;
@@ -643,154 +580,50 @@ bool IgnoreKeyCode(DWORD key)
     }
 }
 
-// Function to check if any keys are pressed down except those in the shortcut
-bool Shortcut::IsKeyboardStateClearExceptShortcut(KeyboardManagerInput::InputInterface& ii) const
+// Function to get the key codes to be ignored as a set of keys
+const KeyboardState& IgnoredKeyCodes()
 {
-    // Iterate through all the virtual key codes - 0xFF is set to key down because of the Num Lock
-    for (int keyVal = 1; keyVal < 0xFF; keyVal++)
-    {
-        // Ignore problematic key codes
-        if (IgnoreKeyCode(keyVal))
+    static const KeyboardState ignoredKeys = [] {
+        KeyboardState keys;
+        for (DWORD keyVal = 0; keyVal < KeyboardState::KeyCount; keyVal++)
         {
-            continue;
-        }
-        // Check state of the key. If the key is pressed down but it is not part of the shortcut then the keyboard state is not clear
-        if (ii.GetVirtualKeyState(keyVal))
-        {
-            // If one of the win keys is pressed check if it is part of the shortcut
-            if (keyVal == VK_LWIN)
-            {
-                if (winKey != ModifierKey::Left && winKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RWIN)
-            {
-                if (winKey != ModifierKey::Right && winKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If one of the ctrl keys is pressed check if it is part of the shortcut
-            else if (keyVal == VK_LCONTROL)
-            {
-                if (ctrlKey != ModifierKey::Left && ctrlKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RCONTROL)
-            {
-                if (ctrlKey != ModifierKey::Right && ctrlKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_CONTROL)
-            {
-                if (ctrlKey == ModifierKey::Disabled)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If one of the alt keys is pressed check if it is part of the shortcut
-            else if (keyVal == VK_LMENU)
-            {
-                if (altKey != ModifierKey::Left && altKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RMENU)
-            {
-                if (altKey != ModifierKey::Right && altKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_MENU)
-            {
-                if (altKey == ModifierKey::Disabled)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If one of the shift keys is pressed check if it is part of the shortcut
-            else if (keyVal == VK_LSHIFT)
-            {
-                if (shiftKey != ModifierKey::Left && shiftKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RSHIFT)
-            {
-                if (shiftKey != ModifierKey::Right && shiftKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_SHIFT)
-            {
-                if (shiftKey == ModifierKey::Disabled)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If any other key is pressed check if it is the action key
-            else if (keyVal != actionKey)
-            {
-                return false;
-            }
+            // 0xFF is set to key down because of the Num Lock
+            keys.SetKeyState(keyVal, keyVal == 0 || keyVal == 0xFF || IgnoreKeyCode(keyVal));
         }
+
+        return keys;
+    }();
+
+    return ignoredKeys;
+}
+
+// Function to get the keys which can be pressed down along with the shortcut: the keys of the shortcut, the generic modifier key codes of its modifiers and the ignored key codes
+KeyboardState Shortcut::GetAllowedKeys() const
+{
+    KeyboardState keys = IgnoredKeyCodes();
+    keys.SetKeyState(VK_LWIN, winKey == ModifierKey::Left || winKey == ModifierKey::Both);
+    keys.SetKeyState(VK_RWIN, winKey == ModifierKey::Right || winKey == ModifierKey::Both);
+    keys.SetKeyState(VK_LCONTROL, ctrlKey == ModifierKey::Left || ctrlKey == ModifierKey::Both);
+    keys.SetKeyState(VK_RCONTROL, ctrlKey == ModifierKey::Right || ctrlKey == ModifierKey::Both);
+    keys.SetKeyState(VK_CONTROL, ctrlKey != ModifierKey::Disabled);
+    keys.SetKeyState(VK_LMENU, altKey == ModifierKey::Left || altKey == ModifierKey::Both);
+    keys.SetKeyState(VK_RMENU, altKey == ModifierKey::Right || altKey == ModifierKey::Both);
+    keys.SetKeyState(VK_MENU, altKey != ModifierKey::Disabled);
+    keys.SetKeyState(VK_LSHIFT, shiftKey == ModifierKey::Left || shiftKey == ModifierKey::Both);
+    keys.SetKeyState(VK_RSHIFT, shiftKey == ModifierKey::Right || shiftKey == ModifierKey::Both);
+    keys.SetKeyState(VK_SHIFT, shiftKey != ModifierKey::Disabled);
+    if (actionKey != NULL)
+    {
+        keys.SetKeyState(actionKey, true);
     }
 
-    return true;
+    return keys;
+}
+
+// Function to check if any keys are pressed down except those in the shortcut
+bool Shortcut::IsKeyboardStateClearExceptShortcut(KeyboardManagerInput::InputInterface& ii) const
+{
+    return !ii.GetKeyboardState().IsAnyKeyPressedExcept(GetAllowedKeys());
 }
 
 // Function to get the number of modifiers that are common between the current shortcut and the shortcut in the argument
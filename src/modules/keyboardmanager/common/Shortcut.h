@@ -1,5 +1,6 @@
 #pragma once
 #include "ModifierKey.h"
+#include "KeyboardState.h"
 #include <variant>
 
 namespace KeyboardManagerInput
@@ -152,6 +153,12 @@ public:
     // Function to set a shortcut from a vector of key codes
     void SetKeyCodes(const std::vector<int32_t>& keys);
 
+    // Function to get the modifier keys of the shortcut which have to be pressed down, the win key accepting both sides is left out since VK_WIN does not exist
+    KeyboardState GetRequiredModifierKeys() const;
+
+    // Function to get the keys which can be pressed down along with the shortcut: the keys of the shortcut, the generic modifier key codes of its modifiers and the ignored key codes
+    KeyboardState GetAllowedKeys() const;
+
     // Function to check if all the modifiers in the shortcut have been pressed down
     bool CheckModifiersKeyboardState(KeyboardManagerInput::InputInterface& ii) const;
 
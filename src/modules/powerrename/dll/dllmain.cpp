@@ -238,6 +238,11 @@ public:
             GET_RESOURCE_STRING(IDS_USE_BOOST_LIB),
             CSettingsInstance().GetUseBoostLib());
 
+        settings.add_bool_toggle(
+            L"bool_use_linear_regex",
+            GET_RESOURCE_STRING(IDS_USE_LINEAR_REGEX),
+            CSettingsInstance().GetUseLinearRegEx());
+
         return settings.serialize_to_buffer(buffer, buffer_size);
     }
 
@@ -257,6 +262,7 @@ public:
             CSettingsInstance().SetShowIconOnMenu(values.get_bool_value(L"bool_show_icon_on_menu").value());
             CSettingsInstance().SetExtendedContextMenuOnly(values.get_bool_value(L"bool_show_extended_menu").value());
             CSettingsInstance().SetUseBoostLib(values.get_bool_value(L"bool_use_boost_lib").value());
+            CSettingsInstance().SetUseLinearRegEx(values.get_bool_value(L"bool_use_linear_regex").value());
             CSettingsInstance().Save();
 
             Trace::SettingsChanged();
@@ -0,0 +1,497 @@
+#include "pch.h"
+#include "DatedFileNameTemplate.h"
+#include "Helpers.h"
+#include "srwlock.h"
+#include <map>
+#include <memory>
+
+namespace
+{
+    enum Token : BYTE
+    {
+        TokenNone = 0,
+        TokenYear4,
+        TokenYear2,
+        TokenYear1,
+        TokenMonthName,
+        TokenMonthAbbreviation,
+        TokenMonth2,
+        TokenMonth1,
+        TokenDayName,
+        TokenDayAbbreviation,
+        TokenDay2,
+        TokenDay1,
+        TokenHour2,
+        TokenHour1,
+        TokenMinute2,
+        TokenMinute1,
+        TokenSecond2,
+        TokenSecond1,
+        TokenMillisecond3,
+        TokenMillisecond2,
+        TokenMillisecond1,
+        TokenCount
+    };
+
+    // In the order GetDatedFileName used to replace them.  The order matters: a token is
+    // only recognized once the longer tokens starting with the same letters were replaced.
+    const PCWSTR c_tokenTexts[TokenCount] = {
+        nullptr,
+        L"YYYY",
+        L"YY",
+        L"Y",
+        L"MMMM",
+        L"MMM",
+        L"MM",
+        L"M",
+        L"DDDD",
+        L"DDD",
+        L"DD",
+        L"D",
+        L"hh",
+        L"h",
+        L"mm",
+        L"m",
+        L"ss",
+        L"s",
+        L"fff",
+        L"ff",
+        L"f",
+    };
+
+    bool IsNameToken(BYTE token)
+    {
+        return token == TokenMonthName || token == TokenMonthAbbreviation || token == TokenDayName || token == TokenDayAbbreviation;
+    }
+
+    // A character of the replace term or a token that was found in it
+    struct Cell
+    {
+        wchar_t ch;
+        BYTE token;
+        bool followsTokenLetter;
+    };
+
+    bool IsDollar(const Cell& cell)
+    {
+        return cell.token == TokenNone && cell.ch == L'$';
+    }
+
+    bool IsTokenLetter(wchar_t ch)
+    {
+        return ch != L'\0' && wcschr(L"YMDhmsf", ch) != nullptr;
+    }
+
+    // Replaces every occurrence of the token the way
+    //     regex_replace(source, wregex(L"(([^\\$]|^)(\\$\\$)*)\\$" + tokenText), L"$01" + value)
+    // does: the token must follow an odd number of $, itself following the start of the text
+    // or a character that was not consumed by the previous occurrence.  The occurrence is
+    // replaced by a token cell when value is null, by the characters of value otherwise.
+    // Note that the replaced text can complete a token: "$M$MMM" becomes "$MMar" in March,
+    // then "03ar".
+    void ApplyToken(_In_ const std::vector<Cell>& source, _Out_ std::vector<Cell>& result, BYTE token, _In_opt_ const std::wstring* value)
+    {
+        const PCWSTR tokenText = c_tokenTexts[token];
+        const size_t tokenLength = wcslen(tokenText);
+        const size_t length = source.size();
+
+        result.clear();
+        result.reserve(length);
+
+        size_t copied = 0;
+        size_t start = 0;
+        while (start < length)
+        {
+            // ([^\$]|^)
+            size_t dollars = start + 1;
+            if (IsDollar(source[start]))
+            {
+                if (start != 0)
+                {
+                    start++;
+                    continue;
+                }
+                dollars = 0;
+            }
+
+            // (\$\$)*\$ followed by the token
+            size_t dollarCount = 0;
+            while (dollars + dollarCount < length && IsDollar(source[dollars + dollarCount]))
+            {
+                dollarCount++;
+            }
+
+            const size_t tokenStart = dollars + dollarCount;
+            bool matched = (dollarCount % 2 == 1) && (tokenStart + tokenLength <= length);
+            for (size_t i = 0; matched && i < tokenLength; i++)
+            {
+                matched = source[tokenStart + i].token == TokenNone && source[tokenStart + i].ch == tokenText[i];
+            }
+
+            if (!matched)
+            {
+                start++;
+                continue;
+            }
+
+            // Keep everything up to the last $, then the value
+            result.insert(result.end(), source.begin() + copied, source.begin() + (tokenStart - 1));
+            if (value)
+            {
+                for (wchar_t ch : *value)
+                {
+                    result.push_back({ ch, TokenNone, false });
+                }
+            }
+            else
+            {
+                bool followsTokenLetter = !result.empty() && result.back().token == TokenNone && IsTokenLetter(result.back().ch);
+                result.push_back({ 0, token, followsTokenLetter });
+            }
+
+            copied = start = tokenStart + tokenLength;
+        }
+
+        result.insert(result.end(), source.begin() + copied, source.end());
+    }
+
+    // Runs the replacement of every token in order.  values holds the text of every token,
+    // when it is null the tokens are left as token cells.
+    std::vector<Cell> ApplyTokens(_In_ PCWSTR source, _In_opt_ const std::wstring* values)
+    {
+        std::vector<Cell> cells;
+        for (PCWSTR ch = source; *ch; ch++)
+        {
+            cells.push_back({ *ch, TokenNone, false });
+        }
+
+        std::vector<Cell> result;
+        for (BYTE token = TokenYear4; token < TokenCount; token++)
+        {
+            ApplyToken(cells, result, token, values ? &values[token] : nullptr);
+            cells.swap(result);
+        }
+
+        return cells;
+    }
+
+    struct LocaleDateNames
+    {
+        // False when the calendar of the locale does not follow the gregorian months,
+        // the names are then formatted for every file time instead.
+        bool isCached = false;
+        std::wstring monthNames[12];
+        std::wstring monthAbbreviations[12];
+        std::wstring dayNames[7];
+        std::wstring dayAbbreviations[7];
+    };
+
+    void FormatDateName(_In_ PCWSTR localeName, _In_ const SYSTEMTIME& time, _In_ PCWSTR picture, _Inout_updates_(MAX_PATH) PWSTR formatted)
+    {
+        // On failure the buffer keeps what the previous call wrote, as it always did
+        GetDateFormatEx(localeName, NULL, &time, picture, formatted, MAX_PATH, NULL);
+        formatted[0] = towupper(formatted[0]);
+    }
+
+    bool IsGregorianCalendar(_In_ PCWSTR localeName)
+    {
+        CALID calendar = 0;
+        if (GetLocaleInfoEx(localeName, LOCALE_ICALENDARTYPE | LOCALE_RETURN_NUMBER, reinterpret_cast<LPWSTR>(&calendar), sizeof(calendar) / sizeof(wchar_t)) == 0)
+        {
+            return false;
+        }
+
+        switch (calendar)
+        {
+        case CAL_GREGORIAN:
+        case CAL_GREGORIAN_US:
+        case CAL_GREGORIAN_ME_FRENCH:
+        case CAL_GREGORIAN_ARABIC:
+        case CAL_GREGORIAN_XLIT_ENGLISH:
+        case CAL_GREGORIAN_XLIT_FRENCH:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    std::wstring GetCachedDateName(_In_ PCWSTR localeName, _In_ const SYSTEMTIME& time, _In_ PCWSTR picture)
+    {
+        wchar_t formatted[MAX_PATH] = { 0 };
+        FormatDateName(localeName, time, picture, formatted);
+        return formatted;
+    }
+
+    const LocaleDateNames& GetLocaleDateNames(_In_ PCWSTR localeName)
+    {
+        static CSRWLock lock;
+        static std::map<std::wstring, std::unique_ptr<LocaleDateNames>> cache;
+
+        // Scope lock
+        {
+            CSRWSharedAutoLock sharedLock(&lock);
+            auto it = cache.find(localeName);
+            if (it != cache.end())
+            {
+                return *it->second;
+            }
+        }
+
+        auto names = std::make_unique<LocaleDateNames>();
+        names->isCached = IsGregorianCalendar(localeName);
+        if (names->isCached)
+        {
+            for (WORD month = 1; month <= 12; month++)
+            {
+                SYSTEMTIME time = { 2001, month, 0, 1 };
+                names->monthNames[month - 1] = GetCachedDateName(localeName, time, L"MMMM");
+                names->monthAbbreviations[month - 1] = GetCachedDateName(localeName, time, L"MMM");
+            }
+
+            // January 1st 2006 is a Sunday
+            for (WORD dayOfWeek = 0; dayOfWeek < 7; dayOfWeek++)
+            {
+                SYSTEMTIME time = { 2006, 1, dayOfWeek, static_cast<WORD>(1 + dayOfWeek) };
+                names->dayNames[dayOfWeek] = GetCachedDateName(localeName, time, L"dddd");
+                names->dayAbbreviations[dayOfWeek] = GetCachedDateName(localeName, time, L"ddd");
+            }
+        }
+
+        CSRWExclusiveAutoLock exclusiveLock(&lock);
+        auto it = cache.emplace(localeName, std::move(names)).first;
+        return *it->second;
+    }
+
+    // Dates that GetDateFormatEx formats with the gregorian calendar.  The names of other
+    // dates are not taken from the cache.
+    bool IsSupportedDate(_In_ const SYSTEMTIME& time)
+    {
+        static const WORD daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        if (time.wYear < 1601 || time.wYear > 9999 || time.wMonth < 1 || time.wMonth > 12 || time.wDay < 1)
+        {
+            return false;
+        }
+
+        bool isLeapYear = (time.wYear % 4 == 0 && time.wYear % 100 != 0) || time.wYear % 400 == 0;
+        return time.wDay <= daysInMonth[time.wMonth - 1] + ((time.wMonth == 2 && isLeapYear) ? 1 : 0);
+    }
+
+    // 0 for Sunday, like SYSTEMTIME::wDayOfWeek.  GetDateFormatEx ignores the one of the file time.
+    WORD GetDayOfWeek(_In_ const SYSTEMTIME& time)
+    {
+        static const int monthOffsets[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+        int year = time.wYear - (time.wMonth < 3 ? 1 : 0);
+        return static_cast<WORD>((year + year / 4 - year / 100 + year / 400 + monthOffsets[time.wMonth - 1] + time.wDay) % 7);
+    }
+
+    // Sets the month and day names of the file time in values
+    void GetDateNames(_In_ const SYSTEMTIME& time, _Inout_updates_(TokenCount) std::wstring* values)
+    {
+        wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
+        if (GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH) == 0)
+        {
+            StringCchCopy(localeName, LOCALE_NAME_MAX_LENGTH, L"en_US");
+        }
+
+        const LocaleDateNames& names = GetLocaleDateNames(localeName);
+        if (names.isCached && IsSupportedDate(time))
+        {
+            WORD dayOfWeek = GetDayOfWeek(time);
+            values[TokenMonthName] = names.monthNames[time.wMonth - 1];
+            values[TokenMonthAbbreviation] = names.monthAbbreviations[time.wMonth - 1];
+            values[TokenDayName] = names.dayNames[dayOfWeek];
+            values[TokenDayAbbreviation] = names.dayAbbreviations[dayOfWeek];
+        }
+        else
+        {
+            // Same calls in the same order as GetDatedFileName always made, sharing one buffer
+            wchar_t formatted[MAX_PATH] = { 0 };
+            FormatDateName(localeName, time, L"MMMM", formatted);
+            values[TokenMonthName] = formatted;
+            FormatDateName(localeName, time, L"MMM", formatted);
+            values[TokenMonthAbbreviation] = formatted;
+            FormatDateName(localeName, time, L"dddd", formatted);
+            values[TokenDayName] = formatted;
+            FormatDateName(localeName, time, L"ddd", formatted);
+            values[TokenDayAbbreviation] = formatted;
+        }
+    }
+
+    void AppendNumber(_Inout_ std::wstring& result, UINT value, UINT width)
+    {
+        wchar_t digits[10];
+        UINT count = 0;
+        do
+        {
+            digits[count++] = static_cast<wchar_t>(L'0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+
+        for (; width > count; width--)
+        {
+            result.push_back(L'0');
+        }
+
+        while (count > 0)
+        {
+            result.push_back(digits[--count]);
+        }
+    }
+
+    // Appends the text of a numeric token, formatted like StringCchPrintf did
+    void AppendNumberToken(_Inout_ std::wstring& result, BYTE token, _In_ const SYSTEMTIME& time)
+    {
+        switch (token)
+        {
+        case TokenYear4:
+            AppendNumber(result, time.wYear, 4);
+            break;
+        case TokenYear2:
+            AppendNumber(result, time.wYear % 100, 2);
+            break;
+        case TokenYear1:
+            AppendNumber(result, time.wYear % 10, 1);
+            break;
+        case TokenMonth2:
+            AppendNumber(result, time.wMonth, 2);
+            break;
+        case TokenMonth1:
+            AppendNumber(result, time.wMonth, 1);
+            break;
+        case TokenDay2:
+            AppendNumber(result, time.wDay, 2);
+            break;
+        case TokenDay1:
+            AppendNumber(result, time.wDay, 1);
+            break;
+        case TokenHour2:
+            AppendNumber(result, time.wHour, 2);
+            break;
+        case TokenHour1:
+            AppendNumber(result, time.wHour, 1);
+            break;
+        case TokenMinute2:
+            AppendNumber(result, time.wMinute, 2);
+            break;
+        case TokenMinute1:
+            AppendNumber(result, time.wMinute, 1);
+            break;
+        case TokenSecond2:
+            AppendNumber(result, time.wSecond, 2);
+            break;
+        case TokenSecond1:
+            AppendNumber(result, time.wSecond, 1);
+            break;
+        case TokenMillisecond3:
+            AppendNumber(result, time.wMilliseconds, 3);
+            break;
+        case TokenMillisecond2:
+            AppendNumber(result, time.wMilliseconds / 10, 2);
+            break;
+        case TokenMillisecond1:
+            AppendNumber(result, time.wMilliseconds / 100, 1);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+CDatedFileNameTemplate::CDatedFileNameTemplate(_In_opt_ PCWSTR source)
+{
+    if (source == nullptr || source[0] == L'\0')
+    {
+        return;
+    }
+
+    m_isValid = true;
+    m_source = source;
+
+    for (const Cell& cell : ApplyTokens(source, nullptr))
+    {
+        if (cell.token != TokenNone)
+        {
+            m_segments.push_back({ cell.token, cell.followsTokenLetter, 0, 0 });
+            m_usesNames = m_usesNames || IsNameToken(cell.token);
+        }
+        else
+        {
+            if (m_segments.empty() || m_segments.back().token != TokenNone)
+            {
+                m_segments.push_back({ TokenNone, false, static_cast<UINT>(m_literals.size()), 0 });
+            }
+            m_literals.push_back(cell.ch);
+            m_segments.back().length++;
+        }
+    }
+}
+
+bool CDatedFileNameTemplate::HasTokens() const
+{
+    for (const Segment& segment : m_segments)
+    {
+        if (segment.token != TokenNone)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+HRESULT CDatedFileNameTemplate::Format(_In_ const SYSTEMTIME& fileTime, _Out_ std::wstring& result) const
+{
+    result.clear();
+    EnsureUserLocale();
+    if (!m_isValid)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::wstring values[TokenCount];
+    if (m_usesNames)
+    {
+        GetDateNames(fileTime, values);
+
+        // The tokens found up front stay valid as long as the expanded text can't be read as
+        // part of another token: it must not be empty, and must not start with a token letter
+        // when it follows one.  Otherwise redo the replacements one by one with the actual text.
+        bool reapplyTokens = values[TokenMonthName].empty() || values[TokenMonthAbbreviation].empty() ||
+                             values[TokenDayName].empty() || values[TokenDayAbbreviation].empty();
+        for (size_t i = 0; !reapplyTokens && i < m_segments.size(); i++)
+        {
+            reapplyTokens = m_segments[i].followsTokenLetter && IsNameToken(m_segments[i].token) && IsTokenLetter(values[m_segments[i].token][0]);
+        }
+
+        if (reapplyTokens)
+        {
+            for (BYTE token = TokenYear4; token < TokenCount; token++)
+            {
+                AppendNumberToken(values[token], token, fileTime);
+            }
+
+            for (const Cell& cell : ApplyTokens(m_source.c_str(), values))
+            {
+                result.push_back(cell.ch);
+            }
+            return S_OK;
+        }
+    }
+
+    for (const Segment& segment : m_segments)
+    {
+        if (segment.token == TokenNone)
+        {
+            result.append(m_literals, segment.offset, segment.length);
+        }
+        else if (IsNameToken(segment.token))
+        {
+            result.append(values[segment.token]);
+        }
+        else
+        {
+            AppendNumberToken(result, segment.token, fileTime);
+        }
+    }
+
+    return S_OK;
+}
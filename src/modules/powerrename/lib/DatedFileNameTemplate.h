@@ -0,0 +1,39 @@
+#pragma once
+#include "pch.h"
+#include <string>
+#include <vector>
+
+// Replace term whose file time tokens ($YYYY, $MMMM, $DD, $hh, $fff...) are located once
+// so that it can be expanded for any number of file times in a single pass.
+// A token is escaped by doubling the $ in front of it ($$YYYY is left alone) and
+// longer tokens win over shorter ones ($MMM is the month abbreviation, not $MM followed by M).
+// The expansion is identical to the regex replacements GetDatedFileName used to run.
+class CDatedFileNameTemplate
+{
+public:
+    CDatedFileNameTemplate() = default;
+    explicit CDatedFileNameTemplate(_In_opt_ PCWSTR source);
+
+    // False for a null or empty replace term, which Format rejects with E_INVALIDARG
+    bool IsValid() const { return m_isValid; }
+    bool HasTokens() const;
+
+    HRESULT Format(_In_ const SYSTEMTIME& fileTime, _Out_ std::wstring& result) const;
+
+private:
+    // Either a slice of m_literals (token 0) or a file time token
+    struct Segment
+    {
+        BYTE token;
+        // The token directly follows a letter that may start a token with the expanded text
+        bool followsTokenLetter;
+        UINT offset;
+        UINT length;
+    };
+
+    bool m_isValid = false;
+    bool m_usesNames = false;
+    std::wstring m_source;
+    std::wstring m_literals;
+    std::vector<Segment> m_segments;
+};
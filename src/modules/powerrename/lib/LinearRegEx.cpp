@@ -0,0 +1,990 @@
+#include "pch.h"
+#include "LinearRegEx.h"
+#include <cwctype>
+
+namespace
+{
+    const UINT Unbounded = UINT_MAX;
+    // Larger repetition counts are left to the other engines
+    const UINT MaxRepeatCount = 1000;
+
+    struct Node
+    {
+        enum Type
+        {
+            Empty,
+            Char,
+            Any,
+            Class,
+            Assert,
+            Group,
+            Concat,
+            Alternate,
+            Repeat
+        };
+
+        Type type = Empty;
+        wchar_t c = 0;
+        // Class index, assertion or group number
+        UINT index = 0;
+        UINT min = 0;
+        UINT max = 0;
+        bool greedy = true;
+        std::vector<std::unique_ptr<Node>> children;
+    };
+
+    bool IsWordChar(wchar_t c)
+    {
+        return c == L'_' || iswalnum(c);
+    }
+
+    // True when the node can match the empty string
+    bool IsNullable(const Node& node)
+    {
+        switch (node.type)
+        {
+        case Node::Empty:
+        case Node::Assert:
+            return true;
+        case Node::Group:
+            return IsNullable(*node.children[0]);
+        case Node::Concat:
+            for (const auto& child : node.children)
+            {
+                if (!IsNullable(*child))
+                {
+                    return false;
+                }
+            }
+            return true;
+        case Node::Alternate:
+            for (const auto& child : node.children)
+            {
+                if (IsNullable(*child))
+                {
+                    return true;
+                }
+            }
+            return false;
+        case Node::Repeat:
+            return node.min == 0 || IsNullable(*node.children[0]);
+        default:
+            return false;
+        }
+    }
+
+    bool HasGroup(const Node& node)
+    {
+        if (node.type == Node::Group)
+        {
+            return true;
+        }
+        for (const auto& child : node.children)
+        {
+            if (HasGroup(*child))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int HexValue(wchar_t c)
+    {
+        if (c >= L'0' && c <= L'9')
+        {
+            return c - L'0';
+        }
+        if (c >= L'a' && c <= L'f')
+        {
+            return c - L'a' + 10;
+        }
+        if (c >= L'A' && c <= L'F')
+        {
+            return c - L'A' + 10;
+        }
+        return -1;
+    }
+
+    // Recursive descent parser for the supported ECMAScript syntax
+    class Parser
+    {
+    public:
+        Parser(const std::wstring& pattern, bool caseInsensitive, std::vector<CLinearRegEx::CharClass>& classes) :
+            m_pattern(pattern), m_caseInsensitive(caseInsensitive), m_classes(classes)
+        {
+        }
+
+        HRESULT Parse(_Out_ std::unique_ptr<Node>& root)
+        {
+            root = _ParseAlternation();
+            if (SUCCEEDED(m_hr) && m_pos != m_pattern.length())
+            {
+                // Unbalanced )
+                m_hr = E_INVALIDARG;
+            }
+            return m_hr;
+        }
+
+        UINT GetGroupCount() const { return m_groupCount; }
+
+    private:
+        bool _AtEnd() const { return m_pos >= m_pattern.length(); }
+        wchar_t _Peek() const { return m_pattern[m_pos]; }
+
+        std::unique_ptr<Node> _Fail(HRESULT hr)
+        {
+            if (SUCCEEDED(m_hr))
+            {
+                m_hr = hr;
+            }
+            return nullptr;
+        }
+
+        std::unique_ptr<Node> _ParseAlternation()
+        {
+            auto first = _ParseConcat();
+            if (FAILED(m_hr) || _AtEnd() || _Peek() != L'|')
+            {
+                return first;
+            }
+
+            auto alternate = std::make_unique<Node>();
+            alternate->type = Node::Alternate;
+            alternate->children.push_back(std::move(first));
+            while (SUCCEEDED(m_hr) && !_AtEnd() && _Peek() == L'|')
+            {
+                m_pos++;
+                alternate->children.push_back(_ParseConcat());
+            }
+            return alternate;
+        }
+
+        std::unique_ptr<Node> _ParseConcat()
+        {
+            auto concat = std::make_unique<Node>();
+            concat->type = Node::Concat;
+            while (SUCCEEDED(m_hr) && !_AtEnd() && _Peek() != L'|' && _Peek() != L')')
+            {
+                concat->children.push_back(_ParseRepeat());
+            }
+            return concat;
+        }
+
+        std::unique_ptr<Node> _ParseRepeat()
+        {
+            auto atom = _ParseAtom();
+            if (FAILED(m_hr) || _AtEnd())
+            {
+                return atom;
+            }
+
+            UINT min = 0;
+            UINT max = 0;
+            switch (_Peek())
+            {
+            case L'*':
+                min = 0;
+                max = Unbounded;
+                m_pos++;
+                break;
+            case L'+':
+                min = 1;
+                max = Unbounded;
+                m_pos++;
+                break;
+            case L'?':
+                min = 0;
+                max = 1;
+                m_pos++;
+                break;
+            case L'{':
+                if (!_ParseCount(min, max))
+                {
+                    return nullptr;
+                }
+                break;
+            default:
+                return atom;
+            }
+
+            if (atom->type == Node::Assert)
+            {
+                return _Fail(E_NOTIMPL);
+            }
+
+            // The captures the other engines leave behind when an optional iteration matches the
+            // empty string are not the ones the simulation gets, ex: (a*)* or (a|)*b.  Only the
+            // captures differ, the other engines get those patterns.
+            if (max > min && HasGroup(*atom) && IsNullable(*atom))
+            {
+                return _Fail(E_NOTIMPL);
+            }
+
+            auto repeat = std::make_unique<Node>();
+            repeat->type = Node::Repeat;
+            repeat->min = min;
+            repeat->max = max;
+            if (!_AtEnd() && _Peek() == L'?')
+            {
+                repeat->greedy = false;
+                m_pos++;
+            }
+            repeat->children.push_back(std::move(atom));
+            return repeat;
+        }
+
+        // {n}, {n,} or {n,m}
+        bool _ParseCount(_Out_ UINT& min, _Out_ UINT& max)
+        {
+            min = 0;
+            max = 0;
+            m_pos++;
+            if (!_ParseNumber(min))
+            {
+                // Taken literally by some engines and rejected by others
+                _Fail(E_NOTIMPL);
+                return false;
+            }
+
+            max = min;
+            if (!_AtEnd() && _Peek() == L',')
+            {
+                m_pos++;
+                max = Unbounded;
+                if (!_AtEnd() && _Peek() != L'}' && !_ParseNumber(max))
+                {
+                    _Fail(E_NOTIMPL);
+                    return false;
+                }
+            }
+
+            if (_AtEnd() || _Peek() != L'}')
+            {
+                _Fail(E_NOTIMPL);
+                return false;
+            }
+            m_pos++;
+
+            if (max < min)
+            {
+                _Fail(E_INVALIDARG);
+                return false;
+            }
+            if (min > MaxRepeatCount || (max != Unbounded && max > MaxRepeatCount))
+            {
+                _Fail(E_NOTIMPL);
+                return false;
+            }
+            return true;
+        }
+
+        bool _ParseNumber(_Out_ UINT& value)
+        {
+            value = 0;
+            const size_t start = m_pos;
+            while (!_AtEnd() && _Peek() >= L'0' && _Peek() <= L'9')
+            {
+                if (value > MaxRepeatCount)
+                {
+                    // Keep counting digits without overflowing, the count is rejected anyway
+                    value = MaxRepeatCount + 1;
+                }
+                else
+                {
+                    value = value * 10 + static_cast<UINT>(_Peek() - L'0');
+                }
+                m_pos++;
+            }
+            return m_pos != start;
+        }
+
+        std::unique_ptr<Node> _ParseAtom()
+        {
+            auto node = std::make_unique<Node>();
+            const wchar_t c = _Peek();
+            m_pos++;
+            switch (c)
+            {
+            case L'(':
+            {
+                bool isCapturing = true;
+                if (!_AtEnd() && _Peek() == L'?')
+                {
+                    if (m_pos + 1 < m_pattern.length() && m_pattern[m_pos + 1] == L':')
+                    {
+                        isCapturing = false;
+                        m_pos += 2;
+                    }
+                    else
+                    {
+                        // Lookahead, lookbehind or named group
+                        return _Fail(E_NOTIMPL);
+                    }
+                }
+
+                const UINT group = isCapturing ? ++m_groupCount : 0;
+                auto child = _ParseAlternation();
+                if (FAILED(m_hr))
+                {
+                    return nullptr;
+                }
+                if (_AtEnd() || _Peek() != L')')
+                {
+                    return _Fail(E_INVALIDARG);
+                }
+                m_pos++;
+
+                if (!isCapturing)
+                {
+                    return child;
+                }
+                node->type = Node::Group;
+                node->index = group;
+                node->children.push_back(std::move(child));
+                return node;
+            }
+            case L'[':
+                return _ParseClass();
+            case L'.':
+                node->type = Node::Any;
+                return node;
+            case L'^':
+                node->type = Node::Assert;
+                node->index = CLinearRegEx::AssertBegin;
+                return node;
+            case L'$':
+                node->type = Node::Assert;
+                node->index = CLinearRegEx::AssertEnd;
+                return node;
+            case L'*':
+            case L'+':
+            case L'?':
+                // Nothing to repeat
+                return _Fail(E_INVALIDARG);
+            case L'{':
+            case L'}':
+            case L']':
+                // Taken literally by some engines and rejected by others
+                return _Fail(E_NOTIMPL);
+            case L'\\':
+                return _ParseEscape();
+            default:
+                return _CharNode(c);
+            }
+        }
+
+        std::unique_ptr<Node> _CharNode(wchar_t c)
+        {
+            auto node = std::make_unique<Node>();
+            node->type = Node::Char;
+            node->c = m_caseInsensitive ? static_cast<wchar_t>(towlower(c)) : c;
+            return node;
+        }
+
+        std::unique_ptr<Node> _ClassNode(CLinearRegEx::CharClass&& charClass)
+        {
+            auto node = std::make_unique<Node>();
+            node->type = Node::Class;
+            node->index = static_cast<UINT>(m_classes.size());
+            m_classes.push_back(std::move(charClass));
+            return node;
+        }
+
+        std::unique_ptr<Node> _ParseEscape()
+        {
+            if (_AtEnd())
+            {
+                return _Fail(E_INVALIDARG);
+            }
+
+            const wchar_t c = _Peek();
+            DWORD classEscape = _ClassEscape(c);
+            if (classEscape != 0)
+            {
+                m_pos++;
+                CLinearRegEx::CharClass charClass;
+                charClass.escapes = classEscape;
+                return _ClassNode(std::move(charClass));
+            }
+
+            if (c == L'b' || c == L'B')
+            {
+                m_pos++;
+                auto node = std::make_unique<Node>();
+                node->type = Node::Assert;
+                node->index = (c == L'b') ? CLinearRegEx::AssertWordBoundary : CLinearRegEx::AssertNotWordBoundary;
+                return node;
+            }
+
+            wchar_t value = 0;
+            if (!_ParseCharEscape(value))
+            {
+                return nullptr;
+            }
+            return _CharNode(value);
+        }
+
+        static DWORD _ClassEscape(wchar_t c)
+        {
+            switch (c)
+            {
+            case L'd':
+                return CLinearRegEx::ClassDigit;
+            case L'D':
+                return CLinearRegEx::ClassNotDigit;
+            case L'w':
+                return CLinearRegEx::ClassWord;
+            case L'W':
+                return CLinearRegEx::ClassNotWord;
+            case L's':
+                return CLinearRegEx::ClassSpace;
+            case L'S':
+                return CLinearRegEx::ClassNotSpace;
+            default:
+                return 0;
+            }
+        }
+
+        // Escapes that stand for a single character, m_pos is on the character after the backslash
+        bool _ParseCharEscape(_Out_ wchar_t& value)
+        {
+            value = 0;
+            const wchar_t c = _Peek();
+            m_pos++;
+            switch (c)
+            {
+            case L't':
+                value = L'\t';
+                return true;
+            case L'n':
+                value = L'\n';
+                return true;
+            case L'v':
+                value = L'\v';
+                return true;
+            case L'f':
+                value = L'\f';
+                return true;
+            case L'r':
+                value = L'\r';
+                return true;
+            case L'0':
+                if (!_AtEnd() && _Peek() >= L'0' && _Peek() <= L'9')
+                {
+                    _Fail(E_NOTIMPL);
+                    return false;
+                }
+                value = L'\0';
+                return true;
+            case L'x':
+                return _ParseHex(2, value);
+            case L'u':
+                return _ParseHex(4, value);
+            default:
+                if (iswalnum(c))
+                {
+                    // Backreferences, control characters, Unicode properties...
+                    _Fail(E_NOTIMPL);
+                    return false;
+                }
+                value = c;
+                return true;
+            }
+        }
+
+        bool _ParseHex(size_t digits, _Out_ wchar_t& value)
+        {
+            value = 0;
+            if (m_pos + digits > m_pattern.length())
+            {
+                _Fail(E_NOTIMPL);
+                return false;
+            }
+
+            UINT result = 0;
+            for (size_t i = 0; i < digits; i++)
+            {
+                int digit = HexValue(m_pattern[m_pos + i]);
+                if (digit < 0)
+                {
+                    _Fail(E_NOTIMPL);
+                    return false;
+                }
+                result = result * 16 + static_cast<UINT>(digit);
+            }
+            m_pos += digits;
+            value = static_cast<wchar_t>(result);
+            return true;
+        }
+
+        std::unique_ptr<Node> _ParseClass()
+        {
+            CLinearRegEx::CharClass charClass;
+            if (!_AtEnd() && _Peek() == L'^')
+            {
+                charClass.negated = true;
+                m_pos++;
+            }
+            if (!_AtEnd() && _Peek() == L']')
+            {
+                // [] and [^] are not supported by every engine
+                return _Fail(E_NOTIMPL);
+            }
+
+            while (!_AtEnd() && _Peek() != L']')
+            {
+                wchar_t first = 0;
+                DWORD classEscape = 0;
+                if (!_ParseClassAtom(first, classEscape))
+                {
+                    return nullptr;
+                }
+
+                if (classEscape != 0)
+                {
+                    charClass.escapes |= classEscape;
+                    if (m_pos + 1 < m_pattern.length() && _Peek() == L'-' && m_pattern[m_pos + 1] != L']')
+                    {
+                        // Range starting with a class escape
+                        return _Fail(E_NOTIMPL);
+                    }
+                    continue;
+                }
+
+                wchar_t last = first;
+                if (m_pos + 1 < m_pattern.length() && _Peek() == L'-' && m_pattern[m_pos + 1] != L']')
+                {
+                    m_pos++;
+                    if (!_ParseClassAtom(last, classEscape))
+                    {
+                        return nullptr;
+                    }
+                    if (classEscape != 0)
+                    {
+                        return _Fail(E_NOTIMPL);
+                    }
+                    if (last < first)
+                    {
+                        return _Fail(E_INVALIDARG);
+                    }
+                }
+                charClass.ranges.emplace_back(first, last);
+            }
+
+            if (_AtEnd())
+            {
+                return _Fail(E_INVALIDARG);
+            }
+            m_pos++;
+            return _ClassNode(std::move(charClass));
+        }
+
+        bool _ParseClassAtom(_Out_ wchar_t& value, _Out_ DWORD& classEscape)
+        {
+            value = 0;
+            classEscape = 0;
+            const wchar_t c = _Peek();
+            m_pos++;
+            if (c != L'\\')
+            {
+                value = c;
+                return true;
+            }
+
+            if (_AtEnd())
+            {
+                _Fail(E_INVALIDARG);
+                return false;
+            }
+
+            classEscape = _ClassEscape(_Peek());
+            if (classEscape != 0)
+            {
+                m_pos++;
+                return true;
+            }
+            if (_Peek() == L'b')
+            {
+                // Backspace in a class
+                m_pos++;
+                value = L'\b';
+                return true;
+            }
+            return _ParseCharEscape(value);
+        }
+
+        const std::wstring& m_pattern;
+        bool m_caseInsensitive;
+        std::vector<CLinearRegEx::CharClass>& m_classes;
+        size_t m_pos = 0;
+        UINT m_groupCount = 0;
+        HRESULT m_hr = S_OK;
+    };
+
+    // Emits the program of a node, Thompson construction
+    class Compiler
+    {
+    public:
+        explicit Compiler(std::vector<CLinearRegEx::Instruction>& program) :
+            m_program(program)
+        {
+        }
+
+        bool Emit(_In_ const Node& node)
+        {
+            switch (node.type)
+            {
+            case Node::Empty:
+                return true;
+            case Node::Char:
+                return _Push({ CLinearRegEx::OpChar, node.c, 0, 0 });
+            case Node::Any:
+                return _Push({ CLinearRegEx::OpAny, 0, 0, 0 });
+            case Node::Class:
+                return _Push({ CLinearRegEx::OpClass, 0, node.index, 0 });
+            case Node::Assert:
+                return _Push({ CLinearRegEx::OpAssert, 0, node.index, 0 });
+            case Node::Group:
+                return _Push({ CLinearRegEx::OpSave, 0, 2 * node.index, 0 }) &&
+                       Emit(*node.children[0]) &&
+                       _Push({ CLinearRegEx::OpSave, 0, 2 * node.index + 1, 0 });
+            case Node::Concat:
+                for (const auto& child : node.children)
+                {
+                    if (!Emit(*child))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            case Node::Alternate:
+                return _EmitAlternate(node);
+            case Node::Repeat:
+                return _EmitRepeat(node);
+            }
+            return false;
+        }
+
+    private:
+        UINT _Next() const { return static_cast<UINT>(m_program.size()); }
+
+        bool _Push(const CLinearRegEx::Instruction& instruction)
+        {
+            if (m_program.size() >= CLinearRegEx::MaxProgramSize)
+            {
+                return false;
+            }
+            m_program.push_back(instruction);
+            return true;
+        }
+
+        // split L1, L2; L1: a; jmp end; L2: split L2, L3; ...
+        bool _EmitAlternate(_In_ const Node& node)
+        {
+            std::vector<UINT> jumps;
+            for (size_t i = 0; i < node.children.size(); i++)
+            {
+                const bool isLast = (i + 1 == node.children.size());
+                UINT split = _Next();
+                if (!isLast && !_Push({ CLinearRegEx::OpSplit, 0, split + 1, 0 }))
+                {
+                    return false;
+                }
+                if (!Emit(*node.children[i]))
+                {
+                    return false;
+                }
+                if (!isLast)
+                {
+                    jumps.push_back(_Next());
+                    if (!_Push({ CLinearRegEx::OpJump, 0, 0, 0 }))
+                    {
+                        return false;
+                    }
+                    m_program[split].y = _Next();
+                }
+            }
+
+            for (UINT jump : jumps)
+            {
+                m_program[jump].x = _Next();
+            }
+            return true;
+        }
+
+        bool _EmitRepeat(_In_ const Node& node)
+        {
+            const Node& child = *node.children[0];
+            for (UINT i = 0; i < node.min; i++)
+            {
+                if (!Emit(child))
+                {
+                    return false;
+                }
+            }
+
+            if (node.max == Unbounded)
+            {
+                // L: split body, out; body; jmp L
+                const UINT loop = _Next();
+                if (!_Push({ CLinearRegEx::OpSplit, 0, 0, 0 }) || !Emit(child) || !_Push({ CLinearRegEx::OpJump, 0, loop, 0 }))
+                {
+                    return false;
+                }
+                _PatchSplit(loop, loop + 1, _Next(), node.greedy);
+                return true;
+            }
+
+            // x{0,n} is (x(x(x)?)?)?, every optional copy can skip to the end
+            std::vector<UINT> splits;
+            for (UINT i = node.min; i < node.max; i++)
+            {
+                splits.push_back(_Next());
+                if (!_Push({ CLinearRegEx::OpSplit, 0, 0, 0 }) || !Emit(child))
+                {
+                    return false;
+                }
+            }
+            for (UINT split : splits)
+            {
+                _PatchSplit(split, split + 1, _Next(), node.greedy);
+            }
+            return true;
+        }
+
+        void _PatchSplit(UINT split, UINT body, UINT out, bool greedy)
+        {
+            m_program[split].x = greedy ? body : out;
+            m_program[split].y = greedy ? out : body;
+        }
+
+        std::vector<CLinearRegEx::Instruction>& m_program;
+    };
+
+    // Threads of the simulation at one position of the text, in priority order
+    struct ThreadList
+    {
+        std::vector<UINT> pcs;
+        // slotCount captures per thread
+        std::vector<size_t> captures;
+
+        void Add(UINT pc, const size_t* threadCaptures, size_t slotCount)
+        {
+            pcs.push_back(pc);
+            captures.insert(captures.end(), threadCaptures, threadCaptures + slotCount);
+        }
+
+        void Clear()
+        {
+            pcs.clear();
+            captures.clear();
+        }
+    };
+}
+
+HRESULT CLinearRegEx::s_Compile(_In_ const std::wstring& pattern, _In_ bool caseInsensitive, _Out_ std::unique_ptr<CLinearRegEx>& regex)
+{
+    regex.reset();
+
+    std::unique_ptr<CLinearRegEx> compiled(new CLinearRegEx());
+    compiled->m_caseInsensitive = caseInsensitive;
+
+    Parser parser(pattern, caseInsensitive, compiled->m_classes);
+    std::unique_ptr<Node> root;
+    HRESULT hr = parser.Parse(root);
+    if (SUCCEEDED(hr))
+    {
+        compiled->m_groupCount = parser.GetGroupCount();
+        Compiler compiler(compiled->m_program);
+        hr = compiler.Emit(*root) ? S_OK : E_NOTIMPL;
+        if (SUCCEEDED(hr))
+        {
+            compiled->m_program.push_back({ OpMatch, 0, 0, 0 });
+            regex = std::move(compiled);
+        }
+    }
+    return hr;
+}
+
+bool CLinearRegEx::Search(_In_ const std::wstring& text, _In_ size_t start, _In_ size_t noEmptyMatchAt, _Out_ Captures& captures) const
+{
+    captures.clear();
+    const size_t length = text.length();
+    if (start > length)
+    {
+        return false;
+    }
+
+    const size_t slotCount = 2 * (static_cast<size_t>(m_groupCount) + 1);
+    ThreadList lists[2];
+    ThreadList* current = &lists[0];
+    ThreadList* next = &lists[1];
+
+    // Position + 1 at which an instruction was last added, so that a thread is added once per position
+    std::vector<size_t> addedAt(m_program.size(), 0);
+
+    // Pending work of the epsilon closure: an instruction, or a capture slot to restore
+    struct StackEntry
+    {
+        bool isRestore;
+        UINT pc;
+        size_t value;
+    };
+    std::vector<StackEntry> stack;
+    Captures threadCaptures(slotCount, std::wstring::npos);
+
+    // Adds the threads reachable from pc at pos without consuming text, in priority order
+    auto addThread = [&](ThreadList& list, UINT startPc, size_t pos) {
+        stack.push_back({ false, startPc, 0 });
+        while (!stack.empty())
+        {
+            StackEntry entry = stack.back();
+            stack.pop_back();
+            if (entry.isRestore)
+            {
+                threadCaptures[entry.pc] = entry.value;
+                continue;
+            }
+
+            const UINT pc = entry.pc;
+            if (addedAt[pc] == pos + 1)
+            {
+                continue;
+            }
+            addedAt[pc] = pos + 1;
+
+            const Instruction& instruction = m_program[pc];
+            switch (instruction.op)
+            {
+            case OpJump:
+                stack.push_back({ false, instruction.x, 0 });
+                break;
+            case OpSplit:
+                stack.push_back({ false, instruction.y, 0 });
+                stack.push_back({ false, instruction.x, 0 });
+                break;
+            case OpSave:
+                stack.push_back({ true, instruction.x, threadCaptures[instruction.x] });
+                threadCaptures[instruction.x] = pos;
+                stack.push_back({ false, pc + 1, 0 });
+                break;
+            case OpAssert:
+                if (_IsAssertionTrue(instruction.x, text, pos))
+                {
+                    stack.push_back({ false, pc + 1, 0 });
+                }
+                break;
+            default:
+                list.Add(pc, threadCaptures.data(), slotCount);
+                break;
+            }
+        }
+    };
+
+    bool matched = false;
+    for (size_t pos = start; pos <= length; pos++)
+    {
+        if (!matched)
+        {
+            // A match starting here has a lower priority than the ones started before
+            std::fill(threadCaptures.begin(), threadCaptures.end(), std::wstring::npos);
+            threadCaptures[0] = pos;
+            addThread(*current, 0, pos);
+        }
+        if (current->pcs.empty() && matched)
+        {
+            // No thread left that could find a higher priority match
+            break;
+        }
+
+        next->Clear();
+        for (size_t i = 0; i < current->pcs.size(); i++)
+        {
+            const UINT pc = current->pcs[i];
+            const size_t* capturesOfThread = current->captures.data() + i * slotCount;
+            const Instruction& instruction = m_program[pc];
+            if (instruction.op == OpMatch)
+            {
+                if (pos == noEmptyMatchAt && capturesOfThread[0] == pos)
+                {
+                    continue;
+                }
+
+                matched = true;
+                captures.assign(capturesOfThread, capturesOfThread + slotCount);
+                captures[1] = pos;
+                // The threads after this one have a lower priority
+                break;
+            }
+
+            if (pos < length && _Matches(instruction, text[pos]))
+            {
+                threadCaptures.assign(capturesOfThread, capturesOfThread + slotCount);
+                addThread(*next, pc + 1, pos + 1);
+            }
+        }
+
+        std::swap(current, next);
+    }
+
+    return matched;
+}
+
+bool CLinearRegEx::_Matches(_In_ const Instruction& instruction, _In_ wchar_t c) const
+{
+    switch (instruction.op)
+    {
+    case OpChar:
+        return (m_caseInsensitive ? static_cast<wchar_t>(towlower(c)) : c) == instruction.c;
+    case OpAny:
+        // Everything but line terminators
+        return c != L'\n' && c != L'\r' && c != L'\x2028' && c != L'\x2029';
+    case OpClass:
+    {
+        const CharClass& charClass = m_classes[instruction.x];
+        auto inRanges = [&charClass](wchar_t value) {
+            for (const auto& range : charClass.ranges)
+            {
+                if (value >= range.first && value <= range.second)
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        const DWORD escapes = charClass.escapes;
+        bool isMatch = inRanges(c) ||
+                       ((escapes & ClassDigit) && iswdigit(c)) || ((escapes & ClassNotDigit) && !iswdigit(c)) ||
+                       ((escapes & ClassWord) && IsWordChar(c)) || ((escapes & ClassNotWord) && !IsWordChar(c)) ||
+                       ((escapes & ClassSpace) && iswspace(c)) || ((escapes & ClassNotSpace) && !iswspace(c));
+        if (!isMatch && m_caseInsensitive)
+        {
+            isMatch = inRanges(static_cast<wchar_t>(towlower(c))) || inRanges(static_cast<wchar_t>(towupper(c)));
+        }
+        return isMatch != charClass.negated;
+    }
+    default:
+        return false;
+    }
+}
+
+bool CLinearRegEx::_IsAssertionTrue(_In_ UINT assertion, _In_ const std::wstring& text, _In_ size_t pos) const
+{
+    switch (assertion)
+    {
+    case AssertBegin:
+        return pos == 0;
+    case AssertEnd:
+        return pos == text.length();
+    case AssertWordBoundary:
+    case AssertNotWordBoundary:
+    {
+        const bool isBoundary = (pos > 0 && IsWordChar(text[pos - 1])) != (pos < text.length() && IsWordChar(text[pos]));
+        return isBoundary == (assertion == AssertWordBoundary);
+    }
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "pch.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Regular expression engine whose running time is linear in the length of the text for
+// any pattern.  The pattern is compiled to a program that is run as an NFA simulation:
+// every way the pattern can match is followed at once, one character of the text at a
+// time, so nothing is ever retried.  Matches are the ones a backtracking engine finds:
+// leftmost, then first alternative and greedy or lazy quantifiers in priority order.
+//
+// Supports the ECMAScript syntax apart from backreferences and lookaround: alternation,
+// capturing and non capturing groups, * + ? {n,m} and their lazy forms, character
+// classes, . \d \w \s (and their negations), \b \B, ^ and $.
+class CLinearRegEx
+{
+public:
+    // Start and end of group n are at [2n] and [2n + 1], npos when the group did not participate
+    using Captures = std::vector<size_t>;
+
+    // Larger patterns, once the counted repetitions are expanded, are left to the other engines
+    static const UINT MaxProgramSize = 10000;
+
+    // Returns E_NOTIMPL when the pattern uses syntax the engine does not support and
+    // E_INVALIDARG when it is not a valid regular expression
+    static HRESULT s_Compile(_In_ const std::wstring& pattern, _In_ bool caseInsensitive, _Out_ std::unique_ptr<CLinearRegEx>& regex);
+
+    // Number of capturing groups, not counting the whole match
+    UINT GetGroupCount() const { return m_groupCount; }
+
+    // Finds the leftmost match that starts at or after start.  An empty match starting at
+    // noEmptyMatchAt is not a match, the way iterating over matches needs it.
+    bool Search(_In_ const std::wstring& text, _In_ size_t start, _In_ size_t noEmptyMatchAt, _Out_ Captures& captures) const;
+
+    enum Opcode : BYTE
+    {
+        OpChar,
+        OpAny,
+        OpClass,
+        OpSplit,
+        OpJump,
+        OpSave,
+        OpAssert,
+        OpMatch
+    };
+
+    enum Assertion : UINT
+    {
+        AssertBegin,
+        AssertEnd,
+        AssertWordBoundary,
+        AssertNotWordBoundary
+    };
+
+    // \d \D \w \W \s \S, alone or in a character class
+    enum ClassEscape : DWORD
+    {
+        ClassDigit = 0x1,
+        ClassNotDigit = 0x2,
+        ClassWord = 0x4,
+        ClassNotWord = 0x8,
+        ClassSpace = 0x10,
+        ClassNotSpace = 0x20,
+    };
+
+    struct CharClass
+    {
+        bool negated = false;
+        DWORD escapes = 0;
+        std::vector<std::pair<wchar_t, wchar_t>> ranges;
+    };
+
+    struct Instruction
+    {
+        Opcode op;
+        // OpChar, folded when the search is case insensitive
+        wchar_t c;
+        // Preferred target of OpSplit, target of OpJump, slot of OpSave, class of OpClass, kind of OpAssert
+        UINT x;
+        // Other target of OpSplit
+        UINT y;
+    };
+
+private:
+    CLinearRegEx() = default;
+
+    bool _Matches(_In_ const Instruction& instruction, _In_ wchar_t c) const;
+    bool _IsAssertionTrue(_In_ UINT assertion, _In_ const std::wstring& text, _In_ size_t pos) const;
+
+    bool m_caseInsensitive = false;
+    UINT m_groupCount = 0;
+    std::vector<Instruction> m_program;
+    std::vector<CharClass> m_classes;
+};
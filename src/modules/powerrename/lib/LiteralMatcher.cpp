@@ -0,0 +1,187 @@
+#include "pch.h"
+#include "LiteralMatcher.h"
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#include <intrin.h>
+#define LITERAL_MATCHER_SSE2
+#endif
+
+namespace
+{
+    // towlower of every UTF-16 code unit, built on first use
+    const wchar_t* FoldTable()
+    {
+        static const std::vector<wchar_t> table = []() {
+            std::vector<wchar_t> folded(0x10000);
+            for (size_t c = 0; c < folded.size(); c++)
+            {
+                folded[c] = static_cast<wchar_t>(towlower(static_cast<wint_t>(c)));
+            }
+            return folded;
+        }();
+        return table.data();
+    }
+
+    bool IsRegExMetaCharacter(wchar_t c)
+    {
+        return c != L'\0' && wcschr(L"\\^$.|?*+()[]{}", c) != nullptr;
+    }
+}
+
+CLiteralMatcher::CLiteralMatcher(_In_ const std::wstring& searchTerm, _In_ bool caseInsensitive) :
+    m_searchTerm(searchTerm),
+    m_caseInsensitive(caseInsensitive)
+{
+    if (m_searchTerm.empty())
+    {
+        return;
+    }
+
+    if (!m_caseInsensitive)
+    {
+        m_firstChars[0] = m_firstChars[1] = m_searchTerm[0];
+        m_canScanFirstChars = true;
+        return;
+    }
+
+    const wchar_t* fold = FoldTable();
+    for (auto& c : m_searchTerm)
+    {
+        c = fold[c];
+    }
+
+    // Look for every character that folds to the first one, usually itself and its upper case
+    UINT firstCharCount = 0;
+    for (size_t c = 0; c < 0x10000; c++)
+    {
+        if (fold[c] == m_searchTerm[0])
+        {
+            if (firstCharCount < ARRAYSIZE(m_firstChars))
+            {
+                m_firstChars[firstCharCount] = static_cast<wchar_t>(c);
+            }
+            firstCharCount++;
+        }
+    }
+
+    if (firstCharCount == 1)
+    {
+        m_firstChars[1] = m_firstChars[0];
+    }
+    m_canScanFirstChars = firstCharCount <= ARRAYSIZE(m_firstChars);
+}
+
+size_t CLiteralMatcher::Find(_In_reads_(length) PCWSTR text, _In_ size_t length, _In_ size_t pos) const
+{
+    const size_t searchLength = m_searchTerm.length();
+    if (searchLength == 0 || pos > length || length - pos < searchLength)
+    {
+        return std::wstring::npos;
+    }
+
+    // Last position a match can start at
+    const size_t lastStart = length - searchLength;
+    size_t i = pos;
+
+    if (m_canScanFirstChars)
+    {
+#ifdef LITERAL_MATCHER_SSE2
+        const __m128i first0 = _mm_set1_epi16(static_cast<short>(m_firstChars[0]));
+        const __m128i first1 = _mm_set1_epi16(static_cast<short>(m_firstChars[1]));
+        for (; i + 8 <= lastStart + 1; i += 8)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+            unsigned long mask = static_cast<unsigned long>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(block, first0), _mm_cmpeq_epi16(block, first1))));
+            while (mask != 0)
+            {
+                unsigned long bit = 0;
+                _BitScanForward(&bit, mask);
+                // Two mask bits per character
+                const size_t candidate = i + bit / 2;
+                if (_MatchesAt(text + candidate))
+                {
+                    return candidate;
+                }
+                mask &= ~(3ul << bit);
+            }
+        }
+#endif
+        for (; i <= lastStart; i++)
+        {
+            if ((text[i] == m_firstChars[0] || text[i] == m_firstChars[1]) && _MatchesAt(text + i))
+            {
+                return i;
+            }
+        }
+    }
+    else
+    {
+        const wchar_t* fold = FoldTable();
+        for (; i <= lastStart; i++)
+        {
+            if (fold[text[i]] == m_searchTerm[0] && _MatchesAt(text + i))
+            {
+                return i;
+            }
+        }
+    }
+
+    return std::wstring::npos;
+}
+
+void CLiteralMatcher::Replace(_In_ const std::wstring& source, _In_ const std::wstring& replaceTerm, _In_ bool matchAll, _Out_ std::wstring& result) const
+{
+    result.clear();
+    result.reserve(source.length());
+    size_t copied = 0;
+    size_t pos = Find(source, 0);
+    while (pos != std::wstring::npos)
+    {
+        result.append(source, copied, pos - copied);
+        result.append(replaceTerm);
+        copied = pos + m_searchTerm.length();
+
+        pos = matchAll ? Find(source, copied) : std::wstring::npos;
+    }
+    result.append(source, copied, std::wstring::npos);
+}
+
+bool CLiteralMatcher::IsLiteralRegEx(_In_ const std::wstring& pattern, _In_ bool caseInsensitive)
+{
+    for (auto c : pattern)
+    {
+        if (IsRegExMetaCharacter(c) || (caseInsensitive && (static_cast<wchar_t>(towlower(c)) != c || static_cast<wchar_t>(towupper(c)) != c)))
+        {
+            return false;
+        }
+    }
+    return !pattern.empty();
+}
+
+bool CLiteralMatcher::IsLiteralReplaceTerm(_In_ const std::wstring& replaceTerm)
+{
+    // $ starts a group reference and boost also treats \ as an escape
+    return replaceTerm.find_first_of(L"$\\") == std::wstring::npos;
+}
+
+bool CLiteralMatcher::_MatchesAt(_In_ PCWSTR text) const
+{
+    // The first character is checked by the caller
+    const size_t searchLength = m_searchTerm.length();
+    if (m_caseInsensitive)
+    {
+        const wchar_t* fold = FoldTable();
+        for (size_t i = 1; i < searchLength; i++)
+        {
+            if (fold[text[i]] != m_searchTerm[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    return wmemcmp(text + 1, m_searchTerm.c_str() + 1, searchLength - 1) == 0;
+}
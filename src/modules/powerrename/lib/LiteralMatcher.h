@@ -0,0 +1,39 @@
+#pragma once
+#include "pch.h"
+#include <string>
+
+// Finds a search term taken literally in file names.  The search term is folded once
+// with towlower and candidates are located by scanning for its first character several
+// characters at a time, so a search neither copies nor converts the whole name.
+// Positions are identical to std::wstring::find on the folded strings.
+class CLiteralMatcher
+{
+public:
+    CLiteralMatcher() = default;
+    CLiteralMatcher(_In_ const std::wstring& searchTerm, _In_ bool caseInsensitive);
+
+    // Returns the position of the first match at or after pos, npos when there is none
+    size_t Find(_In_reads_(length) PCWSTR text, _In_ size_t length, _In_ size_t pos) const;
+    size_t Find(_In_ const std::wstring& text, _In_ size_t pos) const { return Find(text.c_str(), text.length(), pos); }
+
+    // Replaces the first match or all of them from left to right, matches never overlap
+    void Replace(_In_ const std::wstring& source, _In_ const std::wstring& replaceTerm, _In_ bool matchAll, _Out_ std::wstring& result) const;
+
+    // True when the ECMAScript regular expression pattern only matches its own text and
+    // matches the same names as a literal search.  Case insensitive regular expressions
+    // fold characters their own way, so patterns with cased characters are left to them.
+    static bool IsLiteralRegEx(_In_ const std::wstring& pattern, _In_ bool caseInsensitive);
+
+    // True when a regex replace term is inserted as is by regex_replace
+    static bool IsLiteralReplaceTerm(_In_ const std::wstring& replaceTerm);
+
+private:
+    bool _MatchesAt(_In_ PCWSTR text) const;
+
+    std::wstring m_searchTerm;
+    bool m_caseInsensitive = false;
+    // Characters a match can start with.  Only a character with more than two forms
+    // folding to the first character of the search term needs the character by character scan.
+    wchar_t m_firstChars[2] = {};
+    bool m_canScanFirstChars = false;
+};
@@ -1,7 +1,5 @@
 #include "pch.h"
 #include "PowerRenameEnum.h"
-#include <ShlGuid.h>
-#include <helpers.h>
 
 IFACEMETHODIMP_(ULONG) CPowerRenameEnum::AddRef()
 {
@@ -30,20 +28,30 @@ IFACEMETHODIMP CPowerRenameEnum::QueryInterface(_In_ REFIID riid, _Outptr_ void*
 
 IFACEMETHODIMP CPowerRenameEnum::Start()
 {
-    m_canceled = false;
-    CComPtr<IShellItemArray> spsia;
-    HRESULT hr = GetShellItemArrayFromDataObject(m_spdo, &spsia);
-    if (SUCCEEDED(hr))
+    _WaitForWorkerThread();
+
+    UINT itemCount = 0;
+    return _Enumerate([this](UINT) { m_spsrm->UpdatePreview(); }, &itemCount);
+}
+
+IFACEMETHODIMP CPowerRenameEnum::StartAsync(_In_ HWND hwndNotify, _In_ UINT progressMsg, _In_ UINT completeMsg)
+{
+    _WaitForWorkerThread();
+
+    m_hwndNotify = hwndNotify;
+    m_progressMsg = progressMsg;
+    m_completeMsg = completeMsg;
+    // Renaming is refused until the worker thread is done adding items
+    m_spsrm->PutEnumerating(true);
+    // The worker thread is waited for before the enum is destroyed so it does not hold a reference
+    m_workerThreadHandle = CreateThread(nullptr, 0, s_workerThread, this, 0, nullptr);
+    if (!m_workerThreadHandle)
     {
-        CComPtr<IEnumShellItems> spesi;
-        hr = spsia->EnumItems(&spesi);
-        if (SUCCEEDED(hr))
-        {
-            hr = _ParseEnumItems(spesi);
-        }
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        m_spsrm->PutEnumerating(false);
+        return hr;
     }
-
-    return hr;
+    return S_OK;
 }
 
 IFACEMETHODIMP CPowerRenameEnum::Cancel()
@@ -53,6 +61,11 @@ IFACEMETHODIMP CPowerRenameEnum::Cancel()
 }
 
 HRESULT CPowerRenameEnum::s_CreateInstance(_In_ IUnknown* pdo, _In_ IPowerRenameManager* pManager, _In_ REFIID iid, _Outptr_ void** resultInterface)
+{
+    return s_CreateInstance(std::make_unique<CPowerRenameShellEnumSource>(pdo), pManager, iid, resultInterface);
+}
+
+HRESULT CPowerRenameEnum::s_CreateInstance(_In_ std::unique_ptr<CPowerRenameEnumSource> source, _In_ IPowerRenameManager* pManager, _In_ REFIID iid, _Outptr_ void** resultInterface)
 {
     *resultInterface = nullptr;
 
@@ -60,7 +73,7 @@ HRESULT CPowerRenameEnum::s_CreateInstance(_In_ IUnknown* pdo, _In_ IPowerRename
     HRESULT hr = newRenameEnum ? S_OK : E_OUTOFMEMORY;
     if (SUCCEEDED(hr))
     {
-        hr = newRenameEnum->_Init(pdo, pManager);
+        hr = newRenameEnum->_Init(std::move(source), pManager);
         if (SUCCEEDED(hr))
         {
             hr = newRenameEnum->QueryInterface(iid, resultInterface);
@@ -78,67 +91,109 @@ CPowerRenameEnum::CPowerRenameEnum() :
 
 CPowerRenameEnum::~CPowerRenameEnum()
 {
+    Cancel();
+    _WaitForWorkerThread();
 }
 
-HRESULT CPowerRenameEnum::_Init(_In_ IUnknown* pdo, _In_ IPowerRenameManager* pManager)
+HRESULT CPowerRenameEnum::_Init(_In_ std::unique_ptr<CPowerRenameEnumSource> source, _In_ IPowerRenameManager* pManager)
 {
-    m_spdo = pdo;
+    m_source = std::move(source);
     m_spsrm = pManager;
-    return S_OK;
+    return m_source ? S_OK : E_INVALIDARG;
 }
 
-HRESULT CPowerRenameEnum::_ParseEnumItems(_In_ IEnumShellItems* pesi, _In_ int depth)
+HRESULT CPowerRenameEnum::_Enumerate(_In_ const std::function<void(UINT itemCount)>& onPreview, _Out_ UINT* itemCount)
 {
-    HRESULT hr = E_INVALIDARG;
-
-    // We shouldn't get this deep since we only enum the contents of
-    // regular folders but adding just in case
-    if ((pesi) && (depth < (MAX_PATH / 2)))
+    *itemCount = 0;
+    m_canceled = false;
+    m_source->Reset();
+
+    std::vector<PowerRenameEnumItem> items;
+    std::vector<PowerRenameItemInfo> batch;
+    UINT previewItemCount = 0;
+    bool hasMoreItems = true;
+    HRESULT hr = S_OK;
+    while (SUCCEEDED(hr) && hasMoreItems)
     {
-        hr = S_OK;
+        if (m_canceled)
+        {
+            return E_ABORT;
+        }
+
+        hr = m_source->NextBatch(BatchSize, items);
+        hasMoreItems = (hr == S_OK);
+        if (items.empty())
+        {
+            continue;
+        }
 
-        ULONG celtFetched;
-        CComPtr<IShellItem> spsi;
-        while ((S_OK == pesi->Next(1, &spsi, &celtFetched)) && (SUCCEEDED(hr)))
+        batch.clear();
+        for (const auto& item : items)
         {
-            if (m_canceled)
-            {
-                return E_ABORT;
-            }
-
-            CComPtr<IPowerRenameItemFactory> spFactory;
-            hr = m_spsrm->GetRenameItemFactory(&spFactory);
-            if (SUCCEEDED(hr))
-            {
-                CComPtr<IPowerRenameItem> spNewItem;
-                // Failure may be valid if we come across a shell item that does
-                // not support a file system path.  In that case we simply ignore
-                // the item.
-                if (SUCCEEDED(spFactory->Create(spsi, &spNewItem)))
-                {
-                    spNewItem->PutDepth(depth);
-                    hr = m_spsrm->AddItem(spNewItem);
-                    if (SUCCEEDED(hr))
-                    {
-                        bool isFolder = false;
-                        if (SUCCEEDED(spNewItem->GetIsFolder(&isFolder)) && isFolder)
-                        {
-                            // Bind to the IShellItem for the IEnumShellItems interface
-                            CComPtr<IEnumShellItems> spesiNext;
-                            hr = spsi->BindToHandler(nullptr, BHID_EnumItems, IID_PPV_ARGS(&spesiNext));
-                            if (SUCCEEDED(hr))
-                            {
-                                // Parse the folder contents recursively
-                                hr = _ParseEnumItems(spesiNext, depth + 1);
-                            }
-                        }
-                    }
-                }
-            }
-
-            spsi = nullptr;
+            batch.push_back({ item.path.empty() ? nullptr : item.path.c_str(),
+                              item.originalName.empty() ? nullptr : item.originalName.c_str(),
+                              item.depth,
+                              item.isFolder,
+                              item.canRename });
         }
+
+        HRESULT hrAdd = m_spsrm->AddItemInfos(batch.data(), static_cast<UINT>(batch.size()));
+        if (FAILED(hrAdd))
+        {
+            hr = hrAdd;
+        }
+        else
+        {
+            *itemCount += static_cast<UINT>(batch.size());
+        }
+
+        // The items added so far are previewed while the next ones are enumerated
+        if (SUCCEEDED(hr) && *itemCount >= 2 * previewItemCount)
+        {
+            onPreview(*itemCount);
+            previewItemCount = *itemCount;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        if (*itemCount != previewItemCount)
+        {
+            onPreview(*itemCount);
+        }
+        hr = S_OK;
     }
 
     return hr;
 }
+
+void CPowerRenameEnum::_WaitForWorkerThread()
+{
+    if (m_workerThreadHandle)
+    {
+        // The worker thread calls into the data object of our apartment, keep dispatching the calls
+        DWORD index = 0;
+        CoWaitForMultipleHandles(0, INFINITE, 1, &m_workerThreadHandle, &index);
+        CloseHandle(m_workerThreadHandle);
+        m_workerThreadHandle = nullptr;
+    }
+}
+
+DWORD WINAPI CPowerRenameEnum::s_workerThread(_In_ void* pv)
+{
+    CPowerRenameEnum* renameEnum = reinterpret_cast<CPowerRenameEnum*>(pv);
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+    UINT itemCount = 0;
+    if (SUCCEEDED(hr))
+    {
+        auto onPreview = [renameEnum](UINT count) {
+            PostMessage(renameEnum->m_hwndNotify, renameEnum->m_progressMsg, count, 0);
+        };
+        hr = renameEnum->_Enumerate(onPreview, &itemCount);
+        CoUninitialize();
+    }
+
+    renameEnum->m_spsrm->PutEnumerating(false);
+    PostMessage(renameEnum->m_hwndNotify, renameEnum->m_completeMsg, itemCount, static_cast<LPARAM>(hr));
+    return 0;
+}
@@ -1,9 +1,18 @@
 #pragma once
 #include "pch.h"
 #include "PowerRenameInterfaces.h"
+#include "PowerRenameEnumSource.h"
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <vector>
 #include "srwlock.h"
 
+// Adds the items of a CPowerRenameEnumSource to the manager in batches.  The preview
+// of the first batch is started right away and updated every time the number of items
+// doubles, so results show up while large folders are still being enumerated.  StartAsync
+// does the same on a worker thread and leaves the previews to the window it notifies.
+
 class CPowerRenameEnum :
     public IPowerRenameEnum
 {
@@ -15,20 +24,34 @@ public:
 
     // ISmartRenameEnum
     IFACEMETHODIMP Start();
+    IFACEMETHODIMP StartAsync(_In_ HWND hwndNotify, _In_ UINT progressMsg, _In_ UINT completeMsg);
     IFACEMETHODIMP Cancel();
 
 public:
+    // Number of items added to the manager at a time
+    static const UINT BatchSize = 256;
+
+    // Enumerates the shell items of the data object
     static HRESULT s_CreateInstance(_In_ IUnknown* pdo, _In_ IPowerRenameManager* pManager, _In_ REFIID iid, _Outptr_ void** resultInterface);
+    static HRESULT s_CreateInstance(_In_ std::unique_ptr<CPowerRenameEnumSource> source, _In_ IPowerRenameManager* pManager, _In_ REFIID iid, _Outptr_ void** resultInterface);
 
 protected:
     CPowerRenameEnum();
     virtual ~CPowerRenameEnum();
 
-    HRESULT _Init(_In_ IUnknown* pdo, _In_ IPowerRenameManager* pManager);
-    HRESULT _ParseEnumItems(_In_ IEnumShellItems* pesi, _In_ int depth = 0);
+    HRESULT _Init(_In_ std::unique_ptr<CPowerRenameEnumSource> source, _In_ IPowerRenameManager* pManager);
+    // Adds all the items of the source and calls onPreview with the number of items added
+    // every time they should be previewed
+    HRESULT _Enumerate(_In_ const std::function<void(UINT itemCount)>& onPreview, _Out_ UINT* itemCount);
+    void _WaitForWorkerThread();
+    static DWORD WINAPI s_workerThread(_In_ void* pv);
 
     CComPtr<IPowerRenameManager> m_spsrm;
-    CComPtr<IUnknown> m_spdo;
-    bool m_canceled = false;
+    std::unique_ptr<CPowerRenameEnumSource> m_source;
+    std::atomic<bool> m_canceled = false;
+    HANDLE m_workerThreadHandle = nullptr;
+    HWND m_hwndNotify = nullptr;
+    UINT m_progressMsg = 0;
+    UINT m_completeMsg = 0;
     long m_refCount = 0;
 };
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "pch.h"
+#include "PowerRenameEnumSource.h"
+#include <ShlGuid.h>
+#include <helpers.h>
+
+namespace fs = std::filesystem;
+
+CPowerRenameShellEnumSource::CPowerRenameShellEnumSource(_In_ IUnknown* dataObject)
+{
+    if (dataObject && SUCCEEDED(CoCreateInstance(CLSID_StdGlobalInterfaceTable, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&m_globalInterfaceTable))))
+    {
+        m_globalInterfaceTable->RegisterInterfaceInGlobal(dataObject, IID_IUnknown, &m_dataObjectCookie);
+    }
+}
+
+CPowerRenameShellEnumSource::~CPowerRenameShellEnumSource()
+{
+    if (m_dataObjectCookie)
+    {
+        m_globalInterfaceTable->RevokeInterfaceFromGlobal(m_dataObjectCookie);
+    }
+}
+
+void CPowerRenameShellEnumSource::Reset()
+{
+    m_isStarted = false;
+    m_frames.clear();
+}
+
+HRESULT CPowerRenameShellEnumSource::NextBatch(_In_ UINT maxCount, _Inout_ std::vector<PowerRenameEnumItem>& items)
+{
+    items.clear();
+
+    HRESULT hr = S_OK;
+    if (!m_isStarted)
+    {
+        m_isStarted = true;
+        hr = _Start();
+    }
+
+    while (SUCCEEDED(hr) && !m_frames.empty() && items.size() < maxCount)
+    {
+        Frame& frame = m_frames.back();
+        if (frame.next == frame.pending.size())
+        {
+            _Fetch(frame);
+            if (frame.pending.empty())
+            {
+                // Done with this folder
+                m_frames.pop_back();
+                continue;
+            }
+        }
+
+        // The frame may move when a folder is pushed below
+        CComPtr<IShellItem> spsi = frame.pending[frame.next++];
+        const int depth = frame.depth;
+
+        PowerRenameEnumItem item;
+        // Failure may be valid if we come across a shell item that does
+        // not support a file system path.  In that case we simply ignore
+        // the item.
+        if (SUCCEEDED(_GetItem(spsi, depth, item)))
+        {
+            const bool isFolder = item.isFolder;
+            items.push_back(std::move(item));
+
+            if (isFolder)
+            {
+                // Bind to the IShellItem for the IEnumShellItems interface
+                CComPtr<IEnumShellItems> spesiNext;
+                hr = spsi->BindToHandler(nullptr, BHID_EnumItems, IID_PPV_ARGS(&spesiNext));
+                if (SUCCEEDED(hr))
+                {
+                    // The folder contents come next
+                    hr = _PushFrame(spesiNext, depth + 1);
+                }
+            }
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = m_frames.empty() ? S_FALSE : S_OK;
+    }
+    return hr;
+}
+
+HRESULT CPowerRenameShellEnumSource::_Start()
+{
+    m_frames.clear();
+    if (!m_dataObjectCookie)
+    {
+        return E_FAIL;
+    }
+
+    // Marshaled to the apartment of the calling thread
+    CComPtr<IUnknown> spdo;
+    HRESULT hr = m_globalInterfaceTable->GetInterfaceFromGlobal(m_dataObjectCookie, IID_PPV_ARGS(&spdo));
+    if (SUCCEEDED(hr))
+    {
+        CComPtr<IShellItemArray> spsia;
+        hr = GetShellItemArrayFromDataObject(spdo, &spsia);
+        if (SUCCEEDED(hr))
+        {
+            CComPtr<IEnumShellItems> spesi;
+            hr = spsia->EnumItems(&spesi);
+            if (SUCCEEDED(hr))
+            {
+                hr = _PushFrame(spesi, 0);
+            }
+        }
+    }
+    return hr;
+}
+
+HRESULT CPowerRenameShellEnumSource::_PushFrame(_In_ IEnumShellItems* enumItems, _In_ int depth)
+{
+    // We shouldn't get this deep since we only enum the contents of
+    // regular folders but adding just in case
+    if (!enumItems || depth >= (MAX_PATH / 2))
+    {
+        return E_INVALIDARG;
+    }
+
+    Frame frame;
+    frame.enumItems = enumItems;
+    frame.depth = depth;
+    m_frames.push_back(std::move(frame));
+    return S_OK;
+}
+
+void CPowerRenameShellEnumSource::_Fetch(_Inout_ Frame& frame)
+{
+    frame.pending.clear();
+    frame.next = 0;
+
+    IShellItem* fetched[FetchCount] = {};
+    ULONG fetchedCount = 0;
+    // S_FALSE still returns the last few items of the folder
+    if (SUCCEEDED(frame.enumItems->Next(FetchCount, fetched, &fetchedCount)))
+    {
+        frame.pending.reserve(fetchedCount);
+        for (ULONG i = 0; i < fetchedCount; i++)
+        {
+            CComPtr<IShellItem> spsi;
+            spsi.Attach(fetched[i]);
+            frame.pending.push_back(spsi);
+        }
+    }
+}
+
+HRESULT CPowerRenameShellEnumSource::_GetItem(_In_ IShellItem* psi, _In_ int depth, _Out_ PowerRenameEnumItem& item)
+{
+    // Get the full filesystem path from the shell item
+    CComHeapPtr<wchar_t> path;
+    HRESULT hr = psi->GetDisplayName(SIGDN_FILESYSPATH, &path);
+    if (SUCCEEDED(hr))
+    {
+        // Also check if the shell allows us to rename the item.
+        SFGAOF att = 0;
+        hr = psi->GetAttributes(SFGAO_STREAM | SFGAO_FOLDER | SFGAO_CANRENAME, &att);
+        if (SUCCEEDED(hr))
+        {
+            item.path = path.m_pData;
+            item.originalName.clear();
+            item.depth = static_cast<UINT>(depth);
+            // Some items can be both folders and streams (ex: zip folders).
+            item.isFolder = (att & SFGAO_FOLDER) && !(att & SFGAO_STREAM);
+            // The shell lets us know if an item should not be renamed
+            // (ex: user profile director, windows dir, etc).
+            item.canRename = (att & SFGAO_CANRENAME) != 0;
+        }
+    }
+    return hr;
+}
+
+CPowerRenameFileSystemEnumSource::CPowerRenameFileSystemEnumSource(_In_ std::vector<fs::path> roots) :
+    m_roots(std::move(roots))
+{
+}
+
+void CPowerRenameFileSystemEnumSource::Reset()
+{
+    m_nextRoot = 0;
+    m_contents = fs::recursive_directory_iterator();
+}
+
+HRESULT CPowerRenameFileSystemEnumSource::NextBatch(_In_ UINT maxCount, _Inout_ std::vector<PowerRenameEnumItem>& items)
+{
+    items.clear();
+
+    std::error_code error;
+    while (items.size() < maxCount)
+    {
+        if (m_contents != fs::recursive_directory_iterator())
+        {
+            const fs::directory_entry& entry = *m_contents;
+            _AddItem(entry.path(), entry.is_directory(error), static_cast<UINT>(m_contents.depth()) + 1, items);
+            m_contents.increment(error);
+            if (error)
+            {
+                // Skip the rest of a folder that can no longer be read
+                m_contents = fs::recursive_directory_iterator();
+            }
+        }
+        else if (m_nextRoot < m_roots.size())
+        {
+            const fs::path& root = m_roots[m_nextRoot++];
+            const bool isFolder = fs::is_directory(root, error);
+            _AddItem(root, isFolder, 0, items);
+            if (isFolder)
+            {
+                m_contents = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, error);
+            }
+        }
+        else
+        {
+            return S_FALSE;
+        }
+    }
+
+    return S_OK;
+}
+
+void CPowerRenameFileSystemEnumSource::_AddItem(_In_ const fs::path& path, _In_ bool isFolder, _In_ UINT depth, _Inout_ std::vector<PowerRenameEnumItem>& items)
+{
+    PowerRenameEnumItem item;
+    item.path = path.wstring();
+    item.depth = depth;
+    item.isFolder = isFolder;
+    items.push_back(std::move(item));
+}
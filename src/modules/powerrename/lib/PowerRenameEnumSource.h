@@ -0,0 +1,89 @@
+#pragma once
+#include "pch.h"
+#include "PowerRenameInterfaces.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// An item produced by a CPowerRenameEnumSource
+struct PowerRenameEnumItem
+{
+    std::wstring path;
+    // Empty when the name is the last component of the path
+    std::wstring originalName;
+    UINT depth = 0;
+    bool isFolder = false;
+    bool canRename = true;
+};
+
+// Produces the items CPowerRenameEnum adds to the manager.  Items come in depth first
+// order: a folder is directly followed by its contents.
+class CPowerRenameEnumSource
+{
+public:
+    virtual ~CPowerRenameEnumSource() = default;
+
+    // Starts over from the first item
+    virtual void Reset() = 0;
+
+    // Replaces the content of items with up to maxCount new items.  Returns S_FALSE
+    // once the source is exhausted.  Items produced before a failure are still returned.
+    virtual HRESULT NextBatch(_In_ UINT maxCount, _Inout_ std::vector<PowerRenameEnumItem>& items) = 0;
+};
+
+// Enumerates the shell items of a data object and the contents of its folders.
+// Shell items without a file system path are skipped.  The data object is kept in the
+// global interface table so the source can be enumerated from any apartment.
+class CPowerRenameShellEnumSource :
+    public CPowerRenameEnumSource
+{
+public:
+    // Number of shell items fetched from an IEnumShellItems at a time
+    static const ULONG FetchCount = 64;
+
+    explicit CPowerRenameShellEnumSource(_In_ IUnknown* dataObject);
+    ~CPowerRenameShellEnumSource();
+
+    void Reset() override;
+    HRESULT NextBatch(_In_ UINT maxCount, _Inout_ std::vector<PowerRenameEnumItem>& items) override;
+
+private:
+    // A folder being enumerated along with the shell items fetched from it but not returned yet
+    struct Frame
+    {
+        CComPtr<IEnumShellItems> enumItems;
+        int depth = 0;
+        std::vector<CComPtr<IShellItem>> pending;
+        size_t next = 0;
+    };
+
+    HRESULT _Start();
+    HRESULT _PushFrame(_In_ IEnumShellItems* enumItems, _In_ int depth);
+    void _Fetch(_Inout_ Frame& frame);
+    static HRESULT _GetItem(_In_ IShellItem* psi, _In_ int depth, _Out_ PowerRenameEnumItem& item);
+
+    CComPtr<IGlobalInterfaceTable> m_globalInterfaceTable;
+    DWORD m_dataObjectCookie = 0;
+    bool m_isStarted = false;
+    std::vector<Frame> m_frames;
+};
+
+// Enumerates paths and the contents of the folders among them with std::filesystem.
+// Does not need the shell so it can run headless, in tests and benchmarks.
+class CPowerRenameFileSystemEnumSource :
+    public CPowerRenameEnumSource
+{
+public:
+    explicit CPowerRenameFileSystemEnumSource(_In_ std::vector<std::filesystem::path> roots);
+
+    void Reset() override;
+    HRESULT NextBatch(_In_ UINT maxCount, _Inout_ std::vector<PowerRenameEnumItem>& items) override;
+
+private:
+    void _AddItem(_In_ const std::filesystem::path& path, _In_ bool isFolder, _In_ UINT depth, _Inout_ std::vector<PowerRenameEnumItem>& items);
+
+    std::vector<std::filesystem::path> m_roots;
+    size_t m_nextRoot = 0;
+    // Contents of the current root when it is a folder
+    std::filesystem::recursive_directory_iterator m_contents;
+};
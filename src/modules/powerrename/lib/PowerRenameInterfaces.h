@@ -49,6 +49,23 @@ public:
     IFACEMETHOD(PutFileTime)(_In_ SYSTEMTIME fileTime) = 0;
     IFACEMETHOD(ResetFileTime)() = 0;
     IFACEMETHOD(Replace)(_In_ PCWSTR source, _Outptr_ PWSTR* result) = 0;
+    // Same as Replace but expands the file time tokens with the given time instead of
+    // the one set through PutFileTime.  Safe to call from several threads at once.
+    IFACEMETHOD(ReplaceWithFileTime)(_In_ PCWSTR source, _In_ SYSTEMTIME fileTime, _Outptr_ PWSTR* result) = 0;
+};
+
+// Description of an item added with IPowerRenameManager::AddItemInfos.  The manager keeps
+// its own copy of the strings.
+struct PowerRenameItemInfo
+{
+    // Full path of the item, may be nullptr
+    PCWSTR path;
+    // nullptr when the name is the last component of the path
+    PCWSTR originalName;
+    UINT depth;
+    bool isFolder;
+    // False when the shell does not let the item be renamed
+    bool canRename;
 };
 
 interface __declspec(uuid("C7F59201-4DE1-4855-A3A2-26FC3279C8A5")) IPowerRenameItem : public IUnknown
@@ -79,11 +96,20 @@ public:
     IFACEMETHOD(Create)(_In_ IShellItem* psi, _COM_Outptr_ IPowerRenameItem** ppItem) = 0;
 };
 
+// Inclusive range of item indices
+struct PowerRenameItemRange
+{
+    UINT first;
+    UINT last;
+};
+
 interface __declspec(uuid("87FC43F9-7634-43D9-99A5-20876AFCE4AD")) IPowerRenameManagerEvents : public IUnknown
 {
 public:
     IFACEMETHOD(OnItemAdded)(_In_ IPowerRenameItem* renameItem) = 0;
-    IFACEMETHOD(OnUpdate)(_In_ IPowerRenameItem* renameItem) = 0;
+    // The items of the ranges, in index order, got a new name from the regex worker.  Raised
+    // once for all the items updated since the previous call.
+    IFACEMETHOD(OnItemsUpdated)(_In_reads_(rangeCount) const PowerRenameItemRange* ranges, _In_ UINT rangeCount) = 0;
     IFACEMETHOD(OnError)(_In_ IPowerRenameItem* renameItem) = 0;
     IFACEMETHOD(OnRegExStarted)(_In_ DWORD threadId) = 0;
     IFACEMETHOD(OnRegExCanceled)(_In_ DWORD threadId) = 0;
@@ -101,8 +127,20 @@ public:
     IFACEMETHOD(Stop)() = 0;
     IFACEMETHOD(Reset)() = 0;
     IFACEMETHOD(Shutdown)() = 0;
+    // Fails with E_PENDING while items are enumerated, see PutEnumerating
     IFACEMETHOD(Rename)(_In_ HWND hwndParent) = 0;
+    // Set by IPowerRenameEnum::StartAsync while it adds items from its worker thread
+    IFACEMETHOD(PutEnumerating)(_In_ bool isEnumerating) = 0;
     IFACEMETHOD(AddItem)(_In_ IPowerRenameItem* pItem) = 0;
+    // Adds the items in order under a single lock.  Items already added are skipped, S_FALSE
+    // is returned when there were any.
+    IFACEMETHOD(AddItems)(_In_reads_(count) IPowerRenameItem* const* items, _In_ UINT count) = 0;
+    // Adds the items in order under a single lock.  The IPowerRenameItem of an item added
+    // this way is only created when it is asked for, OnItemAdded is raised once with the
+    // last item of the batch.
+    IFACEMETHOD(AddItemInfos)(_In_reads_(count) const PowerRenameItemInfo* items, _In_ UINT count) = 0;
+    // Previews the items added since the last preview.  Does nothing when no item can get a new name.
+    IFACEMETHOD(UpdatePreview)() = 0;
     IFACEMETHOD(GetItemByIndex)(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem) = 0;
     IFACEMETHOD(GetVisibleItemByIndex)(_In_ UINT index, _COM_Outptr_ IPowerRenameItem ** ppItem) = 0;
     IFACEMETHOD(SetVisible)() = 0;
@@ -139,5 +177,9 @@ interface __declspec(uuid("CE8C8616-C1A8-457A-9601-10570F5B9F1F")) IPowerRenameE
 {
 public:
     IFACEMETHOD(Start)() = 0;
+    // Enumerates on a worker thread.  progressMsg is posted to hwndNotify, with the number of items
+    // added so far in wParam, every time the items added should be previewed.  completeMsg is posted
+    // once done with the number of items in wParam and the result in lParam.
+    IFACEMETHOD(StartAsync)(_In_ HWND hwndNotify, _In_ UINT progressMsg, _In_ UINT completeMsg) = 0;
     IFACEMETHOD(Cancel)() = 0;
 };
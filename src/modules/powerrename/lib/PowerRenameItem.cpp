@@ -1,8 +1,14 @@
 #include "pch.h"
 #include "PowerRenameItem.h"
+#include "Helpers.h"
 #include <common/themes/icon_helpers.h>
 
-int CPowerRenameItem::s_id = 0;
+long CPowerRenameItem::s_id = 0;
+
+int CPowerRenameItem::s_NextId()
+{
+    return InterlockedIncrement(&s_id);
+}
 
 IFACEMETHODIMP_(ULONG)
 CPowerRenameItem::AddRef()
@@ -55,25 +61,8 @@ IFACEMETHODIMP CPowerRenameItem::GetTime(_Outptr_ SYSTEMTIME* time)
     }
     else
     {
-        HANDLE hFile = CreateFileW(m_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
-        if (hFile != INVALID_HANDLE_VALUE)
-        {
-            FILETIME CreationTime;
-            if (GetFileTime(hFile, &CreationTime, NULL, NULL))
-            {
-                SYSTEMTIME SystemTime, LocalTime;
-                if (FileTimeToSystemTime(&CreationTime, &SystemTime))
-                {
-                    if (SystemTimeToTzSpecificLocalTime(NULL, &SystemTime, &LocalTime))
-                    {
-                        m_time = LocalTime;
-                        m_isTimeParsed = true;
-                        hr = S_OK;
-                    }
-                }
-            }
-        }
-        CloseHandle(hFile);
+        hr = GetFileCreationTime(m_path, &m_time);
+        m_isTimeParsed = SUCCEEDED(hr);
     }
     *time = m_time;
     return hr;
@@ -245,7 +234,7 @@ HRESULT CPowerRenameItem::s_CreateInstance(_In_opt_ IShellItem* psi, _In_ REFIID
 
 CPowerRenameItem::CPowerRenameItem() :
     m_refCount(1),
-    m_id(++s_id)
+    m_id(s_NextId())
 {
 }
 
@@ -40,9 +40,11 @@ public:
 
 public:
     static HRESULT s_CreateInstance(_In_opt_ IShellItem* psi, _In_ REFIID iid, _Outptr_ void** resultInterface);
+    // Ids are shared with the items of CPowerRenameItemStore
+    static int s_NextId();
 
 protected:
-    static int s_id;
+    static long s_id;
     CPowerRenameItem();
     virtual ~CPowerRenameItem();
 
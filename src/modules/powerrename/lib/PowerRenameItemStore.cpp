@@ -0,0 +1,595 @@
+#include "pch.h"
+#include "PowerRenameItemStore.h"
+#include "PowerRenameItem.h"
+#include "Helpers.h"
+#include <algorithm>
+#include <common/themes/icon_helpers.h>
+
+namespace
+{
+    // IPowerRenameItem over an item of a CPowerRenameItemStore.  Fails once the item was
+    // removed from the store.
+    class CPowerRenameStoreItem :
+        public IPowerRenameItem
+    {
+    public:
+        CPowerRenameStoreItem(_In_ std::shared_ptr<CPowerRenameItemStore> store, _In_ int id) :
+            m_store(std::move(store)),
+            m_id(id)
+        {
+        }
+
+        // IUnknown
+        IFACEMETHODIMP QueryInterface(_In_ REFIID riid, _Outptr_ void** ppv)
+        {
+            static const QITAB qit[] = {
+                QITABENT(CPowerRenameStoreItem, IPowerRenameItem),
+                { 0 }
+            };
+            return QISearch(this, qit, riid, ppv);
+        }
+
+        IFACEMETHODIMP_(ULONG) AddRef()
+        {
+            return InterlockedIncrement(&m_refCount);
+        }
+
+        IFACEMETHODIMP_(ULONG) Release()
+        {
+            long refCount = InterlockedDecrement(&m_refCount);
+            if (refCount == 0)
+            {
+                delete this;
+            }
+            return refCount;
+        }
+
+        // IPowerRenameItem
+        IFACEMETHODIMP GetPath(_Outptr_ PWSTR* path)
+        {
+            *path = nullptr;
+            std::wstring itemPath;
+            HRESULT hr = _GetPath(itemPath);
+            if (SUCCEEDED(hr))
+            {
+                hr = SHStrDup(itemPath.c_str(), path);
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP GetTime(_Outptr_ SYSTEMTIME* time)
+        {
+            return m_store->LoadTime(m_id, time);
+        }
+
+        IFACEMETHODIMP GetShellItem(_Outptr_ IShellItem** ppsi)
+        {
+            *ppsi = nullptr;
+            std::wstring itemPath;
+            HRESULT hr = _GetPath(itemPath);
+            if (SUCCEEDED(hr))
+            {
+                hr = SHCreateItemFromParsingName(itemPath.c_str(), nullptr, IID_PPV_ARGS(ppsi));
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP GetOriginalName(_Outptr_ PWSTR* originalName)
+        {
+            *originalName = nullptr;
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                hr = SHStrDup(std::wstring(m_store->GetOriginalName(index)).c_str(), originalName);
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP GetNewName(_Outptr_ PWSTR* newName)
+        {
+            *newName = nullptr;
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                PCWSTR itemNewName = m_store->GetNewName(index);
+                hr = itemNewName ? SHStrDup(itemNewName, newName) : S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP PutNewName(_In_opt_ PCWSTR newName)
+        {
+            CSRWExclusiveAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                m_store->SetNewName(index, newName);
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP GetIsFolder(_Out_ bool* isFolder)
+        {
+            *isFolder = false;
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                *isFolder = m_store->IsFolder(index);
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP GetIsSubFolderContent(_Out_ bool* isSubFolderContent)
+        {
+            *isSubFolderContent = false;
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                *isSubFolderContent = m_store->GetDepth(index) > 0;
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP GetSelected(_Out_ bool* selected)
+        {
+            *selected = false;
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                *selected = m_store->IsSelected(index);
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP PutSelected(_In_ bool selected)
+        {
+            CSRWExclusiveAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                m_store->SetSelected(index, selected);
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP GetId(_Out_ int* id)
+        {
+            *id = m_id;
+            return S_OK;
+        }
+
+        IFACEMETHODIMP GetIconIndex(_Out_ int* iconIndex)
+        {
+            return m_store->LoadIconIndex(m_id, iconIndex);
+        }
+
+        IFACEMETHODIMP GetDepth(_Out_ UINT* depth)
+        {
+            *depth = 0;
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                *depth = m_store->GetDepth(index);
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP PutDepth(_In_ int depth)
+        {
+            CSRWExclusiveAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                m_store->SetDepth(index, static_cast<UINT>(depth));
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP ShouldRenameItem(_In_ DWORD flags, _Out_ bool* shouldRename)
+        {
+            *shouldRename = false;
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                *shouldRename = m_store->ShouldRename(index, flags);
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP IsItemVisible(_In_ DWORD filter, _In_ DWORD flags, _Out_ bool* isItemVisible)
+        {
+            *isItemVisible = false;
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index))
+            {
+                *isItemVisible = m_store->IsVisibleForFilter(index, filter, flags);
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        IFACEMETHODIMP Reset()
+        {
+            return PutNewName(nullptr);
+        }
+
+    private:
+        virtual ~CPowerRenameStoreItem() = default;
+
+        HRESULT _GetPath(_Out_ std::wstring& path)
+        {
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT index = 0;
+            HRESULT hr = E_FAIL;
+            if (m_store->FindIndex(m_id, &index) && !m_store->GetPath(index).empty())
+            {
+                path = m_store->GetPath(index);
+                hr = S_OK;
+            }
+            return hr;
+        }
+
+        std::shared_ptr<CPowerRenameItemStore> m_store;
+        int m_id;
+        long m_refCount = 1;
+    };
+}
+
+int CPowerRenameItemStore::Add(_In_ const PowerRenameItemInfo& info)
+{
+    std::wstring_view path = info.path ? info.path : L"";
+    std::wstring_view originalName = info.originalName ? info.originalName : std::wstring_view(PathFindFileName(info.path ? info.path : L""));
+
+    BYTE itemFlags = static_cast<BYTE>(ItemFlagVisible | ItemFlagSelected |
+                                       (info.isFolder ? ItemFlagFolder : 0) |
+                                       (info.canRename ? ItemFlagCanRename : 0));
+
+    int id = CPowerRenameItem::s_NextId();
+    _Insert(id, path, originalName, info.depth, itemFlags);
+    return id;
+}
+
+bool CPowerRenameItemStore::Add(_In_ IPowerRenameItem* item)
+{
+    int id = 0;
+    item->GetId(&id);
+    UINT index = 0;
+    if (FindIndex(id, &index))
+    {
+        return false;
+    }
+
+    UINT depth = 0;
+    item->GetDepth(&depth);
+    bool isFolder = false;
+    item->GetIsFolder(&isFolder);
+    bool selected = true;
+    item->GetSelected(&selected);
+    CComHeapPtr<wchar_t> path;
+    item->GetPath(&path);
+    CComHeapPtr<wchar_t> originalName;
+    item->GetOriginalName(&originalName);
+
+    BYTE itemFlags = static_cast<BYTE>(ItemFlagVisible | ItemFlagCanRename |
+                                       (isFolder ? ItemFlagFolder : 0) |
+                                       (selected ? ItemFlagSelected : 0));
+    _Insert(id, path ? path.m_pData : L"", originalName ? originalName.m_pData : L"", depth, itemFlags);
+
+    // Items that already know their time (ex: set by the caller) keep it
+    SYSTEMTIME time = { 0 };
+    if (SUCCEEDED(item->GetTime(&time)))
+    {
+        m_times[id] = time;
+    }
+    return true;
+}
+
+void CPowerRenameItemStore::Clear()
+{
+    m_ids.clear();
+    m_depths.clear();
+    m_itemFlags.clear();
+    m_textOffsets.clear();
+    m_pathLengths.clear();
+    m_nameOffsets.clear();
+    m_nameLengths.clear();
+    m_newNameSlots.clear();
+    m_text.clear();
+    m_newNames.clear();
+    m_freeNewNameSlots.clear();
+    m_times.clear();
+    m_iconIndices.clear();
+    m_selectionVersion++;
+    m_visiblePrefix.clear();
+    m_visiblePrefixValid = false;
+}
+
+bool CPowerRenameItemStore::FindIndex(_In_ int id, _Out_ UINT* index) const
+{
+    *index = 0;
+    auto it = std::lower_bound(m_ids.begin(), m_ids.end(), id);
+    if (it == m_ids.end() || *it != id)
+    {
+        return false;
+    }
+
+    *index = static_cast<UINT>(it - m_ids.begin());
+    return true;
+}
+
+HRESULT CPowerRenameItemStore::GetItem(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** item)
+{
+    *item = nullptr;
+    if (index >= m_ids.size())
+    {
+        return E_FAIL;
+    }
+
+    *item = new (std::nothrow) CPowerRenameStoreItem(shared_from_this(), m_ids[index]);
+    return *item ? S_OK : E_OUTOFMEMORY;
+}
+
+std::wstring_view CPowerRenameItemStore::GetPath(_In_ UINT index) const
+{
+    return std::wstring_view(m_text.data() + m_textOffsets[index], m_pathLengths[index]);
+}
+
+std::wstring_view CPowerRenameItemStore::GetOriginalName(_In_ UINT index) const
+{
+    return std::wstring_view(m_text.data() + m_textOffsets[index] + m_nameOffsets[index], m_nameLengths[index]);
+}
+
+PCWSTR CPowerRenameItemStore::GetNewName(_In_ UINT index) const
+{
+    const UINT slot = m_newNameSlots[index];
+    return (slot != NoNewName) ? m_newNames[slot].c_str() : nullptr;
+}
+
+bool CPowerRenameItemStore::SetNewName(_In_ UINT index, _In_opt_ PCWSTR newName)
+{
+    UINT& slot = m_newNameSlots[index];
+    if (newName == nullptr)
+    {
+        if (slot == NoNewName)
+        {
+            return false;
+        }
+
+        // Keep the buffer for the next new name
+        m_newNames[slot].clear();
+        m_freeNewNameSlots.push_back(slot);
+        slot = NoNewName;
+        return true;
+    }
+
+    if (slot != NoNewName)
+    {
+        if (m_newNames[slot] == newName)
+        {
+            return false;
+        }
+    }
+    else if (!m_freeNewNameSlots.empty())
+    {
+        slot = m_freeNewNameSlots.back();
+        m_freeNewNameSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<UINT>(m_newNames.size());
+        m_newNames.emplace_back();
+    }
+
+    m_newNames[slot] = newName;
+    return true;
+}
+
+void CPowerRenameItemStore::SetSelected(_In_ UINT index, _In_ bool selected)
+{
+    if (IsSelected(index) != selected)
+    {
+        m_itemFlags[index] = static_cast<BYTE>(m_itemFlags[index] ^ ItemFlagSelected);
+        m_selectionVersion++;
+    }
+}
+
+HRESULT CPowerRenameItemStore::LoadTime(_In_ int id, _Out_ SYSTEMTIME* time)
+{
+    *time = { 0 };
+    std::wstring path;
+    {
+        CSRWSharedAutoLock lock(&m_lock);
+        UINT index = 0;
+        if (!FindIndex(id, &index))
+        {
+            return E_FAIL;
+        }
+
+        auto it = m_times.find(id);
+        if (it != m_times.end())
+        {
+            *time = it->second;
+            return S_OK;
+        }
+        path = GetPath(index);
+    }
+
+    // Read the file without holding the lock, the preview workers ask for the times of many items at once
+    HRESULT hr = GetFileCreationTime(path.c_str(), time);
+    if (SUCCEEDED(hr))
+    {
+        CSRWExclusiveAutoLock lock(&m_lock);
+        m_times[id] = *time;
+    }
+    return hr;
+}
+
+HRESULT CPowerRenameItemStore::LoadIconIndex(_In_ int id, _Out_ int* iconIndex)
+{
+    *iconIndex = -1;
+    std::wstring path;
+    {
+        CSRWSharedAutoLock lock(&m_lock);
+        UINT index = 0;
+        if (!FindIndex(id, &index))
+        {
+            return E_FAIL;
+        }
+
+        auto it = m_iconIndices.find(id);
+        if (it != m_iconIndices.end())
+        {
+            *iconIndex = it->second;
+            return S_OK;
+        }
+        path = GetPath(index);
+    }
+
+    GetIconIndexFromPath(path.c_str(), iconIndex);
+
+    CSRWExclusiveAutoLock lock(&m_lock);
+    m_iconIndices[id] = *iconIndex;
+    return S_OK;
+}
+
+bool CPowerRenameItemStore::ShouldRename(_In_ UINT index, _In_ DWORD flags) const
+{
+    // Should we perform a rename on this item given its
+    // state and the options that were set?
+    PCWSTR newName = GetNewName(index);
+    bool hasChanged = newName != nullptr && GetOriginalName(index) != newName;
+    bool isFolder = IsFolder(index);
+    bool excludeBecauseFolder = (isFolder && (flags & PowerRenameFlags::ExcludeFolders));
+    bool excludeBecauseFile = (!isFolder && (flags & PowerRenameFlags::ExcludeFiles));
+    bool excludeBecauseSubFolderContent = (m_depths[index] > 0 && (flags & PowerRenameFlags::ExcludeSubfolders));
+    bool canRename = (m_itemFlags[index] & ItemFlagCanRename) != 0;
+    return IsSelected(index) && canRename && hasChanged && !excludeBecauseFile &&
+           !excludeBecauseFolder && !excludeBecauseSubFolderContent;
+}
+
+bool CPowerRenameItemStore::IsVisibleForFilter(_In_ UINT index, _In_ DWORD filter, _In_ DWORD flags) const
+{
+    bool isItemVisible = false;
+    switch (filter)
+    {
+    case PowerRenameFilters::None:
+        isItemVisible = true;
+        break;
+    case PowerRenameFilters::Selected:
+        isItemVisible = IsSelected(index);
+        break;
+    case PowerRenameFilters::FlagsApplicable:
+        isItemVisible = !((IsFolder(index) && (flags & PowerRenameFlags::ExcludeFolders)) ||
+                          (!IsFolder(index) && (flags & PowerRenameFlags::ExcludeFiles)) ||
+                          (m_depths[index] > 0 && (flags & PowerRenameFlags::ExcludeSubfolders)));
+        break;
+    case PowerRenameFilters::ShouldRename:
+        isItemVisible = ShouldRename(index, flags);
+        break;
+    }
+    return isItemVisible;
+}
+
+void CPowerRenameItemStore::SetVisible(_In_ UINT index, _In_ bool visible)
+{
+    if (IsVisible(index) != visible)
+    {
+        m_itemFlags[index] = static_cast<BYTE>(m_itemFlags[index] ^ ItemFlagVisible);
+        m_visiblePrefixValid = false;
+    }
+}
+
+UINT CPowerRenameItemStore::GetVisibleCount()
+{
+    _UpdateVisiblePrefix();
+    return m_visiblePrefix.back();
+}
+
+bool CPowerRenameItemStore::GetVisibleItemIndex(_In_ UINT visibleIndex, _Out_ UINT* index)
+{
+    *index = 0;
+    _UpdateVisiblePrefix();
+    if (visibleIndex >= m_visiblePrefix.back())
+    {
+        return false;
+    }
+
+    // The first index with more than visibleIndex visible items up to and including it
+    auto it = std::upper_bound(m_visiblePrefix.begin() + 1, m_visiblePrefix.end(), visibleIndex);
+    *index = static_cast<UINT>(it - (m_visiblePrefix.begin() + 1));
+    return true;
+}
+
+void CPowerRenameItemStore::_Insert(_In_ int id, _In_ std::wstring_view path, _In_ std::wstring_view originalName, _In_ UINT depth, _In_ BYTE itemFlags)
+{
+    // Items are almost always added in id order so appending is the common case
+    size_t position = m_ids.size();
+    if (!m_ids.empty() && id < m_ids.back())
+    {
+        position = std::lower_bound(m_ids.begin(), m_ids.end(), id) - m_ids.begin();
+    }
+
+    // Only keep the original name apart when it is not the end of the path
+    const UINT textOffset = static_cast<UINT>(m_text.size());
+    m_text.append(path);
+    size_t nameOffset = path.size() - originalName.size();
+    if (originalName.size() > path.size() || path.substr(nameOffset) != originalName)
+    {
+        nameOffset = path.size();
+        m_text.append(originalName);
+    }
+
+    m_ids.insert(m_ids.begin() + position, id);
+    m_depths.insert(m_depths.begin() + position, static_cast<USHORT>(depth));
+    m_itemFlags.insert(m_itemFlags.begin() + position, itemFlags);
+    m_textOffsets.insert(m_textOffsets.begin() + position, textOffset);
+    m_pathLengths.insert(m_pathLengths.begin() + position, static_cast<USHORT>(path.size()));
+    m_nameOffsets.insert(m_nameOffsets.begin() + position, static_cast<USHORT>(nameOffset));
+    m_nameLengths.insert(m_nameLengths.begin() + position, static_cast<USHORT>(originalName.size()));
+    m_newNameSlots.insert(m_newNameSlots.begin() + position, NoNewName);
+
+    m_visiblePrefixValid = false;
+}
+
+void CPowerRenameItemStore::_UpdateVisiblePrefix()
+{
+    if (m_visiblePrefixValid)
+    {
+        return;
+    }
+
+    m_visiblePrefix.resize(m_ids.size() + 1);
+    m_visiblePrefix[0] = 0;
+    for (size_t i = 0; i < m_ids.size(); i++)
+    {
+        m_visiblePrefix[i + 1] = m_visiblePrefix[i] + ((m_itemFlags[i] & ItemFlagVisible) ? 1 : 0);
+    }
+    m_visiblePrefixValid = true;
+}
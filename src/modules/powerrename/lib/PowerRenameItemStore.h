@@ -0,0 +1,112 @@
+#pragma once
+#include "pch.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "PowerRenameInterfaces.h"
+#include "srwlock.h"
+
+// Contiguous storage for the rename items of the manager, kept in id order.  Items are
+// plain data: every property is held in its own column so that counting, filtering and
+// depth ordering only walk plain arrays, the path and original name of all the items
+// share a single string buffer and new names are kept in slots reused between previews.
+// The IPowerRenameItem of an item is only created when it is asked for, by GetItem, and
+// reads and writes the store.  Items are addressed by index in O(1), by id in O(log n)
+// and by visible index in O(log n) through a prefix sum over the visibility column.
+// Not thread safe, hold GetLock() around the calls.  The items created by GetItem and
+// LoadTime take the lock themselves.
+class CPowerRenameItemStore :
+    public std::enable_shared_from_this<CPowerRenameItemStore>
+{
+public:
+    // Adds the item with a new id and returns the id
+    int Add(_In_ const PowerRenameItemInfo& info);
+    // Adds a copy of the properties of the item at its id position, the item itself is not
+    // kept.  Returns false if an item with the same id was already added.
+    bool Add(_In_ IPowerRenameItem* item);
+    void Clear();
+
+    CSRWLock* GetLock() const { return &m_lock; }
+
+    UINT GetCount() const { return static_cast<UINT>(m_ids.size()); }
+    bool FindIndex(_In_ int id, _Out_ UINT* index) const;
+
+    // Creates the IPowerRenameItem of the item.  Fails when index is out of range.
+    HRESULT GetItem(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** item);
+
+    int GetId(_In_ UINT index) const { return m_ids[index]; }
+    UINT GetDepth(_In_ UINT index) const { return m_depths[index]; }
+    void SetDepth(_In_ UINT index, _In_ UINT depth) { m_depths[index] = static_cast<USHORT>(depth); }
+    bool IsFolder(_In_ UINT index) const { return (m_itemFlags[index] & ItemFlagFolder) != 0; }
+    std::wstring_view GetPath(_In_ UINT index) const;
+    std::wstring_view GetOriginalName(_In_ UINT index) const;
+
+    // nullptr when the item has no new name
+    PCWSTR GetNewName(_In_ UINT index) const;
+    // nullptr clears the new name.  Returns true when the new name changed.
+    bool SetNewName(_In_ UINT index, _In_opt_ PCWSTR newName);
+
+    bool IsSelected(_In_ UINT index) const { return (m_itemFlags[index] & ItemFlagSelected) != 0; }
+    void SetSelected(_In_ UINT index, _In_ bool selected);
+    // Changes every time an item is selected or unselected
+    UINT GetSelectionVersion() const { return m_selectionVersion; }
+
+    // Reads the creation time of the file the first time it is asked for
+    HRESULT LoadTime(_In_ int id, _Out_ SYSTEMTIME* time);
+    HRESULT LoadIconIndex(_In_ int id, _Out_ int* iconIndex);
+
+    // Same as CPowerRenameItem::ShouldRenameItem and CPowerRenameItem::IsItemVisible
+    bool ShouldRename(_In_ UINT index, _In_ DWORD flags) const;
+    bool IsVisibleForFilter(_In_ UINT index, _In_ DWORD filter, _In_ DWORD flags) const;
+
+    bool IsVisible(_In_ UINT index) const { return (m_itemFlags[index] & ItemFlagVisible) != 0; }
+    void SetVisible(_In_ UINT index, _In_ bool visible);
+    UINT GetVisibleCount();
+    // Maps the index of a visible item to its index in the store
+    bool GetVisibleItemIndex(_In_ UINT visibleIndex, _Out_ UINT* index);
+
+private:
+    enum ItemFlags : BYTE
+    {
+        ItemFlagFolder = 0x1,
+        ItemFlagVisible = 0x2,
+        ItemFlagSelected = 0x4,
+        ItemFlagCanRename = 0x8,
+    };
+
+    static const UINT NoNewName = UINT_MAX;
+
+    void _Insert(_In_ int id, _In_ std::wstring_view path, _In_ std::wstring_view originalName, _In_ UINT depth, _In_ BYTE itemFlags);
+    void _UpdateVisiblePrefix();
+
+    mutable CSRWLock m_lock;
+
+    std::vector<int> m_ids;
+    std::vector<USHORT> m_depths;
+    std::vector<BYTE> m_itemFlags;
+    // Path of the item in m_text.  The original name is the end of the path, or follows it
+    // when it is not.
+    std::vector<UINT> m_textOffsets;
+    std::vector<USHORT> m_pathLengths;
+    std::vector<USHORT> m_nameOffsets;
+    std::vector<USHORT> m_nameLengths;
+    // Index in m_newNames, NoNewName when the item has no new name
+    std::vector<UINT> m_newNameSlots;
+
+    std::wstring m_text;
+    std::vector<std::wstring> m_newNames;
+    std::vector<UINT> m_freeNewNameSlots;
+
+    // Only for the items they were asked for, by id
+    std::unordered_map<int, SYSTEMTIME> m_times;
+    std::unordered_map<int, int> m_iconIndices;
+
+    UINT m_selectionVersion = 0;
+
+    // m_visiblePrefix[i] is the number of visible items before index i, rebuilt on demand
+    std::vector<UINT> m_visiblePrefix;
+    bool m_visiblePrefixValid = false;
+};
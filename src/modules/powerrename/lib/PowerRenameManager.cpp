@@ -1,7 +1,10 @@
 #include "pch.h"
 #include "PowerRenameManager.h"
 #include "PowerRenameRegEx.h" // Default RegEx handler
+#include "PowerRenamePlanner.h"
 #include <algorithm>
+#include <map>
+#include <unordered_map>
 #include <shlobj.h>
 #include <cstring>
 #include "helpers.h"
@@ -16,6 +19,165 @@ extern HINSTANCE g_hInst;
 // The default FOF flags to use in the rename operations
 #define FOF_DEFAULTFLAGS (FOF_ALLOWUNDO | FOFX_ADDUNDORECORD | FOFX_SHOWELEVATIONPROMPT | FOF_RENAMEONCOLLISION)
 
+namespace
+{
+    // Items previewed by the regex worker: the items of the store with the ids taken when the preview started
+    class CStoreItems :
+        public CPowerRenamePreviewEngine::Items
+    {
+    public:
+        explicit CStoreItems(_In_ std::shared_ptr<CPowerRenameItemStore> store) :
+            m_store(std::move(store))
+        {
+        }
+
+        size_t GetCount() const override
+        {
+            return ids.size();
+        }
+
+        HRESULT GetId(_In_ size_t index, _Out_ int* id) override
+        {
+            *id = ids[index];
+            return S_OK;
+        }
+
+        HRESULT GetInfo(_In_ size_t index, _Out_ bool* isFolder, _Out_ bool* isSubFolderContent, _Out_ std::wstring& originalName) override
+        {
+            CSRWSharedAutoLock lock(m_store->GetLock());
+            UINT storeIndex = 0;
+            if (!m_store->FindIndex(ids[index], &storeIndex))
+            {
+                return E_FAIL;
+            }
+
+            *isFolder = m_store->IsFolder(storeIndex);
+            *isSubFolderContent = m_store->GetDepth(storeIndex) > 0;
+            originalName = m_store->GetOriginalName(storeIndex);
+            return S_OK;
+        }
+
+        HRESULT GetTime(_In_ size_t index, _Out_ SYSTEMTIME* time) override
+        {
+            return m_store->LoadTime(ids[index], time);
+        }
+
+        HRESULT PutNewName(_In_ size_t index, _In_opt_ PCWSTR newName, _Out_ bool* changed) override
+        {
+            *changed = false;
+            CSRWExclusiveAutoLock lock(m_store->GetLock());
+            UINT storeIndex = 0;
+            if (!m_store->FindIndex(ids[index], &storeIndex))
+            {
+                return E_FAIL;
+            }
+
+            *changed = m_store->SetNewName(storeIndex, newName);
+            return S_OK;
+        }
+
+        std::vector<int> ids;
+
+    private:
+        std::shared_ptr<CPowerRenameItemStore> m_store;
+    };
+
+    // Keeps the items the file operation renamed to a temporary name.  The item at the temporary
+    // name is the one the file operation reports, not one looked up by name later, and there
+    // is none when the rename failed or was canceled.
+    class CTemporaryRenameSink :
+        public IFileOperationProgressSink
+    {
+    public:
+        explicit CTemporaryRenameSink(_In_ UINT itemCount) :
+            m_temporaryItems(itemCount)
+        {
+        }
+
+        // IUnknown
+        IFACEMETHODIMP QueryInterface(_In_ REFIID riid, _Outptr_ void** ppv)
+        {
+            static const QITAB qit[] = {
+                QITABENT(CTemporaryRenameSink, IFileOperationProgressSink),
+                { 0 }
+            };
+            return QISearch(this, qit, riid, ppv);
+        }
+
+        IFACEMETHODIMP_(ULONG) AddRef()
+        {
+            return InterlockedIncrement(&m_refCount);
+        }
+
+        IFACEMETHODIMP_(ULONG) Release()
+        {
+            long refCount = InterlockedDecrement(&m_refCount);
+            if (refCount == 0)
+            {
+                delete this;
+            }
+            return refCount;
+        }
+
+        // IFileOperationProgressSink
+        IFACEMETHODIMP StartOperations() { return S_OK; }
+        IFACEMETHODIMP FinishOperations(_In_ HRESULT) { return S_OK; }
+        IFACEMETHODIMP PreRenameItem(_In_ DWORD, _In_ IShellItem*, _In_opt_ PCWSTR) { return S_OK; }
+
+        IFACEMETHODIMP PostRenameItem(_In_ DWORD, _In_ IShellItem*, _In_opt_ PCWSTR newName, _In_ HRESULT hrRename, _In_opt_ IShellItem* newlyCreated)
+        {
+            if (SUCCEEDED(hrRename) && newName && newlyCreated)
+            {
+                auto it = m_pendingNames.find(newName);
+                if (it != m_pendingNames.end())
+                {
+                    m_temporaryItems[it->second] = newlyCreated;
+                    m_pendingNames.erase(it);
+                }
+            }
+            return S_OK;
+        }
+
+        IFACEMETHODIMP PreMoveItem(_In_ DWORD, _In_ IShellItem*, _In_ IShellItem*, _In_opt_ PCWSTR) { return S_OK; }
+        IFACEMETHODIMP PostMoveItem(_In_ DWORD, _In_ IShellItem*, _In_ IShellItem*, _In_opt_ PCWSTR, _In_ HRESULT, _In_opt_ IShellItem*) { return S_OK; }
+        IFACEMETHODIMP PreCopyItem(_In_ DWORD, _In_ IShellItem*, _In_ IShellItem*, _In_opt_ PCWSTR) { return S_OK; }
+        IFACEMETHODIMP PostCopyItem(_In_ DWORD, _In_ IShellItem*, _In_ IShellItem*, _In_opt_ PCWSTR, _In_ HRESULT, _In_opt_ IShellItem*) { return S_OK; }
+        IFACEMETHODIMP PreDeleteItem(_In_ DWORD, _In_ IShellItem*) { return S_OK; }
+        IFACEMETHODIMP PostDeleteItem(_In_ DWORD, _In_ IShellItem*, _In_ HRESULT, _In_opt_ IShellItem*) { return S_OK; }
+        IFACEMETHODIMP PreNewItem(_In_ DWORD, _In_ IShellItem*, _In_opt_ PCWSTR) { return S_OK; }
+        IFACEMETHODIMP PostNewItem(_In_ DWORD, _In_ IShellItem*, _In_opt_ PCWSTR, _In_opt_ PCWSTR, _In_ DWORD, _In_ HRESULT, _In_opt_ IShellItem*) { return S_OK; }
+        IFACEMETHODIMP UpdateProgress(_In_ UINT, _In_ UINT) { return S_OK; }
+        IFACEMETHODIMP ResetTimer() { return S_OK; }
+        IFACEMETHODIMP PauseTimer() { return S_OK; }
+        IFACEMETHODIMP ResumeTimer() { return S_OK; }
+
+        // Temporary names are unique within a plan
+        void AddTemporaryName(_In_ const std::wstring& temporaryName, _In_ UINT item)
+        {
+            m_pendingNames[temporaryName] = item;
+        }
+
+        // Fails when the item was not renamed to its temporary name
+        HRESULT GetTemporaryItem(_In_ UINT item, _COM_Outptr_ IShellItem** shellItem)
+        {
+            *shellItem = m_temporaryItems[item];
+            if (!*shellItem)
+            {
+                return E_FAIL;
+            }
+            (*shellItem)->AddRef();
+            return S_OK;
+        }
+
+    private:
+        ~CTemporaryRenameSink() = default;
+
+        long m_refCount = 1;
+        std::unordered_map<std::wstring, UINT> m_pendingNames;
+        std::vector<CComPtr<IShellItem>> m_temporaryItems;
+    };
+}
+
 IFACEMETHODIMP_(ULONG)
 CPowerRenameManager::AddRef()
 {
@@ -94,10 +256,21 @@ IFACEMETHODIMP CPowerRenameManager::Stop()
 
 IFACEMETHODIMP CPowerRenameManager::Rename(_In_ HWND hwndParent)
 {
+    if (m_isEnumerating)
+    {
+        return E_PENDING;
+    }
+
     m_hwndParent = hwndParent;
     return _PerformFileOperation();
 }
 
+IFACEMETHODIMP CPowerRenameManager::PutEnumerating(_In_ bool isEnumerating)
+{
+    m_isEnumerating = isEnumerating;
+    return S_OK;
+}
+
 IFACEMETHODIMP CPowerRenameManager::Reset()
 {
     // Stop all threads and wait
@@ -114,74 +287,122 @@ IFACEMETHODIMP CPowerRenameManager::Shutdown()
 
 IFACEMETHODIMP CPowerRenameManager::AddItem(_In_ IPowerRenameItem* pItem)
 {
-    HRESULT hr = E_FAIL;
+    HRESULT hr = AddItems(&pItem, 1);
+    // The item was already added
+    return (hr == S_FALSE) ? E_FAIL : hr;
+}
+
+IFACEMETHODIMP CPowerRenameManager::AddItems(_In_reads_(count) IPowerRenameItem* const* items, _In_ UINT count)
+{
+    // Items that were not already added
+    std::vector<IPowerRenameItem*> addedItems;
+    addedItems.reserve(count);
     // Scope lock
     {
-        CSRWExclusiveAutoLock lock(&m_lockItems);
-        int id = 0;
-        pItem->GetId(&id);
-        // Verify the item isn't already added
-        if (m_renameItems.find(id) == m_renameItems.end())
+        CSRWExclusiveAutoLock lock(m_renameItems->GetLock());
+        for (UINT i = 0; i < count; i++)
         {
-            m_renameItems[id] = pItem;
-            m_isVisible.push_back(true);
-            pItem->AddRef();
-            hr = S_OK;
+            if (m_renameItems->Add(items[i]))
+            {
+                addedItems.push_back(items[i]);
+            }
+        }
+
+        if (!addedItems.empty())
+        {
+            m_isVisibleValid = false;
         }
     }
 
-    if (SUCCEEDED(hr))
+    for (auto item : addedItems)
     {
-        _OnItemAdded(pItem);
+        _OnItemAdded(item);
     }
 
-    return hr;
+    return (addedItems.size() == count) ? S_OK : S_FALSE;
 }
 
-IFACEMETHODIMP CPowerRenameManager::GetItemByIndex(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem)
+IFACEMETHODIMP CPowerRenameManager::AddItemInfos(_In_reads_(count) const PowerRenameItemInfo* items, _In_ UINT count)
 {
-    *ppItem = nullptr;
-    CSRWSharedAutoLock lock(&m_lockItems);
-    HRESULT hr = E_FAIL;
-    if (index < m_renameItems.size())
+    if (count == 0)
     {
-        std::map<int, IPowerRenameItem*>::iterator it = m_renameItems.begin();
-        std::advance(it, index);
-        *ppItem = it->second;
-        (*ppItem)->AddRef();
-        hr = S_OK;
+        return S_OK;
+    }
+
+    CComPtr<IPowerRenameItem> spLastItem;
+    // Scope lock
+    {
+        CSRWExclusiveAutoLock lock(m_renameItems->GetLock());
+        int lastId = 0;
+        for (UINT i = 0; i < count; i++)
+        {
+            lastId = m_renameItems->Add(items[i]);
+        }
+        m_isVisibleValid = false;
+
+        UINT lastIndex = 0;
+        if (m_renameItems->FindIndex(lastId, &lastIndex))
+        {
+            m_renameItems->GetItem(lastIndex, &spLastItem);
+        }
+    }
+
+    // Only the last item of the batch is reported so that no item object is created for the others
+    if (spLastItem)
+    {
+        _OnItemAdded(spLastItem);
+    }
+
+    return S_OK;
+}
+
+IFACEMETHODIMP CPowerRenameManager::UpdatePreview()
+{
+    if (!m_spRegEx)
+    {
+        return S_OK;
     }
 
+    // Without a search term or a case transform no item gets a new name
+    CComHeapPtr<wchar_t> searchTerm;
+    HRESULT hr = m_spRegEx->GetSearchTerm(&searchTerm);
+    if (SUCCEEDED(hr) && ((searchTerm && searchTerm[0] != L'\0') || (m_flags & (Uppercase | Lowercase | Titlecase | Capitalized))))
+    {
+        hr = _PerformRegExRename();
+    }
     return hr;
 }
 
+IFACEMETHODIMP CPowerRenameManager::GetItemByIndex(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem)
+{
+    CSRWSharedAutoLock lock(m_renameItems->GetLock());
+    return m_renameItems->GetItem(index, ppItem);
+}
+
 IFACEMETHODIMP CPowerRenameManager::GetVisibleItemByIndex(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem)
 {
     *ppItem = nullptr;
-    CSRWSharedAutoLock lock(&m_lockItems);
-    UINT count = 0;
     HRESULT hr = E_FAIL;
 
     if (m_filter == PowerRenameFilters::None)
     {
         hr = GetItemByIndex(index, ppItem);
     }
-    else if (SUCCEEDED(GetVisibleItemCount(&count)) && index < count)
+    else
     {
-        UINT realIndex = 0, visibleIndex = 0;
-        for (size_t i = 0; i < m_isVisible.size(); i++)
+        // The list view asks for every painted row so only compute the visibility when it changed
+        if (!_IsVisibilityValid())
         {
-            if (m_isVisible[i] && visibleIndex == index)
-            {
-                realIndex = static_cast<UINT>(i);
-                break;
-            }
-            if (m_isVisible[i])
-            {
-                visibleIndex++;
-            }
+            SetVisible();
+        }
+
+        // Looking up a visible index may rebuild the visible prefix of the store
+        CSRWExclusiveAutoLock lock(m_renameItems->GetLock());
+        UINT realIndex = 0;
+        if (m_renameItems->GetVisibleItemIndex(index, &realIndex))
+        {
+            hr = m_renameItems->GetItem(realIndex, ppItem);
         }
-        hr = GetItemByIndex(realIndex, ppItem);
     }
 
     return hr;
@@ -191,15 +412,12 @@ IFACEMETHODIMP CPowerRenameManager::GetItemById(_In_ int id, _COM_Outptr_ IPower
 {
     *ppItem = nullptr;
 
-    CSRWSharedAutoLock lock(&m_lockItems);
+    CSRWSharedAutoLock lock(m_renameItems->GetLock());
     HRESULT hr = E_FAIL;
-    std::map<int, IPowerRenameItem*>::iterator it;
-    it = m_renameItems.find(id);
-    if (it != m_renameItems.end())
+    UINT index = 0;
+    if (m_renameItems->FindIndex(id, &index))
     {
-        *ppItem = m_renameItems[id];
-        (*ppItem)->AddRef();
-        hr = S_OK;
+        hr = m_renameItems->GetItem(index, ppItem);
     }
 
     return hr;
@@ -207,33 +425,30 @@ IFACEMETHODIMP CPowerRenameManager::GetItemById(_In_ int id, _COM_Outptr_ IPower
 
 IFACEMETHODIMP CPowerRenameManager::GetItemCount(_Out_ UINT* count)
 {
-    CSRWSharedAutoLock lock(&m_lockItems);
-    *count = static_cast<UINT>(m_renameItems.size());
+    CSRWSharedAutoLock lock(m_renameItems->GetLock());
+    *count = m_renameItems->GetCount();
     return S_OK;
 }
 
 IFACEMETHODIMP CPowerRenameManager::SetVisible()
 {
-    CSRWSharedAutoLock lock(&m_lockItems);
+    CSRWExclusiveAutoLock lock(m_renameItems->GetLock());
     HRESULT hr = E_FAIL;
+
+    // Every item is visible in the ShouldRename view while there is no search term
+    bool showAll = false;
+    if (m_filter == PowerRenameFilters::ShouldRename)
+    {
+        CComHeapPtr<wchar_t> searchTerm;
+        showAll = FAILED(m_spRegEx->GetSearchTerm(&searchTerm)) || (searchTerm && wcslen(searchTerm) == 0);
+    }
+
     UINT lastVisibleDepth = 0;
-    size_t i = m_isVisible.size() - 1;
-    PWSTR searchTerm = nullptr;
-    for (auto rit = m_renameItems.rbegin(); rit != m_renameItems.rend(); ++rit, --i)
+    for (UINT i = m_renameItems->GetCount(); i-- > 0;)
     {
-        bool isVisible = false;
-        if (m_filter == PowerRenameFilters::ShouldRename &&
-            (FAILED(m_spRegEx->GetSearchTerm(&searchTerm)) || searchTerm && wcslen(searchTerm) == 0))
-        {
-            isVisible = true;
-        }
-        else
-        {
-            rit->second->IsItemVisible(m_filter, m_flags, &isVisible);
-        }
+        bool isVisible = showAll || m_renameItems->IsVisibleForFilter(i, m_filter, m_flags);
 
-        UINT itemDepth = 0;
-        rit->second->GetDepth(&itemDepth);
+        UINT itemDepth = m_renameItems->GetDepth(i);
 
         //Make an item visible if it has a least one visible subitem
         if (isVisible)
@@ -246,29 +461,28 @@ IFACEMETHODIMP CPowerRenameManager::SetVisible()
             lastVisibleDepth = itemDepth;
         }
 
-        m_isVisible[i] = isVisible;
+        m_renameItems->SetVisible(i, isVisible);
         hr = S_OK;
     }
 
+    m_isVisibleValid = true;
+    m_visibleSelectionVersion = m_renameItems->GetSelectionVersion();
     return hr;
 }
 
 IFACEMETHODIMP CPowerRenameManager::GetVisibleItemCount(_Out_ UINT* count)
 {
     *count = 0;
-    CSRWSharedAutoLock lock(&m_lockItems);
 
     if (m_filter != PowerRenameFilters::None)
     {
-        SetVisible();
-
-        for (size_t i = 0; i < m_isVisible.size(); i++)
+        if (!_IsVisibilityValid())
         {
-            if (m_isVisible[i])
-            {
-                (*count)++;
-            }
+            SetVisible();
         }
+
+        CSRWExclusiveAutoLock lock(m_renameItems->GetLock());
+        *count = m_renameItems->GetVisibleCount();
     }
     else
     {
@@ -281,13 +495,11 @@ IFACEMETHODIMP CPowerRenameManager::GetVisibleItemCount(_Out_ UINT* count)
 IFACEMETHODIMP CPowerRenameManager::GetSelectedItemCount(_Out_ UINT* count)
 {
     *count = 0;
-    CSRWSharedAutoLock lock(&m_lockItems);
+    CSRWSharedAutoLock lock(m_renameItems->GetLock());
 
-    for (auto it : m_renameItems)
+    for (UINT i = 0; i < m_renameItems->GetCount(); i++)
     {
-        IPowerRenameItem* pItem = it.second;
-        bool selected = false;
-        if (SUCCEEDED(pItem->GetSelected(&selected)) && selected)
+        if (m_renameItems->IsSelected(i))
         {
             (*count)++;
         }
@@ -299,13 +511,11 @@ IFACEMETHODIMP CPowerRenameManager::GetSelectedItemCount(_Out_ UINT* count)
 IFACEMETHODIMP CPowerRenameManager::GetRenameItemCount(_Out_ UINT* count)
 {
     *count = 0;
-    CSRWSharedAutoLock lock(&m_lockItems);
+    CSRWSharedAutoLock lock(m_renameItems->GetLock());
 
-    for (auto it : m_renameItems)
+    for (UINT i = 0; i < m_renameItems->GetCount(); i++)
     {
-        IPowerRenameItem* pItem = it.second;
-        bool shouldRename = false;
-        if (SUCCEEDED(pItem->ShouldRenameItem(m_flags, &shouldRename)) && shouldRename)
+        if (m_renameItems->ShouldRename(i, m_flags))
         {
             (*count)++;
         }
@@ -326,6 +536,7 @@ IFACEMETHODIMP CPowerRenameManager::PutFlags(_In_ DWORD flags)
     if (flags != m_flags)
     {
         m_flags = flags;
+        _InvalidateVisibility();
         _EnsureRegEx();
         m_spRegEx->PutFlags(flags);
     }
@@ -356,6 +567,8 @@ IFACEMETHODIMP CPowerRenameManager::SwitchFilter(_In_ int columnNumber)
         break;
     }
 
+    _InvalidateVisibility();
+
     return S_OK;
 }
 
@@ -413,6 +626,7 @@ IFACEMETHODIMP CPowerRenameManager::OnFlagsChanged(_In_ DWORD flags)
 {
     // Flags were updated in the rename regex.  Update our preview.
     m_flags = flags;
+    _InvalidateVisibility();
     _PerformRegExRename();
     return S_OK;
 }
@@ -440,7 +654,20 @@ HRESULT CPowerRenameManager::s_CreateInstance(_Outptr_ IPowerRenameManager** pps
     return hr;
 }
 
+// Custom messages for worker threads
+enum
+{
+    SRM_REGEX_ITEMS_UPDATED = (WM_APP + 1), // Rename items processed by regex worker thread, see m_itemUpdates
+    SRM_REGEX_STARTED, // RegEx operation was started
+    SRM_REGEX_CANCELED, // Regex operation was canceled
+    SRM_REGEX_COMPLETE, // Regex worker thread completed
+    SRM_FILEOP_COMPLETE // File Operation worker thread completed
+};
+
 CPowerRenameManager::CPowerRenameManager() :
+    m_itemUpdates([this]() {
+        PostMessage(m_hwndMessage, SRM_REGEX_ITEMS_UPDATED, 0, 0);
+    }),
     m_refCount(1)
 {
     InitializeCriticalSection(&m_critsecReentrancy);
@@ -463,16 +690,6 @@ HRESULT CPowerRenameManager::_Init()
     return S_OK;
 }
 
-// Custom messages for worker threads
-enum
-{
-    SRM_REGEX_ITEM_UPDATED = (WM_APP + 1), // Single rename item processed by regex worker thread
-    SRM_REGEX_STARTED, // RegEx operation was started
-    SRM_REGEX_CANCELED, // Regex operation was canceled
-    SRM_REGEX_COMPLETE, // Regex worker thread completed
-    SRM_FILEOP_COMPLETE // File Operation worker thread completed
-};
-
 struct WorkerThreadData
 {
     HWND hwndManager = nullptr;
@@ -480,6 +697,8 @@ struct WorkerThreadData
     HANDLE cancelEvent = nullptr;
     HWND hwndParent = nullptr;
     CComPtr<IPowerRenameManager> spsrm;
+    // Same object as spsrm, used by the worker threads to reach the item store directly
+    CPowerRenameManager* pManager = nullptr;
 };
 
 // Msg-only worker window proc for communication from our worker threads
@@ -513,13 +732,14 @@ LRESULT CPowerRenameManager::_WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM
 
     switch (msg)
     {
-    case SRM_REGEX_ITEM_UPDATED:
+    case SRM_REGEX_ITEMS_UPDATED:
     {
-        int id = static_cast<int>(lParam);
-        CComPtr<IPowerRenameItem> spItem;
-        if (SUCCEEDED(GetItemById(id, &spItem)))
+        std::vector<CPowerRenameProgressChannel::ItemRange> ranges;
+        m_itemUpdates.TakeUpdatedRanges(ranges);
+        if (!ranges.empty())
         {
-            _OnUpdate(spItem);
+            _InvalidateVisibility();
+            _OnItemsUpdated(ranges.data(), static_cast<UINT>(ranges.size()));
         }
         break;
     }
@@ -559,26 +779,19 @@ void CPowerRenameManager::_LogOperationTelemetry()
 
     // Enumerate extensions used into a map
     std::map<std::wstring, int> extensionsMap;
-    for (UINT i = 0; i < totalItemCount; i++)
     {
-        CComPtr<IPowerRenameItem> spItem;
-        if (SUCCEEDED(GetItemByIndex(i, &spItem)))
+        CSRWSharedAutoLock lock(m_renameItems->GetLock());
+        for (UINT i = 0; i < m_renameItems->GetCount(); i++)
         {
-            PWSTR originalName;
-            if (SUCCEEDED(spItem->GetOriginalName(&originalName)))
+            std::wstring extension = fs::path(m_renameItems->GetOriginalName(i)).extension().wstring();
+            std::map<std::wstring, int>::iterator it = extensionsMap.find(extension);
+            if (it == extensionsMap.end())
             {
-                std::wstring extension = fs::path(originalName).extension().wstring();
-                std::map<std::wstring, int>::iterator it = extensionsMap.find(extension);
-                if (it == extensionsMap.end())
-                {
-                    extensionsMap.insert({ extension, 1 });
-                }
-                else
-                {
-                    it->second++;
-                }
-
-                CoTaskMemFree(originalName);
+                extensionsMap.insert({ extension, 1 });
+            }
+            else
+            {
+                it->second++;
             }
         }
     }
@@ -659,6 +872,7 @@ HRESULT CPowerRenameManager::_CreateFileOpWorkerThread()
         pwtd->startEvent = m_startRegExWorkerEvent;
         pwtd->cancelEvent = nullptr;
         pwtd->spsrm = this;
+        pwtd->pManager = this;
         m_fileOpWorkerThreadHandle = CreateThread(nullptr, 0, s_fileOpWorkerThread, pwtd, 0, nullptr);
         hr = E_FAIL;
         if (m_fileOpWorkerThreadHandle)
@@ -697,63 +911,138 @@ DWORD WINAPI CPowerRenameManager::s_fileOpWorkerThread(_In_ void* pv)
                         UINT itemCount = 0;
                         pwtd->spsrm->GetItemCount(&itemCount);
 
-                        // We add the items to the operation in depth-first order.  This allows child items to be
-                        // renamed before parent items.
-
-                        // Creating a vector of vectors of items of the same depth
-                        std::vector<std::vector<UINT>> matrix(itemCount);
-
+                        // Plan the renames before queuing them.  The items that keep their name are
+                        // planned too so that nothing is renamed to their name.  Chains are ordered,
+                        // cycles go through a temporary name and children are renamed before their
+                        // parent folder.  Renames to a name that is taken are still queued, last, for
+                        // FOF_RENAMEONCOLLISION to pick another name like it always did.
+                        CPowerRenamePlanner planner;
+                        std::vector<CComPtr<IShellItem>> shellItems;
+                        shellItems.reserve(itemCount);
+                        // Index of the planned items in the manager
+                        std::vector<UINT> itemIndices;
+                        itemIndices.reserve(itemCount);
                         for (UINT u = 0; u < itemCount; u++)
                         {
                             CComPtr<IPowerRenameItem> spItem;
-                            if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(u, &spItem)))
+                            PWSTR path = nullptr;
+                            PWSTR originalName = nullptr;
+                            if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(u, &spItem)) &&
+                                SUCCEEDED(spItem->GetPath(&path)) &&
+                                SUCCEEDED(spItem->GetOriginalName(&originalName)))
                             {
                                 UINT depth = 0;
                                 spItem->GetDepth(&depth);
-                                matrix[depth].push_back(u);
+
+                                std::wstring_view parentPath(path);
+                                const size_t separator = parentPath.find_last_of(L'\\');
+                                parentPath = parentPath.substr(0, separator == std::wstring_view::npos ? 0 : separator);
+
+                                PWSTR newName = nullptr;
+                                CComPtr<IShellItem> spShellItem;
+                                bool shouldRename = false;
+                                if (SUCCEEDED(spItem->ShouldRenameItem(flags, &shouldRename)) && shouldRename &&
+                                    SUCCEEDED(spItem->GetShellItem(&spShellItem)) &&
+                                    SUCCEEDED(spItem->GetNewName(&newName)) && newName)
+                                {
+                                    planner.AddItem(parentPath, originalName, newName, depth);
+                                }
+                                else
+                                {
+                                    spShellItem.Release();
+                                    planner.AddItem(parentPath, originalName, L"", depth);
+                                }
+                                shellItems.push_back(spShellItem);
+                                itemIndices.push_back(u);
+                                CoTaskMemFree(newName);
                             }
+                            CoTaskMemFree(path);
+                            CoTaskMemFree(originalName);
                         }
+                        // Temporary names are checked against the files on disk too
+                        planner.Plan(true, [](const std::wstring& parentPath, const std::wstring& name) {
+                            return GetFileAttributes((parentPath + L"\\" + name).c_str()) != INVALID_FILE_ATTRIBUTES;
+                        });
+
+                        CComPtr<CTemporaryRenameSink> spSink;
+                        spSink.Attach(new CTemporaryRenameSink(planner.GetItemCount()));
+
+                        auto performOperations = [pwtd, &spSink](IFileOperation* fileOp) {
+                            // Set the operation flags
+                            if (SUCCEEDED(fileOp->SetOperationFlags(FOF_DEFAULTFLAGS)))
+                            {
+                                // Set the parent window
+                                if (pwtd->hwndParent)
+                                {
+                                    fileOp->SetOwnerWindow(pwtd->hwndParent);
+                                }
+
+                                DWORD cookie = 0;
+                                const bool isAdvised = SUCCEEDED(fileOp->Advise(spSink, &cookie));
 
-                        // From the greatest depth first, add all items of that depth to the operation
-                        for (LONG v = itemCount - 1; v >= 0; v--)
+                                // Perform the operation
+                                // We don't care about the return code here. We would rather
+                                // return control back to explorer so the user can cleanly
+                                // undo the operation if it failed halfway through.
+                                fileOp->PerformOperations();
+
+                                if (isAdvised)
+                                {
+                                    fileOp->Unadvise(cookie);
+                                }
+                            }
+                        };
+
+                        // The operations are queued in plan order.  An item at a temporary name
+                        // has no shell item until the operation moving it there is performed, so
+                        // plans with cycles take more than one file operation.
+                        bool hasQueuedOperations = false;
+                        for (const auto& operation : planner.GetOperations())
                         {
-                            for (auto it : matrix[v])
+                            CComPtr<IShellItem> spShellItem = shellItems[operation.item];
+                            std::wstring newName(planner.GetNewName(operation.item));
+                            if (operation.kind == CPowerRenamePlanner::OperationKind::RenameToTemporary)
+                            {
+                                newName = planner.GetTemporaryName(operation.item);
+                                spSink->AddTemporaryName(newName, operation.item);
+                            }
+                            else if (operation.kind == CPowerRenamePlanner::OperationKind::RenameFromTemporary)
                             {
-                                CComPtr<IPowerRenameItem> spItem;
-                                if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(it, &spItem)))
+                                if (hasQueuedOperations)
                                 {
-                                    bool shouldRename = false;
-                                    if (SUCCEEDED(spItem->ShouldRenameItem(flags, &shouldRename)) && shouldRename)
+                                    performOperations(spFileOp);
+                                    hasQueuedOperations = false;
+                                    spFileOp.Release();
+                                    if (FAILED(CoCreateInstance(CLSID_FileOperation, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&spFileOp))))
                                     {
-                                        PWSTR newName = nullptr;
-                                        if (SUCCEEDED(spItem->GetNewName(&newName)))
-                                        {
-                                            CComPtr<IShellItem> spShellItem;
-                                            if (SUCCEEDED(spItem->GetShellItem(&spShellItem)))
-                                            {
-                                                spFileOp->RenameItem(spShellItem, newName, nullptr);
-                                            }
-                                            CoTaskMemFree(newName);
-                                        }
+                                        break;
                                     }
                                 }
+
+                                spShellItem.Release();
+                                if (FAILED(spSink->GetTemporaryItem(operation.item, &spShellItem)))
+                                {
+                                    // The rename to the temporary name failed or was canceled so the item
+                                    // still has its original name.  The item that took its new name keeps it.
+                                    CComPtr<IPowerRenameItem> spItem;
+                                    if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(itemIndices[operation.item], &spItem)))
+                                    {
+                                        pwtd->pManager->_OnError(spItem);
+                                    }
+                                    continue;
+                                }
                             }
-                        }
 
-                        // Set the operation flags
-                        if (SUCCEEDED(spFileOp->SetOperationFlags(FOF_DEFAULTFLAGS)))
-                        {
-                            // Set the parent window
-                            if (pwtd->hwndParent)
+                            if (spShellItem && SUCCEEDED(spFileOp->RenameItem(spShellItem, newName.c_str(), nullptr)) &&
+                                operation.kind != CPowerRenamePlanner::OperationKind::RenameFromTemporary)
                             {
-                                spFileOp->SetOwnerWindow(pwtd->hwndParent);
+                                hasQueuedOperations = true;
                             }
+                        }
 
-                            // Perform the operation
-                            // We don't care about the return code here. We would rather
-                            // return control back to explorer so the user can cleanly
-                            // undo the operation if it failed halfway through.
-                            spFileOp->PerformOperations();
+                        if (spFileOp)
+                        {
+                            performOperations(spFileOp);
                         }
                     }
                 }
@@ -810,6 +1099,7 @@ HRESULT CPowerRenameManager::_CreateRegExWorkerThread()
         pwtd->cancelEvent = m_cancelRegExWorkerEvent;
         pwtd->hwndParent = m_hwndParent;
         pwtd->spsrm = this;
+        pwtd->pManager = this;
         m_regExWorkerThreadHandle = CreateThread(nullptr, 0, s_regexWorkerThread, pwtd, 0, nullptr);
         hr = E_FAIL;
         if (m_regExWorkerThreadHandle)
@@ -839,187 +1129,29 @@ DWORD WINAPI CPowerRenameManager::s_regexWorkerThread(_In_ void* pv)
             if (WaitForSingleObject(pwtd->startEvent, INFINITE) == WAIT_OBJECT_0)
             {
                 CComPtr<IPowerRenameRegEx> spRenameRegEx;
-
                 winrt::check_hresult(pwtd->spsrm->GetRenameRegEx(&spRenameRegEx));
 
-                DWORD flags = 0;
-                winrt::check_hresult(spRenameRegEx->GetFlags(&flags));
-
-                PWSTR replaceTerm = nullptr;
-                bool useFileTime = false;
+                CPowerRenameManager* pManager = pwtd->pManager;
+                CStoreItems items(pManager->m_renameItems);
+                pManager->_GetItemIds(items.ids);
 
-                winrt::check_hresult(spRenameRegEx->GetReplaceTerm(&replaceTerm));
+                // The engine keeps the results of the previous preview so only what changed is recomputed
+                HRESULT hr = pManager->m_previewEngine.Run(items, spRenameRegEx, pwtd->cancelEvent, [pManager](UINT index, int) {
+                    // The manager thread is sent the processed items in batches
+                    pManager->m_itemUpdates.MarkUpdated(index);
+                });
+                pManager->m_itemUpdates.Flush();
 
-                if (isFileTimeUsed(replaceTerm))
+                if (hr == E_ABORT)
                 {
-                    useFileTime = true;
+                    // Canceled from manager
+                    // Send the manager thread the canceled message
+                    PostMessage(pwtd->hwndManager, SRM_REGEX_CANCELED, GetCurrentThreadId(), 0);
                 }
-
-                UINT itemCount = 0;
-                unsigned long itemEnumIndex = 1;
-                winrt::check_hresult(pwtd->spsrm->GetItemCount(&itemCount));
-                for (UINT u = 0; u < itemCount; u++)
+                else
                 {
-                    // Check if cancel event is signaled
-                    if (WaitForSingleObject(pwtd->cancelEvent, 0) == WAIT_OBJECT_0)
-                    {
-                        // Canceled from manager
-                        // Send the manager thread the canceled message
-                        PostMessage(pwtd->hwndManager, SRM_REGEX_CANCELED, GetCurrentThreadId(), 0);
-                        break;
-                    }
-
-                    CComPtr<IPowerRenameItem> spItem;
-                    winrt::check_hresult(pwtd->spsrm->GetItemByIndex(u, &spItem));
-
-                    int id = -1;
-                    winrt::check_hresult(spItem->GetId(&id));
-
-                    bool isFolder = false;
-                    bool isSubFolderContent = false;
-                    winrt::check_hresult(spItem->GetIsFolder(&isFolder));
-                    winrt::check_hresult(spItem->GetIsSubFolderContent(&isSubFolderContent));
-                    if ((isFolder && (flags & PowerRenameFlags::ExcludeFolders)) ||
-                        (!isFolder && (flags & PowerRenameFlags::ExcludeFiles)) ||
-                        (isSubFolderContent && (flags & PowerRenameFlags::ExcludeSubfolders)))
-                    {
-                        // Exclude this item from renaming.  Ensure new name is cleared.
-                        winrt::check_hresult(spItem->PutNewName(nullptr));
-
-                        // Send the manager thread the item processed message
-                        PostMessage(pwtd->hwndManager, SRM_REGEX_ITEM_UPDATED, GetCurrentThreadId(), id);
-
-                        continue;
-                    }
-
-                    PWSTR originalName = nullptr;
-                    winrt::check_hresult(spItem->GetOriginalName(&originalName));
-
-
-                    PWSTR currentNewName = nullptr;
-                    winrt::check_hresult(spItem->GetNewName(&currentNewName));
-
-                    wchar_t sourceName[MAX_PATH] = { 0 };
-                    if (flags & NameOnly)
-                    {
-                        StringCchCopy(sourceName, ARRAYSIZE(sourceName), fs::path(originalName).stem().c_str());
-                    }
-                    else if (flags & ExtensionOnly)
-                    {
-                        std::wstring extension = fs::path(originalName).extension().wstring();
-                        if (!extension.empty() && extension.front() == '.')
-                        {
-                            extension = extension.erase(0, 1);
-                        }
-                        StringCchCopy(sourceName, ARRAYSIZE(sourceName), extension.c_str());
-                    }
-                    else
-                    {
-                        StringCchCopy(sourceName, ARRAYSIZE(sourceName), originalName);
-                    }
-
-                    SYSTEMTIME fileTime = { 0 };
-
-                    if (useFileTime)
-                    {
-                        winrt::check_hresult(spItem->GetTime(&fileTime));
-                        winrt::check_hresult(spRenameRegEx->PutFileTime(fileTime));
-                    }
-
-                    PWSTR newName = nullptr;
-
-                    // Failure here means we didn't match anything or had nothing to match
-                    // Call put_newName with null in that case to reset it
-                    winrt::check_hresult(spRenameRegEx->Replace(sourceName, &newName));
-
-                    if (useFileTime)
-                    {
-                        winrt::check_hresult(spRenameRegEx->ResetFileTime());
-                    }
-
-                    wchar_t resultName[MAX_PATH] = { 0 };
-
-                    PWSTR newNameToUse = nullptr;
-
-                    // newName == nullptr likely means we have an empty search string.  We should leave newNameToUse
-                    // as nullptr so we clear the renamed column
-                    // Except string transformation is selected.
-
-                    if (newName == nullptr && (flags & Uppercase || flags & Lowercase || flags & Titlecase || flags & Capitalized))
-                    {
-                        SHStrDup(sourceName, &newName);
-                    }
-
-                    if (newName != nullptr)
-                    {
-                        newNameToUse = resultName;
-                        if (flags & NameOnly)
-                        {
-                            StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s%s", newName, fs::path(originalName).extension().c_str());
-                        }
-                        else if (flags & ExtensionOnly)
-                        {
-                            std::wstring extension = fs::path(originalName).extension().wstring();
-                            if (!extension.empty())
-                            {
-                                StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s.%s", fs::path(originalName).stem().c_str(), newName);
-                            }
-                            else
-                            {
-                                StringCchCopy(resultName, ARRAYSIZE(resultName), originalName);
-                            }
-                        }
-                        else
-                        {
-                            StringCchCopy(resultName, ARRAYSIZE(resultName), newName);
-                        }
-                    }
-
-                    wchar_t trimmedName[MAX_PATH] = { 0 };
-                    if (newNameToUse != nullptr)
-                    {
-                        winrt::check_hresult(GetTrimmedFileName(trimmedName, ARRAYSIZE(trimmedName), newNameToUse));
-                        newNameToUse = trimmedName;
-                    }
-
-                    wchar_t transformedName[MAX_PATH] = { 0 };
-                    if (newNameToUse != nullptr && (flags & Uppercase || flags & Lowercase || flags & Titlecase || flags & Capitalized))
-                    {
-                        winrt::check_hresult(GetTransformedFileName(transformedName, ARRAYSIZE(transformedName), newNameToUse, flags));
-                        newNameToUse = transformedName;
-                    }
-
-                    // No change from originalName so set newName to
-                    // null so we clear it from our UI as well.
-                    if (lstrcmp(originalName, newNameToUse) == 0)
-                    {
-                        newNameToUse = nullptr;
-                    }
-
-                    wchar_t uniqueName[MAX_PATH] = { 0 };
-                    if (newNameToUse != nullptr && (flags & EnumerateItems))
-                    {
-                        unsigned long countUsed = 0;
-                        if (GetEnumeratedFileName(uniqueName, ARRAYSIZE(uniqueName), newNameToUse, nullptr, itemEnumIndex, &countUsed))
-                        {
-                            newNameToUse = uniqueName;
-                        }
-                        itemEnumIndex++;
-                    }
-
-                    winrt::check_hresult(spItem->PutNewName(newNameToUse));
-
-                    // Was there a change?
-                    if (lstrcmp(currentNewName, newNameToUse) != 0)
-                    {
-                        // Send the manager thread the item processed message
-                        PostMessage(pwtd->hwndManager, SRM_REGEX_ITEM_UPDATED, GetCurrentThreadId(), id);
-                    }
-                    CoTaskMemFree(newName);
-                    CoTaskMemFree(currentNewName);
-                    CoTaskMemFree(originalName);
+                    winrt::check_hresult(hr);
                 }
-                CoTaskMemFree(replaceTerm);
             }
 
             // Send the manager thread the completion message
@@ -1124,7 +1256,7 @@ void CPowerRenameManager::_OnItemAdded(_In_ IPowerRenameItem* renameItem)
     }
 }
 
-void CPowerRenameManager::_OnUpdate(_In_ IPowerRenameItem* renameItem)
+void CPowerRenameManager::_OnItemsUpdated(_In_reads_(rangeCount) const PowerRenameItemRange* ranges, _In_ UINT rangeCount)
 {
     CSRWSharedAutoLock lock(&m_lockEvents);
 
@@ -1132,7 +1264,7 @@ void CPowerRenameManager::_OnUpdate(_In_ IPowerRenameItem* renameItem)
     {
         if (it.pEvents)
         {
-            it.pEvents->OnUpdate(renameItem);
+            it.pEvents->OnItemsUpdated(ranges, rangeCount);
         }
     }
 }
@@ -1233,22 +1365,38 @@ void CPowerRenameManager::_ClearEventHandlers()
     m_powerRenameManagerEvents.clear();
 }
 
-void CPowerRenameManager::_ClearPowerRenameItems()
+void CPowerRenameManager::_GetItemIds(_Out_ std::vector<int>& ids)
 {
-    CSRWExclusiveAutoLock lock(&m_lockItems);
+    CSRWSharedAutoLock lock(m_renameItems->GetLock());
 
-    // Cleanup rename items
-    for (std::map<int, IPowerRenameItem*>::iterator it = m_renameItems.begin(); it != m_renameItems.end(); ++it)
+    ids.clear();
+    ids.reserve(m_renameItems->GetCount());
+    for (UINT i = 0; i < m_renameItems->GetCount(); i++)
     {
-        IPowerRenameItem* pItem = it->second;
-        if (pItem)
-        {
-            pItem->Release();
-            it->second = nullptr;
-        }
+        ids.push_back(m_renameItems->GetId(i));
     }
+}
 
-    m_renameItems.clear();
+void CPowerRenameManager::_ClearPowerRenameItems()
+{
+    CSRWExclusiveAutoLock lock(m_renameItems->GetLock());
+
+    // Cleanup rename items
+    m_renameItems->Clear();
+    m_isVisibleValid = false;
+}
+
+void CPowerRenameManager::_InvalidateVisibility()
+{
+    CSRWExclusiveAutoLock lock(m_renameItems->GetLock());
+    m_isVisibleValid = false;
+}
+
+bool CPowerRenameManager::_IsVisibilityValid()
+{
+    // Selecting an item does not go through the manager, the store counts the changes
+    CSRWSharedAutoLock lock(m_renameItems->GetLock());
+    return m_isVisibleValid && m_visibleSelectionVersion == m_renameItems->GetSelectionVersion();
 }
 
 void CPowerRenameManager::_Cleanup()
@@ -1,10 +1,14 @@
 #pragma once
+#include <atomic>
+#include <memory>
 #include <vector>
-#include <map>
 #include "srwlock.h"
 
 #include <lib/PowerRenameManager.h>
 #include <lib/PowerRenameInterfaces.h>
+#include <lib/PowerRenameItemStore.h>
+#include <lib/PowerRenamePreviewEngine.h>
+#include <lib/PowerRenameProgressChannel.h>
 
 class CPowerRenameManager :
     public IPowerRenameManager,
@@ -24,7 +28,11 @@ public:
     IFACEMETHODIMP Reset();
     IFACEMETHODIMP Shutdown();
     IFACEMETHODIMP Rename(_In_ HWND hwndParent);
+    IFACEMETHODIMP PutEnumerating(_In_ bool isEnumerating);
     IFACEMETHODIMP AddItem(_In_ IPowerRenameItem* pItem);
+    IFACEMETHODIMP AddItems(_In_reads_(count) IPowerRenameItem* const* items, _In_ UINT count);
+    IFACEMETHODIMP AddItemInfos(_In_reads_(count) const PowerRenameItemInfo* items, _In_ UINT count);
+    IFACEMETHODIMP UpdatePreview();
     IFACEMETHODIMP GetItemByIndex(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem);
     IFACEMETHODIMP GetVisibleItemByIndex(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem);
     IFACEMETHODIMP GetItemById(_In_ int id, _COM_Outptr_ IPowerRenameItem** ppItem);
@@ -60,7 +68,7 @@ protected:
     void _Cancel();
 
     void _OnItemAdded(_In_ IPowerRenameItem* renameItem);
-    void _OnUpdate(_In_ IPowerRenameItem* renameItem);
+    void _OnItemsUpdated(_In_reads_(rangeCount) const PowerRenameItemRange* ranges, _In_ UINT rangeCount);
     void _OnError(_In_ IPowerRenameItem* renameItem);
     void _OnRegExStarted(_In_ DWORD threadId);
     void _OnRegExCanceled(_In_ DWORD threadId);
@@ -70,6 +78,11 @@ protected:
 
     void _ClearEventHandlers();
     void _ClearPowerRenameItems();
+    void _InvalidateVisibility();
+    bool _IsVisibilityValid();
+
+    // Snapshot of the ids of the rename items in index order
+    void _GetItemIds(_Out_ std::vector<int>& ids);
 
     HRESULT _PerformRegExRename();
     HRESULT _PerformFileOperation();
@@ -101,7 +114,6 @@ protected:
     HANDLE m_startFileOpWorkerEvent = nullptr;
 
     CSRWLock m_lockEvents;
-    CSRWLock m_lockItems;
 
     DWORD m_flags = 0;
 
@@ -120,12 +132,25 @@ protected:
     CComPtr<IPowerRenameRegEx> m_spRegEx;
 
     _Guarded_by_(m_lockEvents) std::vector<RENAME_MGR_EVENT> m_powerRenameManagerEvents;
-    _Guarded_by_(m_lockItems) std::map<int, IPowerRenameItem*> m_renameItems;
-    _Guarded_by_(m_lockItems) std::vector<bool> m_isVisible;
+    // Shared with the items it creates.  The members below are guarded by its lock too.
+    std::shared_ptr<CPowerRenameItemStore> m_renameItems = std::make_shared<CPowerRenameItemStore>();
+    // False until SetVisible has run for the current filter, flags and items
+    bool m_isVisibleValid = false;
+    // Selection version of the items when SetVisible ran, the Selected and ShouldRename
+    // filters depend on the selection
+    UINT m_visibleSelectionVersion = 0;
+
+    // Only used by the regex worker thread.  A new worker is started once the previous one exited.
+    CPowerRenamePreviewEngine m_previewEngine;
+    // Items updated by the regex worker, taken on SRM_REGEX_ITEMS_UPDATED
+    CPowerRenameProgressChannel m_itemUpdates;
 
     // Parent HWND used by IFileOperation
     HWND m_hwndParent = nullptr;
 
+    // Items are still being added, renaming now would only rename part of them
+    std::atomic<bool> m_isEnumerating = false;
+
     HWND m_hwndMessage = nullptr;
 
     CRITICAL_SECTION m_critsecReentrancy;
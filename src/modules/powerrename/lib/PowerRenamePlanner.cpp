@@ -0,0 +1,501 @@
+#include "pch.h"
+#include "PowerRenamePlanner.h"
+#include <algorithm>
+
+namespace
+{
+    // File names compare without case, the way the file system does
+    inline wchar_t FoldNameChar(wchar_t c)
+    {
+        if (c < 0x80)
+        {
+            return (c >= L'a' && c <= L'z') ? static_cast<wchar_t>(c - (L'a' - L'A')) : c;
+        }
+        return static_cast<wchar_t>(towupper(c));
+    }
+
+    enum VisitState : BYTE
+    {
+        NotVisited,
+        OnPath,
+        Visited
+    };
+}
+
+UINT CPowerRenamePlanner::AddItem(_In_ std::wstring_view parentPath, _In_ std::wstring_view originalName, _In_ std::wstring_view newName, _In_ UINT depth)
+{
+    UINT directory = m_lastDirectory;
+    if (directory == NoItem || m_directories[directory] != parentPath)
+    {
+        auto result = m_directoryIds.emplace(std::wstring(parentPath), static_cast<UINT>(m_directories.size()));
+        if (result.second)
+        {
+            m_directories.emplace_back(parentPath);
+        }
+        directory = result.first->second;
+        m_lastDirectory = directory;
+    }
+
+    // Drop the temporary names of the last plan, they are assigned again
+    m_names.resize(m_itemNamesLength);
+
+    Item item = {};
+    item.directory = directory;
+    item.depth = depth;
+    item.originalName = _AddName(originalName);
+    item.originalHash = s_HashName(directory, originalName);
+    item.isRenamed = !newName.empty() && newName != originalName;
+    if (item.isRenamed)
+    {
+        item.newName = _AddName(newName);
+        item.newHash = s_HashName(directory, newName);
+    }
+    else
+    {
+        item.newName = item.originalName;
+        item.newHash = item.originalHash;
+    }
+    item.status = item.isRenamed ? ItemStatus::Renamed : ItemStatus::Unchanged;
+    item.blocker = NoItem;
+    m_itemNamesLength = m_names.length();
+
+    m_items.push_back(item);
+    return static_cast<UINT>(m_items.size() - 1);
+}
+
+void CPowerRenamePlanner::Clear()
+{
+    m_directories.clear();
+    m_directoryIds.clear();
+    m_lastDirectory = NoItem;
+    m_items.clear();
+    m_names.clear();
+    m_itemNamesLength = 0;
+    m_temporaryNameCount = 0;
+    m_operations.clear();
+    m_waveStarts.clear();
+    m_report = Report();
+}
+
+void CPowerRenamePlanner::Plan(_In_ bool renameOnCollision, _In_opt_ const NameExists& nameExists)
+{
+    const UINT count = GetItemCount();
+    m_names.resize(m_itemNamesLength);
+    m_temporaryNameCount = 0;
+    for (auto& item : m_items)
+    {
+        item.status = item.isRenamed ? ItemStatus::Renamed : ItemStatus::Unchanged;
+        item.temporaryName = NameRef();
+        item.blocker = NoItem;
+        item.level = 0;
+    }
+
+    // Items that keep their name, no other item can be renamed to it
+    std::vector<UINT> keptNames;
+    m_originalNames.Reset(count);
+    for (UINT i = 0; i < count; i++)
+    {
+        if (m_originalNames.Insert(*this, i, false) != NoItem)
+        {
+            // The same file twice, its first entry decides
+            m_items[i].status = ItemStatus::Duplicate;
+        }
+        else if (!m_items[i].isRenamed)
+        {
+            keptNames.push_back(i);
+        }
+    }
+
+    // Renames to the same name: none of them gets it
+    m_newNames.Reset(count);
+    for (UINT i = 0; i < count; i++)
+    {
+        if (m_items[i].status == ItemStatus::Renamed)
+        {
+            const UINT other = m_newNames.Insert(*this, i, true);
+            if (other != NoItem)
+            {
+                _Skip(i, ItemStatus::Collision, keptNames);
+                if (m_items[other].status == ItemStatus::Renamed)
+                {
+                    _Skip(other, ItemStatus::Collision, keptNames);
+                }
+            }
+        }
+    }
+
+    // Renames to a name that is kept.  A skipped rename keeps its name in turn, so this
+    // goes on until no rename is left to skip; every item is skipped at most once.
+    for (size_t k = 0; k < keptNames.size(); k++)
+    {
+        const Item& kept = m_items[keptNames[k]];
+        const UINT taker = m_newNames.Find(*this, kept.directory, _GetName(kept.originalName), kept.originalHash, true);
+        if (taker != NoItem && taker != keptNames[k] && m_items[taker].status == ItemStatus::Renamed)
+        {
+            _Skip(taker, ItemStatus::TargetExists, keptNames);
+        }
+    }
+
+    // What is left is renamed.  A rename to the original name of another item waits for it.
+    for (UINT i = 0; i < count; i++)
+    {
+        Item& item = m_items[i];
+        if (item.status == ItemStatus::Renamed)
+        {
+            const UINT holder = m_originalNames.Find(*this, item.directory, _GetName(item.newName), item.newHash, false);
+            if (holder != NoItem && holder != i)
+            {
+                item.blocker = holder;
+            }
+        }
+    }
+
+    _AssignLevels(nameExists);
+    _OrderOperations(renameOnCollision);
+
+    m_report = Report();
+    m_report.itemCount = count;
+    for (const auto& item : m_items)
+    {
+        switch (item.status)
+        {
+        case ItemStatus::Unchanged:
+            m_report.unchanged++;
+            break;
+        case ItemStatus::Renamed:
+        case ItemStatus::RenamedThroughTemporary:
+            m_report.renamed++;
+            m_report.longestChain = std::max(m_report.longestChain, item.level + 1);
+            break;
+        case ItemStatus::Collision:
+            m_report.collisions++;
+            break;
+        case ItemStatus::TargetExists:
+            m_report.targetExists++;
+            break;
+        case ItemStatus::Duplicate:
+            m_report.duplicates++;
+            break;
+        }
+    }
+    m_report.cycles = m_temporaryNameCount;
+    m_report.waves = GetWaveCount();
+}
+
+std::wstring CPowerRenamePlanner::FormatReport() const
+{
+    std::wstring report = std::to_wstring(m_report.renamed) + L" renamed, " + std::to_wstring(m_report.unchanged) + L" unchanged, " +
+                          std::to_wstring(m_report.collisions) + L" collisions, " + std::to_wstring(m_report.targetExists) + L" existing names, " +
+                          std::to_wstring(m_report.duplicates) + L" duplicates, " + std::to_wstring(m_report.cycles) + L" cycles, " +
+                          std::to_wstring(m_report.waves) + L" waves\n";
+
+    auto appendPath = [this, &report](UINT item, std::wstring_view name) {
+        report += GetParentPath(item);
+        report += L'\\';
+        report += name;
+    };
+
+    for (UINT wave = 0; wave < GetWaveCount(); wave++)
+    {
+        for (UINT i = m_waveStarts[wave]; i < m_waveStarts[wave + 1]; i++)
+        {
+            const Operation& operation = m_operations[i];
+            report += L"[" + std::to_wstring(wave) + L"] rename ";
+            appendPath(operation.item, operation.kind == OperationKind::RenameFromTemporary ? GetTemporaryName(operation.item) : GetOriginalName(operation.item));
+            report += L" -> ";
+            report += operation.kind == OperationKind::RenameToTemporary ? GetTemporaryName(operation.item) : GetNewName(operation.item);
+            if (operation.kind == OperationKind::RenameOnCollision)
+            {
+                report += L" (another name on collision)";
+            }
+            report += L'\n';
+        }
+    }
+
+    for (UINT item = 0; item < GetItemCount(); item++)
+    {
+        PCWSTR reason = nullptr;
+        switch (m_items[item].status)
+        {
+        case ItemStatus::Collision:
+            reason = L"another item is renamed to ";
+            break;
+        case ItemStatus::TargetExists:
+            reason = L"an item keeps the name ";
+            break;
+        case ItemStatus::Duplicate:
+            reason = L"added twice as ";
+            break;
+        default:
+            continue;
+        }
+        report += L"conflict ";
+        appendPath(item, GetOriginalName(item));
+        report += L": ";
+        report += reason;
+        report += m_items[item].status == ItemStatus::Duplicate ? GetOriginalName(item) : GetNewName(item);
+        report += L'\n';
+    }
+    return report;
+}
+
+void CPowerRenamePlanner::NameIndex::Reset(_In_ size_t count)
+{
+    // At most half full
+    size_t capacity = 16;
+    while (capacity < 2 * count)
+    {
+        capacity *= 2;
+    }
+    m_slots.assign(capacity, NoItem);
+    m_mask = capacity - 1;
+}
+
+UINT CPowerRenamePlanner::NameIndex::Insert(_In_ const CPowerRenamePlanner& planner, _In_ UINT item, _In_ bool useNewName)
+{
+    const Item& entry = planner.m_items[item];
+    const UINT64 hash = useNewName ? entry.newHash : entry.originalHash;
+    const std::wstring_view name = planner._GetName(useNewName ? entry.newName : entry.originalName);
+    for (size_t slot = static_cast<size_t>(hash) & m_mask;; slot = (slot + 1) & m_mask)
+    {
+        const UINT other = m_slots[slot];
+        if (other == NoItem)
+        {
+            m_slots[slot] = item;
+            return NoItem;
+        }
+
+        const Item& otherEntry = planner.m_items[other];
+        if ((useNewName ? otherEntry.newHash : otherEntry.originalHash) == hash && otherEntry.directory == entry.directory &&
+            s_NamesEqual(planner._GetName(useNewName ? otherEntry.newName : otherEntry.originalName), name))
+        {
+            return other;
+        }
+    }
+}
+
+UINT CPowerRenamePlanner::NameIndex::Find(_In_ const CPowerRenamePlanner& planner, _In_ UINT directory, _In_ std::wstring_view name, _In_ UINT64 hash, _In_ bool useNewName) const
+{
+    for (size_t slot = static_cast<size_t>(hash) & m_mask;; slot = (slot + 1) & m_mask)
+    {
+        const UINT other = m_slots[slot];
+        if (other == NoItem)
+        {
+            return NoItem;
+        }
+
+        const Item& otherEntry = planner.m_items[other];
+        if ((useNewName ? otherEntry.newHash : otherEntry.originalHash) == hash && otherEntry.directory == directory &&
+            s_NamesEqual(planner._GetName(useNewName ? otherEntry.newName : otherEntry.originalName), name))
+        {
+            return other;
+        }
+    }
+}
+
+CPowerRenamePlanner::NameRef CPowerRenamePlanner::_AddName(_In_ std::wstring_view name)
+{
+    NameRef ref;
+    ref.offset = static_cast<UINT>(m_names.length());
+    ref.length = static_cast<UINT>(name.length());
+    m_names.append(name);
+    return ref;
+}
+
+void CPowerRenamePlanner::_Skip(_In_ UINT item, _In_ ItemStatus status, _Inout_ std::vector<UINT>& keptNames)
+{
+    m_items[item].status = status;
+    keptNames.push_back(item);
+}
+
+void CPowerRenamePlanner::_AssignLevels(_In_opt_ const NameExists& nameExists)
+{
+    // Every item has at most one blocker and, the new names being unique, blocks at most
+    // one item: the renames form chains and cycles, each walked once.
+    std::vector<BYTE> state(m_items.size(), NotVisited);
+    std::vector<UINT> path;
+    for (UINT i = 0; i < GetItemCount(); i++)
+    {
+        if (m_items[i].status != ItemStatus::Renamed || state[i] != NotVisited)
+        {
+            continue;
+        }
+
+        path.clear();
+        UINT current = i;
+        while (current != NoItem && state[current] == NotVisited)
+        {
+            state[current] = OnPath;
+            path.push_back(current);
+            current = m_items[current].blocker;
+        }
+
+        size_t chainLength = path.size();
+        if (current != NoItem && state[current] == OnPath)
+        {
+            // The end of the path loops back to current
+            const size_t cycleStart = static_cast<size_t>(std::find(path.begin(), path.end(), current) - path.begin());
+            const size_t cycleLength = path.size() - cycleStart;
+
+            // The lowest item moves to a temporary name first, which frees its name for the
+            // item before it in the cycle, and so on back around to it
+            size_t first = cycleStart;
+            for (size_t k = cycleStart; k < path.size(); k++)
+            {
+                if (path[k] < path[first])
+                {
+                    first = k;
+                }
+            }
+            _AssignTemporaryName(path[first], nameExists);
+
+            UINT level = 0;
+            for (size_t step = 1; step <= cycleLength; step++)
+            {
+                const size_t k = cycleStart + (first - cycleStart + cycleLength - step) % cycleLength;
+                m_items[path[k]].level = ++level;
+                state[path[k]] = Visited;
+            }
+            chainLength = cycleStart;
+        }
+
+        // The rest of the path waits for the item it ends on
+        for (size_t k = chainLength; k-- > 0;)
+        {
+            Item& item = m_items[path[k]];
+            item.level = item.blocker == NoItem ? 0 : _GetFreedAt(item.blocker) + 1;
+            state[path[k]] = Visited;
+        }
+    }
+}
+
+void CPowerRenamePlanner::_AssignTemporaryName(_In_ UINT item, _In_opt_ const NameExists& nameExists)
+{
+    Item& entry = m_items[item];
+    entry.status = ItemStatus::RenamedThroughTemporary;
+
+    const std::wstring originalName(_GetName(entry.originalName));
+    for (;;)
+    {
+        const std::wstring name = originalName + L".~" + std::to_wstring(++m_temporaryNameCount);
+        const UINT64 hash = s_HashName(entry.directory, name);
+        if (m_originalNames.Find(*this, entry.directory, name, hash, false) == NoItem && m_newNames.Find(*this, entry.directory, name, hash, true) == NoItem &&
+            (!nameExists || !nameExists(m_directories[entry.directory], name)))
+        {
+            entry.temporaryName = _AddName(name);
+            break;
+        }
+    }
+}
+
+void CPowerRenamePlanner::_OrderOperations(_In_ bool renameOnCollision)
+{
+    m_operations.clear();
+    m_waveStarts.clear();
+
+    auto isCollision = [renameOnCollision](const Item& item) {
+        return renameOnCollision && (item.status == ItemStatus::Collision || item.status == ItemStatus::TargetExists);
+    };
+
+    // Number of waves of each depth, plus one at the end for the collisions
+    std::vector<UINT> waveCounts;
+    std::vector<bool> hasCollisions;
+    for (const auto& item : m_items)
+    {
+        const bool isRenamed = item.status == ItemStatus::Renamed || item.status == ItemStatus::RenamedThroughTemporary;
+        if (isRenamed || isCollision(item))
+        {
+            if (item.depth >= waveCounts.size())
+            {
+                waveCounts.resize(static_cast<size_t>(item.depth) + 1, 0);
+                hasCollisions.resize(waveCounts.size(), false);
+            }
+            if (isRenamed)
+            {
+                waveCounts[item.depth] = std::max(waveCounts[item.depth], item.level + 1);
+            }
+            else
+            {
+                hasCollisions[item.depth] = true;
+            }
+        }
+    }
+    for (size_t depth = 0; depth < waveCounts.size(); depth++)
+    {
+        if (hasCollisions[depth])
+        {
+            waveCounts[depth]++;
+        }
+    }
+
+    // Deepest first
+    std::vector<UINT> firstWave(waveCounts.size(), 0);
+    UINT waveCount = 0;
+    for (size_t depth = waveCounts.size(); depth-- > 0;)
+    {
+        firstWave[depth] = waveCount;
+        waveCount += waveCounts[depth];
+    }
+
+    // Counting sort of the operations by wave
+    auto forEachOperation = [this, &firstWave, &waveCounts, &isCollision](auto&& callback) {
+        for (UINT i = 0; i < GetItemCount(); i++)
+        {
+            const Item& item = m_items[i];
+            if (item.status == ItemStatus::Renamed)
+            {
+                callback(firstWave[item.depth] + item.level, Operation{ OperationKind::Rename, i });
+            }
+            else if (item.status == ItemStatus::RenamedThroughTemporary)
+            {
+                callback(firstWave[item.depth], Operation{ OperationKind::RenameToTemporary, i });
+                callback(firstWave[item.depth] + item.level, Operation{ OperationKind::RenameFromTemporary, i });
+            }
+            else if (isCollision(item))
+            {
+                callback(firstWave[item.depth] + waveCounts[item.depth] - 1, Operation{ OperationKind::RenameOnCollision, i });
+            }
+        }
+    };
+
+    m_waveStarts.assign(static_cast<size_t>(waveCount) + 1, 0);
+    forEachOperation([this](UINT wave, const Operation&) { m_waveStarts[wave + 1]++; });
+    for (UINT wave = 0; wave < waveCount; wave++)
+    {
+        m_waveStarts[wave + 1] += m_waveStarts[wave];
+    }
+
+    m_operations.resize(m_waveStarts[waveCount]);
+    std::vector<UINT> next(m_waveStarts.begin(), m_waveStarts.end() - 1);
+    forEachOperation([this, &next](UINT wave, const Operation& operation) { m_operations[next[wave]++] = operation; });
+}
+
+UINT64 CPowerRenamePlanner::s_HashName(_In_ UINT directory, _In_ std::wstring_view name)
+{
+    // FNV-1a over the directory and the folded name
+    UINT64 hash = 14695981039346656037ull ^ directory;
+    hash *= 1099511628211ull;
+    for (wchar_t c : name)
+    {
+        hash ^= static_cast<UINT64>(FoldNameChar(c));
+        hash *= 1099511628211ull;
+    }
+    // The low bits pick the slot
+    return hash ^ (hash >> 29);
+}
+
+bool CPowerRenamePlanner::s_NamesEqual(_In_ std::wstring_view first, _In_ std::wstring_view second)
+{
+    if (first.length() != second.length())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < first.length(); i++)
+    {
+        if (first[i] != second[i] && FoldNameChar(first[i]) != FoldNameChar(second[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
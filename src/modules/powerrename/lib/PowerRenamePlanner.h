@@ -0,0 +1,174 @@
+#pragma once
+#include "pch.h"
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Orders the renames of a bulk rename before any of them is performed, without touching
+// the file system.  Names are indexed per directory, ignoring case the way the file system
+// does, so that in O(n):
+//   - renames to the same name, or to the name of an item that keeps its name, are found
+//     and skipped, along with the renames that depended on the skipped ones
+//   - a rename waits for the item that holds its new name to be renamed first (chains)
+//   - a cycle (a -> b, b -> a) is broken by renaming one of its items to a temporary
+//     name first and to its new name last
+// The plan lists the operations in waves: every operation of a wave can run once the
+// previous waves are done and independently of the others in its wave.  Deeper items are
+// renamed first, as their path changes once their parent folder is renamed.
+// Only the names of the planned items are known, names of other files in the directories
+// are left to the file operation.  Temporary names are also checked against the file system
+// through the NameExists callback given to Plan.
+class CPowerRenamePlanner
+{
+public:
+    enum class ItemStatus : BYTE
+    {
+        // The new name is the original name
+        Unchanged,
+        Renamed,
+        // Renamed through a temporary name to break a cycle
+        RenamedThroughTemporary,
+        // Another item gets the same new name
+        Collision,
+        // The new name is the name of an item that keeps its name
+        TargetExists,
+        // The item was already added with the same name in the same directory
+        Duplicate
+    };
+
+    enum class OperationKind : BYTE
+    {
+        // Original name -> new name
+        Rename,
+        // Original name -> temporary name
+        RenameToTemporary,
+        // Temporary name -> new name
+        RenameFromTemporary,
+        // Original name -> new name of a rename skipped for a collision, left for the file
+        // operation to pick another name.  Several of them in a wave may collide.
+        RenameOnCollision
+    };
+
+    struct Operation
+    {
+        OperationKind kind;
+        UINT item;
+    };
+
+    // Returns true when a file or folder named name exists in the directory parentPath
+    using NameExists = std::function<bool(_In_ const std::wstring& parentPath, _In_ const std::wstring& name)>;
+
+    struct Report
+    {
+        UINT itemCount = 0;
+        UINT renamed = 0;
+        UINT unchanged = 0;
+        UINT collisions = 0;
+        UINT targetExists = 0;
+        UINT duplicates = 0;
+        UINT cycles = 0;
+        UINT waves = 0;
+        UINT longestChain = 0;
+    };
+
+    // Items are numbered in the order they are added.  parentPath identifies the directory,
+    // newName is empty or equal to originalName when the item is not renamed.
+    UINT AddItem(_In_ std::wstring_view parentPath, _In_ std::wstring_view originalName, _In_ std::wstring_view newName, _In_ UINT depth);
+    void Clear();
+
+    // Detects the conflicts and orders the operations of the items added so far.  With
+    // renameOnCollision the renames skipped for a collision are planned anyway, in the last
+    // wave of their depth, for a file operation that picks another name (FOF_RENAMEONCOLLISION).
+    // Temporary names for which nameExists returns true are not used.
+    void Plan(_In_ bool renameOnCollision = false, _In_opt_ const NameExists& nameExists = nullptr);
+
+    UINT GetItemCount() const { return static_cast<UINT>(m_items.size()); }
+    ItemStatus GetItemStatus(_In_ UINT item) const { return m_items[item].status; }
+    const std::wstring& GetParentPath(_In_ UINT item) const { return m_directories[m_items[item].directory]; }
+    std::wstring_view GetOriginalName(_In_ UINT item) const { return _GetName(m_items[item].originalName); }
+    std::wstring_view GetNewName(_In_ UINT item) const { return _GetName(m_items[item].newName); }
+    // Empty unless the item is renamed through a temporary name
+    std::wstring_view GetTemporaryName(_In_ UINT item) const { return _GetName(m_items[item].temporaryName); }
+
+    const std::vector<Operation>& GetOperations() const { return m_operations; }
+    // The operations of wave w are [GetWaveStart(w), GetWaveStart(w + 1))
+    UINT GetWaveCount() const { return m_waveStarts.empty() ? 0 : static_cast<UINT>(m_waveStarts.size() - 1); }
+    UINT GetWaveStart(_In_ UINT wave) const { return m_waveStarts[wave]; }
+
+    const Report& GetReport() const { return m_report; }
+    // One line per operation and per conflict, for a dry run
+    std::wstring FormatReport() const;
+
+private:
+    static constexpr UINT NoItem = UINT_MAX;
+
+    // Offset and length in m_names
+    struct NameRef
+    {
+        UINT offset = 0;
+        UINT length = 0;
+    };
+
+    struct Item
+    {
+        UINT directory;
+        UINT depth;
+        NameRef originalName;
+        NameRef newName;
+        NameRef temporaryName;
+        UINT64 originalHash;
+        UINT64 newHash;
+        bool isRenamed;
+        ItemStatus status;
+        // Item holding the new name until it is renamed itself
+        UINT blocker;
+        // Wave, within the depth, at which the item is renamed to its new name
+        UINT level;
+    };
+
+    // Open addressing table from (directory, folded name) to item
+    class NameIndex
+    {
+    public:
+        void Reset(_In_ size_t count);
+        // Returns the item already indexed under the same name, or NoItem once item is added
+        UINT Insert(_In_ const CPowerRenamePlanner& planner, _In_ UINT item, _In_ bool useNewName);
+        UINT Find(_In_ const CPowerRenamePlanner& planner, _In_ UINT directory, _In_ std::wstring_view name, _In_ UINT64 hash, _In_ bool useNewName) const;
+
+    private:
+        std::vector<UINT> m_slots;
+        size_t m_mask = 0;
+    };
+
+    std::wstring_view _GetName(_In_ const NameRef& name) const { return std::wstring_view(m_names.data() + name.offset, name.length); }
+    NameRef _AddName(_In_ std::wstring_view name);
+    void _Skip(_In_ UINT item, _In_ ItemStatus status, _Inout_ std::vector<UINT>& keptNames);
+    void _AssignLevels(_In_opt_ const NameExists& nameExists);
+    void _AssignTemporaryName(_In_ UINT item, _In_opt_ const NameExists& nameExists);
+    void _OrderOperations(_In_ bool renameOnCollision);
+    // Wave after which the original name of a renamed item is free
+    UINT _GetFreedAt(_In_ UINT item) const { return m_items[item].status == ItemStatus::RenamedThroughTemporary ? 0 : m_items[item].level; }
+
+    static UINT64 s_HashName(_In_ UINT directory, _In_ std::wstring_view name);
+    static bool s_NamesEqual(_In_ std::wstring_view first, _In_ std::wstring_view second);
+
+    std::vector<std::wstring> m_directories;
+    std::unordered_map<std::wstring, UINT> m_directoryIds;
+    // Items usually come grouped by directory
+    UINT m_lastDirectory = NoItem;
+
+    std::vector<Item> m_items;
+    std::wstring m_names;
+    // Length of m_names without the temporary names of the last plan
+    size_t m_itemNamesLength = 0;
+    UINT m_temporaryNameCount = 0;
+
+    NameIndex m_originalNames;
+    NameIndex m_newNames;
+
+    std::vector<Operation> m_operations;
+    std::vector<UINT> m_waveStarts;
+    Report m_report;
+};
@@ -0,0 +1,574 @@
+#include "pch.h"
+#include "PowerRenamePreviewEngine.h"
+#include "Helpers.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    bool IsTransformFlagSet(DWORD flags)
+    {
+        return (flags & Uppercase) || (flags & Lowercase) || (flags & Titlecase) || (flags & Capitalized);
+    }
+
+    // Flags the search and replace stage depends on
+    const DWORD c_replaceFlags = CaseSensitive | MatchAllOccurences | UseRegularExpressions | NameOnly | ExtensionOnly;
+    // Flags the transform stage depends on
+    const DWORD c_transformFlags = Uppercase | Lowercase | Titlecase | Capitalized | NameOnly | ExtensionOnly;
+
+    bool IsExcluded(bool isFolder, bool isSubFolderContent, DWORD flags)
+    {
+        return (isFolder && (flags & PowerRenameFlags::ExcludeFolders)) ||
+               (!isFolder && (flags & PowerRenameFlags::ExcludeFiles)) ||
+               (isSubFolderContent && (flags & PowerRenameFlags::ExcludeSubfolders));
+    }
+
+    // Search and replace stage
+    HRESULT ReplaceName(_In_ CPowerRenamePreviewEngine::Items& items, _In_ size_t index, _In_ IPowerRenameRegEx* renameRegEx, PCWSTR originalName, DWORD flags, bool useFileTime, _Out_ std::wstring& sourceName, _Out_ bool* hasReplacement, _Out_ std::wstring& replacement)
+    {
+        *hasReplacement = false;
+        replacement.clear();
+
+        wchar_t source[MAX_PATH] = { 0 };
+        if (flags & NameOnly)
+        {
+            StringCchCopy(source, ARRAYSIZE(source), fs::path(originalName).stem().c_str());
+        }
+        else if (flags & ExtensionOnly)
+        {
+            std::wstring extension = fs::path(originalName).extension().wstring();
+            if (!extension.empty() && extension.front() == '.')
+            {
+                extension = extension.erase(0, 1);
+            }
+            StringCchCopy(source, ARRAYSIZE(source), extension.c_str());
+        }
+        else
+        {
+            StringCchCopy(source, ARRAYSIZE(source), originalName);
+        }
+        sourceName = source;
+
+        // Failure here means we didn't match anything or had nothing to match
+        CComHeapPtr<wchar_t> newName;
+        HRESULT hr = S_OK;
+        if (useFileTime)
+        {
+            SYSTEMTIME fileTime = { 0 };
+            hr = items.GetTime(index, &fileTime);
+            if (SUCCEEDED(hr))
+            {
+                hr = renameRegEx->ReplaceWithFileTime(source, fileTime, &newName);
+            }
+        }
+        else
+        {
+            hr = renameRegEx->Replace(source, &newName);
+        }
+
+        if (SUCCEEDED(hr) && newName != nullptr)
+        {
+            *hasReplacement = true;
+            replacement = newName.m_pData;
+        }
+        return hr;
+    }
+
+    // Trim stage
+    HRESULT TrimName(PCWSTR originalName, PCWSTR newName, DWORD flags, _Out_ std::wstring& trimmedName)
+    {
+        wchar_t resultName[MAX_PATH] = { 0 };
+        if (flags & NameOnly)
+        {
+            StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s%s", newName, fs::path(originalName).extension().c_str());
+        }
+        else if (flags & ExtensionOnly)
+        {
+            std::wstring extension = fs::path(originalName).extension().wstring();
+            if (!extension.empty())
+            {
+                StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s.%s", fs::path(originalName).stem().c_str(), newName);
+            }
+            else
+            {
+                StringCchCopy(resultName, ARRAYSIZE(resultName), originalName);
+            }
+        }
+        else
+        {
+            StringCchCopy(resultName, ARRAYSIZE(resultName), newName);
+        }
+
+        wchar_t trimmed[MAX_PATH] = { 0 };
+        HRESULT hr = GetTrimmedFileName(trimmed, ARRAYSIZE(trimmed), resultName);
+        if (SUCCEEDED(hr))
+        {
+            trimmedName = trimmed;
+        }
+        return hr;
+    }
+
+    // Transform stage.  Leaves newName empty when the name does not change.
+    HRESULT TransformName(PCWSTR originalName, PCWSTR trimmedName, DWORD flags, _Out_ bool* hasNewName, _Out_ std::wstring& newName)
+    {
+        *hasNewName = false;
+        newName.clear();
+
+        PCWSTR newNameToUse = trimmedName;
+        wchar_t transformedName[MAX_PATH] = { 0 };
+        if (IsTransformFlagSet(flags))
+        {
+            HRESULT hr = GetTransformedFileName(transformedName, ARRAYSIZE(transformedName), newNameToUse, flags);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+            newNameToUse = transformedName;
+        }
+
+        // No change from originalName so leave the new name empty
+        // so we clear it from our UI as well.
+        if (lstrcmp(originalName, newNameToUse) != 0)
+        {
+            *hasNewName = true;
+            newName = newNameToUse;
+        }
+        return S_OK;
+    }
+
+    // Items of a snapshot of IPowerRenameItem
+    class CItemSnapshot :
+        public CPowerRenamePreviewEngine::Items
+    {
+    public:
+        explicit CItemSnapshot(_In_ const std::vector<CComPtr<IPowerRenameItem>>& items) :
+            m_items(items)
+        {
+        }
+
+        size_t GetCount() const override
+        {
+            return m_items.size();
+        }
+
+        HRESULT GetId(_In_ size_t index, _Out_ int* id) override
+        {
+            return m_items[index]->GetId(id);
+        }
+
+        HRESULT GetInfo(_In_ size_t index, _Out_ bool* isFolder, _Out_ bool* isSubFolderContent, _Out_ std::wstring& originalName) override
+        {
+            HRESULT hr = m_items[index]->GetIsFolder(isFolder);
+            if (SUCCEEDED(hr))
+            {
+                hr = m_items[index]->GetIsSubFolderContent(isSubFolderContent);
+            }
+
+            CComHeapPtr<wchar_t> name;
+            if (SUCCEEDED(hr))
+            {
+                hr = m_items[index]->GetOriginalName(&name);
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                originalName = name.m_pData;
+            }
+            return hr;
+        }
+
+        HRESULT GetTime(_In_ size_t index, _Out_ SYSTEMTIME* time) override
+        {
+            return m_items[index]->GetTime(time);
+        }
+
+        HRESULT PutNewName(_In_ size_t index, _In_opt_ PCWSTR newName, _Out_ bool* changed) override
+        {
+            *changed = false;
+            CComHeapPtr<wchar_t> currentNewName;
+            HRESULT hr = m_items[index]->GetNewName(&currentNewName);
+            if (SUCCEEDED(hr))
+            {
+                hr = m_items[index]->PutNewName(newName);
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                *changed = lstrcmp(currentNewName, newName) != 0;
+            }
+            return hr;
+        }
+
+    private:
+        const std::vector<CComPtr<IPowerRenameItem>>& m_items;
+    };
+}
+
+CPowerRenamePreviewEngine::CPowerRenamePreviewEngine(UINT threadCount) :
+    m_threadCount(threadCount)
+{
+    if (m_threadCount == 0)
+    {
+        m_threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    if (m_threadCount > 1)
+    {
+        m_work = CreateThreadpoolWork(s_workCallback, this, nullptr);
+    }
+}
+
+CPowerRenamePreviewEngine::~CPowerRenamePreviewEngine()
+{
+    if (m_work)
+    {
+        WaitForThreadpoolWorkCallbacks(m_work, TRUE);
+        CloseThreadpoolWork(m_work);
+    }
+}
+
+HRESULT CPowerRenamePreviewEngine::Run(
+    _In_ const std::vector<CComPtr<IPowerRenameItem>>& items,
+    _In_ IPowerRenameRegEx* renameRegEx,
+    _In_opt_ HANDLE cancelEvent,
+    _In_ const ItemUpdatedCallback& onItemUpdated)
+{
+    CItemSnapshot snapshot(items);
+    return Run(snapshot, renameRegEx, cancelEvent, onItemUpdated);
+}
+
+HRESULT CPowerRenamePreviewEngine::Run(
+    _In_ Items& items,
+    _In_ IPowerRenameRegEx* renameRegEx,
+    _In_opt_ HANDLE cancelEvent,
+    _In_ const ItemUpdatedCallback& onItemUpdated)
+{
+    const size_t itemCount = items.GetCount();
+    m_lastRunStats = RunStats();
+
+    DWORD flags = 0;
+    HRESULT hr = renameRegEx->GetFlags(&flags);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    CComHeapPtr<wchar_t> searchTerm;
+    hr = renameRegEx->GetSearchTerm(&searchTerm);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    CComHeapPtr<wchar_t> replaceTerm;
+    hr = renameRegEx->GetReplaceTerm(&replaceTerm);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    const bool useFileTime = isFileTimeUsed(replaceTerm);
+
+    // Every item runs the search and replace stage again when one of its inputs changed
+    ReplaceInputs replaceInputs;
+    replaceInputs.renameRegEx = renameRegEx;
+    replaceInputs.searchTerm = searchTerm ? searchTerm.m_pData : L"";
+    replaceInputs.replaceTerm = replaceTerm ? replaceTerm.m_pData : L"";
+    replaceInputs.flags = flags & c_replaceFlags;
+    if (m_replaceGeneration == 0 || !(replaceInputs == m_replaceInputs))
+    {
+        m_replaceInputs = replaceInputs;
+        m_replaceGeneration++;
+    }
+
+    // Entries whose item id does not match are reset by _UpdateItemState
+    m_itemStates.resize(itemCount);
+
+    std::atomic<UINT> replaced{ 0 };
+    std::atomic<UINT> trimmed{ 0 };
+    std::atomic<UINT> transformed{ 0 };
+    std::atomic<UINT> committed{ 0 };
+    auto addStats = [&](const RunStats& stats) {
+        replaced += stats.replaced;
+        trimmed += stats.trimmed;
+        transformed += stats.transformed;
+        committed += stats.committed;
+    };
+
+    auto commit = [&](size_t index, unsigned long enumIndex, RunStats& stats) -> HRESULT {
+        ItemState& state = m_itemStates[index];
+        const bool excluded = IsExcluded(state.isFolder, state.isSubFolderContent, flags);
+        PCWSTR newNameToUse = (!excluded && state.hasNewName) ? state.newName.c_str() : nullptr;
+
+        wchar_t uniqueName[MAX_PATH] = { 0 };
+        if (newNameToUse != nullptr && (flags & EnumerateItems))
+        {
+            unsigned long countUsed = 0;
+            if (GetEnumeratedFileName(uniqueName, ARRAYSIZE(uniqueName), newNameToUse, nullptr, enumIndex, &countUsed))
+            {
+                newNameToUse = uniqueName;
+            }
+        }
+
+        // The item already has this new name
+        if (state.isCommitted && state.hasCommittedName == (newNameToUse != nullptr) &&
+            (newNameToUse == nullptr || state.committedName == newNameToUse))
+        {
+            return S_OK;
+        }
+
+        stats.committed++;
+        bool changed = false;
+        HRESULT hrCommit = items.PutNewName(index, newNameToUse, &changed);
+        if (SUCCEEDED(hrCommit))
+        {
+            state.isCommitted = true;
+            state.hasCommittedName = (newNameToUse != nullptr);
+            state.committedName = state.hasCommittedName ? newNameToUse : L"";
+
+            // Was there a change?  Excluded items are always reported the first time.
+            if (excluded || changed)
+            {
+                onItemUpdated(static_cast<UINT>(index), state.id);
+            }
+        }
+        return hrCommit;
+    };
+
+    if (!(flags & EnumerateItems))
+    {
+        // Every item is independent so compute and publish in a single pass
+        hr = _ForEachChunk(itemCount, cancelEvent, [&](size_t begin, size_t end) {
+            RunStats stats;
+            HRESULT hrChunk = S_OK;
+            for (size_t i = begin; i < end && SUCCEEDED(hrChunk); i++)
+            {
+                hrChunk = _UpdateItemState(items, i, renameRegEx, flags, useFileTime, m_itemStates[i], stats);
+                if (SUCCEEDED(hrChunk))
+                {
+                    hrChunk = commit(i, 0, stats);
+                }
+            }
+            addStats(stats);
+            return hrChunk;
+        });
+    }
+    else
+    {
+        // The enumeration counter of an item depends on how many items before it got a new name.
+        // Compute the names in parallel, number them in index order, then publish in parallel.
+        hr = _ForEachChunk(itemCount, cancelEvent, [&](size_t begin, size_t end) {
+            RunStats stats;
+            HRESULT hrChunk = S_OK;
+            for (size_t i = begin; i < end && SUCCEEDED(hrChunk); i++)
+            {
+                hrChunk = _UpdateItemState(items, i, renameRegEx, flags, useFileTime, m_itemStates[i], stats);
+            }
+            addStats(stats);
+            return hrChunk;
+        });
+
+        if (SUCCEEDED(hr))
+        {
+            std::vector<unsigned long> enumIndices(itemCount);
+            unsigned long itemEnumIndex = 1;
+            for (size_t i = 0; i < itemCount; i++)
+            {
+                const ItemState& state = m_itemStates[i];
+                if (!IsExcluded(state.isFolder, state.isSubFolderContent, flags) && state.hasNewName)
+                {
+                    enumIndices[i] = itemEnumIndex++;
+                }
+            }
+
+            hr = _ForEachChunk(itemCount, cancelEvent, [&](size_t begin, size_t end) {
+                RunStats stats;
+                HRESULT hrChunk = S_OK;
+                for (size_t i = begin; i < end && SUCCEEDED(hrChunk); i++)
+                {
+                    hrChunk = commit(i, enumIndices[i], stats);
+                }
+                addStats(stats);
+                return hrChunk;
+            });
+        }
+    }
+
+    m_lastRunStats.replaced = replaced;
+    m_lastRunStats.trimmed = trimmed;
+    m_lastRunStats.transformed = transformed;
+    m_lastRunStats.committed = committed;
+    return hr;
+}
+
+void CPowerRenamePreviewEngine::Reset()
+{
+    m_replaceInputs = ReplaceInputs();
+    m_replaceGeneration = 0;
+    m_itemStates.clear();
+    m_lastRunStats = RunStats();
+}
+
+HRESULT CPowerRenamePreviewEngine::_UpdateItemState(_In_ Items& items, _In_ size_t index, _In_ IPowerRenameRegEx* renameRegEx, DWORD flags, bool useFileTime, _Inout_ ItemState& state, _Inout_ RunStats& stats) const
+{
+    int id = -1;
+    HRESULT hr = items.GetId(index, &id);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    if (state.id != id)
+    {
+        state = ItemState();
+        state.id = id;
+    }
+
+    // These never change for an item
+    if (!state.hasItemInfo)
+    {
+        hr = items.GetInfo(index, &state.isFolder, &state.isSubFolderContent, state.originalName);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        state.hasItemInfo = true;
+    }
+
+    // The results of the stages are kept for when the item is included again
+    if (IsExcluded(state.isFolder, state.isSubFolderContent, flags))
+    {
+        return S_OK;
+    }
+
+    if (state.replaceGeneration != m_replaceGeneration)
+    {
+        state.isTrimValid = false;
+        hr = ReplaceName(items, index, renameRegEx, state.originalName.c_str(), flags, useFileTime, state.sourceName, &state.hasReplacement, state.replacement);
+        if (FAILED(hr))
+        {
+            state.replaceGeneration = 0;
+            return hr;
+        }
+        state.replaceGeneration = m_replaceGeneration;
+        stats.replaced++;
+    }
+
+    // No replacement likely means we have an empty search string.  We should leave the
+    // new name empty so we clear the renamed column, except when a string transformation is selected.
+    const bool trimUsesSourceName = !state.hasReplacement && IsTransformFlagSet(flags);
+    if (!state.isTrimValid || state.trimUsesSourceName != trimUsesSourceName)
+    {
+        state.isTransformValid = false;
+        state.hasTrimmedName = state.hasReplacement || trimUsesSourceName;
+        state.trimmedName.clear();
+        if (state.hasTrimmedName)
+        {
+            hr = TrimName(state.originalName.c_str(), trimUsesSourceName ? state.sourceName.c_str() : state.replacement.c_str(), flags, state.trimmedName);
+            if (FAILED(hr))
+            {
+                state.isTrimValid = false;
+                return hr;
+            }
+        }
+        state.trimUsesSourceName = trimUsesSourceName;
+        state.isTrimValid = true;
+        stats.trimmed++;
+    }
+
+    const DWORD transformFlags = flags & c_transformFlags;
+    if (!state.isTransformValid || state.transformFlags != transformFlags)
+    {
+        state.isTransformValid = false;
+        state.hasNewName = false;
+        state.newName.clear();
+        if (state.hasTrimmedName)
+        {
+            hr = TransformName(state.originalName.c_str(), state.trimmedName.c_str(), flags, &state.hasNewName, state.newName);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+        state.transformFlags = transformFlags;
+        state.isTransformValid = true;
+        stats.transformed++;
+    }
+
+    return S_OK;
+}
+
+HRESULT CPowerRenamePreviewEngine::_ForEachChunk(_In_ size_t itemCount, _In_opt_ HANDLE cancelEvent, _In_ const std::function<HRESULT(size_t begin, size_t end)>& work)
+{
+    const size_t chunkCount = (itemCount + ChunkSize - 1) / ChunkSize;
+    std::atomic<size_t> nextChunk{ 0 };
+    std::atomic<bool> stop{ false };
+    std::atomic<HRESULT> result{ S_OK };
+
+    auto fail = [&](HRESULT hr) {
+        // Keep the first failure
+        HRESULT expected = S_OK;
+        result.compare_exchange_strong(expected, hr);
+        stop = true;
+    };
+
+    const std::function<void()> worker = [&]() {
+        try
+        {
+            while (!stop)
+            {
+                const size_t chunk = nextChunk++;
+                if (chunk >= chunkCount)
+                {
+                    break;
+                }
+
+                // Check if cancel event is signaled
+                if (cancelEvent && WaitForSingleObject(cancelEvent, 0) == WAIT_OBJECT_0)
+                {
+                    fail(E_ABORT);
+                    break;
+                }
+
+                const size_t begin = chunk * ChunkSize;
+                const HRESULT hr = work(begin, std::min(begin + ChunkSize, itemCount));
+                if (FAILED(hr))
+                {
+                    fail(hr);
+                }
+            }
+        }
+        catch (...)
+        {
+            fail(E_FAIL);
+        }
+    };
+
+    // The calling thread is one of the workers and claims chunks until none is left, so the
+    // run completes even when the thread pool starts fewer workers
+    const size_t threadCount = m_work ? std::min(static_cast<size_t>(m_threadCount), chunkCount) : 1;
+    m_worker = &worker;
+    for (size_t i = 1; i < threadCount; i++)
+    {
+        SubmitThreadpoolWork(m_work);
+    }
+
+    worker();
+
+    if (threadCount > 1)
+    {
+        WaitForThreadpoolWorkCallbacks(m_work, FALSE);
+    }
+    m_worker = nullptr;
+
+    return result;
+}
+
+void CALLBACK CPowerRenamePreviewEngine::s_workCallback(_Inout_ PTP_CALLBACK_INSTANCE, _Inout_opt_ PVOID context, _Inout_ PTP_WORK)
+{
+    (*reinterpret_cast<CPowerRenamePreviewEngine*>(context)->m_worker)();
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include "pch.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "PowerRenameInterfaces.h"
+
+// Computes the preview (new name) of a snapshot of rename items on the calling thread and
+// the thread pool.  Items are split in fixed size chunks that idle workers claim one after the
+// other so that a slow chunk never holds the others back.  Results are identical to
+// processing the items one by one in index order, including the EnumerateItems counter.
+//
+// The preview of an item goes through the following stages:
+//   search and replace - select the part of the name to match and run the regex on it
+//   trim               - put the name back together and trim it
+//   transform          - apply the case transform flags
+//   enumerate          - number the renamed items and hand the new name to the item
+// The result of each stage is kept per item between runs.  When an input changes only
+// the stages that depend on it run again, so toggling a case or exclude flag does not
+// run the regex on every item and items whose new name did not change are left alone.
+class CPowerRenamePreviewEngine
+{
+public:
+    // Called from the worker threads for every item whose new name was (re)set, with the
+    // index of the item in the snapshot
+    using ItemUpdatedCallback = std::function<void(_In_ UINT index, _In_ int id)>;
+
+    // Number of items a worker claims at a time.  Cancellation is checked between chunks.
+    static const UINT ChunkSize = 256;
+
+    // Number of items each stage ran for during the last run
+    struct RunStats
+    {
+        UINT replaced = 0;
+        UINT trimmed = 0;
+        UINT transformed = 0;
+        UINT committed = 0;
+    };
+
+    // Items of a run, addressed by their index in the snapshot.  Called from the worker threads.
+    class Items
+    {
+    public:
+        virtual ~Items() = default;
+        virtual size_t GetCount() const = 0;
+        virtual HRESULT GetId(_In_ size_t index, _Out_ int* id) = 0;
+        virtual HRESULT GetInfo(_In_ size_t index, _Out_ bool* isFolder, _Out_ bool* isSubFolderContent, _Out_ std::wstring& originalName) = 0;
+        virtual HRESULT GetTime(_In_ size_t index, _Out_ SYSTEMTIME* time) = 0;
+        // nullptr clears the new name.  *changed is false when the item already had this new name.
+        virtual HRESULT PutNewName(_In_ size_t index, _In_opt_ PCWSTR newName, _Out_ bool* changed) = 0;
+    };
+
+    // threadCount == 0 means one worker per logical processor
+    explicit CPowerRenamePreviewEngine(UINT threadCount = 0);
+    ~CPowerRenamePreviewEngine();
+
+    // Returns S_OK when every item was processed, E_ABORT when cancelEvent was signaled
+    // and the first failure otherwise.  Runs must not overlap.
+    HRESULT Run(
+        _In_ Items& items,
+        _In_ IPowerRenameRegEx* renameRegEx,
+        _In_opt_ HANDLE cancelEvent,
+        _In_ const ItemUpdatedCallback& onItemUpdated);
+    HRESULT Run(
+        _In_ const std::vector<CComPtr<IPowerRenameItem>>& items,
+        _In_ IPowerRenameRegEx* renameRegEx,
+        _In_opt_ HANDLE cancelEvent,
+        _In_ const ItemUpdatedCallback& onItemUpdated);
+
+    // Drops the results kept from previous runs
+    void Reset();
+
+    UINT GetThreadCount() const { return m_threadCount; }
+    const RunStats& GetLastRunStats() const { return m_lastRunStats; }
+
+private:
+    // Everything the search and replace stage depends on apart from the item itself
+    struct ReplaceInputs
+    {
+        CComPtr<IPowerRenameRegEx> renameRegEx;
+        std::wstring searchTerm;
+        std::wstring replaceTerm;
+        DWORD flags = 0;
+
+        bool operator==(const ReplaceInputs& other) const
+        {
+            return renameRegEx == other.renameRegEx && searchTerm == other.searchTerm && replaceTerm == other.replaceTerm && flags == other.flags;
+        }
+    };
+
+    // Results of the stages for one item, valid for the item with the same id only
+    struct ItemState
+    {
+        int id = -1;
+        bool hasItemInfo = false;
+        bool isFolder = false;
+        bool isSubFolderContent = false;
+        std::wstring originalName;
+
+        // Search and replace, 0 until it ran with the inputs of m_replaceGeneration
+        UINT replaceGeneration = 0;
+        std::wstring sourceName;
+        bool hasReplacement = false;
+        std::wstring replacement;
+
+        // Trim
+        bool isTrimValid = false;
+        bool trimUsesSourceName = false;
+        bool hasTrimmedName = false;
+        std::wstring trimmedName;
+
+        // Transform
+        bool isTransformValid = false;
+        DWORD transformFlags = 0;
+        bool hasNewName = false;
+        std::wstring newName;
+
+        // New name last handed to the item
+        bool isCommitted = false;
+        bool hasCommittedName = false;
+        std::wstring committedName;
+    };
+
+    HRESULT _UpdateItemState(_In_ Items& items, _In_ size_t index, _In_ IPowerRenameRegEx* renameRegEx, DWORD flags, bool useFileTime, _Inout_ ItemState& state, _Inout_ RunStats& stats) const;
+
+    // Runs work(chunkIndex) for every chunk on the worker threads until all chunks are
+    // done, the run is canceled or a chunk fails.
+    HRESULT _ForEachChunk(_In_ size_t itemCount, _In_opt_ HANDLE cancelEvent, _In_ const std::function<HRESULT(size_t begin, size_t end)>& work);
+    static void CALLBACK s_workCallback(_Inout_ PTP_CALLBACK_INSTANCE instance, _Inout_opt_ PVOID context, _Inout_ PTP_WORK work);
+
+    UINT m_threadCount = 1;
+    // Submitted once per extra worker of a run, the calling thread being the first worker.
+    // Without it the chunks all run on the calling thread.
+    PTP_WORK m_work = nullptr;
+    // Worker of the current run, read by the thread pool callbacks
+    const std::function<void()>* m_worker = nullptr;
+
+    ReplaceInputs m_replaceInputs;
+    UINT m_replaceGeneration = 0;
+    // Parallel to the items of the last run
+    std::vector<ItemState> m_itemStates;
+    RunStats m_lastRunStats;
+};
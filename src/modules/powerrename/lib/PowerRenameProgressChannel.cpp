@@ -0,0 +1,186 @@
+#include "pch.h"
+#include "PowerRenameProgressChannel.h"
+#include <algorithm>
+
+namespace
+{
+    const size_t c_bitsPerWord = 64;
+}
+
+CPowerRenameProgressChannel::CPowerRenameProgressChannel(_In_ std::function<void()> notify) :
+    m_notify(std::move(notify))
+{
+    // Without the timer pending updates still go out with the next item or Flush
+    m_timer = CreateThreadpoolTimer(s_timerCallback, this, nullptr);
+}
+
+CPowerRenameProgressChannel::~CPowerRenameProgressChannel()
+{
+    if (m_timer)
+    {
+        SetThreadpoolTimer(m_timer, nullptr, 0, 0);
+        WaitForThreadpoolTimerCallbacks(m_timer, TRUE);
+        CloseThreadpoolTimer(m_timer);
+    }
+}
+
+void CPowerRenameProgressChannel::MarkUpdated(_In_ UINT index)
+{
+    bool notify = false;
+    // Scope lock
+    {
+        CSRWExclusiveAutoLock lock(&m_lock);
+        const size_t word = index / c_bitsPerWord;
+        const UINT64 bit = 1ull << (index % c_bitsPerWord);
+        if (word >= m_dirty.size())
+        {
+            m_dirty.resize(word + 1);
+        }
+
+        if (!(m_dirty[word] & bit))
+        {
+            if (m_pendingCount == 0)
+            {
+                m_firstDirtyWord = word;
+                m_lastDirtyWord = word;
+            }
+            else
+            {
+                m_firstDirtyWord = std::min(m_firstDirtyWord, word);
+                m_lastDirtyWord = std::max(m_lastDirtyWord, word);
+            }
+            m_dirty[word] |= bit;
+            m_pendingCount++;
+        }
+
+        m_counters.itemsUpdated++;
+        notify = _ShouldNotify(false);
+        if (!notify && !m_isNotified)
+        {
+            _ArmTimer();
+        }
+    }
+
+    if (notify)
+    {
+        m_notify();
+    }
+}
+
+void CPowerRenameProgressChannel::Flush()
+{
+    bool notify = false;
+    // Scope lock
+    {
+        CSRWExclusiveAutoLock lock(&m_lock);
+        notify = _ShouldNotify(true);
+    }
+
+    if (notify)
+    {
+        m_notify();
+    }
+}
+
+void CPowerRenameProgressChannel::TakeUpdatedRanges(_Out_ std::vector<ItemRange>& ranges)
+{
+    ranges.clear();
+
+    CSRWExclusiveAutoLock lock(&m_lock);
+    m_isNotified = false;
+    if (m_pendingCount == 0)
+    {
+        return;
+    }
+
+    for (size_t word = m_firstDirtyWord; word <= m_lastDirtyWord; word++)
+    {
+        UINT64 bits = m_dirty[word];
+        m_dirty[word] = 0;
+        for (size_t bit = 0; bits != 0; bit++, bits >>= 1)
+        {
+            if (!(bits & 1))
+            {
+                continue;
+            }
+
+            const UINT index = static_cast<UINT>(word * c_bitsPerWord + bit);
+            if (!ranges.empty() && ranges.back().last + 1 == index)
+            {
+                ranges.back().last = index;
+            }
+            else
+            {
+                ranges.push_back({ index, index });
+            }
+        }
+    }
+
+    m_pendingCount = 0;
+    m_counters.ranges += ranges.size();
+}
+
+CPowerRenameProgressChannel::Counters CPowerRenameProgressChannel::GetCounters()
+{
+    CSRWSharedAutoLock lock(&m_lock);
+    return m_counters;
+}
+
+bool CPowerRenameProgressChannel::_ShouldNotify(bool force)
+{
+    if (m_isNotified || m_pendingCount == 0)
+    {
+        return false;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!force && m_pendingCount < FlushItemCount && now - m_lastNotification < FlushInterval)
+    {
+        return false;
+    }
+
+    m_isNotified = true;
+    m_lastNotification = now;
+    m_counters.notifications++;
+    return true;
+}
+
+void CPowerRenameProgressChannel::_ArmTimer()
+{
+    if (!m_timer || m_isTimerArmed)
+    {
+        return;
+    }
+
+    // Relative due time in 100 nanoseconds units
+    const auto elapsed = std::chrono::steady_clock::now() - m_lastNotification;
+    const auto remaining = std::max(std::chrono::duration_cast<std::chrono::microseconds>(FlushInterval - elapsed), std::chrono::microseconds(0));
+    ULARGE_INTEGER dueTime;
+    dueTime.QuadPart = static_cast<ULONGLONG>(-10 * remaining.count());
+    FILETIME fileDueTime;
+    fileDueTime.dwLowDateTime = dueTime.LowPart;
+    fileDueTime.dwHighDateTime = dueTime.HighPart;
+    SetThreadpoolTimer(m_timer, &fileDueTime, 0, 0);
+    m_isTimerArmed = true;
+}
+
+void CPowerRenameProgressChannel::_OnTimer()
+{
+    bool notify = false;
+    // Scope lock
+    {
+        CSRWExclusiveAutoLock lock(&m_lock);
+        m_isTimerArmed = false;
+        notify = _ShouldNotify(true);
+    }
+
+    if (notify)
+    {
+        m_notify();
+    }
+}
+
+void CALLBACK CPowerRenameProgressChannel::s_timerCallback(_Inout_ PTP_CALLBACK_INSTANCE, _Inout_opt_ PVOID context, _Inout_ PTP_TIMER)
+{
+    reinterpret_cast<CPowerRenameProgressChannel*>(context)->_OnTimer();
+}
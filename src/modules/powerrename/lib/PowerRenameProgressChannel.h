@@ -0,0 +1,68 @@
+#pragma once
+#include "pch.h"
+#include "PowerRenameInterfaces.h"
+#include "srwlock.h"
+#include <chrono>
+#include <functional>
+#include <vector>
+
+// Collects the indices of the items updated by the regex workers and hands them to the
+// manager thread as ranges.  Instead of one notification per item there is at most one
+// outstanding notification, sent once FlushInterval has passed since the previous one or
+// as soon as FlushItemCount items are pending.  A timer sends the updates still pending
+// after FlushInterval when no more items are marked.  Flush sends what is left at the end
+// of a run.
+class CPowerRenameProgressChannel
+{
+public:
+    using ItemRange = PowerRenameItemRange;
+
+    struct Counters
+    {
+        // Calls to MarkUpdated, an item marked again before it was taken counts twice
+        UINT64 itemsUpdated = 0;
+        UINT64 notifications = 0;
+        UINT64 ranges = 0;
+    };
+
+    static constexpr std::chrono::milliseconds FlushInterval{ 16 };
+    static const UINT FlushItemCount = 1024;
+
+    // notify is called on the thread marking the items, or on a thread pool thread for the
+    // timed flush, without the lock held, and should get TakeUpdatedRanges called on the
+    // consumer thread.
+    explicit CPowerRenameProgressChannel(_In_ std::function<void()> notify);
+    ~CPowerRenameProgressChannel();
+
+    // Safe to call from several threads at once
+    void MarkUpdated(_In_ UINT index);
+    void Flush();
+
+    // Moves the pending updates to ranges in index order, adjacent items merged
+    void TakeUpdatedRanges(_Out_ std::vector<ItemRange>& ranges);
+
+    Counters GetCounters();
+
+private:
+    // Returns true when the caller should notify once the lock is released
+    _Requires_exclusive_lock_held_(m_lock) bool _ShouldNotify(bool force);
+    // Arms the timer to flush the pending updates once FlushInterval has passed
+    _Requires_exclusive_lock_held_(m_lock) void _ArmTimer();
+    void _OnTimer();
+    static void CALLBACK s_timerCallback(_Inout_ PTP_CALLBACK_INSTANCE instance, _Inout_opt_ PVOID context, _Inout_ PTP_TIMER timer);
+
+    std::function<void()> m_notify;
+
+    CSRWLock m_lock;
+    // One bit per item index and the range of words with a bit set
+    _Guarded_by_(m_lock) std::vector<UINT64> m_dirty;
+    _Guarded_by_(m_lock) size_t m_firstDirtyWord = 0;
+    _Guarded_by_(m_lock) size_t m_lastDirtyWord = 0;
+    _Guarded_by_(m_lock) UINT m_pendingCount = 0;
+    // A notification was sent and the updates were not taken yet
+    _Guarded_by_(m_lock) bool m_isNotified = false;
+    _Guarded_by_(m_lock) bool m_isTimerArmed = false;
+    PTP_TIMER m_timer = nullptr;
+    _Guarded_by_(m_lock) std::chrono::steady_clock::time_point m_lastNotification;
+    _Guarded_by_(m_lock) Counters m_counters;
+};
@@ -4,12 +4,46 @@
 #include <regex>
 #include <string>
 #include <algorithm>
-#include <boost/regex.hpp>
 #include <helpers.h>
+#include "DatedFileNameTemplate.h"
+#include "LiteralMatcher.h"
+#include "PowerRenameRegExBackend.h"
 
 using namespace std;
 using std::regex_error;
 
+struct CPowerRenameRegEx::CompiledPattern
+{
+    DWORD flags = 0;
+    // False when the search term is not a valid regular expression
+    bool isValid = true;
+    std::wstring searchTerm;
+    // Replace term with $0 and $1..$9 already rewritten for regex_replace
+    std::wstring replaceTerm;
+    // Replace term with its file time tokens located, expanded for every item
+    CDatedFileNameTemplate datedReplaceTerm;
+    // Null when regular expressions are off or the search term is not valid
+    std::unique_ptr<CPowerRenameRegExBackend> backend;
+    // The search term is taken literally, either because regular expressions are off
+    // or because it has no regular expression syntax
+    bool isLiteral = false;
+    CLiteralMatcher literalMatcher;
+};
+
+namespace
+{
+    // Rewrites $0 and $1..$9 in the replace term so that regex_replace treats them
+    // the way users expect. The patterns are compiled once per process.
+    std::wstring RewriteReplaceTerm(const std::wstring& replaceTerm)
+    {
+        static const std::wregex zeroGroupPattern(L"(([^\\$]|^)(\\$\\$)*)\\$[0]");
+        static const std::wregex numberedGroupPattern(L"(([^\\$]|^)(\\$\\$)*)\\$([1-9])");
+
+        std::wstring result = regex_replace(replaceTerm, zeroGroupPattern, L"$1$$$0");
+        return regex_replace(result, numberedGroupPattern, L"$1$0$4");
+    }
+}
+
 IFACEMETHODIMP_(ULONG) CPowerRenameRegEx::AddRef()
 {
     return InterlockedIncrement(&m_refCount);
@@ -97,6 +131,10 @@ IFACEMETHODIMP CPowerRenameRegEx::PutSearchTerm(_In_ PCWSTR searchTerm)
             changed = true;
             CoTaskMemFree(m_searchTerm);
             hr = SHStrDup(searchTerm, &m_searchTerm);
+            if (SUCCEEDED(hr))
+            {
+                _CompilePattern();
+            }
         }
     }
 
@@ -132,6 +170,10 @@ IFACEMETHODIMP CPowerRenameRegEx::PutReplaceTerm(_In_ PCWSTR replaceTerm)
             changed = true;
             CoTaskMemFree(m_replaceTerm);
             hr = SHStrDup(replaceTerm, &m_replaceTerm);
+            if (SUCCEEDED(hr))
+            {
+                _CompilePattern();
+            }
         }
     }
 
@@ -153,7 +195,12 @@ IFACEMETHODIMP CPowerRenameRegEx::PutFlags(_In_ DWORD flags)
 {
     if (m_flags != flags)
     {
-        m_flags = flags;
+        // Scope lock
+        {
+            CSRWExclusiveAutoLock lock(&m_lock);
+            m_flags = flags;
+            _CompilePattern();
+        }
         _OnFlagsChanged();
     }
     return S_OK;
@@ -213,6 +260,10 @@ CPowerRenameRegEx::CPowerRenameRegEx() :
     SHStrDup(L"", &m_replaceTerm);
 
     _useBoostLib = CSettingsInstance().GetUseBoostLib();
+    _useLinearRegEx = CSettingsInstance().GetUseLinearRegEx();
+
+    CSRWExclusiveAutoLock lock(&m_lock);
+    _CompilePattern();
 }
 
 CPowerRenameRegEx::~CPowerRenameRegEx()
@@ -221,91 +272,107 @@ CPowerRenameRegEx::~CPowerRenameRegEx()
     CoTaskMemFree(m_replaceTerm);
 }
 
+void CPowerRenameRegEx::_CompilePattern()
+{
+    auto compiled = std::make_shared<CompiledPattern>();
+    compiled->flags = m_flags;
+    compiled->searchTerm = m_searchTerm ? m_searchTerm : L"";
+    compiled->replaceTerm = RewriteReplaceTerm(m_replaceTerm ? m_replaceTerm : L"");
+    compiled->datedReplaceTerm = CDatedFileNameTemplate(m_replaceTerm);
+
+    const bool caseInsensitive = !(m_flags & CaseSensitive);
+    if (!compiled->searchTerm.empty() && (!(m_flags & UseRegularExpressions) || CLiteralMatcher::IsLiteralRegEx(compiled->searchTerm, caseInsensitive)))
+    {
+        compiled->isLiteral = true;
+        compiled->literalMatcher = CLiteralMatcher(compiled->searchTerm, caseInsensitive);
+    }
+
+    if ((m_flags & UseRegularExpressions) && !compiled->searchTerm.empty())
+    {
+        // Likely a partially typed expression when it fails. Replace reports it as a failure.
+        compiled->isValid = SUCCEEDED(CPowerRenameRegExBackend::s_Create(compiled->searchTerm, caseInsensitive, _useBoostLib, _useLinearRegEx, compiled->backend));
+    }
+
+    m_compiledPattern = compiled;
+}
+
 HRESULT CPowerRenameRegEx::Replace(_In_ PCWSTR source, _Outptr_ PWSTR* result)
+{
+    SYSTEMTIME fileTime = { 0 };
+    bool useFileTime = false;
+    // Scope lock
+    {
+        CSRWSharedAutoLock lock(&m_lock);
+        fileTime = m_fileTime;
+        useFileTime = m_useFileTime;
+    }
+
+    return _Replace(source, useFileTime ? &fileTime : nullptr, result);
+}
+
+HRESULT CPowerRenameRegEx::ReplaceWithFileTime(_In_ PCWSTR source, _In_ SYSTEMTIME fileTime, _Outptr_ PWSTR* result)
+{
+    return _Replace(source, &fileTime, result);
+}
+
+HRESULT CPowerRenameRegEx::_Replace(_In_ PCWSTR source, _In_opt_ const SYSTEMTIME* fileTime, _Outptr_ PWSTR* result)
 {
     *result = nullptr;
 
-    CSRWSharedAutoLock lock(&m_lock);
-    HRESULT hr = S_OK;
-    if (!(m_searchTerm && wcslen(m_searchTerm) > 0 && source && wcslen(source) > 0))
+    // Take a reference to the compiled pattern so the lock is not held while matching.
+    // The compiled pattern is immutable and can be used by several threads at once.
+    std::shared_ptr<const CompiledPattern> compiled;
+    // Scope lock
     {
-        return hr;
+        CSRWSharedAutoLock lock(&m_lock);
+        compiled = m_compiledPattern;
     }
-    wstring res = source;
-    try
+
+    if (compiled->searchTerm.empty() || !source || wcslen(source) == 0)
     {
-        // TODO: creating the regex could be costly.  May want to cache this.
-        wchar_t newReplaceTerm[MAX_PATH] = { 0 };
-        bool fileTimeErrorOccurred = false;
-        if (m_useFileTime)
-        {
-            if (FAILED(GetDatedFileName(newReplaceTerm, ARRAYSIZE(newReplaceTerm), m_replaceTerm, m_fileTime)))
-                fileTimeErrorOccurred = true;
-        }
+        return S_OK;
+    }
 
-        std::wstring sourceToUse(source);
-        std::wstring searchTerm(m_searchTerm);
-        std::wstring replaceTerm(L"");
-        if (m_useFileTime && !fileTimeErrorOccurred)
-        {
-            replaceTerm = wstring(newReplaceTerm);
-        }
-        else if (m_replaceTerm)
+    wstring replaceTerm = compiled->replaceTerm;
+    if (fileTime)
+    {
+        // The dated replace term used to be built in a MAX_PATH buffer and ignored when too long
+        wstring datedReplaceTerm;
+        if (SUCCEEDED(compiled->datedReplaceTerm.Format(*fileTime, datedReplaceTerm)) && datedReplaceTerm.length() < MAX_PATH)
         {
-            replaceTerm = wstring(m_replaceTerm);
+            replaceTerm = RewriteReplaceTerm(datedReplaceTerm);
         }
+    }
 
-        replaceTerm = regex_replace(replaceTerm, std::wregex(L"(([^\\$]|^)(\\$\\$)*)\\$[0]"), L"$1$$$0");
-        replaceTerm = regex_replace(replaceTerm, std::wregex(L"(([^\\$]|^)(\\$\\$)*)\\$([1-9])"), L"$1$0$4");
+    if (!compiled->isValid)
+    {
+        return E_FAIL;
+    }
 
-        if (m_flags & UseRegularExpressions)
+    HRESULT hr = S_OK;
+    wstring res = source;
+    try
+    {
+        // A literal regular expression still needs the regex engine when the replace term
+        // refers to the match
+        if (compiled->isLiteral && (!(compiled->flags & UseRegularExpressions) || CLiteralMatcher::IsLiteralReplaceTerm(replaceTerm)))
         {
-            if (_useBoostLib)
-            {
-                boost::wregex pattern(m_searchTerm, (!(m_flags & CaseSensitive)) ? boost::regex::icase | boost::regex::ECMAScript : boost::regex::ECMAScript);
-                if (m_flags & MatchAllOccurences)
-                {
-                    res = boost::regex_replace(wstring(source), pattern, replaceTerm);
-                }
-                else
-                {
-                    res = boost::regex_replace(wstring(source), pattern, replaceTerm, boost::regex_constants::format_first_only);
-                }
-            }
-            else
-            {
-                std::wregex pattern(m_searchTerm, (!(m_flags & CaseSensitive)) ? regex_constants::icase | regex_constants::ECMAScript : regex_constants::ECMAScript);
-                if (m_flags & MatchAllOccurences)
-                {
-                    res = regex_replace(wstring(source), pattern, replaceTerm);
-                }
-                else
-                {
-                    res = regex_replace(wstring(source), pattern, replaceTerm, regex_constants::format_first_only);
-                }
-            }
+            // Simple search and replace
+            wstring replaced;
+            compiled->literalMatcher.Replace(res, replaceTerm, (compiled->flags & MatchAllOccurences) != 0, replaced);
+            res = std::move(replaced);
         }
         else
         {
-            // Simple search and replace
-            size_t pos = 0;
-            do
-            {
-                pos = _Find(sourceToUse, searchTerm, (!(m_flags & CaseSensitive)), pos);
-                if (pos != std::string::npos)
-                {
-                    res = sourceToUse.replace(pos, searchTerm.length(), replaceTerm);
-                    pos += replaceTerm.length();
-                }
-
-                if (!(m_flags & MatchAllOccurences))
-                {
-                    break;
-                }
-            } while (pos != std::string::npos);
+            wstring replaced;
+            hr = compiled->backend->Replace(res, replaceTerm, (compiled->flags & MatchAllOccurences) != 0, replaced);
+            res = std::move(replaced);
         }
 
-        hr = SHStrDup(res.c_str(), result);
+        if (SUCCEEDED(hr))
+        {
+            hr = SHStrDup(res.c_str(), result);
+        }
     }
     catch (regex_error e)
     {
@@ -314,19 +381,6 @@ HRESULT CPowerRenameRegEx::Replace(_In_ PCWSTR source, _Outptr_ PWSTR* result)
     return hr;
 }
 
-size_t CPowerRenameRegEx::_Find(std::wstring data, std::wstring toSearch, bool caseInsensitive, size_t pos)
-{
-    if (caseInsensitive)
-    {
-        // Convert to lower
-        std::transform(data.begin(), data.end(), data.begin(), ::towlower);
-        std::transform(toSearch.begin(), toSearch.end(), toSearch.begin(), ::towlower);
-    }
-
-    // Find sub string position in given string starting at position pos
-    return data.find(toSearch, pos);
-}
-
 void CPowerRenameRegEx::_OnSearchTermChanged()
 {
     CSRWSharedAutoLock lock(&m_lockEvents);
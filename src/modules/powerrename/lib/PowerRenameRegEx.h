@@ -2,6 +2,7 @@
 #include "pch.h"
 #include <vector>
 #include <string>
+#include <memory>
 #include "srwlock.h"
 
 #include "PowerRenameInterfaces.h"
@@ -28,6 +29,7 @@ public:
     IFACEMETHODIMP PutFileTime(_In_ SYSTEMTIME fileTime);
     IFACEMETHODIMP ResetFileTime();
     IFACEMETHODIMP Replace(_In_ PCWSTR source, _Outptr_ PWSTR* result);
+    IFACEMETHODIMP ReplaceWithFileTime(_In_ PCWSTR source, _In_ SYSTEMTIME fileTime, _Outptr_ PWSTR* result);
 
     static HRESULT s_CreateInstance(_Outptr_ IPowerRenameRegEx **renameRegEx);
 
@@ -40,13 +42,21 @@ protected:
     void _OnFlagsChanged();
     void _OnFileTimeChanged();
 
-    size_t _Find(std::wstring data, std::wstring toSearch, bool caseInsensitive, size_t pos);
+    // Compiled form of the search term, replace term and flags. Defined in the
+    // .cpp so that regex engine headers stay out of this header.
+    struct CompiledPattern;
+
+    _Requires_exclusive_lock_held_(m_lock) void _CompilePattern();
+    HRESULT _Replace(_In_ PCWSTR source, _In_opt_ const SYSTEMTIME* fileTime, _Outptr_ PWSTR* result);
 
     bool _useBoostLib = false;
+    bool _useLinearRegEx = false;
     DWORD m_flags = DEFAULT_FLAGS;
     PWSTR m_searchTerm = nullptr;
     PWSTR m_replaceTerm = nullptr;
 
+    _Guarded_by_(m_lock) std::shared_ptr<const CompiledPattern> m_compiledPattern;
+
     SYSTEMTIME m_fileTime = {0};
     bool m_useFileTime = false;
 
@@ -0,0 +1,369 @@
+#include "pch.h"
+#include "PowerRenameRegExBackend.h"
+#include "LinearRegEx.h"
+#include "srwlock.h"
+#include <regex>
+#include <vector>
+#include <boost/regex.hpp>
+
+namespace
+{
+    class CStdRegExBackend :
+        public CPowerRenameRegExBackend
+    {
+    public:
+        explicit CStdRegExBackend(std::wregex pattern) :
+            m_pattern(std::move(pattern))
+        {
+        }
+
+        Engine GetEngine() const override { return Engine::Std; }
+
+        HRESULT Replace(_In_ const std::wstring& source, _In_ const std::wstring& replaceTerm, _In_ bool matchAll, _Out_ std::wstring& result) const override
+        {
+            try
+            {
+                result = matchAll ? std::regex_replace(source, m_pattern, replaceTerm) : std::regex_replace(source, m_pattern, replaceTerm, std::regex_constants::format_first_only);
+                return S_OK;
+            }
+            catch (const std::regex_error&)
+            {
+                // Complexity or stack limit reached while matching
+                result.clear();
+                return E_FAIL;
+            }
+        }
+
+    private:
+        std::wregex m_pattern;
+    };
+
+    class CBoostRegExBackend :
+        public CPowerRenameRegExBackend
+    {
+    public:
+        explicit CBoostRegExBackend(boost::wregex pattern) :
+            m_pattern(std::move(pattern))
+        {
+        }
+
+        Engine GetEngine() const override { return Engine::Boost; }
+
+        HRESULT Replace(_In_ const std::wstring& source, _In_ const std::wstring& replaceTerm, _In_ bool matchAll, _Out_ std::wstring& result) const override
+        {
+            try
+            {
+                result = matchAll ? boost::regex_replace(source, m_pattern, replaceTerm) : boost::regex_replace(source, m_pattern, replaceTerm, boost::regex_constants::format_first_only);
+                return S_OK;
+            }
+            catch (const boost::regex_error&)
+            {
+                // Complexity or stack limit reached while matching
+                result.clear();
+                return E_FAIL;
+            }
+        }
+
+    private:
+        boost::wregex m_pattern;
+    };
+
+    // The replacement of a match as literal text and parts of the match
+    struct ReplaceFormat
+    {
+        enum PieceType
+        {
+            Literal,
+            Group,
+            Prefix,
+            Suffix
+        };
+
+        struct Piece
+        {
+            PieceType type;
+            // Group number, or offset of the text in literals
+            size_t index;
+            size_t length;
+        };
+
+        // False when the replacement cannot be built from the pieces
+        bool isSupported = true;
+        std::wstring literals;
+        std::vector<Piece> pieces;
+    };
+
+    // Unicode noncharacters, which neither file names nor replace terms contain.  They make
+    // up the probe the replace term of the linear engine is formatted for.
+    const wchar_t c_probeMatchBegin = 0xFDD0;
+    const wchar_t c_probeMatchEnd = 0xFDD1;
+    const wchar_t c_probePrefix = 0xFDD2;
+    const wchar_t c_probeSuffix = 0xFDD3;
+    // Group n is c_probeFirstGroup + n - 1
+    const wchar_t c_probeFirstGroup = 0xFDD4;
+    const wchar_t c_probeLast = 0xFDEF;
+
+    // Finds matches with CLinearRegEx.  The replacement of a match is formatted the way the
+    // std or Boost engine formats it: the replace term is formatted once by that engine
+    // for a probe match made of placeholder characters, and the placeholders found in the
+    // result tell which part of the match goes where.  Matches are iterated the way that
+    // engine does it too: Boost allows an empty match right after a match, std does not.
+    class CLinearRegExBackend :
+        public CPowerRenameRegExBackend
+    {
+    public:
+        static const UINT MaxGroupCount = c_probeLast - c_probeFirstGroup + 1;
+
+        CLinearRegExBackend(std::unique_ptr<CLinearRegEx> regex, std::unique_ptr<CPowerRenameRegExBackend> fallback, bool useBoostLib) :
+            m_regex(std::move(regex)),
+            m_fallback(std::move(fallback)),
+            m_useBoostLib(useBoostLib)
+        {
+            // Probe text: prefix, whole match made of one character per group, suffix.
+            // The probe pattern matches the whole match and captures every group.
+            std::wstring probePattern(1, c_probeMatchBegin);
+            m_probe.push_back(c_probePrefix);
+            m_probe.push_back(c_probeMatchBegin);
+            for (UINT group = 0; group < m_regex->GetGroupCount(); group++)
+            {
+                const wchar_t placeholder = static_cast<wchar_t>(c_probeFirstGroup + group);
+                m_probe.push_back(placeholder);
+                probePattern += L'(';
+                probePattern += placeholder;
+                probePattern += L')';
+            }
+            m_probe.push_back(c_probeMatchEnd);
+            m_probe.push_back(c_probeSuffix);
+            probePattern.push_back(c_probeMatchEnd);
+
+            if (m_useBoostLib)
+            {
+                m_boostProbePattern.assign(probePattern, boost::regex::ECMAScript);
+            }
+            else
+            {
+                m_stdProbePattern.assign(probePattern, std::regex_constants::ECMAScript);
+            }
+        }
+
+        Engine GetEngine() const override { return Engine::Linear; }
+
+        HRESULT Replace(_In_ const std::wstring& source, _In_ const std::wstring& replaceTerm, _In_ bool matchAll, _Out_ std::wstring& result) const override
+        {
+            std::shared_ptr<const ReplaceFormat> format = _GetFormat(replaceTerm);
+            if (!format->isSupported)
+            {
+                return m_fallback->Replace(source, replaceTerm, matchAll, result);
+            }
+
+            result.clear();
+            CLinearRegEx::Captures captures;
+            size_t copied = 0;
+            size_t start = 0;
+            size_t noEmptyMatchAt = std::wstring::npos;
+            while (m_regex->Search(source, start, noEmptyMatchAt, captures))
+            {
+                const size_t matchBegin = captures[0];
+                const size_t matchEnd = captures[1];
+                result.append(source, copied, matchBegin - copied);
+                _AppendReplacement(*format, source, captures, copied, result);
+                copied = matchEnd;
+
+                if (!matchAll)
+                {
+                    break;
+                }
+                start = matchEnd;
+                noEmptyMatchAt = (matchBegin == matchEnd || !m_useBoostLib) ? matchEnd : std::wstring::npos;
+            }
+            result.append(source, copied, std::wstring::npos);
+            return S_OK;
+        }
+
+    private:
+        std::shared_ptr<const ReplaceFormat> _GetFormat(_In_ const std::wstring& replaceTerm) const
+        {
+            // Scope lock
+            {
+                CSRWSharedAutoLock lock(&m_formatLock);
+                if (m_lastFormat && m_lastReplaceTerm == replaceTerm)
+                {
+                    return m_lastFormat;
+                }
+            }
+
+            auto format = std::make_shared<ReplaceFormat>();
+            format->isSupported = _CompileFormat(replaceTerm, *format);
+
+            CSRWExclusiveAutoLock lock(&m_formatLock);
+            m_lastReplaceTerm = replaceTerm;
+            m_lastFormat = format;
+            return format;
+        }
+
+        bool _CompileFormat(_In_ const std::wstring& replaceTerm, _Inout_ ReplaceFormat& format) const
+        {
+            for (size_t i = 0; i < replaceTerm.length(); i++)
+            {
+                if (replaceTerm[i] >= c_probeMatchBegin && replaceTerm[i] <= c_probeLast)
+                {
+                    return false;
+                }
+                // Boost case conversions (\U, \L...) change the text of the match
+                if (m_useBoostLib && replaceTerm[i] == L'\\' && i + 1 < replaceTerm.length() && replaceTerm[i + 1] != L'\0' && wcschr(L"lLuUE", replaceTerm[i + 1]))
+                {
+                    return false;
+                }
+            }
+
+            std::wstring output;
+            try
+            {
+                if (m_useBoostLib)
+                {
+                    output = boost::regex_replace(m_probe, m_boostProbePattern, replaceTerm, boost::regex_constants::format_no_copy | boost::regex_constants::format_first_only);
+                }
+                else
+                {
+                    output = std::regex_replace(m_probe, m_stdProbePattern, replaceTerm, std::regex_constants::format_no_copy | std::regex_constants::format_first_only);
+                }
+            }
+            catch (const std::regex_error&)
+            {
+                return false;
+            }
+            catch (const boost::regex_error&)
+            {
+                return false;
+            }
+
+            // The whole match is the probe without its prefix and suffix
+            const size_t matchLength = m_probe.length() - 2;
+            const UINT groupCount = m_regex->GetGroupCount();
+            for (size_t i = 0; i < output.length();)
+            {
+                const wchar_t c = output[i];
+                if (c == c_probeMatchBegin)
+                {
+                    if (output.compare(i, matchLength, m_probe, 1, matchLength) != 0)
+                    {
+                        return false;
+                    }
+                    format.pieces.push_back({ ReplaceFormat::Group, 0, 0 });
+                    i += matchLength;
+                    continue;
+                }
+
+                if (c >= c_probeFirstGroup && static_cast<UINT>(c - c_probeFirstGroup) < groupCount)
+                {
+                    format.pieces.push_back({ ReplaceFormat::Group, static_cast<size_t>(c - c_probeFirstGroup) + 1, 0 });
+                }
+                else if (c == c_probePrefix)
+                {
+                    format.pieces.push_back({ ReplaceFormat::Prefix, 0, 0 });
+                }
+                else if (c == c_probeSuffix)
+                {
+                    format.pieces.push_back({ ReplaceFormat::Suffix, 0, 0 });
+                }
+                else if (c >= c_probeMatchBegin && c <= c_probeLast)
+                {
+                    // Part of the match without the rest of it
+                    return false;
+                }
+                else if (!format.pieces.empty() && format.pieces.back().type == ReplaceFormat::Literal)
+                {
+                    format.literals.push_back(c);
+                    format.pieces.back().length++;
+                }
+                else
+                {
+                    format.pieces.push_back({ ReplaceFormat::Literal, format.literals.length(), 1 });
+                    format.literals.push_back(c);
+                }
+                i++;
+            }
+            return true;
+        }
+
+        // prefixBegin is the end of the previous match, the way regex_replace sets the prefix
+        static void _AppendReplacement(_In_ const ReplaceFormat& format, _In_ const std::wstring& source, _In_ const CLinearRegEx::Captures& captures, _In_ size_t prefixBegin, _Inout_ std::wstring& result)
+        {
+            for (const auto& piece : format.pieces)
+            {
+                switch (piece.type)
+                {
+                case ReplaceFormat::Literal:
+                    result.append(format.literals, piece.index, piece.length);
+                    break;
+                case ReplaceFormat::Group:
+                    if (captures[2 * piece.index] != std::wstring::npos)
+                    {
+                        result.append(source, captures[2 * piece.index], captures[2 * piece.index + 1] - captures[2 * piece.index]);
+                    }
+                    break;
+                case ReplaceFormat::Prefix:
+                    result.append(source, prefixBegin, captures[0] - prefixBegin);
+                    break;
+                case ReplaceFormat::Suffix:
+                    result.append(source, captures[1], std::wstring::npos);
+                    break;
+                }
+            }
+        }
+
+        std::unique_ptr<CLinearRegEx> m_regex;
+        // Same pattern compiled by the std or Boost engine
+        std::unique_ptr<CPowerRenameRegExBackend> m_fallback;
+        bool m_useBoostLib;
+        std::wstring m_probe;
+        std::wregex m_stdProbePattern;
+        boost::wregex m_boostProbePattern;
+
+        // Format of the last replace term, the replace term rarely changes between items
+        mutable CSRWLock m_formatLock;
+        _Guarded_by_(m_formatLock) mutable std::wstring m_lastReplaceTerm;
+        _Guarded_by_(m_formatLock) mutable std::shared_ptr<const ReplaceFormat> m_lastFormat;
+    };
+}
+
+HRESULT CPowerRenameRegExBackend::s_Create(_In_ const std::wstring& pattern, _In_ bool caseInsensitive, _In_ bool useBoostLib, _In_ bool useLinearEngine, _Out_ std::unique_ptr<CPowerRenameRegExBackend>& backend)
+{
+    backend.reset();
+
+    try
+    {
+        // Also compiled when the linear engine is used: the replace terms and patterns it
+        // does not support are left to it, and it decides which patterns are valid
+        std::unique_ptr<CPowerRenameRegExBackend> library;
+        if (useBoostLib)
+        {
+            library = std::make_unique<CBoostRegExBackend>(boost::wregex(pattern, caseInsensitive ? boost::regex::icase | boost::regex::ECMAScript : boost::regex::ECMAScript));
+        }
+        else
+        {
+            library = std::make_unique<CStdRegExBackend>(std::wregex(pattern, caseInsensitive ? std::regex_constants::icase | std::regex_constants::ECMAScript : std::regex_constants::ECMAScript));
+        }
+
+        std::unique_ptr<CLinearRegEx> linear;
+        if (useLinearEngine && CLinearRegEx::s_Compile(pattern, caseInsensitive, linear) == S_OK && linear->GetGroupCount() <= CLinearRegExBackend::MaxGroupCount)
+        {
+            backend = std::make_unique<CLinearRegExBackend>(std::move(linear), std::move(library), useBoostLib);
+        }
+        else
+        {
+            // Backreferences, lookaround...
+            backend = std::move(library);
+        }
+    }
+    catch (const std::regex_error&)
+    {
+        // Likely a partially typed expression
+        return E_INVALIDARG;
+    }
+    catch (const boost::regex_error&)
+    {
+        return E_INVALIDARG;
+    }
+    return S_OK;
+}
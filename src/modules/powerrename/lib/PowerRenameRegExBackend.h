@@ -0,0 +1,34 @@
+#pragma once
+#include "pch.h"
+#include <memory>
+#include <string>
+
+// Regular expression engine behind CPowerRenameRegEx.  A backend is a compiled search
+// pattern; it is immutable and can replace in several threads at once.
+class CPowerRenameRegExBackend
+{
+public:
+    enum class Engine
+    {
+        // std::wregex
+        Std,
+        // boost::wregex
+        Boost,
+        // CLinearRegEx, with the std or Boost engine for what it does not support
+        Linear
+    };
+
+    virtual ~CPowerRenameRegExBackend() = default;
+
+    virtual Engine GetEngine() const = 0;
+
+    // Replaces the first match in source, or all of them, with replaceTerm.  The replace
+    // term uses the format syntax of the std or Boost engine ($1, $&...).
+    virtual HRESULT Replace(_In_ const std::wstring& source, _In_ const std::wstring& replaceTerm, _In_ bool matchAll, _Out_ std::wstring& result) const = 0;
+
+    // Compiles pattern as an ECMAScript regular expression.  useBoostLib picks the Boost
+    // engine over the std one.  useLinearEngine picks the linear time engine for the
+    // patterns it supports, the results are the ones the std or Boost engine gives.
+    // Returns E_INVALIDARG when pattern is not valid for the std or Boost engine.
+    static HRESULT s_Create(_In_ const std::wstring& pattern, _In_ bool caseInsensitive, _In_ bool useBoostLib, _In_ bool useLinearEngine, _Out_ std::unique_ptr<CPowerRenameRegExBackend>& backend);
+};
@@ -32,6 +32,7 @@ namespace
     const wchar_t c_mruList[] = L"MRUList";
     const wchar_t c_insertionIdx[] = L"InsertionIdx";
     const wchar_t c_useBoostLib[] = L"UseBoostLib";
+    const wchar_t c_useLinearRegEx[] = L"UseLinearRegEx";
 
     unsigned int GetRegNumber(const std::wstring& valueName, unsigned int defaultValue)
     {
@@ -426,6 +427,7 @@ void CSettings::Save()
     jsonData.SetNamedValue(c_searchText, json::value(settings.searchText));
     jsonData.SetNamedValue(c_replaceText, json::value(settings.replaceText));
     jsonData.SetNamedValue(c_useBoostLib, json::value(settings.useBoostLib));
+    jsonData.SetNamedValue(c_useLinearRegEx, json::value(settings.useLinearRegEx));
 
     json::to_file(jsonFilePath, jsonData);
     GetSystemTimeAsFileTime(&lastLoadedTime);
@@ -470,6 +472,7 @@ void CSettings::MigrateFromRegistry()
     settings.searchText = GetRegString(c_searchText, L"");
     settings.replaceText = GetRegString(c_replaceText, L"");
     settings.useBoostLib = false; // Never existed in registry, disabled by default.
+    settings.useLinearRegEx = false; // Never existed in registry, disabled by default.
 }
 
 void CSettings::ParseJson()
@@ -516,6 +519,10 @@ void CSettings::ParseJson()
             {
                 settings.useBoostLib = jsonSettings.GetNamedBoolean(c_useBoostLib);
             }
+            if (json::has(jsonSettings, c_useLinearRegEx, json::JsonValueType::Boolean))
+            {
+                settings.useLinearRegEx = jsonSettings.GetNamedBoolean(c_useLinearRegEx);
+            }
         }
         catch (const winrt::hresult_error&)
         {
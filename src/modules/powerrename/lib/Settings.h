@@ -61,6 +61,16 @@ public:
         settings.useBoostLib = useBoostLib;
     }
 
+    inline bool GetUseLinearRegEx() const
+    {
+        return settings.useLinearRegEx;
+    }
+
+    inline void SetUseLinearRegEx(bool useLinearRegEx)
+    {
+        settings.useLinearRegEx = useLinearRegEx;
+    }
+
     inline bool GetMRUEnabled() const
     {
         return settings.MRUEnabled;
@@ -125,6 +135,7 @@ private:
         bool extendedContextMenuOnly{ false }; // Disabled by default.
         bool persistState{ true };
         bool useBoostLib{ false }; // Disabled by default.
+        bool useLinearRegEx{ false }; // Disabled by default.
         bool MRUEnabled{ true };
         unsigned int maxMRUSize{ 10 };
         unsigned int flags{ 0 };
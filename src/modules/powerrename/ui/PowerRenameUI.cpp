@@ -14,6 +14,13 @@
 
 extern HINSTANCE g_hInst;
 
+enum
+{
+    PRUI_ENUM_PROGRESS = (WM_APP + 1), // Items were enumerated, wParam is the number of items so far
+    PRUI_ENUM_COMPLETE, // Enumeration completed, wParam is the number of items and lParam the result
+    PRUI_ENUM_CANCEL, // The user canceled the enumeration from the progress dialog UI
+};
+
 enum
 {
     MATCHMODE_FULLNAME = 0,
@@ -169,30 +176,45 @@ IFACEMETHODIMP CPowerRenameUI::GetShowUI(_Out_ bool* showUI)
 // IPowerRenameManagerEvents
 IFACEMETHODIMP CPowerRenameUI::OnItemAdded(_In_ IPowerRenameItem*)
 {
-    // Check if the user canceled the enumeration from the progress dialog UI
+    // Items are added on the enumeration worker thread.  Check if the user canceled the
+    // enumeration from the progress dialog UI and let the dialog thread cancel it.
     if (m_prpui.IsCanceled())
     {
-        m_prpui.Stop();
-        if (m_sppre)
-        {
-            // Cancel the enumeration
-            m_sppre->Cancel();
-        }
+        PostMessage(m_hwnd, PRUI_ENUM_CANCEL, 0, 0);
     }
 
     return S_OK;
 }
 
-IFACEMETHODIMP CPowerRenameUI::OnUpdate(_In_ IPowerRenameItem*)
+IFACEMETHODIMP CPowerRenameUI::OnItemsUpdated(_In_reads_(rangeCount) const PowerRenameItemRange* ranges, _In_ UINT rangeCount)
 {
-    UINT visibleItemCount = 0;
-    if (m_spsrm)
+    if (!m_spsrm)
     {
-        m_spsrm->GetVisibleItemCount(&visibleItemCount);
+        return S_OK;
     }
+
+    UINT visibleItemCount = 0;
+    m_spsrm->GetVisibleItemCount(&visibleItemCount);
     m_listview.SetItemCount(visibleItemCount);
-    m_listview.RedrawItems(0, visibleItemCount);
-    _UpdateCounts();
+
+    DWORD filter = PowerRenameFilters::None;
+    m_spsrm->GetFilter(&filter);
+    if (filter == PowerRenameFilters::None)
+    {
+        // Every item is shown so only the rows of the updated items need to be redrawn
+        for (UINT i = 0; i < rangeCount && ranges[i].first < visibleItemCount; i++)
+        {
+            const UINT last = (ranges[i].last < visibleItemCount) ? ranges[i].last : visibleItemCount - 1;
+            m_listview.RedrawItems(static_cast<int>(ranges[i].first), static_cast<int>(last));
+        }
+    }
+    else
+    {
+        // A new name can show or hide the item and move the rows after it
+        m_listview.RedrawItems(0, static_cast<int>(visibleItemCount));
+    }
+
+    // The counts are updated once the regex worker completes
     return S_OK;
 }
 
@@ -257,6 +279,12 @@ IFACEMETHODIMP CPowerRenameUI::DragEnter(_In_ IDataObject* pdtobj, DWORD /* grfK
         m_spdth->DragEnter(m_hwnd, pdtobj, &ptT, *pdwEffect);
     }
 
+    // Items can only be dropped once the previous ones are enumerated
+    if (m_sppre)
+    {
+        *pdwEffect = DROPEFFECT_NONE;
+    }
+
     return S_OK;
 }
 
@@ -268,6 +296,11 @@ IFACEMETHODIMP CPowerRenameUI::DragOver(DWORD /* grfKeyState */, POINTL pt, _Ino
         m_spdth->DragOver(&ptT, *pdwEffect);
     }
 
+    if (m_sppre)
+    {
+        *pdwEffect = DROPEFFECT_NONE;
+    }
+
     return S_OK;
 }
 
@@ -289,7 +322,12 @@ IFACEMETHODIMP CPowerRenameUI::Drop(_In_ IDataObject* pdtobj, DWORD, POINTL pt,
         m_spdth->Drop(pdtobj, &ptT, *pdwEffect);
     }
 
-    EnableWindow(GetDlgItem(m_hwnd, ID_RENAME), TRUE);
+    if (m_sppre)
+    {
+        return S_OK;
+    }
+
+    // The rename button is enabled once the items are enumerated
     EnableWindow(m_hwndLV, TRUE);
 
     // Populate the manager from the data object
@@ -375,6 +413,14 @@ void CPowerRenameUI::_Cleanup()
         m_spsrm = nullptr;
     }
 
+    // No items are reported to us anymore, stop the enumeration and wait for it
+    if (m_sppre)
+    {
+        m_sppre->Cancel();
+        m_sppre = nullptr;
+        m_prpui.Stop();
+    }
+
     m_dataSource = nullptr;
     m_spdth = nullptr;
 
@@ -389,34 +435,56 @@ void CPowerRenameUI::_Cleanup()
 HRESULT CPowerRenameUI::_EnumerateItems(_In_ IUnknown* pdtobj)
 {
     HRESULT hr = S_OK;
-    // Enumerate the data object and populate the manager
+    // Enumerate the data object and populate the manager on a worker thread.  The items
+    // are shown as PRUI_ENUM_PROGRESS comes in.
     if (m_spsrm)
     {
-        m_disableCountUpdate = true;
-
-        // Ensure we re-create the enumerator
-        m_sppre = nullptr;
         hr = CPowerRenameEnum::s_CreateInstance(pdtobj, m_spsrm, IID_PPV_ARGS(&m_sppre));
         if (SUCCEEDED(hr))
         {
             m_prpui.Start();
-            hr = m_sppre->Start();
-            m_prpui.Stop();
+            hr = m_sppre->StartAsync(m_hwnd, PRUI_ENUM_PROGRESS, PRUI_ENUM_COMPLETE);
+            if (FAILED(hr))
+            {
+                m_prpui.Stop();
+                m_sppre = nullptr;
+            }
         }
+    }
 
-        m_disableCountUpdate = false;
+    return hr;
+}
 
-        if (SUCCEEDED(hr))
-        {
-            UINT itemCount = 0;
-            m_spsrm->GetItemCount(&itemCount);
-            m_listview.SetItemCount(itemCount);
+void CPowerRenameUI::_OnEnumProgress()
+{
+    if (m_spsrm)
+    {
+        // The items added so far are previewed while the next ones are enumerated
+        m_spsrm->UpdatePreview();
 
-            _UpdateCounts();
-        }
+        UINT visibleItemCount = 0;
+        m_spsrm->GetVisibleItemCount(&visibleItemCount);
+        m_listview.SetItemCount(visibleItemCount);
+        _UpdateCounts();
     }
+}
 
-    return hr;
+void CPowerRenameUI::_OnEnumComplete(_In_ HRESULT hr)
+{
+    m_prpui.Stop();
+    // The worker thread is done, this only waits for it to exit
+    m_sppre = nullptr;
+
+    // The rename button stayed disabled while the items were added
+    _UpdateCounts();
+    EnableWindow(GetDlgItem(m_hwnd, ID_RENAME), (m_renamingCount > 0));
+
+    if (FAILED(hr) && m_closeOnEnumFailure)
+    {
+        // Failed during enumeration.  Close the dialog.
+        _OnCloseDlg();
+    }
+    m_closeOnEnumFailure = false;
 }
 
 HRESULT CPowerRenameUI::_ReadSettings()
@@ -511,6 +579,13 @@ void CPowerRenameUI::_OnDestroyDlg()
 
 void CPowerRenameUI::_OnRename()
 {
+    // Only part of the items would be renamed and renaming a folder would break the
+    // enumeration of its content
+    if (m_sppre)
+    {
+        return;
+    }
+
     if (m_spsrm)
     {
         m_spsrm->Rename(m_hwnd);
@@ -618,6 +693,22 @@ INT_PTR CPowerRenameUI::_DlgProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
         _OnDestroyDlg();
         break;
 
+    case PRUI_ENUM_PROGRESS:
+        _OnEnumProgress();
+        break;
+
+    case PRUI_ENUM_COMPLETE:
+        _OnEnumComplete(static_cast<HRESULT>(lParam));
+        break;
+
+    case PRUI_ENUM_CANCEL:
+        m_prpui.Stop();
+        if (m_sppre)
+        {
+            m_sppre->Cancel();
+        }
+        break;
+
     default:
         bRet = FALSE;
     }
@@ -636,6 +727,7 @@ void CPowerRenameUI::_OnInitDlg()
     if (m_dataSource)
     {
         // Populate the manager from the data object
+        m_closeOnEnumFailure = true;
         if (FAILED(_EnumerateItems(m_dataSource)))
         {
             // Failed during enumeration.  Close the dialog.
@@ -1065,8 +1157,8 @@ void CPowerRenameUI::_UpdateCounts()
         SetDlgItemText(m_hwnd, IDC_STATUS_MESSAGE_SELECTED, countsLabelSelected);
         SetDlgItemText(m_hwnd, IDC_STATUS_MESSAGE_RENAMING, countsLabelRenaming);
 
-        // Update Rename button state
-        EnableWindow(GetDlgItem(m_hwnd, ID_RENAME), (renamingCount > 0));
+        // Update Rename button state, renaming waits for the enumeration to complete
+        EnableWindow(GetDlgItem(m_hwnd, ID_RENAME), (renamingCount > 0 && !m_sppre));
     }
 }
 
@@ -1247,9 +1339,10 @@ void CPowerRenameListView::UpdateItemCheckState(_In_ IPowerRenameManager* psrm,
 
 void CPowerRenameListView::GetDisplayInfo(_In_ IPowerRenameManager* psrm, _Inout_ LV_DISPINFO* plvdi)
 {
+    // The visible item count is cached by the manager until the items, filter or selection change
     UINT count = 0;
     psrm->GetVisibleItemCount(&count);
-    if (plvdi->item.iItem < 0 || plvdi->item.iItem > static_cast<int>(count))
+    if (plvdi->item.iItem < 0 || plvdi->item.iItem >= static_cast<int>(count))
     {
         // Invalid index
         return;
@@ -96,7 +96,7 @@ public:
 
     // IPowerRenameManagerEvents
     IFACEMETHODIMP OnItemAdded(_In_ IPowerRenameItem* renameItem);
-    IFACEMETHODIMP OnUpdate(_In_ IPowerRenameItem* renameItem);
+    IFACEMETHODIMP OnItemsUpdated(_In_reads_(rangeCount) const PowerRenameItemRange* ranges, _In_ UINT rangeCount);
     IFACEMETHODIMP OnError(_In_ IPowerRenameItem* renameItem);
     IFACEMETHODIMP OnRegExStarted(_In_ DWORD threadId);
     IFACEMETHODIMP OnRegExCanceled(_In_ DWORD threadId);
@@ -179,6 +179,8 @@ private:
     void _ValidateFlagCheckbox(_In_ DWORD checkBoxId);
 
     HRESULT _EnumerateItems(_In_ IUnknown* pdtobj);
+    void _OnEnumProgress();
+    void _OnEnumComplete(_In_ HRESULT hr);
     void _UpdateCounts();
 
     void _CollectItemPosition(_In_ DWORD id);
@@ -187,6 +189,8 @@ private:
     bool m_initialized = false;
     bool m_enableDragDrop = false;
     bool m_disableCountUpdate = false;
+    // Set while the items the dialog was opened with are enumerated
+    bool m_closeOnEnumFailure = false;
     bool m_modeless = true;
     HWND m_hwnd = nullptr;
     HWND m_hwndLV = nullptr;
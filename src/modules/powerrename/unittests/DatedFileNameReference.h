@@ -0,0 +1,78 @@
+#pragma once
+#include <regex>
+#include <string>
+
+// GetDatedFileName as it was before the file time tokens were compiled into a
+// CDatedFileNameTemplate: one regex replacement per token.  Kept to verify that the
+// expansion did not change and to measure the difference.
+inline HRESULT GetDatedFileNameReference(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source, SYSTEMTIME fileTime)
+{
+    std::locale::global(std::locale(""));
+    HRESULT hr = E_INVALIDARG;
+    if (source && wcslen(source) > 0)
+    {
+        std::wstring res(source);
+        wchar_t replaceTerm[MAX_PATH] = { 0 };
+        wchar_t formattedDate[MAX_PATH] = { 0 };
+
+        wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
+        if (GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH) == 0)
+        {
+            StringCchCopy(localeName, LOCALE_NAME_MAX_LENGTH, L"en_US");
+        }
+
+        auto replaceNumber = [&](PCWSTR token, PCWSTR format, int value) {
+            wchar_t number[MAX_PATH] = { 0 };
+            StringCchPrintf(number, MAX_PATH, format, value);
+            StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%s%s"), L"$01", number);
+            res = regex_replace(res, std::wregex(std::wstring(L"(([^\\$]|^)(\\$\\$)*)\\$") + token), replaceTerm);
+        };
+
+        auto replaceName = [&](PCWSTR token, PCWSTR picture) {
+            GetDateFormatEx(localeName, NULL, &fileTime, picture, formattedDate, MAX_PATH, NULL);
+            formattedDate[0] = towupper(formattedDate[0]);
+            StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%s%s"), L"$01", formattedDate);
+            res = regex_replace(res, std::wregex(std::wstring(L"(([^\\$]|^)(\\$\\$)*)\\$") + token), replaceTerm);
+        };
+
+        replaceNumber(L"YYYY", L"%04d", fileTime.wYear);
+        replaceNumber(L"YY", L"%02d", fileTime.wYear % 100);
+        replaceNumber(L"Y", L"%d", fileTime.wYear % 10);
+        replaceName(L"MMMM", L"MMMM");
+        replaceName(L"MMM", L"MMM");
+        replaceNumber(L"MM", L"%02d", fileTime.wMonth);
+        replaceNumber(L"M", L"%d", fileTime.wMonth);
+        replaceName(L"DDDD", L"dddd");
+        replaceName(L"DDD", L"ddd");
+        replaceNumber(L"DD", L"%02d", fileTime.wDay);
+        replaceNumber(L"D", L"%d", fileTime.wDay);
+        replaceNumber(L"hh", L"%02d", fileTime.wHour);
+        replaceNumber(L"h", L"%d", fileTime.wHour);
+        replaceNumber(L"mm", L"%02d", fileTime.wMinute);
+        replaceNumber(L"m", L"%d", fileTime.wMinute);
+        replaceNumber(L"ss", L"%02d", fileTime.wSecond);
+        replaceNumber(L"s", L"%d", fileTime.wSecond);
+        replaceNumber(L"fff", L"%03d", fileTime.wMilliseconds);
+        replaceNumber(L"ff", L"%02d", fileTime.wMilliseconds / 10);
+        replaceNumber(L"f", L"%d", fileTime.wMilliseconds / 100);
+
+        hr = StringCchCopy(result, cchMax, res.c_str());
+    }
+
+    return hr;
+}
+
+// isFileTimeUsed as it was before
+inline bool isFileTimeUsedReference(_In_ PCWSTR source)
+{
+    std::wstring patterns[] = { L"(([^\\$]|^)(\\$\\$)*)\\$Y", L"(([^\\$]|^)(\\$\\$)*)\\$M", L"(([^\\$]|^)(\\$\\$)*)\\$D",
+        L"(([^\\$]|^)(\\$\\$)*)\\$h", L"(([^\\$]|^)(\\$\\$)*)\\$m", L"(([^\\$]|^)(\\$\\$)*)\\$s", L"(([^\\$]|^)(\\$\\$)*)\\$f" };
+    for (auto& pattern : patterns)
+    {
+        if (std::regex_search(source, std::wregex(pattern)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+#include <string>
+
+// The simple search and replace of CPowerRenameRegEx before it used a CLiteralMatcher:
+// both strings are copied and lowercased for every search and every search starts over
+// on the updated name.  Kept to verify that the results did not change and to measure
+// the difference.
+inline size_t FindLiteralReference(std::wstring data, std::wstring toSearch, bool caseInsensitive, size_t pos)
+{
+    if (caseInsensitive)
+    {
+        // Convert to lower
+        std::transform(data.begin(), data.end(), data.begin(), ::towlower);
+        std::transform(toSearch.begin(), toSearch.end(), toSearch.begin(), ::towlower);
+    }
+
+    // Find sub string position in given string starting at position pos
+    return data.find(toSearch, pos);
+}
+
+inline std::wstring ReplaceLiteralReference(const std::wstring& source, const std::wstring& searchTerm, const std::wstring& replaceTerm, bool caseInsensitive, bool matchAll)
+{
+    std::wstring res = source;
+    std::wstring sourceToUse(source);
+    size_t pos = 0;
+    do
+    {
+        pos = FindLiteralReference(sourceToUse, searchTerm, caseInsensitive, pos);
+        if (pos != std::string::npos)
+        {
+            res = sourceToUse.replace(pos, searchTerm.length(), replaceTerm);
+            pos += replaceTerm.length();
+        }
+
+        if (!matchAll)
+        {
+            break;
+        }
+    } while (pos != std::string::npos);
+    return res;
+}
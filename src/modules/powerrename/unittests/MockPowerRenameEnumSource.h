@@ -0,0 +1,86 @@
+#pragma once
+#include "pch.h"
+#include <PowerRenameEnumSource.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// In memory tree of mock items, listed in depth first order
+class CMockPowerRenameEnumSource :
+    public CPowerRenameEnumSource
+{
+public:
+    struct Entry
+    {
+        std::wstring name;
+        UINT depth;
+        bool isFolder;
+    };
+
+    explicit CMockPowerRenameEnumSource(std::vector<Entry> entries) :
+        m_entries(std::move(entries))
+    {
+    }
+
+    // folderCount folders of filesPerFolder files each, every third file in a sub folder
+    static std::vector<Entry> CreateTree(int folderCount, int filesPerFolder)
+    {
+        auto fileName = [&](int folder, int file) {
+            return L"IMG_" + std::to_wstring(20200000 + folder * filesPerFolder + file) + L"_holiday.jpg";
+        };
+
+        std::vector<Entry> entries;
+        for (int folder = 0; folder < folderCount; folder++)
+        {
+            entries.push_back({ L"folder_" + std::to_wstring(folder), 0, true });
+            for (int file = 0; file < filesPerFolder; file++)
+            {
+                if (file % 3 != 0)
+                {
+                    entries.push_back({ fileName(folder, file), 1, false });
+                }
+            }
+
+            entries.push_back({ L"sub", 1, true });
+            for (int file = 0; file < filesPerFolder; file += 3)
+            {
+                entries.push_back({ fileName(folder, file), 2, false });
+            }
+        }
+        return entries;
+    }
+
+    void Reset() override
+    {
+        m_next = 0;
+    }
+
+    HRESULT NextBatch(_In_ UINT maxCount, _Inout_ std::vector<PowerRenameEnumItem>& items) override
+    {
+        m_batchCount++;
+        if (m_onBatch)
+        {
+            m_onBatch(m_batchCount);
+        }
+
+        items.clear();
+        while (items.size() < maxCount && m_next < m_entries.size())
+        {
+            const Entry& entry = m_entries[m_next++];
+            PowerRenameEnumItem item;
+            item.originalName = entry.name;
+            item.depth = entry.depth;
+            item.isFolder = entry.isFolder;
+            items.push_back(std::move(item));
+        }
+        return (m_next < m_entries.size()) ? S_OK : S_FALSE;
+    }
+
+    // Called with the number of the batch before it is produced
+    std::function<void(UINT)> m_onBatch;
+    UINT m_batchCount = 0;
+
+private:
+    std::vector<Entry> m_entries;
+    size_t m_next = 0;
+};
@@ -35,9 +35,13 @@ IFACEMETHODIMP CMockPowerRenameManagerEvents::OnItemAdded(_In_ IPowerRenameItem*
     return S_OK;
 }
 
-IFACEMETHODIMP CMockPowerRenameManagerEvents::OnUpdate(_In_ IPowerRenameItem* pItem)
+IFACEMETHODIMP CMockPowerRenameManagerEvents::OnItemsUpdated(_In_reads_(rangeCount) const PowerRenameItemRange* ranges, _In_ UINT rangeCount)
 {
-    m_itemUpdated = pItem;
+    m_itemsUpdatedCount++;
+    for (UINT i = 0; i < rangeCount; i++)
+    {
+        m_updatedItemCount += ranges[i].last - ranges[i].first + 1;
+    }
     return S_OK;
 }
 
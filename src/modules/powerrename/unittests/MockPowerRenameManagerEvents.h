@@ -19,7 +19,7 @@ public:
 
     // IPowerRenameManagerEvents
     IFACEMETHODIMP OnItemAdded(_In_ IPowerRenameItem* renameItem);
-    IFACEMETHODIMP OnUpdate(_In_ IPowerRenameItem* renameItem);
+    IFACEMETHODIMP OnItemsUpdated(_In_reads_(rangeCount) const PowerRenameItemRange* ranges, _In_ UINT rangeCount);
     IFACEMETHODIMP OnError(_In_ IPowerRenameItem* renameItem);
     IFACEMETHODIMP OnRegExStarted(_In_ DWORD threadId);
     IFACEMETHODIMP OnRegExCanceled(_In_ DWORD threadId);
@@ -34,7 +34,9 @@ public:
     }
 
     CComPtr<IPowerRenameItem> m_itemAdded;
-    CComPtr<IPowerRenameItem> m_itemUpdated;
+    // Number of OnItemsUpdated calls and of items they covered
+    UINT m_itemsUpdatedCount = 0;
+    UINT m_updatedItemCount = 0;
     CComPtr<IPowerRenameItem> m_itemError;
     bool m_regExStarted = false;
     bool m_regExCanceled = false;
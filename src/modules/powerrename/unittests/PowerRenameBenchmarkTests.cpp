@@ -0,0 +1,561 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "powerrename/lib/Settings.h"
+#include <PowerRenameInterfaces.h>
+#include <PowerRenameRegEx.h>
+#include <PowerRenamePreviewEngine.h>
+#include <PowerRenameItemStore.h>
+#include <DatedFileNameTemplate.h>
+#include "DatedFileNameReference.h"
+#include <LiteralMatcher.h>
+#include "LiteralSearchReference.h"
+#include <PowerRenameEnum.h>
+#include <PowerRenameManager.h>
+#include <PowerRenamePlanner.h>
+#include <PowerRenameProgressChannel.h>
+#include <PowerRenameRegExBackend.h>
+#include "MockPowerRenameEnumSource.h"
+#include "MockPowerRenameItem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+// Micro benchmarks for the preview hot path. They log the measured cost per item
+// and only assert on correctness, so they never fail because of a slow machine.
+namespace PowerRenameBenchmarkTests
+{
+    const int BenchmarkItemCount = 10000;
+
+    std::vector<std::wstring> CreateFileNames(int count)
+    {
+        std::vector<std::wstring> names;
+        names.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            names.push_back(L"IMG_" + std::to_wstring(20200000 + i) + L"_holiday.jpg");
+        }
+        return names;
+    }
+
+    void LogPerItemCost(const wchar_t* name, std::chrono::steady_clock::duration elapsed, size_t itemCount)
+    {
+        double nsPerItem = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / itemCount;
+        std::wstring message = std::wstring(name) + L": " + std::to_wstring(nsPerItem) + L" ns/item\n";
+        Logger::WriteMessage(message.c_str());
+    }
+
+    TEST_CLASS(RegExBenchmarks)
+    {
+    public:
+        TEST_CLASS_INITIALIZE(ClassInitialize)
+        {
+            CSettingsInstance().SetUseBoostLib(false);
+        }
+
+        TEST_METHOD(ReplacePerItemCost)
+        {
+            const std::wstring searchTerm = L"IMG_(\\d+)_(\\w+)";
+            const std::wstring replaceTerm = L"$2_$1";
+            const auto names = CreateFileNames(BenchmarkItemCount);
+
+            // Before: what Replace used to do for every item, compiling the search
+            // pattern and the two replace term rewrite patterns each time.
+            std::vector<std::wstring> expected;
+            expected.reserve(names.size());
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& name : names)
+            {
+                std::wstring replace = std::regex_replace(replaceTerm, std::wregex(L"(([^\\$]|^)(\\$\\$)*)\\$[0]"), L"$1$$$0");
+                replace = std::regex_replace(replace, std::wregex(L"(([^\\$]|^)(\\$\\$)*)\\$([1-9])"), L"$1$0$4");
+                std::wregex pattern(searchTerm, std::regex_constants::icase | std::regex_constants::ECMAScript);
+                expected.push_back(std::regex_replace(name, pattern, replace));
+            }
+            LogPerItemCost(L"Replace, pattern compiled per item", std::chrono::steady_clock::now() - start, names.size());
+
+            // After: the pattern is compiled once by PutSearchTerm/PutReplaceTerm/PutFlags.
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | UseRegularExpressions) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(searchTerm.c_str()) == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(replaceTerm.c_str()) == S_OK);
+
+            std::vector<PWSTR> results(names.size(), nullptr);
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                renameRegEx->Replace(names[i].c_str(), &results[i]);
+            }
+            LogPerItemCost(L"Replace, compiled pattern cached", std::chrono::steady_clock::now() - start, names.size());
+
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                Assert::AreEqual(expected[i].c_str(), results[i]);
+                CoTaskMemFree(results[i]);
+            }
+        }
+    };
+
+    TEST_CLASS(PreviewEngineBenchmarks)
+    {
+    public:
+        TEST_CLASS_INITIALIZE(ClassInitialize)
+        {
+            CSettingsInstance().SetUseBoostLib(false);
+        }
+
+        // Logs the preview time of itemCount synthetic names on 1, 2, 4... up to all logical processors
+        void MeasurePreviewScaling(int itemCount)
+        {
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | UseRegularExpressions) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"IMG_(\\d+)_(\\w+)") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"$2_$1") == S_OK);
+
+            const auto names = CreateFileNames(itemCount);
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            items.reserve(names.size());
+            for (const auto& name : names)
+            {
+                CComPtr<IPowerRenameItem> item;
+                Assert::IsTrue(CMockPowerRenameItem::CreateInstance(nullptr, name.c_str(), 0, false, SYSTEMTIME{ 0 }, &item) == S_OK);
+                items.push_back(item);
+            }
+
+            const UINT maxThreads = CPowerRenamePreviewEngine().GetThreadCount();
+            for (UINT threads = 1;; threads = std::min(threads * 2, maxThreads))
+            {
+                for (auto& item : items)
+                {
+                    item->Reset();
+                }
+
+                CPowerRenamePreviewEngine engine(threads);
+                auto start = std::chrono::steady_clock::now();
+                Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [](UINT, int) {}) == S_OK);
+                std::wstring name = std::to_wstring(itemCount) + L" items, " + std::to_wstring(threads) + L" threads";
+                LogPerItemCost(name.c_str(), std::chrono::steady_clock::now() - start, items.size());
+
+                if (threads == maxThreads)
+                {
+                    break;
+                }
+            }
+        }
+
+        TEST_METHOD(PreviewScaling1K)
+        {
+            MeasurePreviewScaling(1000);
+        }
+
+        TEST_METHOD(PreviewScaling10K)
+        {
+            MeasurePreviewScaling(10000);
+        }
+
+        TEST_METHOD(PreviewScaling100K)
+        {
+            MeasurePreviewScaling(100000);
+        }
+
+        // Takes a while and a lot of memory so it only runs on demand
+        BEGIN_TEST_METHOD_ATTRIBUTE(PreviewScaling1M)
+            TEST_IGNORE()
+        END_TEST_METHOD_ATTRIBUTE()
+        TEST_METHOD(PreviewScaling1M)
+        {
+            MeasurePreviewScaling(1000000);
+        }
+
+        // What typing in the UI does: re-preview the same items after a single input changed
+        TEST_METHOD(IncrementalPreview)
+        {
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | UseRegularExpressions) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"IMG_(\\d+)_(\\w+)") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"$2_$1") == S_OK);
+
+            const auto names = CreateFileNames(BenchmarkItemCount * 10);
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            items.reserve(names.size());
+            for (const auto& name : names)
+            {
+                CComPtr<IPowerRenameItem> item;
+                Assert::IsTrue(CMockPowerRenameItem::CreateInstance(nullptr, name.c_str(), 0, false, SYSTEMTIME{ 0 }, &item) == S_OK);
+                items.push_back(item);
+            }
+
+            CPowerRenamePreviewEngine engine;
+            auto start = std::chrono::steady_clock::now();
+            Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [](UINT, int) {}) == S_OK);
+            LogPerItemCost(L"Preview, first run", std::chrono::steady_clock::now() - start, items.size());
+
+            auto measure = [&](PCWSTR name, DWORD flags) {
+                Assert::IsTrue(renameRegEx->PutFlags(flags) == S_OK);
+                auto runStart = std::chrono::steady_clock::now();
+                Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [](UINT, int) {}) == S_OK);
+                LogPerItemCost(name, std::chrono::steady_clock::now() - runStart, items.size());
+                Assert::AreEqual(0u, engine.GetLastRunStats().replaced);
+            };
+
+            measure(L"Preview, case transform toggled", MatchAllOccurences | UseRegularExpressions | Uppercase);
+            measure(L"Preview, exclude folders toggled", MatchAllOccurences | UseRegularExpressions | Uppercase | ExcludeFolders);
+            measure(L"Preview, nothing changed", MatchAllOccurences | UseRegularExpressions | Uppercase | ExcludeFolders);
+        }
+    };
+
+    TEST_CLASS(ItemStoreBenchmarks)
+    {
+    public:
+        // What the list view does while scrolling: look up every visible row once
+        TEST_METHOD(VisibleItemLookup)
+        {
+            const auto names = CreateFileNames(BenchmarkItemCount * 10);
+            auto store = std::make_shared<CPowerRenameItemStore>();
+            for (const auto& name : names)
+            {
+                store->Add(PowerRenameItemInfo{ nullptr, name.c_str(), 0, false, true });
+            }
+
+            // Hide every other item
+            for (UINT i = 0; i < store->GetCount(); i++)
+            {
+                store->SetVisible(i, i % 2 == 0);
+            }
+
+            const UINT visibleCount = store->GetVisibleCount();
+            auto start = std::chrono::steady_clock::now();
+            for (UINT visibleIndex = 0; visibleIndex < visibleCount; visibleIndex++)
+            {
+                UINT index = 0;
+                Assert::IsTrue(store->GetVisibleItemIndex(visibleIndex, &index));
+                CComPtr<IPowerRenameItem> item;
+                Assert::IsTrue(store->GetItem(index, &item) == S_OK);
+            }
+            LogPerItemCost(L"Visible item lookup", std::chrono::steady_clock::now() - start, visibleCount);
+        }
+    };
+
+    TEST_CLASS(EnumerationBenchmarks)
+    {
+    public:
+        // Adds an in memory tree to a manager, the way the shell items of a huge selection are
+        TEST_METHOD(EnumerationThroughput)
+        {
+            auto entries = CMockPowerRenameEnumSource::CreateTree(100, BenchmarkItemCount / 100 * 10);
+
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+
+            auto source = std::make_unique<CMockPowerRenameEnumSource>(entries);
+            CMockPowerRenameEnumSource* mockSource = source.get();
+            std::chrono::steady_clock::time_point firstBatchAdded;
+            auto start = std::chrono::steady_clock::now();
+            mockSource->m_onBatch = [&](UINT batch) {
+                // The first batch is in the manager once the second one is requested
+                if (batch == 2)
+                {
+                    firstBatchAdded = std::chrono::steady_clock::now();
+                }
+            };
+
+            CComPtr<IPowerRenameEnum> renameEnum;
+            Assert::IsTrue(CPowerRenameEnum::s_CreateInstance(std::move(source), mgr, IID_PPV_ARGS(&renameEnum)) == S_OK);
+            Assert::IsTrue(renameEnum->Start() == S_OK);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+
+            LogPerItemCost(L"Enumeration, first batch", firstBatchAdded - start, CPowerRenameEnum::BatchSize);
+            LogPerItemCost(L"Enumeration, all items", elapsed, entries.size());
+
+            UINT itemCount = 0;
+            Assert::IsTrue(mgr->GetItemCount(&itemCount) == S_OK);
+            Assert::AreEqual(static_cast<UINT>(entries.size()), itemCount);
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+        }
+    };
+
+    TEST_CLASS(DatedFileNameBenchmarks)
+    {
+    public:
+        TEST_METHOD(DatedFileNamePerItemCost)
+        {
+            const PCWSTR replaceTerm = L"$YYYY-$MM-$DD_$hh$mm$ss_$DDD";
+            std::vector<SYSTEMTIME> fileTimes;
+            for (int i = 0; i < BenchmarkItemCount; i++)
+            {
+                fileTimes.push_back({ static_cast<WORD>(2000 + i % 20), static_cast<WORD>(1 + i % 12), 0, static_cast<WORD>(1 + i % 28),
+                                      static_cast<WORD>(i % 24), static_cast<WORD>(i % 60), static_cast<WORD>(i % 60), static_cast<WORD>(i % 1000) });
+            }
+
+            // Before: one regex replacement per token for every item
+            std::vector<std::wstring> expected;
+            expected.reserve(fileTimes.size());
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& fileTime : fileTimes)
+            {
+                wchar_t result[MAX_PATH] = { 0 };
+                GetDatedFileNameReference(result, ARRAYSIZE(result), replaceTerm, fileTime);
+                expected.push_back(result);
+            }
+            LogPerItemCost(L"Dated file name, regex per token", std::chrono::steady_clock::now() - start, fileTimes.size());
+
+            // After: tokens located once, expanded in a single pass
+            CDatedFileNameTemplate datedTemplate(replaceTerm);
+            std::vector<std::wstring> results(fileTimes.size());
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < fileTimes.size(); i++)
+            {
+                datedTemplate.Format(fileTimes[i], results[i]);
+            }
+            LogPerItemCost(L"Dated file name, compiled template", std::chrono::steady_clock::now() - start, fileTimes.size());
+
+            for (size_t i = 0; i < fileTimes.size(); i++)
+            {
+                Assert::AreEqual(expected[i], results[i]);
+            }
+        }
+    };
+
+    TEST_CLASS(ProgressChannelBenchmarks)
+    {
+    public:
+        TEST_METHOD(ItemUpdateNotifications)
+        {
+            const UINT itemCount = 100000;
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            items.reserve(itemCount);
+            for (UINT i = 0; i < itemCount; i++)
+            {
+                CComPtr<IPowerRenameItem> item;
+                CMockPowerRenameItem::CreateInstance(L"foo", L"foo", 0, false, SYSTEMTIME{ 0 }, &item);
+                items.push_back(item);
+            }
+
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            renameRegEx->PutSearchTerm(L"foo");
+            renameRegEx->PutReplaceTerm(L"bar");
+
+            // The consumer takes the ranges as soon as it is notified, like the UI thread does.
+            // Notifications come from the worker threads here.
+            std::atomic<size_t> reportedItems{ 0 };
+            CPowerRenameProgressChannel* channel = nullptr;
+            CPowerRenameProgressChannel progress([&]() {
+                std::vector<CPowerRenameProgressChannel::ItemRange> ranges;
+                channel->TakeUpdatedRanges(ranges);
+                for (const auto& range : ranges)
+                {
+                    reportedItems += range.last - range.first + 1;
+                }
+            });
+            channel = &progress;
+
+            CPowerRenamePreviewEngine engine;
+            auto start = std::chrono::steady_clock::now();
+            Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [&](UINT index, int) { progress.MarkUpdated(index); }) == S_OK);
+            progress.Flush();
+            LogPerItemCost(L"Preview with batched item updates", std::chrono::steady_clock::now() - start, items.size());
+
+            auto counters = progress.GetCounters();
+            std::wstring message = L"Item updates: " + std::to_wstring(counters.itemsUpdated) + L", notifications: " + std::to_wstring(counters.notifications) +
+                                   L", ranges: " + std::to_wstring(counters.ranges) + L"\n";
+            Logger::WriteMessage(message.c_str());
+
+            Assert::AreEqual(static_cast<size_t>(itemCount), reportedItems.load());
+            Assert::IsTrue(counters.notifications <= counters.itemsUpdated);
+        }
+    };
+
+    TEST_CLASS(LiteralSearchBenchmarks)
+    {
+    public:
+        TEST_CLASS_INITIALIZE(ClassInitialize)
+        {
+            CSettingsInstance().SetUseBoostLib(false);
+        }
+
+        TEST_METHOD(LiteralReplacePerItemCost)
+        {
+            std::vector<std::wstring> names = CreateFileNames(BenchmarkItemCount);
+            const std::wstring searchTerm = L"Holiday";
+            const std::wstring replaceTerm = L"Trip";
+
+            // Before: both strings copied and lowercased for every search
+            std::vector<std::wstring> expected;
+            expected.reserve(names.size());
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& name : names)
+            {
+                expected.push_back(ReplaceLiteralReference(name, searchTerm, replaceTerm, true, true));
+            }
+            LogPerItemCost(L"Literal replace, lowercased copies", std::chrono::steady_clock::now() - start, names.size());
+
+            // After: folded search term, first character scanned several characters at a time
+            CLiteralMatcher matcher(searchTerm, true);
+            std::vector<std::wstring> results(names.size());
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                matcher.Replace(names[i], replaceTerm, true, results[i]);
+            }
+            LogPerItemCost(L"Literal replace, literal matcher", std::chrono::steady_clock::now() - start, names.size());
+
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                Assert::AreEqual(expected[i], results[i]);
+            }
+
+            // Through IPowerRenameRegEx, plain search and a regular expression without syntax
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            renameRegEx->PutSearchTerm(L"20200");
+            renameRegEx->PutReplaceTerm(L"19990");
+            for (DWORD flags : { static_cast<DWORD>(MatchAllOccurences), static_cast<DWORD>(MatchAllOccurences | UseRegularExpressions) })
+            {
+                renameRegEx->PutFlags(flags);
+                start = std::chrono::steady_clock::now();
+                for (const auto& name : names)
+                {
+                    PWSTR result = nullptr;
+                    Assert::IsTrue(renameRegEx->Replace(name.c_str(), &result) == S_OK);
+                    CoTaskMemFree(result);
+                }
+                LogPerItemCost((flags & UseRegularExpressions) ? L"Replace, literal regular expression" : L"Replace, plain search", std::chrono::steady_clock::now() - start, names.size());
+            }
+        }
+    };
+
+    TEST_CLASS(RegExEngineBenchmarks)
+    {
+    public:
+        TEST_METHOD(ReplacePerItemCost)
+        {
+            const std::wstring searchTerm = L"IMG_(\\d+)_(\\w+)";
+            const std::wstring replaceTerm = L"$2_$1";
+            const auto names = CreateFileNames(BenchmarkItemCount);
+
+            std::unique_ptr<CPowerRenameRegExBackend> library;
+            std::unique_ptr<CPowerRenameRegExBackend> linear;
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(searchTerm, true, false, false, library) == S_OK);
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(searchTerm, true, false, true, linear) == S_OK);
+
+            std::vector<std::wstring> expected(names.size());
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                library->Replace(names[i], replaceTerm, true, expected[i]);
+            }
+            LogPerItemCost(L"Replace, std engine", std::chrono::steady_clock::now() - start, names.size());
+
+            std::vector<std::wstring> results(names.size());
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                linear->Replace(names[i], replaceTerm, true, results[i]);
+            }
+            LogPerItemCost(L"Replace, linear engine", std::chrono::steady_clock::now() - start, names.size());
+
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                Assert::AreEqual(expected[i], results[i]);
+            }
+        }
+
+        TEST_METHOD(PathologicalPatternCost)
+        {
+            // Nested quantifiers: the backtracking engine doubles its work with every character
+            const std::wstring searchTerm = L"(a+)+b";
+            std::unique_ptr<CPowerRenameRegExBackend> library;
+            std::unique_ptr<CPowerRenameRegExBackend> linear;
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(searchTerm, false, false, false, library) == S_OK);
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(searchTerm, false, false, true, linear) == S_OK);
+
+            for (int length : { 12, 16, 20 })
+            {
+                const std::wstring name(static_cast<size_t>(length), L'a');
+                std::wstring expected;
+                std::wstring result;
+
+                auto start = std::chrono::steady_clock::now();
+                library->Replace(name, L"x", true, expected);
+                LogPerItemCost((L"(a+)+b on " + std::to_wstring(length) + L" characters, std engine").c_str(), std::chrono::steady_clock::now() - start, 1);
+
+                start = std::chrono::steady_clock::now();
+                Assert::IsTrue(linear->Replace(name, L"x", true, result) == S_OK);
+                LogPerItemCost((L"(a+)+b on " + std::to_wstring(length) + L" characters, linear engine").c_str(), std::chrono::steady_clock::now() - start, 1);
+                Assert::AreEqual(name, result);
+            }
+
+            // Out of reach for the backtracking engine
+            const std::wstring longName(MAX_PATH, L'a');
+            std::wstring result;
+            auto start = std::chrono::steady_clock::now();
+            Assert::IsTrue(linear->Replace(longName, L"x", true, result) == S_OK);
+            LogPerItemCost(L"(a+)+b on MAX_PATH characters, linear engine", std::chrono::steady_clock::now() - start, 1);
+            Assert::AreEqual(longName, result);
+        }
+    };
+
+    TEST_CLASS(PlannerBenchmarks)
+    {
+    public:
+        TEST_METHOD(PlanOneMillionItems)
+        {
+            // 1000 directories of 1000 items, nothing touches the file system
+            const UINT directoryCount = 1000;
+            const UINT itemsPerDirectory = 1000;
+            const size_t itemCount = static_cast<size_t>(directoryCount) * itemsPerDirectory;
+
+            CPowerRenamePlanner planner;
+            auto start = std::chrono::steady_clock::now();
+            for (UINT directory = 0; directory < directoryCount; directory++)
+            {
+                const std::wstring path = L"c:\\photos\\" + std::to_wstring(directory);
+                for (UINT i = 0; i < itemsPerDirectory; i++)
+                {
+                    const std::wstring name = L"IMG_" + std::to_wstring(i) + L".jpg";
+                    std::wstring newName;
+                    switch (directory % 4)
+                    {
+                    case 0:
+                        // One chain through the whole directory: IMG_0 -> IMG_1 -> ...
+                        newName = L"IMG_" + std::to_wstring(i + 1) + L".jpg";
+                        break;
+                    case 1:
+                        // Swapped pairs, every pair a cycle
+                        newName = L"IMG_" + std::to_wstring(i ^ 1) + L".jpg";
+                        break;
+                    case 2:
+                        // Independent renames, every tenth to the name of the next one
+                        newName = (i % 10 == 0) ? L"Holiday_" + std::to_wstring(i + 1) + L".jpg" : L"Holiday_" + std::to_wstring(i) + L".jpg";
+                        break;
+                    default:
+                        // Unchanged
+                        break;
+                    }
+                    planner.AddItem(path, name, newName, 1);
+                }
+            }
+            LogPerItemCost(L"Planner, add item", std::chrono::steady_clock::now() - start, itemCount);
+
+            start = std::chrono::steady_clock::now();
+            planner.Plan();
+            LogPerItemCost(L"Planner, plan", std::chrono::steady_clock::now() - start, itemCount);
+
+            const auto& report = planner.GetReport();
+            Assert::AreEqual(static_cast<UINT>(itemCount), report.itemCount);
+            Assert::AreEqual(directoryCount / 4 * itemsPerDirectory, report.unchanged);
+            Assert::AreEqual(directoryCount / 4 * itemsPerDirectory / 2, report.cycles);
+            Assert::AreEqual(itemsPerDirectory, report.longestChain);
+            // Both renames to Holiday_(10k + 1) collide
+            Assert::AreEqual(directoryCount / 4 * itemsPerDirectory / 10 * 2, report.collisions);
+            Assert::AreEqual(static_cast<UINT>(itemCount) - report.unchanged - report.collisions, report.renamed);
+        }
+    };
+}
@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <PowerRenameInterfaces.h>
+#include <DatedFileNameTemplate.h>
+#include "Helpers.h"
+#include "DatedFileNameReference.h"
+#include <random>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenameDatedFileNameTests
+{
+    std::wstring GetDatedFileNameOrError(PCWSTR source, SYSTEMTIME fileTime, HRESULT (*getDatedFileName)(PWSTR, UINT, PCWSTR, SYSTEMTIME))
+    {
+        wchar_t result[MAX_PATH] = { 0 };
+        HRESULT hr = getDatedFileName(result, ARRAYSIZE(result), source, fileTime);
+        return SUCCEEDED(hr) ? result : L"<error " + std::to_wstring(hr) + L">";
+    }
+
+    void VerifyMatchesReference(PCWSTR source, SYSTEMTIME fileTime)
+    {
+        std::wstring expected = GetDatedFileNameOrError(source, fileTime, GetDatedFileNameReference);
+        std::wstring actual = GetDatedFileNameOrError(source, fileTime, GetDatedFileName);
+        if (expected != actual)
+        {
+            std::wstring message = std::wstring(L"Template: ") + source + L" Date: " + std::to_wstring(fileTime.wYear) + L"-" +
+                                   std::to_wstring(fileTime.wMonth) + L"-" + std::to_wstring(fileTime.wDay);
+            Assert::AreEqual(expected, actual, message.c_str());
+        }
+        Assert::AreEqual(isFileTimeUsedReference(source), isFileTimeUsed(source), source);
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(VerifyTokens)
+        {
+            SYSTEMTIME fileTime = { 2020, 7, 3, 22, 15, 6, 42, 453 };
+            std::wstring result;
+            Assert::IsTrue(CDatedFileNameTemplate(L"$YYYY-$YY-$Y $MM-$M $DD-$D $hh:$h $mm:$m $ss:$s $fff-$ff-$f").Format(fileTime, result) == S_OK);
+            Assert::AreEqual(std::wstring(L"2020-20-0 07-7 22-22 15:15 06:6 42:42 453-45-4"), result);
+        }
+
+        TEST_METHOD(VerifyEscapedTokens)
+        {
+            SYSTEMTIME fileTime = { 2020, 7, 3, 22, 15, 6, 42, 453 };
+            std::wstring result;
+            Assert::IsTrue(CDatedFileNameTemplate(L"$$YYYY $$$YYYY $$$$MM").Format(fileTime, result) == S_OK);
+            Assert::AreEqual(std::wstring(L"$$YYYY $$2020 $$$$MM"), result);
+
+            CDatedFileNameTemplate noTokens(L"$$YYYY-foo");
+            Assert::IsTrue(noTokens.IsValid());
+            Assert::IsFalse(noTokens.HasTokens());
+            Assert::IsTrue(CDatedFileNameTemplate(L"$$$hh").HasTokens());
+        }
+
+        TEST_METHOD(VerifyEmptyTemplate)
+        {
+            std::wstring result;
+            Assert::IsFalse(CDatedFileNameTemplate(nullptr).IsValid());
+            Assert::IsTrue(CDatedFileNameTemplate(L"").Format(SYSTEMTIME{ 0 }, result) == E_INVALIDARG);
+        }
+
+        TEST_METHOD(VerifyAdjacentTokens)
+        {
+            // Oddities of the regex replacements that have to be kept
+            VerifyMatchesReference(L"$YYYY$YYYY", { 2020, 7, 3, 22, 15, 6, 42, 453 });
+            VerifyMatchesReference(L"$MM$MM", { 2020, 7, 3, 22, 15, 6, 42, 453 });
+            VerifyMatchesReference(L"$M$MMM", { 2020, 3, 0, 2, 15, 6, 42, 453 });
+            VerifyMatchesReference(L"$M$MMMM", { 2020, 5, 5, 1, 15, 6, 42, 453 });
+            VerifyMatchesReference(L"$DD$DDDD", { 2020, 7, 3, 22, 15, 6, 42, 453 });
+            VerifyMatchesReference(L"$D$DDD$MMMM", { 2020, 12, 3, 2, 15, 6, 42, 453 });
+        }
+
+        TEST_METHOD(VerifyInvalidDate)
+        {
+            // GetDateFormatEx fails and the names are left empty
+            VerifyMatchesReference(L"$MMMM$$$MM-$DDD$DDD", { 2020, 13, 0, 40, 15, 6, 42, 453 });
+            VerifyMatchesReference(L"$YYYY$MMMM$DDDD", SYSTEMTIME{ 0 });
+        }
+
+        TEST_METHOD(VerifyRandomTemplatesMatchReference)
+        {
+            std::mt19937 random(12345);
+            const wchar_t alphabet[] = L"$$$$YYMMDDhhmmssfxa-";
+            for (int i = 0; i < 5000; i++)
+            {
+                std::wstring source;
+                size_t length = random() % 16;
+                for (size_t j = 0; j < length; j++)
+                {
+                    source.push_back(alphabet[random() % (ARRAYSIZE(alphabet) - 1)]);
+                }
+
+                SYSTEMTIME fileTime = { static_cast<WORD>(1990 + random() % 60), static_cast<WORD>(1 + random() % 12), 0, static_cast<WORD>(1 + random() % 28),
+                                        static_cast<WORD>(random() % 24), static_cast<WORD>(random() % 60), static_cast<WORD>(random() % 60), static_cast<WORD>(random() % 1000) };
+                VerifyMatchesReference(source.c_str(), fileTime);
+            }
+        }
+    };
+}
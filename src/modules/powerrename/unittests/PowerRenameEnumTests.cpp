@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <PowerRenameInterfaces.h>
+#include <PowerRenameEnum.h>
+#include <PowerRenameManager.h>
+#include "MockPowerRenameEnumSource.h"
+#include "TestFileHelper.h"
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenameEnumTests
+{
+    std::wstring GetOriginalName(IPowerRenameItem* item)
+    {
+        PWSTR originalName = nullptr;
+        Assert::IsTrue(item->GetOriginalName(&originalName) == S_OK);
+        std::wstring name(originalName);
+        CoTaskMemFree(originalName);
+        return name;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(VerifyBatchedEnumeration)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+
+            // Enough items for several batches
+            auto entries = CMockPowerRenameEnumSource::CreateTree(10, CPowerRenameEnum::BatchSize / 3);
+            auto source = std::make_unique<CMockPowerRenameEnumSource>(entries);
+            CMockPowerRenameEnumSource* mockSource = source.get();
+            CComPtr<IPowerRenameEnum> renameEnum;
+            Assert::IsTrue(CPowerRenameEnum::s_CreateInstance(std::move(source), mgr, IID_PPV_ARGS(&renameEnum)) == S_OK);
+            Assert::IsTrue(renameEnum->Start() == S_OK);
+            Assert::IsTrue(mockSource->m_batchCount > 1);
+
+            UINT itemCount = 0;
+            Assert::IsTrue(mgr->GetItemCount(&itemCount) == S_OK);
+            Assert::AreEqual(static_cast<UINT>(entries.size()), itemCount);
+            for (UINT i = 0; i < itemCount; i++)
+            {
+                CComPtr<IPowerRenameItem> item;
+                Assert::IsTrue(mgr->GetItemByIndex(i, &item) == S_OK);
+                UINT depth = 0;
+                Assert::IsTrue(item->GetDepth(&depth) == S_OK);
+                Assert::AreEqual(entries[i].name, GetOriginalName(item));
+                Assert::AreEqual(entries[i].depth, depth);
+            }
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+        }
+
+        TEST_METHOD(VerifyCancel)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+
+            auto entries = CMockPowerRenameEnumSource::CreateTree(10, CPowerRenameEnum::BatchSize);
+            auto source = std::make_unique<CMockPowerRenameEnumSource>(entries);
+            CMockPowerRenameEnumSource* mockSource = source.get();
+            CComPtr<IPowerRenameEnum> renameEnum;
+            Assert::IsTrue(CPowerRenameEnum::s_CreateInstance(std::move(source), mgr, IID_PPV_ARGS(&renameEnum)) == S_OK);
+
+            // Cancel while the second batch is produced
+            mockSource->m_onBatch = [&](UINT batch) {
+                if (batch == 2)
+                {
+                    renameEnum->Cancel();
+                }
+            };
+            Assert::IsTrue(renameEnum->Start() == E_ABORT);
+
+            UINT itemCount = 0;
+            Assert::IsTrue(mgr->GetItemCount(&itemCount) == S_OK);
+            Assert::AreEqual(2 * CPowerRenameEnum::BatchSize, itemCount);
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+        }
+
+        TEST_METHOD(VerifyPreviewDuringEnumeration)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(mgr->GetRenameRegEx(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"holiday") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"trip") == S_OK);
+
+            auto entries = CMockPowerRenameEnumSource::CreateTree(20, CPowerRenameEnum::BatchSize);
+            CComPtr<IPowerRenameEnum> renameEnum;
+            Assert::IsTrue(CPowerRenameEnum::s_CreateInstance(std::make_unique<CMockPowerRenameEnumSource>(entries), mgr, IID_PPV_ARGS(&renameEnum)) == S_OK);
+            Assert::IsTrue(renameEnum->Start() == S_OK);
+
+            // The preview runs on a worker thread, wait for it to reach the last item
+            CComPtr<IPowerRenameItem> lastItem;
+            Assert::IsTrue(mgr->GetItemByIndex(static_cast<UINT>(entries.size() - 1), &lastItem) == S_OK);
+            bool hasNewName = false;
+            for (int step = 0; step < 500 && !hasNewName; step++)
+            {
+                PWSTR newName = nullptr;
+                hasNewName = SUCCEEDED(lastItem->GetNewName(&newName)) && newName != nullptr;
+                CoTaskMemFree(newName);
+                if (!hasNewName)
+                {
+                    Sleep(10);
+                }
+            }
+            Assert::IsTrue(hasNewName);
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+        }
+
+        TEST_METHOD(VerifyStartAsync)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+
+            auto entries = CMockPowerRenameEnumSource::CreateTree(10, CPowerRenameEnum::BatchSize);
+            auto source = std::make_unique<CMockPowerRenameEnumSource>(entries);
+            const DWORD testThreadId = GetCurrentThreadId();
+            DWORD sourceThreadId = testThreadId;
+            // Renaming is refused until the items are all added
+            HRESULT renameResult = S_OK;
+            source->m_onBatch = [&](UINT batch) {
+                sourceThreadId = GetCurrentThreadId();
+                if (batch == 2)
+                {
+                    renameResult = mgr->Rename(nullptr);
+                }
+            };
+            CComPtr<IPowerRenameEnum> renameEnum;
+            Assert::IsTrue(CPowerRenameEnum::s_CreateInstance(std::move(source), mgr, IID_PPV_ARGS(&renameEnum)) == S_OK);
+
+            const UINT progressMsg = WM_APP + 1;
+            const UINT completeMsg = WM_APP + 2;
+            HWND hwnd = CreateWindowEx(0, L"Message", nullptr, 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, nullptr, nullptr);
+            Assert::IsNotNull(hwnd);
+            Assert::IsTrue(renameEnum->StartAsync(hwnd, progressMsg, completeMsg) == S_OK);
+
+            // Progress is reported as the item count doubles and for the last items
+            std::vector<UINT> progress;
+            MSG msg;
+            while (GetMessage(&msg, hwnd, progressMsg, completeMsg) > 0 && msg.message == progressMsg)
+            {
+                progress.push_back(static_cast<UINT>(msg.wParam));
+            }
+            Assert::AreEqual(completeMsg, msg.message);
+            Assert::AreEqual(static_cast<UINT>(entries.size()), static_cast<UINT>(msg.wParam));
+            Assert::IsTrue(static_cast<HRESULT>(msg.lParam) == S_OK);
+            Assert::IsTrue(progress.size() > 1);
+            Assert::AreEqual(static_cast<UINT>(entries.size()), progress.back());
+            Assert::AreNotEqual(testThreadId, sourceThreadId);
+            Assert::IsTrue(renameResult == E_PENDING);
+
+            UINT itemCount = 0;
+            Assert::IsTrue(mgr->GetItemCount(&itemCount) == S_OK);
+            Assert::AreEqual(static_cast<UINT>(entries.size()), itemCount);
+
+            renameEnum = nullptr;
+            DestroyWindow(hwnd);
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+        }
+
+        TEST_METHOD(VerifyFileSystemSource)
+        {
+            CTestFileHelper testFileHelper;
+            Assert::IsTrue(testFileHelper.AddFolder(L"foo"));
+            Assert::IsTrue(testFileHelper.AddFile(L"foo\\bar.txt"));
+            Assert::IsTrue(testFileHelper.AddFolder(L"foo\\baz"));
+            Assert::IsTrue(testFileHelper.AddFile(L"foo\\baz\\qux.txt"));
+            Assert::IsTrue(testFileHelper.AddFile(L"top.txt"));
+
+            CPowerRenameFileSystemEnumSource source({ testFileHelper.GetFullPath(L"foo"), testFileHelper.GetFullPath(L"top.txt") });
+
+            // A batch of two items at a time to go across folder boundaries
+            std::vector<PowerRenameEnumItem> items;
+            std::vector<std::wstring> names;
+            std::vector<UINT> depths;
+            HRESULT hr = S_OK;
+            do
+            {
+                hr = source.NextBatch(2, items);
+                Assert::IsTrue(SUCCEEDED(hr));
+                for (const auto& item : items)
+                {
+                    names.push_back(std::filesystem::path(item.path).filename().wstring());
+                    depths.push_back(item.depth);
+                }
+            } while (hr == S_OK);
+
+            std::vector<std::wstring> expectedNames = { L"foo", L"bar.txt", L"baz", L"qux.txt", L"top.txt" };
+            std::vector<UINT> expectedDepths = { 0, 1, 1, 2, 0 };
+            Assert::AreEqual(expectedNames.size(), names.size());
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                Assert::AreEqual(expectedNames[i], names[i]);
+                Assert::AreEqual(expectedDepths[i], depths[i]);
+            }
+
+            // Starts over after a reset
+            source.Reset();
+            Assert::IsTrue(SUCCEEDED(source.NextBatch(1, items)));
+            Assert::AreEqual(testFileHelper.GetFullPath(L"foo").wstring(), items[0].path);
+        }
+    };
+}
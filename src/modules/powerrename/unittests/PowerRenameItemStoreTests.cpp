@@ -0,0 +1,206 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <PowerRenameInterfaces.h>
+#include <PowerRenameItemStore.h>
+#include "MockPowerRenameItem.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenameItemStoreTests
+{
+    CComPtr<IPowerRenameItem> CreateItem(PCWSTR name, UINT depth, bool isFolder)
+    {
+        CComPtr<IPowerRenameItem> item;
+        Assert::IsTrue(CMockPowerRenameItem::CreateInstance(nullptr, name, depth, isFolder, SYSTEMTIME{ 0 }, &item) == S_OK);
+        return item;
+    }
+
+    int GetId(IPowerRenameItem* item)
+    {
+        int id = 0;
+        Assert::IsTrue(item->GetId(&id) == S_OK);
+        return id;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(VerifyAddAndLookup)
+        {
+            auto first = CreateItem(L"foo.txt", 0, false);
+            auto second = CreateItem(L"bar", 1, true);
+
+            auto store = std::make_shared<CPowerRenameItemStore>();
+            Assert::IsTrue(store->Add(first));
+            Assert::IsTrue(store->Add(second));
+            Assert::IsFalse(store->Add(first));
+            Assert::AreEqual(2u, store->GetCount());
+
+            Assert::AreEqual(GetId(second), store->GetId(1));
+            Assert::AreEqual(1u, store->GetDepth(1));
+            Assert::IsFalse(store->IsFolder(0));
+            Assert::IsTrue(store->IsFolder(1));
+            Assert::AreEqual(std::wstring(L"foo.txt"), std::wstring(store->GetOriginalName(0)));
+            Assert::AreEqual(std::wstring(L"bar"), std::wstring(store->GetOriginalName(1)));
+
+            UINT index = 0;
+            Assert::IsTrue(store->FindIndex(GetId(second), &index));
+            Assert::AreEqual(1u, index);
+            Assert::IsFalse(store->FindIndex(GetId(second) + 1, &index));
+
+            // The items of the store are created on demand and have the id of the item they were copied from
+            CComPtr<IPowerRenameItem> item;
+            Assert::IsTrue(store->GetItem(1, &item) == S_OK);
+            Assert::AreEqual(GetId(second), GetId(item));
+            CComPtr<IPowerRenameItem> outOfRange;
+            Assert::IsTrue(store->GetItem(2, &outOfRange) == E_FAIL);
+            Assert::IsTrue(outOfRange == nullptr);
+        }
+
+        TEST_METHOD(VerifyAddItemInfo)
+        {
+            auto store = std::make_shared<CPowerRenameItemStore>();
+            const int fileId = store->Add(PowerRenameItemInfo{ L"c:\\foo\\bar.txt", nullptr, 1, false, true });
+            const int folderId = store->Add(PowerRenameItemInfo{ L"c:\\foo", L"renamed", 0, true, false });
+            Assert::IsTrue(folderId > fileId);
+
+            Assert::AreEqual(std::wstring(L"c:\\foo\\bar.txt"), std::wstring(store->GetPath(0)));
+            Assert::AreEqual(std::wstring(L"bar.txt"), std::wstring(store->GetOriginalName(0)));
+            Assert::AreEqual(std::wstring(L"c:\\foo"), std::wstring(store->GetPath(1)));
+            Assert::AreEqual(std::wstring(L"renamed"), std::wstring(store->GetOriginalName(1)));
+            Assert::IsTrue(store->IsSelected(0));
+
+            CComPtr<IPowerRenameItem> item;
+            Assert::IsTrue(store->GetItem(0, &item) == S_OK);
+            CComHeapPtr<wchar_t> path;
+            Assert::IsTrue(item->GetPath(&path) == S_OK);
+            Assert::AreEqual(L"c:\\foo\\bar.txt", path.m_pData);
+            bool isSubFolderContent = false;
+            Assert::IsTrue(item->GetIsSubFolderContent(&isSubFolderContent) == S_OK);
+            Assert::IsTrue(isSubFolderContent);
+
+            // The shell does not let the folder be renamed
+            store->SetNewName(0, L"baz.txt");
+            store->SetNewName(1, L"baz");
+            Assert::IsTrue(store->ShouldRename(0, 0));
+            Assert::IsFalse(store->ShouldRename(1, 0));
+        }
+
+        TEST_METHOD(VerifyNewNames)
+        {
+            auto store = std::make_shared<CPowerRenameItemStore>();
+            store->Add(PowerRenameItemInfo{ nullptr, L"foo", 0, false, true });
+            store->Add(PowerRenameItemInfo{ nullptr, L"bar", 0, false, true });
+            Assert::IsTrue(store->GetNewName(0) == nullptr);
+
+            Assert::IsTrue(store->SetNewName(0, L"foo2"));
+            Assert::IsFalse(store->SetNewName(0, L"foo2"));
+            Assert::AreEqual(L"foo2", store->GetNewName(0));
+            Assert::IsTrue(store->ShouldRename(0, 0));
+
+            // Setting the original name back is not a rename
+            Assert::IsTrue(store->SetNewName(1, L"bar"));
+            Assert::IsFalse(store->ShouldRename(1, 0));
+
+            Assert::IsTrue(store->SetNewName(0, nullptr));
+            Assert::IsFalse(store->SetNewName(0, nullptr));
+            Assert::IsTrue(store->GetNewName(0) == nullptr);
+
+            // Writes through an item of the store end up in the store
+            CComPtr<IPowerRenameItem> item;
+            Assert::IsTrue(store->GetItem(1, &item) == S_OK);
+            Assert::IsTrue(item->PutNewName(L"baz") == S_OK);
+            Assert::AreEqual(L"baz", store->GetNewName(1));
+            CComHeapPtr<wchar_t> newName;
+            Assert::IsTrue(item->GetNewName(&newName) == S_OK);
+            Assert::AreEqual(L"baz", newName.m_pData);
+
+            // Items fail once they are no longer in the store
+            store->Clear();
+            CComHeapPtr<wchar_t> clearedName;
+            Assert::IsTrue(item->GetNewName(&clearedName) == E_FAIL);
+        }
+
+        TEST_METHOD(VerifySelection)
+        {
+            auto store = std::make_shared<CPowerRenameItemStore>();
+            store->Add(PowerRenameItemInfo{ nullptr, L"foo", 0, false, true });
+
+            const UINT version = store->GetSelectionVersion();
+            store->SetSelected(0, true);
+            Assert::AreEqual(version, store->GetSelectionVersion());
+
+            CComPtr<IPowerRenameItem> item;
+            Assert::IsTrue(store->GetItem(0, &item) == S_OK);
+            Assert::IsTrue(item->PutSelected(false) == S_OK);
+            Assert::IsFalse(store->IsSelected(0));
+            Assert::AreNotEqual(version, store->GetSelectionVersion());
+            Assert::IsFalse(store->IsVisibleForFilter(0, PowerRenameFilters::Selected, 0));
+            Assert::IsTrue(store->IsVisibleForFilter(0, PowerRenameFilters::None, 0));
+        }
+
+        TEST_METHOD(VerifyIdOrder)
+        {
+            // Items are kept in id order whatever the order they are added in
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            for (int i = 0; i < 5; i++)
+            {
+                items.push_back(CreateItem((L"foo" + std::to_wstring(i)).c_str(), 0, false));
+            }
+
+            auto store = std::make_shared<CPowerRenameItemStore>();
+            for (int i : { 3, 0, 4, 1, 2 })
+            {
+                Assert::IsTrue(store->Add(items[i]));
+            }
+
+            for (UINT i = 0; i < 5; i++)
+            {
+                Assert::AreEqual(GetId(items[i]), store->GetId(i));
+                Assert::AreEqual(L"foo" + std::to_wstring(i), std::wstring(store->GetOriginalName(i)));
+
+                UINT index = 0;
+                Assert::IsTrue(store->FindIndex(GetId(items[i]), &index));
+                Assert::AreEqual(i, index);
+            }
+        }
+
+        TEST_METHOD(VerifyVisibleItemIndex)
+        {
+            const UINT itemCount = 100;
+            auto store = std::make_shared<CPowerRenameItemStore>();
+            for (UINT i = 0; i < itemCount; i++)
+            {
+                store->Add(PowerRenameItemInfo{ nullptr, (L"foo" + std::to_wstring(i)).c_str(), 0, false, true });
+            }
+
+            // Everything is visible by default
+            Assert::AreEqual(itemCount, store->GetVisibleCount());
+
+            // Keep every third item visible
+            for (UINT i = 0; i < itemCount; i++)
+            {
+                store->SetVisible(i, i % 3 == 0);
+            }
+
+            Assert::AreEqual(34u, store->GetVisibleCount());
+            for (UINT visibleIndex = 0; visibleIndex < 34; visibleIndex++)
+            {
+                UINT index = 0;
+                Assert::IsTrue(store->GetVisibleItemIndex(visibleIndex, &index));
+                Assert::AreEqual(visibleIndex * 3, index);
+            }
+
+            UINT index = 0;
+            Assert::IsFalse(store->GetVisibleItemIndex(34, &index));
+
+            store->Clear();
+            Assert::AreEqual(0u, store->GetCount());
+            Assert::AreEqual(0u, store->GetVisibleCount());
+            Assert::IsFalse(store->GetVisibleItemIndex(0, &index));
+        }
+    };
+}
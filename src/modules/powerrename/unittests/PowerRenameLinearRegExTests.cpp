@@ -0,0 +1,277 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "powerrename/lib/Settings.h"
+#include <PowerRenameInterfaces.h>
+#include <PowerRenameRegEx.h>
+#include <PowerRenameRegExBackend.h>
+#include <LinearRegEx.h>
+#include <random>
+#include <regex>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenameLinearRegExTests
+{
+    std::wstring RandomString(std::mt19937& random, PCWSTR alphabet, size_t maxLength)
+    {
+        const size_t alphabetLength = wcslen(alphabet);
+        std::wstring result;
+        size_t length = random() % (maxLength + 1);
+        for (size_t i = 0; i < length; i++)
+        {
+            result.push_back(alphabet[random() % alphabetLength]);
+        }
+        return result;
+    }
+
+    // Random pattern without quantified groups, where the captures of every engine agree
+    std::wstring RandomPattern(std::mt19937& random, int depth)
+    {
+        static const PCWSTR atoms[] = { L"a", L"b", L"A", L".", L"[ab]", L"[^a]", L"\\w", L"\\d", L"\\s", L"\\b", L"^", L"$" };
+        static const PCWSTR quantifiers[] = { L"", L"", L"*", L"+", L"?", L"*?", L"{1,2}" };
+        std::wstring pattern;
+        const size_t count = 1 + random() % 3;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (depth > 0 && random() % 4 == 0)
+            {
+                pattern += L"(" + RandomPattern(random, depth - 1) + L"|" + RandomPattern(random, depth - 1) + L")";
+            }
+            else
+            {
+                std::wstring atom = atoms[random() % ARRAYSIZE(atoms)];
+                pattern += atom;
+                if (atom != L"\\b" && atom != L"^" && atom != L"$")
+                {
+                    pattern += quantifiers[random() % ARRAYSIZE(quantifiers)];
+                }
+            }
+        }
+        return pattern;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(VerifySearch)
+        {
+            std::unique_ptr<CLinearRegEx> regex;
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(\\w+)_(\\d+)(x)?", false, regex) == S_OK);
+            Assert::AreEqual(3u, regex->GetGroupCount());
+
+            CLinearRegEx::Captures captures;
+            Assert::IsTrue(regex->Search(L"IMG_2020.jpg", 0, std::wstring::npos, captures));
+            Assert::AreEqual(static_cast<size_t>(0), captures[0]);
+            Assert::AreEqual(static_cast<size_t>(8), captures[1]);
+            Assert::AreEqual(static_cast<size_t>(3), captures[3]);
+            Assert::AreEqual(static_cast<size_t>(4), captures[4]);
+            Assert::AreEqual(std::wstring::npos, captures[6]);
+
+            // Lazy quantifier and alternation in priority order
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"a+?|b", false, regex) == S_OK);
+            Assert::IsTrue(regex->Search(L"xaaa", 0, std::wstring::npos, captures));
+            Assert::AreEqual(static_cast<size_t>(1), captures[0]);
+            Assert::AreEqual(static_cast<size_t>(2), captures[1]);
+
+            // An empty match is skipped where iterating over matches forbids it
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"\\b", false, regex) == S_OK);
+            Assert::IsTrue(regex->Search(L"ab cd", 0, 0, captures));
+            Assert::AreEqual(static_cast<size_t>(2), captures[0]);
+        }
+
+        TEST_METHOD(VerifyCaseInsensitiveSearch)
+        {
+            std::unique_ptr<CLinearRegEx> regex;
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"foo[A-C]", true, regex) == S_OK);
+
+            CLinearRegEx::Captures captures;
+            Assert::IsTrue(regex->Search(L"xFOOb", 0, std::wstring::npos, captures));
+            Assert::AreEqual(static_cast<size_t>(1), captures[0]);
+            Assert::IsFalse(regex->Search(L"xFOOd", 0, std::wstring::npos, captures));
+        }
+
+        TEST_METHOD(VerifyUnsupportedSyntax)
+        {
+            std::unique_ptr<CLinearRegEx> regex;
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(a)\\1", false, regex) == E_NOTIMPL);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"a(?=b)", false, regex) == E_NOTIMPL);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(?<=a)b", false, regex) == E_NOTIMPL);
+            // Optional iterations of groups that can match the empty string
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(a*)*", false, regex) == E_NOTIMPL);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"()*x", false, regex) == E_NOTIMPL);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(a|)*b", false, regex) == E_NOTIMPL);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(?:(a)|b?)+?", false, regex) == E_NOTIMPL);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(a)*", false, regex) == S_OK);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(?:a*)*", false, regex) == S_OK);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(a*){2}", false, regex) == S_OK);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(a", false, regex) == E_INVALIDARG);
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"*a", false, regex) == E_INVALIDARG);
+        }
+
+        TEST_METHOD(VerifyPathologicalPatternIsLinear)
+        {
+            // Backtracking engines take exponential time on these
+            std::unique_ptr<CLinearRegEx> regex;
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(a|aa)+$", false, regex) == S_OK);
+
+            std::wstring text(100000, L'a');
+            text.push_back(L'b');
+            CLinearRegEx::Captures captures;
+            Assert::IsFalse(regex->Search(text, 0, std::wstring::npos, captures));
+
+            Assert::IsTrue(CLinearRegEx::s_Compile(L"(a+)+b", false, regex) == S_OK);
+            Assert::IsFalse(regex->Search(std::wstring(100000, L'a'), 0, std::wstring::npos, captures));
+        }
+
+        TEST_METHOD(VerifyRandomSearchesMatchRegex)
+        {
+            std::mt19937 random(2021);
+            for (int i = 0; i < 5000; i++)
+            {
+                const std::wstring searchTerm = RandomPattern(random, 2);
+                const std::wstring text = RandomString(random, L"aAb 1_", 12);
+                const bool caseInsensitive = (random() % 2) == 0;
+
+                std::unique_ptr<CLinearRegEx> regex;
+                Assert::IsTrue(CLinearRegEx::s_Compile(searchTerm, caseInsensitive, regex) == S_OK, searchTerm.c_str());
+
+                std::wregex pattern(searchTerm, caseInsensitive ? std::regex_constants::icase | std::regex_constants::ECMAScript : std::regex_constants::ECMAScript);
+                std::wsmatch expected;
+                const bool found = std::regex_search(text, expected, pattern);
+
+                CLinearRegEx::Captures captures;
+                Assert::AreEqual(found, regex->Search(text, 0, std::wstring::npos, captures), (searchTerm + L" / " + text).c_str());
+                if (found)
+                {
+                    for (size_t group = 0; group < expected.size(); group++)
+                    {
+                        const size_t begin = expected[group].matched ? static_cast<size_t>(expected.position(group)) : std::wstring::npos;
+                        Assert::AreEqual(begin, captures[2 * group], (searchTerm + L" / " + text).c_str());
+                    }
+                    Assert::AreEqual(static_cast<size_t>(expected.position(0) + expected.length(0)), captures[1], (searchTerm + L" / " + text).c_str());
+                }
+            }
+        }
+    };
+
+    TEST_CLASS(BackendTests)
+    {
+    public:
+        TEST_CLASS_CLEANUP(ClassCleanup)
+        {
+            CSettingsInstance().SetUseLinearRegEx(false);
+        }
+
+        TEST_METHOD(VerifyEngineSelection)
+        {
+            std::unique_ptr<CPowerRenameRegExBackend> backend;
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(L"(\\d+)", false, false, true, backend) == S_OK);
+            Assert::IsTrue(backend->GetEngine() == CPowerRenameRegExBackend::Engine::Linear);
+
+            // Left to the library for what the linear engine does not support
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(L"(a)\\1", false, false, true, backend) == S_OK);
+            Assert::IsTrue(backend->GetEngine() == CPowerRenameRegExBackend::Engine::Std);
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(L"(?<=a)b", false, true, true, backend) == S_OK);
+            Assert::IsTrue(backend->GetEngine() == CPowerRenameRegExBackend::Engine::Boost);
+
+            // Still invalid for the std engine
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(L"(?<=a)b", false, false, true, backend) == E_INVALIDARG);
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(L"(a", false, false, true, backend) == E_INVALIDARG);
+
+            Assert::IsTrue(CPowerRenameRegExBackend::s_Create(L"(\\d+)", false, false, false, backend) == S_OK);
+            Assert::IsTrue(backend->GetEngine() == CPowerRenameRegExBackend::Engine::Std);
+        }
+
+        TEST_METHOD(VerifyReplaceMatchesLibrary)
+        {
+            const PCWSTR searchTerms[] = { L".*", L"a", L"(a)(b)?", L"x*", L"(\\w+)\\.(\\w+)", L"^", L"$", L"\\b", L"(a|ab)(c|bcd)(d*)", L"[a-c]+?", L"(?:ab)*", L"IMG_(\\d+)" };
+            const PCWSTR replaceTerms[] = { L"Foo", L"$1", L"[$&]", L"$`|$'", L"$$", L"$2-$1", L"${1}x", L"\\U$1", L"" };
+            const PCWSTR sources[] = { L"AAAAAA", L"abcabd", L"foo.txt bar.jpg", L"abcd abcd", L"IMG_2020_holiday.jpg", L"xaxxb" };
+
+            for (bool useBoostLib : { false, true })
+            {
+                for (PCWSTR searchTerm : searchTerms)
+                {
+                    for (bool caseInsensitive : { false, true })
+                    {
+                        std::unique_ptr<CPowerRenameRegExBackend> library;
+                        std::unique_ptr<CPowerRenameRegExBackend> linear;
+                        Assert::IsTrue(CPowerRenameRegExBackend::s_Create(searchTerm, caseInsensitive, useBoostLib, false, library) == S_OK);
+                        Assert::IsTrue(CPowerRenameRegExBackend::s_Create(searchTerm, caseInsensitive, useBoostLib, true, linear) == S_OK);
+                        Assert::IsTrue(linear->GetEngine() == CPowerRenameRegExBackend::Engine::Linear);
+
+                        for (PCWSTR replaceTerm : replaceTerms)
+                        {
+                            for (PCWSTR source : sources)
+                            {
+                                for (bool matchAll : { false, true })
+                                {
+                                    std::wstring expected;
+                                    std::wstring result;
+                                    Assert::IsTrue(library->Replace(source, replaceTerm, matchAll, expected) == S_OK);
+                                    Assert::IsTrue(linear->Replace(source, replaceTerm, matchAll, result) == S_OK);
+                                    Assert::AreEqual(expected, result, (std::wstring(searchTerm) + L" / " + replaceTerm + L" / " + source).c_str());
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(VerifyEmptyIterationCapturesUseLibrary)
+        {
+            // The captures of these are left to the library engine
+            const PCWSTR searchTerms[] = { L"(a*)*", L"()*x", L"(a|)*b" };
+            const PCWSTR sources[] = { L"b", L"x", L"aab", L"aaxb" };
+
+            for (bool useBoostLib : { false, true })
+            {
+                for (PCWSTR searchTerm : searchTerms)
+                {
+                    std::unique_ptr<CPowerRenameRegExBackend> library;
+                    std::unique_ptr<CPowerRenameRegExBackend> linear;
+                    Assert::IsTrue(CPowerRenameRegExBackend::s_Create(searchTerm, false, useBoostLib, false, library) == S_OK);
+                    Assert::IsTrue(CPowerRenameRegExBackend::s_Create(searchTerm, false, useBoostLib, true, linear) == S_OK);
+                    Assert::IsTrue(linear->GetEngine() == library->GetEngine());
+
+                    for (PCWSTR source : sources)
+                    {
+                        std::wstring expected;
+                        std::wstring result;
+                        Assert::IsTrue(library->Replace(source, L"[$1]", true, expected) == S_OK);
+                        Assert::IsTrue(linear->Replace(source, L"[$1]", true, result) == S_OK);
+                        Assert::AreEqual(expected, result, (std::wstring(searchTerm) + L" / " + source).c_str());
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(VerifyPowerRenameRegExUsesSetting)
+        {
+            CSettingsInstance().SetUseLinearRegEx(true);
+
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | UseRegularExpressions) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"(a+)+b") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"[$1]") == S_OK);
+
+            // Too slow for a backtracking engine
+            PWSTR result = nullptr;
+            std::wstring source(5000, L'a');
+            Assert::IsTrue(renameRegEx->Replace(source.c_str(), &result) == S_OK);
+            Assert::AreEqual(source.c_str(), result);
+            CoTaskMemFree(result);
+
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L".*") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"Foo") == S_OK);
+            Assert::IsTrue(renameRegEx->Replace(L"AAAAAA", &result) == S_OK);
+            Assert::AreEqual(L"Foo", result);
+            CoTaskMemFree(result);
+
+            CSettingsInstance().SetUseLinearRegEx(false);
+        }
+    };
+}
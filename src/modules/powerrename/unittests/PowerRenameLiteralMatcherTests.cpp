@@ -0,0 +1,158 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <LiteralMatcher.h>
+#include "LiteralSearchReference.h"
+#include <algorithm>
+#include <random>
+#include <regex>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenameLiteralMatcherTests
+{
+    std::wstring RandomString(std::mt19937& random, PCWSTR alphabet, size_t maxLength)
+    {
+        const size_t alphabetLength = wcslen(alphabet);
+        std::wstring result;
+        size_t length = random() % (maxLength + 1);
+        for (size_t i = 0; i < length; i++)
+        {
+            result.push_back(alphabet[random() % alphabetLength]);
+        }
+        return result;
+    }
+
+    std::wstring Fold(std::wstring text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), ::towlower);
+        return text;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(VerifyFind)
+        {
+            CLiteralMatcher matcher(L"Foo", true);
+            Assert::AreEqual(static_cast<size_t>(0), matcher.Find(L"FOObar", 0));
+            Assert::AreEqual(static_cast<size_t>(6), matcher.Find(L"FOObarfoo", 1));
+            Assert::AreEqual(std::wstring::npos, matcher.Find(L"FObar", 0));
+            Assert::AreEqual(std::wstring::npos, matcher.Find(L"foo", 4));
+
+            CLiteralMatcher caseSensitiveMatcher(L"Foo", false);
+            Assert::AreEqual(static_cast<size_t>(9), caseSensitiveMatcher.Find(L"foo.FOO.fFoo", 0));
+        }
+
+        TEST_METHOD(VerifyFindInLongNames)
+        {
+            // Matches on both sides of the blocks scanned at once and in the tail
+            CLiteralMatcher matcher(L"ab", true);
+            for (size_t length = 2; length < 40; length++)
+            {
+                for (size_t at = 0; at + 2 <= length; at++)
+                {
+                    std::wstring text(length, L'x');
+                    text[at] = L'A';
+                    text[at + 1] = L'b';
+                    Assert::AreEqual(at, matcher.Find(text, 0));
+                    Assert::AreEqual(std::wstring::npos, matcher.Find(text, at + 1));
+                }
+            }
+        }
+
+        TEST_METHOD(VerifyReplace)
+        {
+            CLiteralMatcher matcher(L"b", true);
+            std::wstring result;
+            matcher.Replace(L"ABBA", L"bb", true, result);
+            Assert::AreEqual(std::wstring(L"AbbbbA"), result);
+            matcher.Replace(L"ABBA", L"bb", false, result);
+            Assert::AreEqual(std::wstring(L"AbbBA"), result);
+            matcher.Replace(L"xyz", L"bb", true, result);
+            Assert::AreEqual(std::wstring(L"xyz"), result);
+        }
+
+        TEST_METHOD(VerifyLiteralRegEx)
+        {
+            Assert::IsTrue(CLiteralMatcher::IsLiteralRegEx(L"foo", false));
+            Assert::IsTrue(CLiteralMatcher::IsLiteralRegEx(L"2020-01_", true));
+            Assert::IsFalse(CLiteralMatcher::IsLiteralRegEx(L"foo", true));
+            Assert::IsFalse(CLiteralMatcher::IsLiteralRegEx(L"", false));
+            Assert::IsFalse(CLiteralMatcher::IsLiteralRegEx(L"a.b", false));
+            Assert::IsFalse(CLiteralMatcher::IsLiteralRegEx(L"(foo)", false));
+            Assert::IsFalse(CLiteralMatcher::IsLiteralRegEx(L"foo$", false));
+            Assert::IsTrue(CLiteralMatcher::IsLiteralReplaceTerm(L"bar"));
+            Assert::IsFalse(CLiteralMatcher::IsLiteralReplaceTerm(L"$1bar"));
+            Assert::IsFalse(CLiteralMatcher::IsLiteralReplaceTerm(L"\\bar"));
+        }
+
+        TEST_METHOD(VerifyRandomSearchesMatchFind)
+        {
+            std::mt19937 random(12345);
+            const PCWSTR alphabet = L"aAbB_.x\u00c9\u00e9";
+            for (int i = 0; i < 20000; i++)
+            {
+                std::wstring text = RandomString(random, alphabet, 40);
+                std::wstring searchTerm = RandomString(random, alphabet, 4);
+                if (searchTerm.empty())
+                {
+                    searchTerm = L"a";
+                }
+                const bool caseInsensitive = (random() % 2) == 0;
+                const size_t pos = random() % (text.length() + 2);
+
+                CLiteralMatcher matcher(searchTerm, caseInsensitive);
+                size_t expected = caseInsensitive ? Fold(text).find(Fold(searchTerm), pos) : text.find(searchTerm, pos);
+                Assert::AreEqual(expected, matcher.Find(text, pos), (text + L" / " + searchTerm).c_str());
+            }
+        }
+
+        TEST_METHOD(VerifyRandomReplacesMatchReference)
+        {
+            std::mt19937 random(54321);
+            const PCWSTR alphabet = L"aAbB_.x";
+            for (int i = 0; i < 20000; i++)
+            {
+                std::wstring text = RandomString(random, alphabet, 40);
+                std::wstring searchTerm = RandomString(random, alphabet, 4);
+                if (searchTerm.empty())
+                {
+                    searchTerm = L"B";
+                }
+                std::wstring replaceTerm = RandomString(random, alphabet, 3);
+                const bool caseInsensitive = (random() % 2) == 0;
+                const bool matchAll = (random() % 2) == 0;
+
+                std::wstring result;
+                CLiteralMatcher(searchTerm, caseInsensitive).Replace(text, replaceTerm, matchAll, result);
+                Assert::AreEqual(ReplaceLiteralReference(text, searchTerm, replaceTerm, caseInsensitive, matchAll), result, (text + L" / " + searchTerm).c_str());
+            }
+        }
+
+        TEST_METHOD(VerifyRandomLiteralRegExMatchRegex)
+        {
+            std::mt19937 random(777);
+            const PCWSTR alphabet = L"aAb_.x1-";
+            for (int i = 0; i < 20000; i++)
+            {
+                std::wstring text = RandomString(random, alphabet, 30);
+                std::wstring searchTerm = RandomString(random, alphabet, 4);
+                std::wstring replaceTerm = RandomString(random, alphabet, 3);
+                const bool caseInsensitive = (random() % 2) == 0;
+                const bool matchAll = (random() % 2) == 0;
+                if (!CLiteralMatcher::IsLiteralRegEx(searchTerm, caseInsensitive))
+                {
+                    continue;
+                }
+
+                std::wregex pattern(searchTerm, caseInsensitive ? std::regex_constants::icase | std::regex_constants::ECMAScript : std::regex_constants::ECMAScript);
+                std::wstring expected = matchAll ? std::regex_replace(text, pattern, replaceTerm) : std::regex_replace(text, pattern, replaceTerm, std::regex_constants::format_first_only);
+
+                std::wstring result;
+                CLiteralMatcher(searchTerm, caseInsensitive).Replace(text, replaceTerm, matchAll, result);
+                Assert::AreEqual(expected, result, (text + L" / " + searchTerm).c_str());
+            }
+        }
+    };
+}
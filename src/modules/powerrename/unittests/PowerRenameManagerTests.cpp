@@ -20,6 +20,14 @@ HINSTANCE g_hInst = HINST_THISCOMPONENT;
 
 namespace PowerRenameManagerTests
 {
+    // The manager keeps a copy of the items added to it so items are compared by id
+    int GetItemId(IPowerRenameItem* item)
+    {
+        int id = 0;
+        Assert::IsTrue(item->GetId(&id) == S_OK);
+        return id;
+    }
+
     TEST_CLASS(SimpleTests)
     {
     public:
@@ -133,6 +141,223 @@ namespace PowerRenameManagerTests
             Assert::IsTrue(mgr->Shutdown() == S_OK);
         }
 
+        TEST_METHOD(VerifyItemLookup)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            for (int i = 0; i < 10; i++)
+            {
+                CComPtr<IPowerRenameItem> item;
+                CMockPowerRenameItem::CreateInstance(L"foo", L"foo", 0, false, SYSTEMTIME{ 0 }, &item);
+                Assert::IsTrue(mgr->AddItem(item) == S_OK);
+                items.push_back(item);
+            }
+
+            // Adding the same item twice fails
+            Assert::IsTrue(mgr->AddItem(items[0]) == E_FAIL);
+
+            UINT itemCount = 0;
+            Assert::IsTrue(mgr->GetItemCount(&itemCount) == S_OK);
+            Assert::AreEqual(10u, itemCount);
+
+            for (UINT i = 0; i < itemCount; i++)
+            {
+                CComPtr<IPowerRenameItem> item;
+                Assert::IsTrue(mgr->GetItemByIndex(i, &item) == S_OK);
+                Assert::AreEqual(GetItemId(items[i]), GetItemId(item));
+
+                CComPtr<IPowerRenameItem> itemById;
+                Assert::IsTrue(mgr->GetItemById(GetItemId(items[i]), &itemById) == S_OK);
+                Assert::AreEqual(GetItemId(items[i]), GetItemId(itemById));
+            }
+
+            CComPtr<IPowerRenameItem> item;
+            Assert::IsTrue(mgr->GetItemByIndex(itemCount, &item) == E_FAIL);
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+        }
+
+        TEST_METHOD(VerifyAddItems)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+            CMockPowerRenameManagerEvents* mockMgrEvents = new CMockPowerRenameManagerEvents();
+            CComPtr<IPowerRenameManagerEvents> mgrEvents;
+            Assert::IsTrue(mockMgrEvents->QueryInterface(IID_PPV_ARGS(&mgrEvents)) == S_OK);
+            DWORD cookie = 0;
+            Assert::IsTrue(mgr->Advise(mgrEvents, &cookie) == S_OK);
+
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            std::vector<IPowerRenameItem*> batch;
+            for (int i = 0; i < 10; i++)
+            {
+                CComPtr<IPowerRenameItem> item;
+                CMockPowerRenameItem::CreateInstance(L"foo", L"foo", 0, false, SYSTEMTIME{ 0 }, &item);
+                items.push_back(item);
+                batch.push_back(item);
+            }
+
+            Assert::IsTrue(mgr->AddItems(batch.data(), 5) == S_OK);
+            Assert::IsTrue(mockMgrEvents->m_itemAdded == items[4]);
+
+            // The item already added is skipped and the rest are still added
+            batch[7] = items[0];
+            Assert::IsTrue(mgr->AddItems(batch.data() + 5, 5) == S_FALSE);
+            Assert::IsTrue(mockMgrEvents->m_itemAdded == items[9]);
+
+            UINT itemCount = 0;
+            Assert::IsTrue(mgr->GetItemCount(&itemCount) == S_OK);
+            Assert::AreEqual(9u, itemCount);
+            items.erase(items.begin() + 7);
+            for (UINT i = 0; i < itemCount; i++)
+            {
+                CComPtr<IPowerRenameItem> item;
+                Assert::IsTrue(mgr->GetItemByIndex(i, &item) == S_OK);
+                Assert::AreEqual(GetItemId(items[i]), GetItemId(item));
+            }
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+            mockMgrEvents->Release();
+        }
+
+        TEST_METHOD(VerifyItemsUpdatedInBatches)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+            CMockPowerRenameManagerEvents* mockMgrEvents = new CMockPowerRenameManagerEvents();
+            CComPtr<IPowerRenameManagerEvents> mgrEvents;
+            Assert::IsTrue(mockMgrEvents->QueryInterface(IID_PPV_ARGS(&mgrEvents)) == S_OK);
+            DWORD cookie = 0;
+            Assert::IsTrue(mgr->Advise(mgrEvents, &cookie) == S_OK);
+
+            CComPtr<IPowerRenameRegEx> renRegEx;
+            Assert::IsTrue(mgr->GetRenameRegEx(&renRegEx) == S_OK);
+            renRegEx->PutSearchTerm(L"foo");
+            renRegEx->PutReplaceTerm(L"bar");
+
+            const UINT itemCount = 5000;
+            for (UINT i = 0; i < itemCount; i++)
+            {
+                CComPtr<IPowerRenameItem> item;
+                CMockPowerRenameItem::CreateInstance(L"foo", L"foo", 0, false, SYSTEMTIME{ 0 }, &item);
+                Assert::IsTrue(mgr->AddItem(item) == S_OK);
+            }
+
+            auto pumpMessages = [&]() {
+                MSG msg;
+                while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+                {
+                    TranslateMessage(&msg);
+                    DispatchMessage(&msg);
+                }
+            };
+
+            // Drop the notifications of the previews run while there were no items
+            pumpMessages();
+            mockMgrEvents->m_regExCompleted = false;
+
+            Assert::IsTrue(mgr->UpdatePreview() == S_OK);
+            for (int step = 0; step < 500 && !mockMgrEvents->m_regExCompleted; step++)
+            {
+                Sleep(10);
+                pumpMessages();
+            }
+            Assert::IsTrue(mockMgrEvents->m_regExCompleted);
+
+            // Every item is reported once, in far fewer notifications than items
+            Assert::AreEqual(itemCount, mockMgrEvents->m_updatedItemCount);
+            Assert::IsTrue(mockMgrEvents->m_itemsUpdatedCount < itemCount);
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+            mockMgrEvents->Release();
+        }
+
+        TEST_METHOD(VerifyVisibleItemLookup)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+
+            // Only folders apply when files are excluded, and parents of a visible item stay visible
+            struct
+            {
+                PCWSTR name;
+                UINT depth;
+                bool isFolder;
+            } entries[] = {
+                { L"a", 0, true },
+                { L"b", 1, false },
+                { L"c", 1, true },
+                { L"d", 2, false },
+                { L"e", 0, false },
+                { L"f", 0, true },
+            };
+
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            for (auto& entry : entries)
+            {
+                CComPtr<IPowerRenameItem> item;
+                CMockPowerRenameItem::CreateInstance(entry.name, entry.name, entry.depth, entry.isFolder, SYSTEMTIME{ 0 }, &item);
+                Assert::IsTrue(mgr->AddItem(item) == S_OK);
+                items.push_back(item);
+            }
+
+            Assert::IsTrue(mgr->PutFlags(DEFAULT_FLAGS | ExcludeFiles) == S_OK);
+            // None -> Selected -> FlagsApplicable
+            Assert::IsTrue(mgr->SwitchFilter(0) == S_OK);
+            Assert::IsTrue(mgr->SwitchFilter(0) == S_OK);
+
+            UINT visibleCount = 0;
+            Assert::IsTrue(mgr->GetVisibleItemCount(&visibleCount) == S_OK);
+            Assert::AreEqual(3u, visibleCount);
+
+            size_t expected[] = { 0, 2, 5 };
+            for (UINT i = 0; i < visibleCount; i++)
+            {
+                CComPtr<IPowerRenameItem> item;
+                Assert::IsTrue(mgr->GetVisibleItemByIndex(i, &item) == S_OK);
+                Assert::AreEqual(GetItemId(items[expected[i]]), GetItemId(item));
+            }
+
+            CComPtr<IPowerRenameItem> item;
+            Assert::IsTrue(mgr->GetVisibleItemByIndex(visibleCount, &item) == E_FAIL);
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+        }
+
+        TEST_METHOD(VerifyVisibleItemsFollowSelection)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+
+            PowerRenameItemInfo infos[] = {
+                { nullptr, L"a", 0, false, true },
+                { nullptr, L"b", 0, false, true },
+                { nullptr, L"c", 0, false, true },
+            };
+            Assert::IsTrue(mgr->AddItemInfos(infos, ARRAYSIZE(infos)) == S_OK);
+
+            // None -> Selected
+            Assert::IsTrue(mgr->SwitchFilter(0) == S_OK);
+            UINT visibleCount = 0;
+            Assert::IsTrue(mgr->GetVisibleItemCount(&visibleCount) == S_OK);
+            Assert::AreEqual(3u, visibleCount);
+
+            // Unselecting an item through the item hides it without telling the manager
+            CComPtr<IPowerRenameItem> item;
+            Assert::IsTrue(mgr->GetItemByIndex(1, &item) == S_OK);
+            Assert::IsTrue(item->PutSelected(false) == S_OK);
+
+            Assert::IsTrue(mgr->GetVisibleItemCount(&visibleCount) == S_OK);
+            Assert::AreEqual(2u, visibleCount);
+            CComPtr<IPowerRenameItem> visibleItem;
+            Assert::IsTrue(mgr->GetVisibleItemByIndex(1, &visibleItem) == S_OK);
+            CComHeapPtr<wchar_t> originalName;
+            Assert::IsTrue(visibleItem->GetOriginalName(&originalName) == S_OK);
+            Assert::AreEqual(L"c", originalName.m_pData);
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+        }
+
         TEST_METHOD(VerifyRenameManagerEvents)
         {
             CComPtr<IPowerRenameManager> mgr;
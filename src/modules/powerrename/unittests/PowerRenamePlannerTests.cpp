@@ -0,0 +1,277 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <PowerRenamePlanner.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenamePlannerTests
+{
+    using ItemStatus = CPowerRenamePlanner::ItemStatus;
+    using OperationKind = CPowerRenamePlanner::OperationKind;
+
+    std::wstring Fold(std::wstring_view name)
+    {
+        std::wstring folded(name);
+        std::transform(folded.begin(), folded.end(), folded.begin(), ::towupper);
+        return folded;
+    }
+
+    // Runs the plan against the original names, checking that every operation finds its
+    // source and a free target once the previous waves are done, whatever the order of the
+    // operations within a wave.  Returns the names at the end.
+    std::set<std::pair<std::wstring, std::wstring>> RunPlan(const CPowerRenamePlanner& planner)
+    {
+        std::set<std::pair<std::wstring, std::wstring>> names;
+        for (UINT item = 0; item < planner.GetItemCount(); item++)
+        {
+            if (planner.GetItemStatus(item) != ItemStatus::Duplicate)
+            {
+                Assert::IsTrue(names.emplace(planner.GetParentPath(item), Fold(planner.GetOriginalName(item))).second);
+            }
+        }
+
+        const auto& operations = planner.GetOperations();
+        for (UINT wave = 0; wave < planner.GetWaveCount(); wave++)
+        {
+            std::set<std::pair<std::wstring, std::wstring>> sources;
+            std::set<std::pair<std::wstring, std::wstring>> targets;
+            for (UINT i = planner.GetWaveStart(wave); i < planner.GetWaveStart(wave + 1); i++)
+            {
+                const auto& operation = operations[i];
+                const std::wstring& directory = planner.GetParentPath(operation.item);
+                std::wstring source = Fold(operation.kind == OperationKind::RenameFromTemporary ? planner.GetTemporaryName(operation.item) : planner.GetOriginalName(operation.item));
+                std::wstring target = Fold(operation.kind == OperationKind::RenameToTemporary ? planner.GetTemporaryName(operation.item) : planner.GetNewName(operation.item));
+
+                Assert::IsTrue(names.count({ directory, source }) == 1);
+                Assert::IsTrue(source == target || names.count({ directory, target }) == 0);
+                Assert::IsTrue(sources.emplace(directory, source).second);
+                Assert::IsTrue(targets.emplace(directory, target).second);
+            }
+
+            for (const auto& source : sources)
+            {
+                names.erase(source);
+            }
+            names.insert(targets.begin(), targets.end());
+        }
+        return names;
+    }
+
+    void VerifyFinalNames(const CPowerRenamePlanner& planner, const std::set<std::pair<std::wstring, std::wstring>>& names)
+    {
+        size_t expectedCount = 0;
+        for (UINT item = 0; item < planner.GetItemCount(); item++)
+        {
+            const ItemStatus status = planner.GetItemStatus(item);
+            if (status == ItemStatus::Duplicate)
+            {
+                continue;
+            }
+
+            const bool isRenamed = status == ItemStatus::Renamed || status == ItemStatus::RenamedThroughTemporary;
+            const std::wstring name = Fold(isRenamed ? planner.GetNewName(item) : planner.GetOriginalName(item));
+            Assert::IsTrue(names.count({ planner.GetParentPath(item), name }) == 1);
+            expectedCount++;
+        }
+        Assert::AreEqual(expectedCount, names.size());
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(VerifyIndependentRenames)
+        {
+            CPowerRenamePlanner planner;
+            planner.AddItem(L"c:\\dir", L"a.txt", L"x.txt", 1);
+            planner.AddItem(L"c:\\dir", L"b.txt", L"y.txt", 1);
+            planner.AddItem(L"c:\\dir", L"c.txt", L"c.txt", 1);
+            planner.AddItem(L"c:\\dir", L"d.txt", L"", 1);
+            planner.Plan();
+
+            Assert::IsTrue(planner.GetItemStatus(0) == ItemStatus::Renamed);
+            Assert::IsTrue(planner.GetItemStatus(2) == ItemStatus::Unchanged);
+            Assert::IsTrue(planner.GetItemStatus(3) == ItemStatus::Unchanged);
+            Assert::AreEqual(1u, planner.GetWaveCount());
+            Assert::AreEqual(static_cast<size_t>(2), planner.GetOperations().size());
+            Assert::AreEqual(2u, planner.GetReport().renamed);
+            Assert::AreEqual(2u, planner.GetReport().unchanged);
+        }
+
+        TEST_METHOD(VerifyChainIsOrdered)
+        {
+            // file2 has to move before file1 can take its name
+            CPowerRenamePlanner planner;
+            planner.AddItem(L"c:\\dir", L"file1", L"file2", 1);
+            planner.AddItem(L"c:\\dir", L"file2", L"file3", 1);
+            planner.Plan();
+
+            Assert::AreEqual(2u, planner.GetWaveCount());
+            Assert::AreEqual(1u, planner.GetOperations()[0].item);
+            Assert::AreEqual(0u, planner.GetOperations()[1].item);
+            Assert::AreEqual(2u, planner.GetReport().longestChain);
+            VerifyFinalNames(planner, RunPlan(planner));
+        }
+
+        TEST_METHOD(VerifyCycleUsesTemporaryName)
+        {
+            CPowerRenamePlanner planner;
+            planner.AddItem(L"c:\\dir", L"a", L"b", 1);
+            planner.AddItem(L"c:\\dir", L"b", L"a", 1);
+            planner.Plan();
+
+            Assert::IsTrue(planner.GetItemStatus(0) == ItemStatus::RenamedThroughTemporary);
+            Assert::IsTrue(planner.GetItemStatus(1) == ItemStatus::Renamed);
+            Assert::IsFalse(planner.GetTemporaryName(0).empty());
+            Assert::AreEqual(1u, planner.GetReport().cycles);
+            Assert::AreEqual(3u, planner.GetWaveCount());
+
+            const auto& operations = planner.GetOperations();
+            Assert::IsTrue(operations[0].kind == OperationKind::RenameToTemporary);
+            Assert::IsTrue(operations[1].kind == OperationKind::Rename);
+            Assert::IsTrue(operations[2].kind == OperationKind::RenameFromTemporary);
+            VerifyFinalNames(planner, RunPlan(planner));
+        }
+
+        TEST_METHOD(VerifyTemporaryNameIsFreeOnDisk)
+        {
+            CPowerRenamePlanner planner;
+            planner.AddItem(L"c:\\dir", L"a", L"b", 1);
+            planner.AddItem(L"c:\\dir", L"b", L"a", 1);
+
+            // Files the planner does not know about hold the first temporary names
+            std::vector<std::wstring> checkedNames;
+            planner.Plan(false, [&](const std::wstring& parentPath, const std::wstring& name) {
+                Assert::AreEqual(std::wstring(L"c:\\dir"), parentPath);
+                checkedNames.push_back(name);
+                return checkedNames.size() < 3;
+            });
+
+            Assert::AreEqual(static_cast<size_t>(3), checkedNames.size());
+            Assert::AreEqual(checkedNames.back(), std::wstring(planner.GetTemporaryName(0)));
+            VerifyFinalNames(planner, RunPlan(planner));
+        }
+
+        TEST_METHOD(VerifyCollisionsAreSkipped)
+        {
+            CPowerRenamePlanner planner;
+            planner.AddItem(L"c:\\dir", L"a", L"same", 1);
+            planner.AddItem(L"c:\\dir", L"b", L"SAME", 1);
+            // Same name in another directory is fine
+            planner.AddItem(L"c:\\other", L"a", L"same", 1);
+            planner.Plan();
+
+            Assert::IsTrue(planner.GetItemStatus(0) == ItemStatus::Collision);
+            Assert::IsTrue(planner.GetItemStatus(1) == ItemStatus::Collision);
+            Assert::IsTrue(planner.GetItemStatus(2) == ItemStatus::Renamed);
+            Assert::AreEqual(2u, planner.GetReport().collisions);
+            VerifyFinalNames(planner, RunPlan(planner));
+        }
+
+        TEST_METHOD(VerifyTargetExistsCascades)
+        {
+            // c keeps its name so b cannot take it, so b keeps its name and a cannot take it
+            CPowerRenamePlanner planner;
+            planner.AddItem(L"c:\\dir", L"a", L"b", 1);
+            planner.AddItem(L"c:\\dir", L"b", L"C", 1);
+            planner.AddItem(L"c:\\dir", L"c", L"", 1);
+            planner.Plan();
+
+            Assert::IsTrue(planner.GetItemStatus(0) == ItemStatus::TargetExists);
+            Assert::IsTrue(planner.GetItemStatus(1) == ItemStatus::TargetExists);
+            Assert::AreEqual(0u, planner.GetWaveCount());
+            Assert::AreNotEqual(std::wstring::npos, planner.FormatReport().find(L"conflict c:\\dir\\a"));
+        }
+
+        TEST_METHOD(VerifyRenameOnCollision)
+        {
+            CPowerRenamePlanner planner;
+            planner.AddItem(L"c:\\dir", L"a", L"same", 1);
+            planner.AddItem(L"c:\\dir", L"b", L"same", 1);
+            planner.AddItem(L"c:\\dir", L"c", L"d", 1);
+            planner.AddItem(L"c:\\dir", L"d", L"e", 1);
+            planner.AddItem(L"c:", L"dir", L"folder", 0);
+            planner.Plan(true);
+
+            // Chain c -> d -> e, then the collisions, then the parent folder
+            Assert::AreEqual(4u, planner.GetWaveCount());
+            const auto& operations = planner.GetOperations();
+            Assert::AreEqual(planner.GetWaveStart(3) - 2, planner.GetWaveStart(2));
+            Assert::IsTrue(operations[planner.GetWaveStart(2)].kind == OperationKind::RenameOnCollision);
+            Assert::AreEqual(4u, operations[planner.GetWaveStart(3)].item);
+            Assert::AreEqual(2u, planner.GetReport().collisions);
+        }
+
+        TEST_METHOD(VerifyCaseOnlyRename)
+        {
+            CPowerRenamePlanner planner;
+            planner.AddItem(L"c:\\dir", L"photo.JPG", L"photo.jpg", 1);
+            planner.Plan();
+
+            Assert::IsTrue(planner.GetItemStatus(0) == ItemStatus::Renamed);
+            Assert::AreEqual(1u, planner.GetWaveCount());
+            VerifyFinalNames(planner, RunPlan(planner));
+        }
+
+        TEST_METHOD(VerifyDeeperItemsFirst)
+        {
+            CPowerRenamePlanner planner;
+            planner.AddItem(L"c:", L"folder", L"renamed", 0);
+            planner.AddItem(L"c:\\folder", L"file", L"renamedFile", 1);
+            planner.Plan();
+
+            Assert::AreEqual(2u, planner.GetWaveCount());
+            Assert::AreEqual(1u, planner.GetOperations()[0].item);
+            Assert::AreEqual(0u, planner.GetOperations()[1].item);
+        }
+
+        TEST_METHOD(VerifyRandomPlansAreValid)
+        {
+            std::mt19937 random(31);
+            for (int run = 0; run < 300; run++)
+            {
+                // Few names and directories, for many chains, cycles and collisions
+                const UINT nameCount = 2 + random() % 12;
+                CPowerRenamePlanner planner;
+                for (UINT directory = 0; directory < 3; directory++)
+                {
+                    const std::wstring path = L"c:\\" + std::to_wstring(directory);
+                    for (UINT name = 0; name < nameCount; name++)
+                    {
+                        if (random() % 3 == 0)
+                        {
+                            continue;
+                        }
+                        const std::wstring original = L"n" + std::to_wstring(name);
+                        std::wstring newName;
+                        switch (random() % 4)
+                        {
+                        case 0:
+                            break;
+                        case 1:
+                            newName = L"N" + std::to_wstring(random() % nameCount);
+                            break;
+                        default:
+                            newName = L"n" + std::to_wstring(random() % (nameCount + 2));
+                            break;
+                        }
+                        planner.AddItem(path, original, newName, directory == 0 ? 0 : 1);
+                    }
+                }
+                planner.Plan();
+
+                VerifyFinalNames(planner, RunPlan(planner));
+
+                // Planning twice gives the same plan
+                const auto operationCount = planner.GetOperations().size();
+                planner.Plan();
+                Assert::AreEqual(operationCount, planner.GetOperations().size());
+            }
+        }
+    };
+}
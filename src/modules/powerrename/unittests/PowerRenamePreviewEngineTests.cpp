@@ -0,0 +1,285 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "powerrename/lib/Settings.h"
+#include <PowerRenameInterfaces.h>
+#include <PowerRenameRegEx.h>
+#include <PowerRenamePreviewEngine.h>
+#include "MockPowerRenameItem.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenamePreviewEngineTests
+{
+    std::vector<CComPtr<IPowerRenameItem>> CreateItems(int count)
+    {
+        std::vector<CComPtr<IPowerRenameItem>> items;
+        SYSTEMTIME fileTime = { 2020, 7, 3, 22, 15, 6, 42, 453 };
+        for (int i = 0; i < count; i++)
+        {
+            // Mix files and folders at a few depths, some without an extension
+            std::wstring name = L"foo_" + std::to_wstring(i) + ((i % 5 == 0) ? L"" : L".Foo.txt");
+            CComPtr<IPowerRenameItem> item;
+            Assert::IsTrue(CMockPowerRenameItem::CreateInstance(nullptr, name.c_str(), i % 3, i % 7 == 0, fileTime, &item) == S_OK);
+            items.push_back(item);
+        }
+        return items;
+    }
+
+    std::vector<std::wstring> GetNewNames(const std::vector<CComPtr<IPowerRenameItem>>& items)
+    {
+        std::vector<std::wstring> names;
+        for (auto& item : items)
+        {
+            PWSTR newName = nullptr;
+            item->GetNewName(&newName);
+            names.push_back(newName ? newName : L"<none>");
+            CoTaskMemFree(newName);
+        }
+        return names;
+    }
+
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_CLASS_INITIALIZE(ClassInitialize)
+        {
+            CSettingsInstance().SetUseBoostLib(false);
+        }
+
+        // Runs the engine on one thread and on several threads and verifies both produce the same names
+        void VerifyParallelMatchesSerial(DWORD flags, PCWSTR search, PCWSTR replace)
+        {
+            const int itemCount = 3 * CPowerRenamePreviewEngine::ChunkSize + 17;
+
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutFlags(flags) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(search) == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(replace) == S_OK);
+
+            auto serialItems = CreateItems(itemCount);
+            int serialUpdates = 0;
+            CPowerRenamePreviewEngine serialEngine(1);
+            Assert::IsTrue(serialEngine.Run(serialItems, renameRegEx, nullptr, [&](UINT, int) { serialUpdates++; }) == S_OK);
+
+            auto parallelItems = CreateItems(itemCount);
+            std::atomic<int> parallelUpdates{ 0 };
+            CPowerRenamePreviewEngine parallelEngine(4);
+            Assert::IsTrue(parallelEngine.Run(parallelItems, renameRegEx, nullptr, [&](UINT, int) { parallelUpdates++; }) == S_OK);
+
+            auto serialNames = GetNewNames(serialItems);
+            auto parallelNames = GetNewNames(parallelItems);
+            for (int i = 0; i < itemCount; i++)
+            {
+                Assert::AreEqual(serialNames[i], parallelNames[i]);
+            }
+            Assert::AreEqual(serialUpdates, parallelUpdates.load());
+        }
+
+        TEST_METHOD(VerifyParallelMatchesSerial)
+        {
+            VerifyParallelMatchesSerial(MatchAllOccurences, L"foo", L"bar");
+        }
+
+        TEST_METHOD(VerifyParallelMatchesSerialRegEx)
+        {
+            VerifyParallelMatchesSerial(MatchAllOccurences | UseRegularExpressions, L"foo_(\\d+)", L"$1_bar");
+        }
+
+        TEST_METHOD(VerifyParallelMatchesSerialEnumerate)
+        {
+            VerifyParallelMatchesSerial(MatchAllOccurences | EnumerateItems | ExcludeFolders, L"foo_\\d+", L"bar");
+        }
+
+        TEST_METHOD(VerifyParallelMatchesSerialNameOnly)
+        {
+            VerifyParallelMatchesSerial(MatchAllOccurences | NameOnly | Uppercase, L"foo", L"bar");
+        }
+
+        TEST_METHOD(VerifyParallelMatchesSerialExtensionOnly)
+        {
+            VerifyParallelMatchesSerial(MatchAllOccurences | ExtensionOnly | ExcludeSubfolders, L"txt", L"md");
+        }
+
+        TEST_METHOD(VerifyParallelMatchesSerialFileTime)
+        {
+            VerifyParallelMatchesSerial(MatchAllOccurences | UseRegularExpressions, L"foo", L"$YYYY-$MM-$DD");
+        }
+
+        TEST_METHOD(VerifyEnumerationOrder)
+        {
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | UseRegularExpressions | EnumerateItems) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"^.+$") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"bar") == S_OK);
+
+            auto items = CreateItems(2 * CPowerRenamePreviewEngine::ChunkSize);
+            CPowerRenamePreviewEngine engine(4);
+            Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [](UINT, int) {}) == S_OK);
+
+            auto names = GetNewNames(items);
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                Assert::AreEqual(L"bar (" + std::to_wstring(i + 1) + L")", names[i]);
+            }
+        }
+
+        // Runs a new engine on new items and verifies it produces the same names as the incremental run
+        void VerifyMatchesFreshRun(IPowerRenameRegEx* renameRegEx, const std::vector<CComPtr<IPowerRenameItem>>& items)
+        {
+            auto freshItems = CreateItems(static_cast<int>(items.size()));
+            CPowerRenamePreviewEngine freshEngine(4);
+            Assert::IsTrue(freshEngine.Run(freshItems, renameRegEx, nullptr, [](UINT, int) {}) == S_OK);
+
+            auto names = GetNewNames(items);
+            auto freshNames = GetNewNames(freshItems);
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                Assert::AreEqual(freshNames[i], names[i]);
+            }
+        }
+
+        TEST_METHOD(VerifyIncrementalStages)
+        {
+            const int itemCount = 2 * CPowerRenamePreviewEngine::ChunkSize + 17;
+            int folderCount = 0;
+            for (int i = 0; i < itemCount; i++)
+            {
+                folderCount += (i % 7 == 0) ? 1 : 0;
+            }
+
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"foo") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"bar") == S_OK);
+
+            auto items = CreateItems(itemCount);
+            std::atomic<int> updates{ 0 };
+            CPowerRenamePreviewEngine engine(4);
+            auto run = [&]() {
+                updates = 0;
+                Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [&](UINT, int) { updates++; }) == S_OK);
+                VerifyMatchesFreshRun(renameRegEx, items);
+                return engine.GetLastRunStats();
+            };
+
+            auto stats = run();
+            Assert::AreEqual(static_cast<UINT>(itemCount), stats.replaced);
+            Assert::AreEqual(itemCount, updates.load());
+
+            // Nothing changed
+            stats = run();
+            Assert::AreEqual(0u, stats.replaced);
+            Assert::AreEqual(0u, stats.trimmed);
+            Assert::AreEqual(0u, stats.transformed);
+            Assert::AreEqual(0u, stats.committed);
+            Assert::AreEqual(0, updates.load());
+
+            // A case transform only runs the transform stage
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | Uppercase) == S_OK);
+            stats = run();
+            Assert::AreEqual(0u, stats.replaced);
+            Assert::AreEqual(0u, stats.trimmed);
+            Assert::AreEqual(static_cast<UINT>(itemCount), stats.transformed);
+
+            // Excluding folders only touches the folders
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | Uppercase | ExcludeFolders) == S_OK);
+            stats = run();
+            Assert::AreEqual(0u, stats.replaced);
+            Assert::AreEqual(0u, stats.transformed);
+            Assert::AreEqual(static_cast<UINT>(folderCount), stats.committed);
+            Assert::AreEqual(folderCount, updates.load());
+
+            // Including them again reuses their results
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | Uppercase) == S_OK);
+            stats = run();
+            Assert::AreEqual(0u, stats.replaced);
+            Assert::AreEqual(static_cast<UINT>(folderCount), stats.committed);
+
+            // A new replace term runs every stage again
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"baz") == S_OK);
+            stats = run();
+            Assert::AreEqual(static_cast<UINT>(itemCount), stats.replaced);
+            Assert::AreEqual(static_cast<UINT>(itemCount), stats.committed);
+
+            // Enumeration renumbers the items without running the regex again
+            Assert::IsTrue(renameRegEx->PutFlags(MatchAllOccurences | Uppercase | EnumerateItems) == S_OK);
+            stats = run();
+            Assert::AreEqual(0u, stats.replaced);
+            Assert::AreEqual(0u, stats.transformed);
+            Assert::AreEqual(static_cast<UINT>(itemCount), stats.committed);
+        }
+
+        TEST_METHOD(VerifyIncrementalAfterCancel)
+        {
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"foo") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"bar") == S_OK);
+
+            auto items = CreateItems(CPowerRenamePreviewEngine::ChunkSize);
+            CPowerRenamePreviewEngine engine(4);
+            Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [](UINT, int) {}) == S_OK);
+
+            // A canceled run must not leave stale results behind
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"baz") == S_OK);
+            HANDLE cancelEvent = CreateEvent(nullptr, TRUE, TRUE, nullptr);
+            Assert::IsTrue(engine.Run(items, renameRegEx, cancelEvent, [](UINT, int) {}) == E_ABORT);
+            CloseHandle(cancelEvent);
+
+            Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [](UINT, int) {}) == S_OK);
+            VerifyMatchesFreshRun(renameRegEx, items);
+        }
+
+        TEST_METHOD(VerifyNewItemsAfterRun)
+        {
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"foo") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"bar") == S_OK);
+
+            auto items = CreateItems(10);
+            CPowerRenamePreviewEngine engine(4);
+            Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [](UINT, int) {}) == S_OK);
+
+            // Other items at the same indices get their own results
+            items = CreateItems(20);
+            Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [](UINT, int) {}) == S_OK);
+            Assert::AreEqual(20u, engine.GetLastRunStats().replaced);
+            VerifyMatchesFreshRun(renameRegEx, items);
+        }
+
+        TEST_METHOD(VerifyCancel)
+        {
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"foo") == S_OK);
+            Assert::IsTrue(renameRegEx->PutReplaceTerm(L"bar") == S_OK);
+
+            HANDLE cancelEvent = CreateEvent(nullptr, TRUE, TRUE, nullptr);
+            auto items = CreateItems(CPowerRenamePreviewEngine::ChunkSize);
+            int updates = 0;
+            CPowerRenamePreviewEngine engine(4);
+            Assert::IsTrue(engine.Run(items, renameRegEx, cancelEvent, [&](UINT, int) { updates++; }) == E_ABORT);
+            Assert::AreEqual(0, updates);
+            CloseHandle(cancelEvent);
+        }
+
+        TEST_METHOD(VerifyInvalidRegExFails)
+        {
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->PutFlags(UseRegularExpressions) == S_OK);
+            Assert::IsTrue(renameRegEx->PutSearchTerm(L"(foo") == S_OK);
+
+            auto items = CreateItems(10);
+            CPowerRenamePreviewEngine engine(4);
+            Assert::IsTrue(engine.Run(items, renameRegEx, nullptr, [](UINT, int) {}) == E_FAIL);
+        }
+    };
+}
@@ -0,0 +1,145 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <PowerRenameProgressChannel.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenameProgressChannelTests
+{
+    TEST_CLASS(SimpleTests)
+    {
+    public:
+        TEST_METHOD(VerifyRanges)
+        {
+            std::atomic<int> notifications{ 0 };
+            CPowerRenameProgressChannel channel([&]() { notifications++; });
+            for (UINT index : { 200u, 3u, 1u, 2u, 70u, 64u, 65u, 2u })
+            {
+                channel.MarkUpdated(index);
+            }
+
+            // Only the first update notifies until the updates are taken
+            Assert::AreEqual(1, notifications.load());
+
+            std::vector<CPowerRenameProgressChannel::ItemRange> ranges;
+            channel.TakeUpdatedRanges(ranges);
+            Assert::AreEqual(4ull, static_cast<unsigned long long>(ranges.size()));
+            Assert::AreEqual(1u, ranges[0].first);
+            Assert::AreEqual(3u, ranges[0].last);
+            Assert::AreEqual(64u, ranges[1].first);
+            Assert::AreEqual(65u, ranges[1].last);
+            Assert::AreEqual(70u, ranges[2].first);
+            Assert::AreEqual(70u, ranges[2].last);
+            Assert::AreEqual(200u, ranges[3].first);
+            Assert::AreEqual(200u, ranges[3].last);
+
+            channel.TakeUpdatedRanges(ranges);
+            Assert::IsTrue(ranges.empty());
+
+            auto counters = channel.GetCounters();
+            Assert::AreEqual(8ull, counters.itemsUpdated);
+            Assert::AreEqual(1ull, counters.notifications);
+            Assert::AreEqual(4ull, counters.ranges);
+        }
+
+        TEST_METHOD(VerifyFlush)
+        {
+            std::atomic<int> notifications{ 0 };
+            CPowerRenameProgressChannel channel([&]() { notifications++; });
+            std::vector<CPowerRenameProgressChannel::ItemRange> ranges;
+
+            // Nothing to flush
+            channel.Flush();
+            Assert::AreEqual(0, notifications.load());
+
+            channel.MarkUpdated(0);
+            channel.TakeUpdatedRanges(ranges);
+            Assert::AreEqual(1, notifications.load());
+
+            // Right after a notification an update waits for the interval or a flush
+            channel.MarkUpdated(1);
+            channel.Flush();
+            Assert::AreEqual(2, notifications.load());
+
+            // Already notified
+            channel.Flush();
+            Assert::AreEqual(2, notifications.load());
+
+            channel.TakeUpdatedRanges(ranges);
+            Assert::AreEqual(1ull, static_cast<unsigned long long>(ranges.size()));
+            Assert::AreEqual(1u, ranges[0].first);
+        }
+
+        TEST_METHOD(VerifyItemCountThreshold)
+        {
+            std::atomic<int> notifications{ 0 };
+            CPowerRenameProgressChannel channel([&]() { notifications++; });
+            std::vector<CPowerRenameProgressChannel::ItemRange> ranges;
+            channel.MarkUpdated(0);
+            channel.TakeUpdatedRanges(ranges);
+
+            // Enough pending items notify without waiting for the interval
+            for (UINT i = 1; i <= CPowerRenameProgressChannel::FlushItemCount; i++)
+            {
+                channel.MarkUpdated(i);
+            }
+            Assert::AreEqual(2, notifications.load());
+        }
+
+        TEST_METHOD(VerifyTimedFlush)
+        {
+            std::atomic<int> notifications{ 0 };
+            CPowerRenameProgressChannel channel([&]() { notifications++; });
+            std::vector<CPowerRenameProgressChannel::ItemRange> ranges;
+            channel.MarkUpdated(0);
+            channel.TakeUpdatedRanges(ranges);
+
+            // An update marked right after a notification goes out without more updates or a flush
+            channel.MarkUpdated(1);
+            for (int step = 0; step < 500 && notifications < 2; step++)
+            {
+                Sleep(10);
+            }
+            Assert::AreEqual(2, notifications.load());
+
+            channel.TakeUpdatedRanges(ranges);
+            Assert::AreEqual(1ull, static_cast<unsigned long long>(ranges.size()));
+            Assert::AreEqual(1u, ranges[0].first);
+        }
+
+        TEST_METHOD(VerifyConcurrentUpdates)
+        {
+            const UINT threadCount = 4;
+            const UINT itemsPerThread = 10000;
+            std::atomic<int> notifications{ 0 };
+            CPowerRenameProgressChannel channel([&]() { notifications++; });
+
+            std::vector<std::thread> threads;
+            for (UINT t = 0; t < threadCount; t++)
+            {
+                threads.emplace_back([&, t]() {
+                    for (UINT i = t; i < threadCount * itemsPerThread; i += threadCount)
+                    {
+                        channel.MarkUpdated(i);
+                    }
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            channel.Flush();
+
+            std::vector<CPowerRenameProgressChannel::ItemRange> ranges;
+            channel.TakeUpdatedRanges(ranges);
+            Assert::AreEqual(1ull, static_cast<unsigned long long>(ranges.size()));
+            Assert::AreEqual(0u, ranges[0].first);
+            Assert::AreEqual(threadCount * itemsPerThread - 1, ranges[0].last);
+            Assert::AreEqual(1, notifications.load());
+            Assert::AreEqual(static_cast<UINT64>(threadCount * itemsPerThread), channel.GetCounters().itemsUpdated);
+        }
+    };
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "pch.h"
+#include "powerrename/lib/Settings.h"
+#include "CppUnitTest.h"
+#include <functional>
+
+// Runs test with the std or Boost engine picked by the test class, then with the linear
+// engine on top of it, so the same expectations hold for every regex backend
+inline void RunForEachRegExEngine(_In_ const std::function<void()>& test)
+{
+    for (bool useLinearRegEx : { false, true })
+    {
+        Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(useLinearRegEx ? L"Linear engine\n" : L"Library engine\n");
+        CSettingsInstance().SetUseLinearRegEx(useLinearRegEx);
+        try
+        {
+            test();
+        }
+        catch (...)
+        {
+            CSettingsInstance().SetUseLinearRegEx(false);
+            throw;
+        }
+    }
+    CSettingsInstance().SetUseLinearRegEx(false);
+}
@@ -17,6 +17,7 @@ namespace Microsoft.PowerToys.Settings.UI.Library
             ShowIcon = false;
             ExtendedContextMenuOnly = false;
             UseBoostLib = false;
+            UseLinearRegEx = false;
         }
 
         private int _maxSize;
@@ -51,6 +52,8 @@ namespace Microsoft.PowerToys.Settings.UI.Library
 
         public bool UseBoostLib { get; set; }
 
+        public bool UseLinearRegEx { get; set; }
+
         public string ToJsonString()
         {
             return JsonSerializer.Serialize(this);
@@ -36,6 +36,7 @@ namespace Microsoft.PowerToys.Settings.UI.Library
             Properties.ShowIcon.Value = localProperties.ShowIcon;
             Properties.ExtendedContextMenuOnly.Value = localProperties.ExtendedContextMenuOnly;
             Properties.UseBoostLib.Value = localProperties.UseBoostLib;
+            Properties.UseLinearRegEx.Value = localProperties.UseLinearRegEx;
 
             Version = "1";
             Name = ModuleName;
@@ -0,0 +1,239 @@
+// Parse and serialize benchmark of json::native (src/common/utils/json_native.h) on a zones-settings file.
+//
+// json::native only needs the standard library, so the benchmark builds on any platform with a C++20 compiler,
+// for instance from the root of the repository:
+//
+//   g++ -std=c++20 -O2 -Isrc tools/JsonBenchmark/JsonBenchmark.cpp -o JsonBenchmark
+//
+// Usage: JsonBenchmark [zones-settings.json]
+// Without a file, a 5 MB zones-settings file is generated, with devices, custom layouts and app zone history.
+
+#include <common/utils/json_native.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace json::native;
+
+namespace
+{
+    constexpr size_t GeneratedSize = 5 * 1024 * 1024;
+    constexpr int Iterations = 20;
+
+    std::string Guid(std::mt19937& random)
+    {
+        char buffer[40];
+        std::snprintf(buffer, sizeof(buffer), "{%08X-%04X-%04X-%04X-%04X%08X}", static_cast<unsigned>(random()), static_cast<unsigned>(random() & 0xFFFF), static_cast<unsigned>(random() & 0xFFFF), static_cast<unsigned>(random() & 0xFFFF), static_cast<unsigned>(random() & 0xFFFF), static_cast<unsigned>(random()));
+        return buffer;
+    }
+
+    std::string DeviceId(std::mt19937& random)
+    {
+        return "DELA026#5&10a58c63&0&UID" + std::to_string(random() % 100000) + "_3440_1400_" + Guid(random);
+    }
+
+    // Same layout as the files written by FancyZones
+    std::string GenerateZonesSettings()
+    {
+        std::mt19937 random{ 42 };
+        Writer writer;
+        writer.Reserve(GeneratedSize + 64 * 1024);
+        writer.StartObject();
+
+        writer.Key("devices");
+        writer.StartArray();
+        for (int i = 0; i < 200; ++i)
+        {
+            writer.StartObject();
+            writer.Key("device-id");
+            writer.String(DeviceId(random));
+            writer.Key("active-zoneset");
+            writer.StartObject();
+            writer.Key("uuid");
+            writer.String(Guid(random));
+            writer.Key("type");
+            writer.String("priority-grid");
+            writer.EndObject();
+            writer.Key("editor-show-spacing");
+            writer.Boolean(true);
+            writer.Key("editor-spacing");
+            writer.Number(int64_t{ 16 });
+            writer.Key("editor-zone-count");
+            writer.Number(int64_t{ 3 });
+            writer.Key("editor-sensitivity-radius");
+            writer.Number(int64_t{ 20 });
+            writer.EndObject();
+        }
+        writer.EndArray();
+
+        writer.Key("custom-zone-sets");
+        writer.StartArray();
+        for (int i = 0; i < 300; ++i)
+        {
+            writer.StartObject();
+            writer.Key("uuid");
+            writer.String(Guid(random));
+            writer.Key("name");
+            writer.String("Custom layout " + std::to_string(i));
+            writer.Key("type");
+            writer.String("canvas");
+            writer.Key("info");
+            writer.StartObject();
+            writer.Key("ref-width");
+            writer.Number(int64_t{ 3440 });
+            writer.Key("ref-height");
+            writer.Number(int64_t{ 1400 });
+            writer.Key("zones");
+            writer.StartArray();
+            for (int zone = 0; zone < 16; ++zone)
+            {
+                writer.StartObject();
+                writer.Key("X");
+                writer.Number(static_cast<int64_t>(random() % 3000));
+                writer.Key("Y");
+                writer.Number(static_cast<int64_t>(random() % 1200));
+                writer.Key("width");
+                writer.Number(static_cast<int64_t>(random() % 1000 + 100));
+                writer.Key("height");
+                writer.Number(static_cast<int64_t>(random() % 800 + 100));
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+            writer.EndObject();
+        }
+        writer.EndArray();
+
+        writer.Key("app-zone-history");
+        writer.StartArray();
+        for (int app = 0; writer.GetString().size() < GeneratedSize; ++app)
+        {
+            writer.StartObject();
+            writer.Key("app-path");
+            writer.String("C:\\Program Files\\Application " + std::to_string(app) + "\\app.exe");
+            writer.Key("history");
+            writer.StartArray();
+            for (int desktop = 0; desktop < 3; ++desktop)
+            {
+                writer.StartObject();
+                writer.Key("zone-index-set");
+                writer.StartArray();
+                writer.Number(static_cast<int64_t>(random() % 8));
+                writer.EndArray();
+                writer.Key("device-id");
+                writer.String(DeviceId(random));
+                writer.Key("zoneset-uuid");
+                writer.String(Guid(random));
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+        }
+        writer.EndArray();
+
+        writer.EndObject();
+        return writer.Release();
+    }
+
+    struct CountingHandler
+    {
+        size_t values = 0;
+
+        bool Value()
+        {
+            ++values;
+            return true;
+        }
+
+        bool Null() { return Value(); }
+        bool Boolean(bool) { return Value(); }
+        bool Number(double) { return Value(); }
+        bool String(std::string_view) { return Value(); }
+        bool Key(std::string_view) { return true; }
+        bool StartObject() { return true; }
+        bool EndObject(size_t) { return Value(); }
+        bool StartArray() { return true; }
+        bool EndArray(size_t) { return Value(); }
+    };
+
+    template<typename F>
+    double BestMilliseconds(F&& f)
+    {
+        double best = 1e300;
+        for (int i = 0; i < Iterations; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            best = (std::min)(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    void Report(const char* name, double milliseconds, size_t bytes)
+    {
+        std::printf("%-24s %8.2f ms %8.1f MB/s\n", name, milliseconds, bytes / (1024.0 * 1024.0) / (milliseconds / 1000.0));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string text;
+    if (argc > 1)
+    {
+        const std::string fileName = argv[1];
+        auto contents = read_file(std::wstring(fileName.begin(), fileName.end()));
+        if (!contents)
+        {
+            std::fprintf(stderr, "Cannot read %s\n", argv[1]);
+            return 1;
+        }
+        text = std::move(*contents);
+    }
+    else
+    {
+        text = GenerateZonesSettings();
+    }
+
+    ParseError error;
+    const auto document = Document::Parse(text, &error);
+    if (!document)
+    {
+        std::fprintf(stderr, "Parse error at %zu: %s\n", error.offset, error.message);
+        return 1;
+    }
+
+    Writer writer;
+    writer.Write(document->Root());
+    const std::string serialized = writer.Release();
+    const auto reparsed = Document::Parse(serialized);
+    Writer rewriter;
+    rewriter.Write(reparsed->Root());
+    if (rewriter.GetString() != serialized)
+    {
+        std::fprintf(stderr, "Serialization does not round trip\n");
+        return 1;
+    }
+
+    std::printf("Input %.2f MB, arena %.2f MB\n", text.size() / (1024.0 * 1024.0), document->GetArena().BytesReserved() / (1024.0 * 1024.0));
+
+    size_t values = 0;
+    Report("SAX parse", BestMilliseconds([&] {
+               Reader reader;
+               CountingHandler handler;
+               reader.Parse(text, handler);
+               values = handler.values;
+           }),
+           text.size());
+    Report("DOM parse", BestMilliseconds([&] { Document::Parse(text); }), text.size());
+    Report("Serialize", BestMilliseconds([&] {
+               Writer benchmarkWriter;
+               benchmarkWriter.Reserve(serialized.size());
+               benchmarkWriter.Write(document->Root());
+           }),
+           serialized.size());
+    std::printf("%zu values\n", values);
+    return 0;
+}